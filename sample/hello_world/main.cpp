@@ -22,6 +22,7 @@ int main()
             quickgui::widgets::draw_bg();
             draw_hello_world();
             quickgui::widgets::vulkan_window(&st);
+            quickgui::widgets::gpu_profiler_window(&st);
             #ifdef QUICKGUI_WITH_DEMOS
             quickgui::widgets::demo(&st);
             #endif
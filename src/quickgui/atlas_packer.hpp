@@ -0,0 +1,163 @@
+#ifndef QUICKGUI_ATLAS_PACKER_HPP_
+#define QUICKGUI_ATLAS_PACKER_HPP_
+
+#include <cstdint>
+#include <vector>
+
+namespace quickgui {
+
+/** a rect in a layer of an atlas */
+struct AtlasRect
+{
+    uint32_t layer;
+    uint32_t x, y;
+    uint32_t width, height;
+};
+
+/** shelf packing over the layers of a 2D array texture. The rects are
+ * placed left to right on horizontal shelves, choosing the shelf that
+ * wastes less height; a new shelf is opened below the last one of the
+ * first layer that has room. Each rect is surrounded by padding
+ * texels of its own, so that the filtering does not bleed between
+ * neighbours: two rects are separated by twice the padding.
+ * A removed rect is reused by the next rect that fits in it, and the
+ * whole layer is reclaimed once it is empty. A reused slot keeps its
+ * original size, so that removing the smaller rect frees all of it. */
+struct AtlasPacker
+{
+    struct Shelf
+    {
+        uint32_t y, height;
+        uint32_t x; ///< the next free position
+    };
+    struct Layer
+    {
+        std::vector<Shelf> shelves;
+        std::vector<AtlasRect> free_rects; ///< removed, in a layer that is not empty
+        std::vector<AtlasRect> reused_slots; ///< the free rects taken by a live rect, at its position
+        uint32_t next_y;
+        uint32_t num_rects;
+    };
+
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t padding = 0;
+    std::vector<Layer> layers;
+
+public:
+
+    void reset(uint32_t width_, uint32_t height_, uint32_t num_layers, uint32_t padding_=1)
+    {
+        width = width_;
+        height = height_;
+        padding = padding_;
+        layers.assign(num_layers, Layer{{}, {}, {}, padding_, 0u});
+    }
+
+    /** @return false if there is no room for the rect */
+    bool add(uint32_t w, uint32_t h, AtlasRect *rect)
+    {
+        if(w == 0 || h == 0 || w + 2 * padding > width || h + 2 * padding > height)
+            return false;
+        // the removed rect with the least wasted area, in any layer
+        AtlasRect *best_free = nullptr;
+        uint32_t best_free_layer = 0;
+        for(uint32_t l = 0; l < (uint32_t)layers.size(); ++l)
+        {
+            for(AtlasRect &fr : layers[l].free_rects)
+            {
+                if(fr.width < w || fr.height < h)
+                    continue;
+                if(!best_free || (uint64_t)fr.width * fr.height < (uint64_t)best_free->width * best_free->height)
+                {
+                    best_free = &fr;
+                    best_free_layer = l;
+                }
+            }
+        }
+        if(best_free)
+        {
+            *rect = {best_free_layer, best_free->x, best_free->y, w, h};
+            Layer &layer = layers[best_free_layer];
+            layer.reused_slots.push_back(*best_free);
+            *best_free = layer.free_rects.back();
+            layer.free_rects.pop_back();
+            ++layer.num_rects;
+            return true;
+        }
+        // the shelf with the least wasted height, in any layer
+        Shelf *best = nullptr;
+        uint32_t best_layer = 0;
+        for(uint32_t l = 0; l < (uint32_t)layers.size(); ++l)
+        {
+            for(Shelf &shelf : layers[l].shelves)
+            {
+                if(shelf.height < h || shelf.x + w + padding > width)
+                    continue;
+                if(!best || shelf.height < best->height)
+                {
+                    best = &shelf;
+                    best_layer = l;
+                }
+            }
+        }
+        // prefer a new shelf when the best one wastes too much
+        if(!best || best->height > 2 * h)
+        {
+            for(uint32_t l = 0; l < (uint32_t)layers.size(); ++l)
+            {
+                Layer &layer = layers[l];
+                if(layer.next_y + h + padding > height)
+                    continue;
+                layer.shelves.push_back(Shelf{layer.next_y, h, padding});
+                layer.next_y += h + 2 * padding;
+                best = &layer.shelves.back();
+                best_layer = l;
+                break;
+            }
+        }
+        if(!best)
+            return false;
+        rect->layer = best_layer;
+        rect->x = best->x;
+        rect->y = best->y;
+        rect->width = w;
+        rect->height = h;
+        best->x += w + 2 * padding;
+        ++layers[best_layer].num_rects;
+        return true;
+    }
+
+    void remove(AtlasRect const& rect)
+    {
+        Layer &layer = layers[rect.layer];
+        if(!layer.num_rects)
+            return;
+        if(--layer.num_rects == 0)
+        {
+            layer.shelves.clear();
+            layer.free_rects.clear();
+            layer.reused_slots.clear();
+            layer.next_y = padding;
+            return;
+        }
+        // no two live rects share a position, so it identifies the slot
+        for(AtlasRect &slot : layer.reused_slots)
+        {
+            if(slot.x == rect.x && slot.y == rect.y)
+            {
+                layer.free_rects.push_back(slot);
+                slot = layer.reused_slots.back();
+                layer.reused_slots.pop_back();
+                return;
+            }
+        }
+        layer.free_rects.push_back(rect);
+    }
+
+    uint32_t num_rects(uint32_t layer) const { return layers[layer].num_rects; }
+};
+
+} // namespace quickgui
+
+#endif /* QUICKGUI_ATLAS_PACKER_HPP_ */
@@ -0,0 +1,62 @@
+#include "quickgui/compute_kernels.hpp"
+
+namespace quickgui {
+namespace rhi {
+
+namespace {
+
+const uint32_t s_convert_channels_spv[] = {
+#include "quickgui/shaders/convert_channels.comp.glsl.spv"
+};
+const uint32_t s_vflip_spv[] = {
+#include "quickgui/shaders/vflip.comp.glsl.spv"
+};
+const uint32_t s_yuv2rgb_spv[] = {
+#include "quickgui/shaders/yuv2rgb.comp.glsl.spv"
+};
+const uint32_t s_colormap_spv[] = {
+#include "quickgui/shaders/colormap.comp.glsl.spv"
+};
+
+// all the built-in kernels use 16x16 workgroups, as declared in
+// their sources
+template<size_t N, size_t M>
+ComputeShader _shader(const uint32_t (&code)[N], const VkDescriptorType (&bindings)[M], uint32_t push_constants_size)
+{
+    ComputeShader shader;
+    shader.code = c4::cspan<uint32_t>(code, N);
+    shader.bindings = c4::cspan<VkDescriptorType>(bindings, M);
+    shader.push_constants_size = push_constants_size;
+    return shader;
+}
+
+} // namespace
+
+
+void ComputeKernels::acquire(Rhi *rhi)
+{
+    static const VkDescriptorType buf2img[] = {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE};
+    static const VkDescriptorType img[] = {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE};
+    static const VkDescriptorType lut[] = {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE};
+    convert_channels = rhi->make_compute_pipeline(_shader(s_convert_channels_spv, buf2img, sizeof(ConvertChannelsParams)));
+    vflip = rhi->make_compute_pipeline(_shader(s_vflip_spv, img, sizeof(VFlipParams)));
+    yuv2rgb = rhi->make_compute_pipeline(_shader(s_yuv2rgb_spv, buf2img, sizeof(Yuv2RgbParams)));
+    colormap = rhi->make_compute_pipeline(_shader(s_colormap_spv, lut, sizeof(ColormapParams)));
+    rhi->set_name(convert_channels, "compute/convert_channels");
+    rhi->set_name(vflip, "compute/vflip");
+    rhi->set_name(yuv2rgb, "compute/yuv2rgb");
+    rhi->set_name(colormap, "compute/colormap");
+}
+
+void ComputeKernels::release(Rhi *rhi)
+{
+    for(compute_pipeline_id *id : {&convert_channels, &vflip, &yuv2rgb, &colormap})
+    {
+        if(*id)
+            rhi->destroy_compute_pipeline(*id);
+        *id = {};
+    }
+}
+
+} // namespace rhi
+} // namespace quickgui
@@ -0,0 +1,133 @@
+#ifndef QUICKGUI_COMPUTE_KERNELS_HPP_
+#define QUICKGUI_COMPUTE_KERNELS_HPP_
+
+#include "quickgui/rhi.hpp"
+
+namespace quickgui {
+namespace rhi {
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+/* The push constants of each built-in kernel, with the resources it
+ * expects in binding order. Source buffers are read as 32-bit words,
+ * so their size must be a multiple of 4 bytes. The destination
+ * images are R8G8B8A8_UNORM, created with ImageLayout::with_storage(). */
+
+
+/** expand tightly packed 8-bit pixels with 1 to 4 channels to rgba8:
+ * gray to (v,v,v,1), gray+alpha to (v,v,v,a), rgb to (r,g,b,1).
+ *
+ * bindings: 0=storage_buffer(src pixels), 1=storage_image(dst) */
+struct ConvertChannelsParams
+{
+    enum : uint32_t { swap_rb = 1u, vflip = 2u };
+    uint32_t width;
+    uint32_t height;
+    uint32_t row_pitch;    ///< bytes between the start of consecutive rows
+    uint32_t num_channels; ///< 1, 2, 3 or 4
+    uint32_t flags;
+
+    /** tightly packed rows */
+    static ConvertChannelsParams make(uint32_t w, uint32_t h, uint32_t num_channels_, uint32_t flags_=0)
+    {
+        return {w, h, w * num_channels_, num_channels_, flags_};
+    }
+    /** the size of the source buffer */
+    size_t src_size() const { return (size_t)row_pitch * height; }
+};
+
+
+/** flip an rgba8 image vertically, in place.
+ *
+ * bindings: 0=storage_image(img) */
+struct VFlipParams
+{
+    uint32_t width;
+    uint32_t height;
+};
+
+
+/** convert a 4:2:0 YUV frame to rgba8. The planes are given by their
+ * byte offsets into the source buffer. BT.601 limited range by
+ * default.
+ *
+ * bindings: 0=storage_buffer(src planes), 1=storage_image(dst) */
+struct Yuv2RgbParams
+{
+    enum : uint32_t { nv12 = 1u, bt709 = 2u, full_range = 4u };
+    uint32_t width;
+    uint32_t height;
+    uint32_t y_offset;
+    uint32_t y_pitch;
+    uint32_t u_offset; ///< for nv12, the offset of the interleaved UV plane
+    uint32_t v_offset; ///< unused for nv12
+    uint32_t uv_pitch;
+    uint32_t flags;
+
+    /** planar Y, then U, then V, with no row padding */
+    static Yuv2RgbParams make_i420(uint32_t w, uint32_t h, uint32_t flags_=0)
+    {
+        const uint32_t cw = (w + 1u) / 2u, ch = (h + 1u) / 2u;
+        return {w, h, 0u, w, w * h, w * h + cw * ch, cw, flags_ & ~uint32_t(nv12)};
+    }
+    /** planar Y, then interleaved UV, with no row padding */
+    static Yuv2RgbParams make_nv12(uint32_t w, uint32_t h, uint32_t flags_=0)
+    {
+        const uint32_t cw = (w + 1u) / 2u;
+        return {w, h, 0u, w, w * h, 0u, 2u * cw, flags_ | uint32_t(nv12)};
+    }
+    /** the size of the source buffer: the end of the last plane */
+    size_t src_size() const
+    {
+        const size_t ch = (height + 1u) / 2u;
+        const size_t y_end = (size_t)y_offset + (size_t)y_pitch * height;
+        const size_t u_end = (size_t)u_offset + (size_t)uv_pitch * ch;
+        const size_t v_end = (flags & nv12) ? 0u : (size_t)v_offset + (size_t)uv_pitch * ch;
+        return y_end > u_end ? (y_end > v_end ? y_end : v_end) : (u_end > v_end ? u_end : v_end);
+    }
+};
+
+
+/** map the first channel of the source image through a color table:
+ * values in [vmin,vmax] are spread over the lut_size entries.
+ *
+ * bindings: 0=sampled_image(src), 1=storage_buffer(lut, packed
+ * rgba8 as in ucolor), 2=storage_image(dst) */
+struct ColormapParams
+{
+    uint32_t width;
+    uint32_t height;
+    uint32_t lut_size;
+    float    vmin;
+    float    vmax;
+};
+
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+/** the pipelines of the built-in kernels. Each is dispatched through
+ * a ComputePass, eg:
+ *
+ *   pass.reset(&g_rhi, kernels.yuv2rgb);
+ *   pass.bind({ComputeResource::storage_buffer(src), ComputeResource::storage_image(dst_view)});
+ *   pass.dispatch(cmd, Yuv2RgbParams::make_i420(w, h));
+ */
+struct ComputeKernels
+{
+    compute_pipeline_id convert_channels = {};
+    compute_pipeline_id vflip = {};
+    compute_pipeline_id yuv2rgb = {};
+    compute_pipeline_id colormap = {};
+
+    void acquire(Rhi *rhi);
+    void release(Rhi *rhi);
+};
+
+} // namespace rhi
+} // namespace quickgui
+
+#endif /* QUICKGUI_COMPUTE_KERNELS_HPP_ */
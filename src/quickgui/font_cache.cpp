@@ -0,0 +1,352 @@
+#include "quickgui/font_cache.hpp"
+
+#include "quickgui/imgui.hpp"
+#include "quickgui/log.hpp"
+#include "quickgui/time.hpp"
+#include <c4/format.hpp>
+#include <c4/fs/fs.hpp>
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+
+namespace quickgui {
+
+C4_SUPPRESS_WARNING_GCC_CLANG_PUSH
+C4_SUPPRESS_WARNING_GCC_CLANG("-Wold-style-cast")
+
+namespace {
+
+static_assert(std::is_trivially_copyable_v<ImFontGlyph>);
+
+constexpr const char font_atlas_magic[4] = {'Q', 'G', 'F', 'A'};
+constexpr const uint32_t font_atlas_version = 2;
+constexpr const float font_atlas_default_size = 13.f;
+
+struct Fnv1a
+{
+    uint64_t val = UINT64_C(14695981039346656037);
+    void add(const void *data, size_t sz)
+    {
+        const uint8_t *C4_RESTRICT bytes = (const uint8_t*)data;
+        for(size_t i = 0; i < sz; ++i)
+        {
+            val ^= bytes[i];
+            val *= UINT64_C(1099511628211);
+        }
+    }
+    template<class T>
+    void add(T const& var)
+    {
+        static_assert(std::is_arithmetic_v<T>);
+        add(&var, sizeof(T));
+    }
+};
+
+struct Writer
+{
+    String *buf;
+    void write(const void *data, size_t sz)
+    {
+        buf->append((const char*)data, sz);
+    }
+    template<class T>
+    void write(T const& var)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        write(&var, sizeof(T));
+    }
+};
+
+struct Reader
+{
+    ccharspan buf;
+    size_t pos;
+    bool read(void *data, size_t sz)
+    {
+        if(sz > buf.size() - pos)
+            return false;
+        memcpy(data, buf.data() + pos, sz);
+        pos += sz;
+        return true;
+    }
+    template<class T>
+    bool read(T *var)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        return read(var, sizeof(T));
+    }
+};
+
+float font_size(FontAtlasSpec const& spec)
+{
+    return spec.size > 0.f ? spec.size : font_atlas_default_size;
+}
+
+ImFontConfig font_config(FontAtlasSpec const& spec)
+{
+    ImFontConfig cfg;
+    if(spec.ttf_data.empty())
+    {
+        // the bitmap default font is sharper without oversampling;
+        // these are the settings of AddFontDefault() without config
+        cfg.OversampleH = cfg.OversampleV = 1;
+        cfg.PixelSnapH = true;
+    }
+    return cfg;
+}
+
+bool font_atlas_load_(ImFontAtlas *atlas, uint64_t key, ccharspan data)
+{
+    Reader r{data, 0};
+    char magic[sizeof(font_atlas_magic)];
+    uint32_t version = 0;
+    uint64_t stored_key = 0;
+    if(!r.read(magic, sizeof(magic)) || memcmp(magic, font_atlas_magic, sizeof(magic)) != 0)
+        return false;
+    if(!r.read(&version) || version != font_atlas_version)
+        return false;
+    if(!r.read(&stored_key) || stored_key != key)
+        return false;
+    int32_t width = 0, height = 0, num_fonts = 0;
+    if(!r.read(&width) || !r.read(&height) || width <= 0 || height <= 0)
+        return false;
+    if(!r.read(&atlas->TexUvScale) || !r.read(&atlas->TexUvWhitePixel))
+        return false;
+    if(!r.read(atlas->TexUvLines, sizeof(atlas->TexUvLines)))
+        return false;
+    if(!r.read(&num_fonts) || num_fonts <= 0)
+        return false;
+    for(int32_t i = 0; i < num_fonts; ++i)
+    {
+        ImFont *font = IM_NEW(ImFont);
+        atlas->Fonts.push_back(font);
+        font->ContainerAtlas = atlas;
+        int32_t num_glyphs = 0;
+        if(!r.read(&font->FontSize)
+           || !r.read(&font->Scale)
+           || !r.read(&font->Ascent)
+           || !r.read(&font->Descent)
+           || !r.read(&font->MetricsTotalSurface)
+           || !r.read(&font->FallbackChar)
+           || !r.read(&font->EllipsisChar)
+           || !r.read(&num_glyphs))
+            return false;
+        if(num_glyphs <= 0 || (size_t)num_glyphs > (data.size() - r.pos) / sizeof(ImFontGlyph))
+            return false;
+        font->Glyphs.resize(num_glyphs);
+        if(!r.read(font->Glyphs.Data, (size_t)num_glyphs * sizeof(ImFontGlyph)))
+            return false;
+        font->BuildLookupTable();
+    }
+    // the custom rects, eg the mouse cursors and the baked lines
+    int32_t num_rects = 0, pack_id_cursors = 0, pack_id_lines = 0;
+    if(!r.read(&num_rects) || num_rects < 0 || !r.read(&pack_id_cursors) || !r.read(&pack_id_lines))
+        return false;
+    if(pack_id_cursors >= num_rects || pack_id_lines >= num_rects)
+        return false;
+    constexpr const size_t rect_bytes = 4 * sizeof(uint16_t) + sizeof(uint32_t) + sizeof(float) + sizeof(ImVec2) + sizeof(int32_t);
+    if((size_t)num_rects > (data.size() - r.pos) / rect_bytes)
+        return false;
+    atlas->CustomRects.resize(num_rects);
+    for(ImFontAtlasCustomRect &rect : atlas->CustomRects)
+    {
+        uint16_t x, y, w, h;
+        uint32_t glyph_id;
+        int32_t font_index;
+        if(!r.read(&x) || !r.read(&y) || !r.read(&w) || !r.read(&h)
+           || !r.read(&glyph_id)
+           || !r.read(&rect.GlyphAdvanceX)
+           || !r.read(&rect.GlyphOffset)
+           || !r.read(&font_index))
+            return false;
+        if(font_index < -1 || font_index >= num_fonts)
+            return false;
+        rect.X = x;
+        rect.Y = y;
+        rect.Width = w;
+        rect.Height = h;
+        rect.GlyphID = glyph_id;
+        rect.Font = font_index >= 0 ? atlas->Fonts[font_index] : nullptr;
+    }
+    atlas->PackIdMouseCursors = pack_id_cursors;
+    atlas->PackIdLines = pack_id_lines;
+    const size_t num_pixels = (size_t)width * (size_t)height;
+    if(num_pixels != data.size() - r.pos)
+        return false;
+    atlas->TexPixelsAlpha8 = (unsigned char*)IM_ALLOC(num_pixels);
+    r.read(atlas->TexPixelsAlpha8, num_pixels);
+    atlas->TexWidth = width;
+    atlas->TexHeight = height;
+    atlas->TexPixelsUseColors = false;
+    atlas->TexReady = true;
+    return true;
+}
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+uint64_t font_atlas_key(ImFontAtlas const* atlas, FontAtlasSpec const& spec)
+{
+    Fnv1a h;
+    h.add(font_atlas_magic, sizeof(font_atlas_magic));
+    h.add(font_atlas_version);
+    h.add((int32_t)IMGUI_VERSION_NUM);
+    h.add((uint32_t)sizeof(ImFontGlyph));
+    if(spec.ttf_data.empty())
+        h.add("default", 7);
+    else
+        h.add(spec.ttf_data.data(), spec.ttf_data.size());
+    h.add(font_size(spec));
+    h.add((uint32_t)spec.scales.size());
+    for(float scale : spec.scales)
+        h.add(scale);
+    const ImFontConfig cfg = font_config(spec);
+    h.add(cfg.OversampleH);
+    h.add(cfg.OversampleV);
+    h.add(cfg.PixelSnapH);
+    h.add(cfg.RasterizerMultiply);
+    h.add(atlas->Flags);
+    h.add(atlas->TexDesiredWidth);
+    h.add(atlas->TexGlyphPadding);
+    h.add(atlas->FontBuilderFlags);
+    return h.val;
+}
+
+
+void font_atlas_build(ImFontAtlas *atlas, FontAtlasSpec const& spec)
+{
+    const float size = font_size(spec);
+    const float default_scale = 1.f;
+    c4::span<const float> scales = spec.scales;
+    if(scales.empty())
+        scales = {&default_scale, 1};
+    for(float scale : scales)
+    {
+        ImFontConfig cfg = font_config(spec);
+        cfg.SizePixels = size * scale;
+        if(spec.ttf_data.empty())
+        {
+            atlas->AddFontDefault(&cfg);
+        }
+        else
+        {
+            // the atlas does not own the data: it is dropped below
+            // with ClearInputData()
+            cfg.FontDataOwnedByAtlas = false;
+            atlas->AddFontFromMemoryTTF((void*)spec.ttf_data.data(), (int)spec.ttf_data.size(), size * scale, &cfg);
+        }
+    }
+    C4_CHECK(atlas->Build());
+    // release the font data, and make the built atlas equal to a loaded one
+    atlas->ClearInputData();
+}
+
+
+void font_atlas_save(ImFontAtlas const* atlas, uint64_t key, String *data)
+{
+    C4_CHECK(atlas->TexPixelsAlpha8 != nullptr);
+    data->clear();
+    Writer w{data};
+    w.write(font_atlas_magic, sizeof(font_atlas_magic));
+    w.write(font_atlas_version);
+    w.write(key);
+    w.write((int32_t)atlas->TexWidth);
+    w.write((int32_t)atlas->TexHeight);
+    w.write(atlas->TexUvScale);
+    w.write(atlas->TexUvWhitePixel);
+    w.write(atlas->TexUvLines, sizeof(atlas->TexUvLines));
+    w.write((int32_t)atlas->Fonts.Size);
+    for(ImFont const* font : atlas->Fonts)
+    {
+        w.write(font->FontSize);
+        w.write(font->Scale);
+        w.write(font->Ascent);
+        w.write(font->Descent);
+        w.write(font->MetricsTotalSurface);
+        w.write(font->FallbackChar);
+        w.write(font->EllipsisChar);
+        w.write((int32_t)font->Glyphs.Size);
+        w.write(font->Glyphs.Data, (size_t)font->Glyphs.Size * sizeof(ImFontGlyph));
+    }
+    // field by field: the rects point at their font, and their layout
+    // varies across imgui versions
+    w.write((int32_t)atlas->CustomRects.Size);
+    w.write((int32_t)atlas->PackIdMouseCursors);
+    w.write((int32_t)atlas->PackIdLines);
+    for(ImFontAtlasCustomRect const& rect : atlas->CustomRects)
+    {
+        w.write((uint16_t)rect.X);
+        w.write((uint16_t)rect.Y);
+        w.write((uint16_t)rect.Width);
+        w.write((uint16_t)rect.Height);
+        w.write((uint32_t)rect.GlyphID);
+        w.write(rect.GlyphAdvanceX);
+        w.write(rect.GlyphOffset);
+        w.write((int32_t)(rect.Font ? atlas->Fonts.index_from_ptr(atlas->Fonts.find(rect.Font)) : -1));
+    }
+    w.write(atlas->TexPixelsAlpha8, (size_t)atlas->TexWidth * (size_t)atlas->TexHeight);
+}
+
+
+bool font_atlas_load(ImFontAtlas *atlas, uint64_t key, ccharspan data)
+{
+    C4_CHECK(atlas->Fonts.empty() && atlas->TexPixelsAlpha8 == nullptr);
+    if(font_atlas_load_(atlas, key, data))
+        return true;
+    atlas->Clear();
+    return false;
+}
+
+
+bool font_atlas_acquire(ImFontAtlas *atlas, FontAtlasSpec const& spec, const char *cache_dir)
+{
+    const time_point t = now();
+    const uint64_t key = font_atlas_key(atlas, spec);
+    String file;
+    if(cache_dir && cache_dir[0])
+    {
+        file = cache_dir;
+        if(file.back() != '/' && file.back() != '\\')
+            file += '/';
+        char name[64];
+        snprintf(name, sizeof(name), "font_atlas_%016llx.bin", (unsigned long long)key);
+        file += name;
+        if(c4::fs::file_exists(file.c_str()))
+        {
+            String data = c4::fs::file_get_contents<String>(file.c_str());
+            if(font_atlas_load(atlas, key, {data.data(), data.size()}))
+            {
+                QUICKGUI_LOGF("font atlas: loaded {}x{} from {}: {}ms", atlas->TexWidth, atlas->TexHeight, c4::to_csubstr(file), fmsecs(now() - t).count());
+                return true;
+            }
+            QUICKGUI_LOGF("font atlas: discarding invalid file {}", c4::to_csubstr(file));
+        }
+    }
+    font_atlas_build(atlas, spec);
+    QUICKGUI_LOGF("font atlas: built {}x{}: {}ms", atlas->TexWidth, atlas->TexHeight, fmsecs(now() - t).count());
+    if(!file.empty())
+    {
+        String data;
+        font_atlas_save(atlas, key, &data);
+        // write to a temporary file first, so that an interrupted
+        // write does not leave a truncated cache behind
+        String tmp = file + ".tmp";
+        c4::fs::file_put_contents(tmp.c_str(), data);
+        bool ok = (std::rename(tmp.c_str(), file.c_str()) == 0);
+        if(!ok) // some platforms do not overwrite on rename
+        {
+            std::remove(file.c_str());
+            ok = (std::rename(tmp.c_str(), file.c_str()) == 0);
+        }
+        QUICKGUI_LOGF_IF(!ok, "font atlas: could not save to {}", c4::to_csubstr(file));
+    }
+    return false;
+}
+
+C4_SUPPRESS_WARNING_GCC_CLANG_POP
+
+} // namespace quickgui
@@ -0,0 +1,46 @@
+#ifndef QUICKGUI_FONT_CACHE_HPP_
+#define QUICKGUI_FONT_CACHE_HPP_
+
+#include <cstdint>
+#include <c4/span.hpp>
+#include "quickgui/string.hpp"
+
+struct ImFontAtlas;
+
+namespace quickgui {
+
+/** the fonts of the gui atlas: the same font rasterized at several
+ * scales, so that the scale can be changed without blurring the
+ * glyphs, nor rebuilding the atlas */
+struct FontAtlasSpec
+{
+    ccharspan               ttf_data; ///< empty for the default imgui font
+    float                   size;     ///< in pixels, at scale 1. 0 for the default (13)
+    c4::span<const float>   scales;   ///< one font is added per scale, in this order
+};
+
+/** identifies a rasterized atlas: hashes the font data, the sizes,
+ * the atlas and font settings, and the imgui version */
+uint64_t font_atlas_key(ImFontAtlas const* atlas, FontAtlasSpec const& spec);
+
+/** add one font per scale to the atlas, and rasterize it */
+void font_atlas_build(ImFontAtlas *atlas, FontAtlasSpec const& spec);
+
+/** serialize a built atlas: the alpha pixels, the fonts with their
+ * glyph tables and metrics, and the custom rects with the ids of the
+ * mouse cursors and of the baked lines */
+void font_atlas_save(ImFontAtlas const* atlas, uint64_t key, String *data);
+
+/** restore an atlas saved with font_atlas_save(). The atlas must be
+ * empty. @return false if the data is not valid or is for another
+ * key, in which case the atlas is left empty */
+bool font_atlas_load(ImFontAtlas *atlas, uint64_t key, ccharspan data);
+
+/** load the atlas from a file in cache_dir, or build it and save it
+ * there. Pass a null or empty cache_dir to skip persistence.
+ * @return true if the atlas was loaded from the cache */
+bool font_atlas_acquire(ImFontAtlas *atlas, FontAtlasSpec const& spec, const char *cache_dir);
+
+} // namespace quickgui
+
+#endif /* QUICKGUI_FONT_CACHE_HPP_ */
@@ -1,17 +1,27 @@
 
 #include "quickgui/gui.hpp"
+#include "quickgui/font_cache.hpp"
 #include "quickgui/imgui_impl_sdl2.h"
 #include "quickgui/imgui_impl_vulkan.h"
-#include "quickgui/static_vector.hpp"
+#include "quickgui/mpsc_queue.hpp"
 #include "quickgui/stb_image_data.hpp"
+#include "quickgui/tiff.hpp"
 #include "quickgui/imgview.hpp"
 #include "quickgui/mem.hpp"
 #include "quickgui/log.hpp"
+#include "quickgui/time.hpp"
 #include "quickgui/sdl.hpp"
 
 #include <c4/error.hpp>
 #include <c4/szconv.hpp>
 #include <c4/fs/fs.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
 
 #include <SDL_vulkan.h>
 
@@ -22,10 +32,15 @@ C4_SUPPRESS_WARNING_GCC_CLANG("-Wold-style-cast")
 void SetupVulkan(const char **exts, uint32_t num_exts, quickgui::reusable_buffer *exts_buf);
 void CleanupVulkan();
 void SetupVulkanWindow(ImGui_ImplVulkanH_Window* wd, VkSurfaceKHR surface, int width, int height);
+void SetupVulkanOffscreen(ImGui_ImplVulkanH_Window* wd, int width, int height);
+void ResizeVulkanWindow(ImGui_ImplVulkanH_Window* wd, int width, int height);
 void CleanupVulkanWindow();
+void SetupPipelineCache(const char *dir);
+void CleanupPipelineCache();
 bool FrameStart(ImGui_ImplVulkanH_Window* wd); // returns true if the swap chain should be rebuilt
-void FrameRender(ImGui_ImplVulkanH_Window* wd, ImDrawData* draw_data);
-void FramePresent(ImGui_ImplVulkanH_Window* wd);
+void FrameCapture(ImGui_ImplVulkanH_Window* wd, quickgui::rhi::FrameSubmit *fs);
+void FrameRender(ImGui_ImplVulkanH_Window* wd, ImDrawData* draw_data, quickgui::rhi::FrameSubmit *fs);
+bool FramePresent(ImGui_ImplVulkanH_Window* wd, quickgui::rhi::FrameSubmit const& fs); // returns true if the swap chain should be rebuilt
 
 
 extern VkAllocationCallbacks*   g_Allocator;
@@ -40,9 +55,19 @@ extern VkDescriptorPool         g_DescriptorPool;
 extern ImGui_ImplVulkanH_Window g_MainWindowData;
 extern uint32_t                 g_MinImageCount;
 extern bool                     g_SwapChainRebuild;
+extern bool                     g_Offscreen;
+extern VkPresentModeKHR         g_PresentMode;
+extern uint32_t                 g_FramesInFlight;
+extern uint32_t                 g_RenderThreadDepth;
+extern uint32_t                 g_BindlessTextureCount;
 
 SDL_Window              *g_window = nullptr;
 bool                     g_window_full_screen = false;
+quickgui::time_point     g_init_time = {};
+quickgui::time_point     g_last_frame_time = {}; // used for the imgui delta time when offscreen
+bool                     g_first_frame_done = false;
+quickgui::time_point     g_resize_time = {}; // to measure the resize-to-first-frame latency
+bool                     g_resize_pending = false;
 #if SDL_MAJOR_VERSION == 3
 const SDL_DisplayMode*   g_window_display_mode = {};
 #else
@@ -58,11 +83,15 @@ namespace quickgui::gui {
 
 struct GuiState
 {
-    using FrameEvents = quickgui::static_vector<SDL_Event, 64>;
+    /** grows as needed, and keeps its capacity across frames */
+    using FrameEvents = std::vector<SDL_Event>;
 
     FrameEvents frame_events;
+    /** posted from any thread, moved to frame_events at the start of
+     * the frame */
+    quickgui::mpsc_queue<SDL_Event> posted_events;
 
-    GuiState() : frame_events() {}
+    GuiState() : frame_events(), posted_events() { frame_events.reserve(64); }
 
     void iter_events(quickgui::GuiEventHandler fn, void *data)
     {
@@ -76,9 +105,44 @@ struct GuiState
         }
     }
 
+    /** consecutive motion events of the same mouse or finger are
+     * merged into one, with the accumulated relative motion */
     void push_event(SDL_Event const& event)
     {
-        frame_events.emplace_back(event);
+        if(!frame_events.empty() && frame_events.back().type == event.type)
+        {
+            SDL_Event &prev = frame_events.back();
+            if(event.type == SDL_MOUSEMOTION
+               && prev.motion.windowID == event.motion.windowID
+               && prev.motion.which == event.motion.which)
+            {
+                const int32_t xrel = prev.motion.xrel + event.motion.xrel;
+                const int32_t yrel = prev.motion.yrel + event.motion.yrel;
+                prev.motion = event.motion;
+                prev.motion.xrel = xrel;
+                prev.motion.yrel = yrel;
+                return;
+            }
+            else if(event.type == SDL_FINGERMOTION
+                    && prev.tfinger.touchId == event.tfinger.touchId
+                    && prev.tfinger.fingerId == event.tfinger.fingerId)
+            {
+                const float dx = prev.tfinger.dx + event.tfinger.dx;
+                const float dy = prev.tfinger.dy + event.tfinger.dy;
+                prev.tfinger = event.tfinger;
+                prev.tfinger.dx = dx;
+                prev.tfinger.dy = dy;
+                return;
+            }
+        }
+        frame_events.push_back(event);
+    }
+
+    void push_posted_events()
+    {
+        SDL_Event event;
+        while(posted_events.pop(&event))
+            frame_events.push_back(event);
     }
 
     void clear_events()
@@ -87,10 +151,846 @@ struct GuiState
     }
 };
 
+/** waits at the start of each frame to cap the frame rate. Sleeps
+ * until shortly before the deadline, and then spins, as the sleep
+ * alone overshoots by up to a scheduler tick. */
+struct FrameLimiter
+{
+    duration   period = {};
+    duration   spin = {};
+    time_point next = {};
+
+    void reset(float fps, float spin_ms)
+    {
+        period = fps > 0.f ? from_hz(fps) : duration{};
+        spin = msecs(spin_ms > 0.f ? spin_ms : 0.f);
+        next = now();
+    }
+
+    void wait()
+    {
+        if(period.count() == 0)
+            return;
+        time_point t = now();
+        if(t < next)
+        {
+            if(next - t > spin)
+                sleep_until(next - spin);
+            t = busy_wait_until(next);
+        }
+        // do not try to catch up after a long frame
+        next = (t - next < period) ? next + period : t + period;
+    }
+};
+
+/** with lazy rendering, blocks at the start of the frame while there
+ * is nothing to redraw. imgui needs a few frames to settle after an
+ * input (eg hover highlights, opening popups), so those are drawn
+ * too. */
+struct IdleWait
+{
+    enum : uint32_t { settle_frames = 3 };
+
+    bool              enabled = false;
+    duration          heartbeat = {};
+    time_point        last_frame = {};
+    uint32_t          pending_frames = 0;
+    uint32_t          wake_event = 0; // SDL user event, to wake up from another thread
+    std::atomic<bool> invalidated = {false};
+
+    /** call after SDL_Init() */
+    void reset(bool enable, float heartbeat_hz)
+    {
+        enabled = enable;
+        heartbeat = heartbeat_hz > 0.f ? from_hz(heartbeat_hz) : duration{};
+        last_frame = now();
+        pending_frames = settle_frames;
+        invalidated = false;
+        if(enabled && !wake_event)
+        {
+            const uint32_t ev = SDL_RegisterEvents(1);
+            wake_event = (ev != (uint32_t)-1) ? ev : 0;
+        }
+    }
+
+    void invalidate()
+    {
+        // push a single wake event per frame
+        if(!invalidated.exchange(true) && enabled && wake_event)
+        {
+            SDL_Event event = {};
+            event.type = wake_event;
+            SDL_PushEvent(&event);
+        }
+    }
+
+    void wait()
+    {
+        if(!enabled)
+            return;
+        if(pending_frames == 0 && !invalidated.load() && !g_SwapChainRebuild)
+        {
+            // do not remove the event from the queue: it is polled
+            // afterwards with the others
+            if(heartbeat.count() == 0)
+            {
+                SDL_WaitEvent(nullptr);
+            }
+            else
+            {
+                const time_point t = now();
+                if(t < last_frame + heartbeat)
+                    SDL_WaitEventTimeout(nullptr, (int)std::chrono::ceil<std::chrono::milliseconds>(last_frame + heartbeat - t).count());
+            }
+        }
+        if(pending_frames)
+            --pending_frames;
+        invalidated = false;
+        last_frame = now();
+    }
+
+    void on_event(SDL_Event const& event)
+    {
+        if(event.type != wake_event)
+            pending_frames = settle_frames;
+    }
+};
+
+/** the gui font, rasterized once per prebaked scale. The atlas is
+ * loaded from the cache when possible. */
+struct Fonts
+{
+    String             ttf_data; // empty for the imgui default font
+    float              size = 0.f;
+    std::vector<float> scales;
+    String             cache_dir;
+    float              scale = 1.f;
+
+    void reset(GuiConfig const& cfg)
+    {
+        ttf_data.clear();
+        if(!cfg.font_file.empty())
+        {
+            if(c4::fs::file_exists(cfg.font_file.c_str()))
+                ttf_data = c4::fs::file_get_contents<String>(cfg.font_file.c_str());
+            else
+                QUICKGUI_LOGF("font file not found, using the default: {}", c4::to_csubstr(cfg.font_file));
+        }
+        size = cfg.font_size;
+        scales = cfg.font_prebaked_scales;
+        if(scales.empty())
+            scales.push_back(1.f);
+        scale = cfg.font_scale > 0.f ? cfg.font_scale : 1.f;
+        cache_dir = cfg.font_cache_dir;
+        if(cache_dir.empty())
+        {
+            char *pref_path = SDL_GetPrefPath("quickgui", "font_cache");
+            if(pref_path)
+            {
+                cache_dir = pref_path;
+                SDL_free(pref_path);
+            }
+        }
+    }
+
+    /** requires the imgui context */
+    void acquire()
+    {
+        ImGuiIO &io = ImGui::GetIO();
+        if(io.Fonts->Fonts.empty())
+        {
+            FontAtlasSpec spec = {};
+            spec.ttf_data = {ttf_data.data(), ttf_data.size()};
+            spec.size = size;
+            spec.scales = {scales.data(), scales.size()};
+            font_atlas_acquire(io.Fonts, spec, cache_dir.c_str());
+        }
+        set_scale(scale);
+    }
+
+    void set_scale(float s)
+    {
+        C4_CHECK(s > 0.f);
+        scale = s;
+        ImGuiIO &io = ImGui::GetIO();
+        if(io.Fonts->Fonts.Size != (int)scales.size())
+            return; // not acquired yet, or the fonts were changed by the user
+        size_t closest = 0;
+        for(size_t i : irange(scales.size()))
+            if(std::fabs(scales[i] - s) < std::fabs(scales[closest] - s))
+                closest = i;
+        io.FontDefault = io.Fonts->Fonts[(int)closest];
+        io.FontGlobalScale = s / scales[closest];
+    }
+};
+
+/** records and submits the frames in a separate thread, so that the
+ * application can go on with the next frame meanwhile. The draw data
+ * is deep-copied to snapshots, whose buffers are reused across
+ * frames. At most depth frames are queued: ending a frame blocks
+ * while the queue is full. */
+struct RenderThread
+{
+    enum : uint32_t { max_depth = 2 };
+
+    struct Snapshot
+    {
+        ImDrawData            draw_data;
+        ImVector<ImDrawList*> lists; // owned, reused
+        rhi::FrameSubmit      submit;
+        bool                  present = true;
+
+        void copy(ImDrawData const* src)
+        {
+            while(lists.Size < src->CmdListsCount)
+                lists.push_back(IM_NEW(ImDrawList)(ImGui::GetDrawListSharedData()));
+            draw_data.Clear();
+            draw_data.Valid = src->Valid;
+            draw_data.CmdListsCount = src->CmdListsCount;
+            draw_data.TotalIdxCount = src->TotalIdxCount;
+            draw_data.TotalVtxCount = src->TotalVtxCount;
+            draw_data.DisplayPos = src->DisplayPos;
+            draw_data.DisplaySize = src->DisplaySize;
+            draw_data.FramebufferScale = src->FramebufferScale;
+            draw_data.OwnerViewport = src->OwnerViewport;
+            draw_data.CmdLists.resize(src->CmdListsCount);
+            for(int i = 0; i < src->CmdListsCount; ++i)
+            {
+                ImDrawList const* sl = src->CmdLists[i];
+                ImDrawList *dl = lists[i];
+                _copy(dl->CmdBuffer, sl->CmdBuffer);
+                _copy(dl->IdxBuffer, sl->IdxBuffer);
+                _copy(dl->VtxBuffer, sl->VtxBuffer);
+                dl->Flags = sl->Flags;
+                draw_data.CmdLists[i] = dl;
+            }
+        }
+        template<class T>
+        static void _copy(ImVector<T> &dst, ImVector<T> const& src)
+        {
+            dst.resize(src.Size); // does not shrink the capacity
+            if(src.Size)
+                memcpy(dst.Data, src.Data, (size_t)src.Size * sizeof(T));
+        }
+        void destroy()
+        {
+            for(ImDrawList *dl : lists)
+                IM_DELETE(dl);
+            lists.clear();
+            draw_data.Clear();
+        }
+    };
+
+    Snapshot                slots[max_depth];
+    uint32_t                depth = 0; ///< 0 when there is no thread
+    uint32_t                first = 0;
+    uint32_t                pending = 0; ///< queued or being rendered
+    bool                    quit = false;
+    bool                    needs_rebuild = false;
+    std::mutex              mutex;
+    std::condition_variable cv;
+    std::thread             thread;
+
+    void start(uint32_t depth_)
+    {
+        depth = depth_ < max_depth ? depth_ : (uint32_t)max_depth;
+        first = pending = 0;
+        quit = needs_rebuild = false;
+        if(depth)
+            thread = std::thread(&RenderThread::run, this);
+    }
+
+    void stop()
+    {
+        if(!depth)
+            return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            quit = true;
+        }
+        cv.notify_all();
+        thread.join();
+        for(Snapshot &slot : slots)
+            slot.destroy();
+        depth = 0;
+    }
+
+    /** wait until all the queued frames were submitted */
+    void drain()
+    {
+        if(!depth)
+            return;
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this]{ return pending == 0; });
+    }
+
+    /** blocks while the queue is full */
+    Snapshot& next_slot()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this]{ return pending < depth; });
+        return slots[(first + pending) % depth];
+    }
+
+    void push()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++pending;
+        }
+        cv.notify_all();
+    }
+
+    /** whether a present found the swapchain out of date */
+    bool take_rebuild()
+    {
+        if(!depth)
+            return false;
+        std::lock_guard<std::mutex> lock(mutex);
+        const bool ret = needs_rebuild;
+        needs_rebuild = false;
+        return ret;
+    }
+
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while(true)
+        {
+            cv.wait(lock, [this]{ return pending || quit; });
+            if(!pending)
+                return;
+            Snapshot &slot = slots[first];
+            lock.unlock();
+            FrameRender(&g_MainWindowData, &slot.draw_data, &slot.submit);
+            const bool rebuild = slot.present && FramePresent(&g_MainWindowData, slot.submit);
+            lock.lock();
+            needs_rebuild |= rebuild;
+            first = (first + 1) % depth;
+            --pending;
+            cv.notify_all();
+        }
+    }
+};
+
+/** expand in place num_pixels rgb pixels, at the start of data, into
+ * opaque rgba pixels. data must have room for the rgba pixels. */
+template<class T>
+void expand_rgb_to_rgba(T *data, size_t num_pixels, T alpha)
+{
+    // backwards: each rgba pixel ends after the rgb pixel it comes from
+    for(size_t i = num_pixels; i > 0; --i)
+    {
+        T const* rgb = data + 3 * (i - 1);
+        T *rgba = data + 4 * (i - 1);
+        const T r = rgb[0], g = rgb[1], b = rgb[2];
+        rgba[0] = r;
+        rgba[1] = g;
+        rgba[2] = b;
+        rgba[3] = alpha;
+    }
+}
+static void expand_rgb_to_rgba(char *data, size_t num_pixels, imgviewtype::data_type_e type)
+{
+    switch(type)
+    {
+    case imgviewtype::u8:  expand_rgb_to_rgba((uint8_t *)data, num_pixels, UINT8_MAX); break;
+    case imgviewtype::i8:  expand_rgb_to_rgba((int8_t  *)data, num_pixels, INT8_MAX); break;
+    case imgviewtype::u16: expand_rgb_to_rgba((uint16_t*)data, num_pixels, UINT16_MAX); break;
+    case imgviewtype::i16: expand_rgb_to_rgba((int16_t *)data, num_pixels, INT16_MAX); break;
+    case imgviewtype::u32: expand_rgb_to_rgba((uint32_t*)data, num_pixels, UINT32_MAX); break;
+    case imgviewtype::i32: expand_rgb_to_rgba((int32_t *)data, num_pixels, INT32_MAX); break;
+    case imgviewtype::f32: expand_rgb_to_rgba((float   *)data, num_pixels, 1.f); break;
+    default: C4_ERROR("unsupported data type"); break;
+    }
+}
+
+/** streams the pages of gui_load_image_2d_array_tiff() into the
+ * layers of the image: a worker thread reads consecutive pages into a
+ * chunk, and the chunk is uploaded with the other images when the
+ * frame ends. At most num_chunks chunks exist at a time, so that the
+ * memory is bounded regardless of the size of the stack. */
+struct StackLoader
+{
+    static constexpr const size_t chunk_bytes = size_t(64) << 20; ///< or one page, if larger
+    static constexpr const size_t num_chunks = 2;
+
+    struct Stack
+    {
+        TiffFile      tiff;
+        String        filename;
+        rhi::image_id img_id = {};
+        uint32_t      num_pages = 0;
+        uint32_t      num_channels = 0; ///< of the image: 4 when the rgb pages are expanded
+        size_t        layer_bytes = 0;
+        uint32_t      num_uploaded = 0; // owned by the gui thread
+        bool          failed = false;   // owned by the gui thread
+        // guarded by the mutex
+        uint32_t      next_page = 0;
+        uint32_t      num_chunks = 0; ///< being read or waiting for the upload
+        bool          queued = true;  ///< has pages left to read
+        bool          cancelled = false;
+    };
+    struct Chunk
+    {
+        Stack   *stack = nullptr;
+        uint32_t first_layer = 0;
+        uint32_t num_layers = 0;
+        bool     ok = false; // written by the worker
+        String   data;
+    };
+
+    std::thread              thread;
+    std::mutex               mutex;
+    std::condition_variable  cv;
+    bool                     quit = false;
+    std::deque<Stack*>       queue;       // guarded by the mutex
+    std::vector<Chunk*>      free_chunks; // guarded by the mutex
+    quickgui::mpsc_queue<Chunk*> filled;  // pushed by the worker
+    // owned by the gui thread
+    std::vector<Stack*>      stacks;
+    std::vector<Chunk*>      ready;
+    Chunk                   *collected = nullptr;
+
+    ~StackLoader()
+    {
+        stop();
+    }
+
+    void request(Stack *s)
+    {
+        if(!thread.joinable())
+        {
+            quit = false;
+            for(size_t i = 0; i < num_chunks; ++i)
+                free_chunks.push_back(new Chunk);
+            thread = std::thread([this]{ run(); });
+        }
+        stacks.push_back(s);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queue.push_back(s);
+        }
+        cv.notify_one();
+    }
+
+    Stack* find(rhi::image_id id) const
+    {
+        for(Stack *s : stacks)
+            if(s->img_id == id)
+                return s;
+        return nullptr;
+    }
+
+    void cancel(rhi::image_id id)
+    {
+        Stack *s = find(id);
+        if(!s)
+            return;
+        std::lock_guard<std::mutex> lock(mutex);
+        s->cancelled = true;
+        if(s->queued)
+        {
+            queue.erase(std::find(queue.begin(), queue.end(), s));
+            s->queued = false;
+        }
+        if(!s->num_chunks) // the worker no longer uses it
+        {
+            stacks.erase(std::find(stacks.begin(), stacks.end(), s));
+            delete s;
+        }
+    }
+
+    void stop()
+    {
+        if(thread.joinable())
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                quit = true;
+            }
+            cv.notify_all();
+            thread.join();
+        }
+        Chunk *c;
+        while(filled.pop(&c))
+            delete c;
+        for(Chunk *r : ready)
+            delete r;
+        for(Chunk *f : free_chunks)
+            delete f;
+        for(Stack *s : stacks)
+            delete s;
+        ready.clear();
+        free_chunks.clear();
+        stacks.clear();
+        queue.clear();
+    }
+
+    void run()
+    {
+        while(true)
+        {
+            Stack *s = nullptr;
+            Chunk *c = nullptr;
+            size_t layer_bytes = 0;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [this]{ return quit || (!queue.empty() && !free_chunks.empty()); });
+                if(quit)
+                    return;
+                s = queue.front();
+                c = free_chunks.back();
+                free_chunks.pop_back();
+                layer_bytes = s->layer_bytes;
+                const size_t pages_left = s->num_pages - s->next_page;
+                c->stack = s;
+                c->first_layer = s->next_page;
+                c->num_layers = (uint32_t)std::clamp(chunk_bytes / layer_bytes, size_t(1), pages_left);
+                s->next_page += c->num_layers;
+                ++s->num_chunks;
+                if(s->next_page == s->num_pages)
+                {
+                    queue.pop_front();
+                    s->queued = false;
+                }
+            }
+            c->data.resize(c->num_layers * layer_bytes);
+            c->ok = true;
+            TiffPage const& page = s->tiff.pages[0];
+            for(uint32_t i = 0; i < c->num_layers && c->ok; ++i)
+            {
+                char *layer = &c->data[i * layer_bytes];
+                c->ok = s->tiff.read_page(c->first_layer + i, layer);
+                if(c->ok && s->num_channels != page.samples_per_pixel)
+                    expand_rgb_to_rgba(layer, (size_t)page.width * page.height, page.data_type());
+            }
+            if(!c->ok)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if(s->queued) // do not read the rest
+                {
+                    queue.erase(std::find(queue.begin(), queue.end(), s));
+                    s->queued = false;
+                }
+            }
+            filled.push(c);
+            gui_invalidate(); // wake up a lazy frame
+        }
+    }
+
+    /** add the upload request of at most one chunk that is ready, so
+     * that a frame does not upload more than a chunk of the stacks.
+     * Call from the gui thread, followed by uploaded()
+     * @return the bytes of the request */
+    size_t collect(std::vector<rhi::UploadRequest> *reqs)
+    {
+        Chunk *c;
+        while(filled.pop(&c))
+            ready.push_back(c);
+        collected = nullptr;
+        for(Chunk *r : ready)
+        {
+            if(!r->ok || r->stack->cancelled)
+                continue;
+            TiffPage const& page = r->stack->tiff.pages[0];
+            rhi::UploadRequest req;
+            req.img_id = r->stack->img_id;
+            req.data = {r->data.data(), r->data.size()};
+            req.first_layer = r->first_layer;
+            req.num_layers = r->num_layers;
+            // the image was cleared when created, and is in its
+            // sampled layout: upload as a sub-rect of the whole layer
+            req.extent = {page.width, page.height};
+            reqs->push_back(req);
+            collected = r;
+            return r->data.size();
+        }
+        return 0;
+    }
+
+    /** recycle the chunk given by collect() and the chunks that failed
+     * or were cancelled, and release the stacks that are complete */
+    void uploaded()
+    {
+        const auto done = [this](Chunk const* r){
+            return r == collected || !r->ok || r->stack->cancelled;
+        };
+        if(std::none_of(ready.begin(), ready.end(), done))
+            return;
+        for(Chunk *r : ready)
+        {
+            Stack *s = r->stack;
+            if(r == collected)
+                s->num_uploaded += r->num_layers;
+            if(!r->ok && !s->cancelled && !s->failed)
+            {
+                QUICKGUI_LOGF("could not load image: {}: {}", c4::to_csubstr(s->filename), c4::to_csubstr(s->tiff.error()));
+                s->failed = true;
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for(size_t i = 0; i < ready.size(); )
+            {
+                Chunk *r = ready[i];
+                if(!done(r))
+                {
+                    ++i;
+                    continue;
+                }
+                --r->stack->num_chunks;
+                r->stack = nullptr;
+                free_chunks.push_back(r);
+                ready.erase(ready.begin() + (std::ptrdiff_t)i);
+            }
+            collected = nullptr;
+            // the worker no longer uses these. The failed stacks are
+            // kept to report the error, until they are cancelled
+            for(size_t i = 0; i < stacks.size(); )
+            {
+                Stack *s = stacks[i];
+                if(!s->queued && !s->num_chunks && (!s->failed || s->cancelled))
+                {
+                    delete s;
+                    stacks.erase(stacks.begin() + (std::ptrdiff_t)i);
+                }
+                else
+                {
+                    ++i;
+                }
+            }
+            if(stacks.empty()) // release the memory
+                for(Chunk *f : free_chunks)
+                    f->data = String();
+        }
+        cv.notify_one();
+    }
+};
+
+/** reads and decodes the images of GuiImage::load_async() in worker
+ * threads. The decoded images are uploaded from the gui thread when
+ * the frame ends, in a single batch through the rhi staging buffer,
+ * together with the pixels added to the atlases. The jobs are
+ * recycled, keeping the capacity of their file buffers. */
+struct ImageLoader
+{
+    /** at least one image is uploaded per frame, but no more than this
+     * unless it is the first, so that a folder of large images is
+     * spread over several frames */
+    static constexpr const size_t max_upload_bytes = size_t(64) << 20;
+
+    struct Job
+    {
+        String             filename;
+        GuiImage          *img = nullptr; // null when cancelled
+        rhi::sampler_id    sampler = {};
+        bool               mipmaps = false;
+        GuiImage::LoadedFn on_loaded = nullptr;
+        void              *on_loaded_data = nullptr;
+        String             file_contents;
+        stb_image_data     pixels;
+        bool               ok = false; // written by the worker
+    };
+
+    std::vector<std::thread> threads;
+    std::mutex               mutex;
+    std::condition_variable  cv;
+    std::deque<Job*>         requests; // guarded by the mutex
+    bool                     quit = false;
+    quickgui::mpsc_queue<Job*> decoded;  // pushed by the workers
+    // owned by the gui thread
+    std::vector<Job*>        jobs;     // requested and not yet finished
+    std::vector<Job*>        ready;    // decoded and waiting for the upload
+    std::vector<Job*>        free_jobs;
+    std::vector<rhi::UploadRequest> upload_reqs;
+    std::vector<GuiImageAtlas*> atlases;
+    StackLoader              stacks;
+
+    ~ImageLoader()
+    {
+        stop();
+    }
+
+    void request(GuiImage *img, const char *filename, rhi::sampler_id sampler, GuiImage::LoadedFn fn, void *data)
+    {
+        if(threads.empty())
+        {
+            const unsigned hw = std::thread::hardware_concurrency();
+            const unsigned num_threads = hw > 2u ? std::min(hw - 1u, 4u) : 1u;
+            quit = false;
+            for(unsigned i = 0; i < num_threads; ++i)
+                threads.emplace_back([this]{ run(); });
+        }
+        Job *job = nullptr;
+        if(free_jobs.empty())
+        {
+            job = new Job;
+        }
+        else
+        {
+            job = free_jobs.back();
+            free_jobs.pop_back();
+        }
+        job->filename = filename;
+        job->img = img;
+        job->sampler = sampler;
+        job->mipmaps = img->mipmaps;
+        job->on_loaded = fn;
+        job->on_loaded_data = data;
+        job->ok = false;
+        jobs.push_back(job);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            requests.push_back(job);
+        }
+        cv.notify_one();
+    }
+
+    void cancel(GuiImage const* img)
+    {
+        for(Job *job : jobs)
+            if(job->img == img)
+                job->img = nullptr;
+    }
+
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            quit = true;
+            requests.clear(); // the jobs are owned by the gui thread
+        }
+        cv.notify_all();
+        for(std::thread &t : threads)
+            t.join();
+        threads.clear();
+        Job *job;
+        while(decoded.pop(&job))
+            ;
+        for(Job *j : jobs)
+        {
+            if(j->img)
+                j->img->async_status = GuiImage::async_none;
+            delete j;
+        }
+        for(Job *j : free_jobs)
+            delete j;
+        stacks.stop();
+        jobs.clear();
+        ready.clear();
+        free_jobs.clear();
+    }
+
+    void run()
+    {
+        while(true)
+        {
+            Job *job = nullptr;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [this]{ return quit || !requests.empty(); });
+                if(quit)
+                    return;
+                job = requests.front();
+                requests.pop_front();
+            }
+            job->ok = c4::fs::file_exists(job->filename.c_str())
+                && c4::fs::file_get_contents(job->filename.c_str(), &job->file_contents)
+                && job->pixels.try_load({job->file_contents.data(), job->file_contents.size()}, RequiredChannels::four);
+            decoded.push(job);
+            gui_invalidate(); // wake up a lazy frame
+        }
+    }
+
+    /** create and upload the decoded images. Call from the gui thread
+     * while the frame is recording. */
+    void upload(rhi::Rhi &r)
+    {
+        Job *job;
+        while(decoded.pop(&job))
+            ready.push_back(job);
+        // the staging buffer is used once per frame: when it was
+        // already used by this frame, try again in the next
+        if(r.m_upload_buffer_in_use)
+            return;
+        upload_reqs.clear();
+        for(GuiImageAtlas const* atlas : atlases)
+            atlas->_collect(&upload_reqs);
+        // the stack chunk counts in the budget of the frame
+        size_t num_bytes = stacks.collect(&upload_reqs);
+        const size_t num_other_reqs = upload_reqs.size();
+        if(ready.empty() && !num_other_reqs)
+        {
+            stacks.uploaded(); // recycle the chunks that failed or were cancelled
+            return;
+        }
+        size_t num_taken = 0;
+        for( ; num_taken < ready.size(); ++num_taken)
+        {
+            Job *j = ready[num_taken];
+            if(!j->img || !j->ok)
+                continue;
+            if(num_bytes && num_bytes + j->pixels.data_size() > max_upload_bytes)
+                break;
+            rhi::ImageLayout layout = stb_layout(j->pixels);
+            if(j->mipmaps)
+                (void)r.with_mips(&layout);
+            rhi::UploadRequest req;
+            req.img_id = r.make_image(layout.to_vk());
+            req.data = j->pixels.to_span();
+            r.set_name(req.img_id, j->filename.c_str());
+            upload_reqs.push_back(req);
+            num_bytes += j->pixels.data_size();
+        }
+        if(!upload_reqs.empty())
+        {
+            r.upload_images({upload_reqs.data(), upload_reqs.size()}, r.usr_cmd_buffer());
+            r.mark_usr_cmd_buffer();
+        }
+        for(GuiImageAtlas *atlas : atlases)
+            atlas->_uploaded();
+        stacks.uploaded();
+        size_t curr_req = num_other_reqs;
+        for(size_t i : irange(num_taken))
+        {
+            Job *j = ready[i];
+            if(GuiImage *img = j->img)
+            {
+                if(j->ok)
+                {
+                    img->img_id = upload_reqs[curr_req++].img_id;
+                    img->view_id = r.make_image_view(r.get_image(img->img_id), 0);
+                    r.set_name(img->view_id, j->filename.c_str());
+                    img->_add_texture(j->sampler);
+                    img->async_status = GuiImage::async_done;
+                }
+                else
+                {
+                    QUICKGUI_LOGF("could not load image: {}", c4::to_csubstr(j->filename));
+                    img->async_status = GuiImage::async_failed;
+                }
+                if(j->on_loaded)
+                    j->on_loaded(img, j->ok, j->on_loaded_data);
+            }
+            j->pixels.clear();
+            jobs.erase(std::find(jobs.begin(), jobs.end(), j));
+            free_jobs.push_back(j);
+        }
+        ready.erase(ready.begin(), ready.begin() + (std::ptrdiff_t)num_taken);
+    }
+};
+
 } // namespace quickgui::gui
 
 static std::aligned_storage_t<sizeof(quickgui::gui::GuiState), alignof(quickgui::gui::GuiState)> g_gui_state_buf;
 quickgui::gui::GuiState  &g_gui_state = reinterpret_cast<quickgui::gui::GuiState&>(g_gui_state_buf);
+quickgui::gui::FrameLimiter g_frame_limiter;
+quickgui::gui::IdleWait     g_idle_wait;
+quickgui::gui::Fonts        g_fonts;
+quickgui::gui::RenderThread g_render_thread;
+quickgui::gui::ImageLoader  g_image_loader;
+quickgui::rhi::FrameSubmit  g_frame_submit; // when there is no render thread
 
 
 //-----------------------------------------------------------------------------
@@ -323,6 +1223,90 @@ rhi::image_id load_image_2d_rgba(const char *filename, rhi::Rhi *r, VkCommandBuf
     return load_image_2d_rgba(filename, file_contents, r, cmd);
 }
 
+gui_image gui_load_image_2d_array_tiff(const char *filename)
+{
+    auto *s = new gui::StackLoader::Stack;
+    s->filename = filename;
+    if(!s->tiff.open(filename))
+    {
+        QUICKGUI_LOGF("could not load image: {}: {}", c4::to_csubstr(filename), c4::to_csubstr(s->tiff.error()));
+        delete s;
+        return {};
+    }
+    TiffPage const& first = s->tiff.pages[0];
+    for(TiffPage const& page : s->tiff.pages)
+    {
+        if(!page.same_layout(first))
+        {
+            QUICKGUI_LOGF("could not load image: {}: the pages have different sizes or formats", c4::to_csubstr(filename));
+            delete s;
+            return {};
+        }
+    }
+    s->num_pages = (uint32_t)s->tiff.pages.size();
+    if(s->num_pages > rhi::vk_max_image_array_layers())
+    {
+        QUICKGUI_LOGF("could not load image: {}: {} pages, but the device supports at most {} layers", c4::to_csubstr(filename), s->num_pages, rhi::vk_max_image_array_layers());
+        delete s;
+        return {};
+    }
+    // the rgb formats can seldom be sampled: expand the pages to rgba
+    // when they are read
+    const imgviewtype::data_type_e type = first.data_type();
+    s->num_channels = first.samples_per_pixel;
+    VkFormat format = imgview_format(type, s->num_channels);
+    if(s->num_channels == 3 && !rhi::vk_format_supports_filtering(format))
+    {
+        s->num_channels = 4;
+        format = imgview_format(type, s->num_channels);
+    }
+    // eg the 32 bit integers cannot be filtered
+    if(!rhi::vk_format_supports_filtering(format))
+    {
+        QUICKGUI_LOGF("could not load image: {}: the device cannot sample {} pages with {} channels", c4::to_csubstr(filename), c4::to_csubstr(imgviewtype::to_str(type)), first.samples_per_pixel);
+        delete s;
+        return {};
+    }
+    s->layer_bytes = (size_t)first.width * first.height * s->num_channels * imgviewtype::data_size(type);
+    rhi::ImageLayout layout = rhi::ImageLayout::make_2d(format, first.width, first.height);
+    layout.depth = s->num_pages;
+    s->img_id = rhi::g_rhi.make_image(layout.to_vk());
+    rhi::g_rhi.set_name(s->img_id, filename);
+    // clear, so that the layers show black until they are loaded
+    rhi::Image const& img = rhi::g_rhi.get_image(s->img_id);
+    VkCommandBuffer cmd = rhi::g_rhi.usr_cmd_buffer();
+    rhi::image_barrier(cmd, img,
+                       VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0,
+                       VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+    const VkClearColorValue black = {};
+    VkImageSubresourceRange range = {};
+    range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    range.levelCount = VK_REMAINING_MIP_LEVELS;
+    range.layerCount = VK_REMAINING_ARRAY_LAYERS;
+    vkCmdClearColorImage(cmd, img.handle, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &black, 1, &range);
+    rhi::image_barrier(cmd, img,
+                       VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+                       layout.sampled_layout(), VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT|VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+    rhi::g_rhi.mark_usr_cmd_buffer();
+    QUICKGUI_LOGF("streaming image: {}: {}x{}, {} pages", c4::to_csubstr(filename), first.width, first.height, s->num_pages);
+    const rhi::image_id id = s->img_id;
+    g_image_loader.stacks.request(s);
+    return id;
+}
+
+float gui_image_load_progress(gui_image img)
+{
+    gui::StackLoader::Stack const* s = g_image_loader.stacks.find(img);
+    if(!s)
+        return 1.f;
+    return s->failed ? -1.f : (float)s->num_uploaded / (float)s->num_pages;
+}
+
+void gui_image_load_cancel(gui_image img)
+{
+    g_image_loader.stacks.cancel(img);
+}
+
 
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
@@ -331,40 +1315,81 @@ rhi::image_id load_image_2d_rgba(const char *filename, rhi::Rhi *r, VkCommandBuf
 
 bool gui_init(GuiConfig const& cfg)
 {
+    g_init_time = now();
+    g_first_frame_done = false;
     new (&g_gui_state) gui::GuiState();
+    g_Offscreen = cfg.offscreen;
+    switch(cfg.present_mode)
+    {
+    case GuiConfig::present_mailbox: g_PresentMode = VK_PRESENT_MODE_MAILBOX_KHR; break;
+    case GuiConfig::present_immediate: g_PresentMode = VK_PRESENT_MODE_IMMEDIATE_KHR; break;
+    default: g_PresentMode = VK_PRESENT_MODE_FIFO_KHR; break;
+    }
+    g_FramesInFlight = cfg.frames_in_flight;
+    g_RenderThreadDepth = cfg.render_thread_depth < (uint32_t)gui::RenderThread::max_depth ? cfg.render_thread_depth : (uint32_t)gui::RenderThread::max_depth;
+    g_frame_limiter.reset(cfg.target_fps, cfg.frame_limiter_spin_ms);
 
-    if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_TIMER | SDL_INIT_GAMECONTROLLER) != 0)
+    if (SDL_Init(g_Offscreen ? SDL_INIT_TIMER : (SDL_INIT_VIDEO | SDL_INIT_TIMER | SDL_INIT_GAMECONTROLLER)) != 0)
         C4_ERROR("SDL init error: %s", SDL_GetError());
+    g_idle_wait.reset(cfg.lazy_rendering && !g_Offscreen, cfg.idle_heartbeat_hz);
+    g_fonts.reset(cfg);
 
     // Setup SDL window
     const char* window_name = cfg.window_name.c_str();
     int window_width = cfg.window_width ? (int)cfg.window_width : 1280;
     int window_height = cfg.window_height ? (int)cfg.window_height :  720;
-    SDL_WindowFlags window_flags = (SDL_WindowFlags)(SDL_WINDOW_VULKAN | SDL_WINDOW_RESIZABLE | SDL_WINDOW_ALLOW_HIGHDPI);
-    g_window = SDL_CreateWindow(window_name, SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
-                                window_width, window_height, window_flags);
+    if(!g_Offscreen)
+    {
+        SDL_WindowFlags window_flags = (SDL_WindowFlags)(SDL_WINDOW_VULKAN | SDL_WINDOW_RESIZABLE | SDL_WINDOW_ALLOW_HIGHDPI);
+        g_window = SDL_CreateWindow(window_name, SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
+                                    window_width, window_height, window_flags);
+    }
 
     // Setup Vulkan
     reusable_buffer buf;
     uint32_t num_exts = 0;
-    if(!SDL_Vulkan_GetInstanceExtensions(g_window, &num_exts, nullptr))
+    if(!g_Offscreen && !SDL_Vulkan_GetInstanceExtensions(g_window, &num_exts, nullptr))
         C4_ERROR("could not get instance extensions: %s", SDL_GetError());
     const char** exts = buf.reset<const char*>(num_exts + 1);
-    if(!SDL_Vulkan_GetInstanceExtensions(g_window, &num_exts, exts))
+    if(!g_Offscreen && !SDL_Vulkan_GetInstanceExtensions(g_window, &num_exts, exts))
         C4_ERROR("could not get instance extensions: %s", SDL_GetError());
     exts[num_exts] = "VK_EXT_debug_report";
+    g_Allocator = cfg.track_vulkan_host_memory ? rhi::host_alloc_init(cfg.vulkan_transient_arena_size) : nullptr;
     SetupVulkan(exts, num_exts + 1, &buf);
 
-    // Create Window Surface
-    VkSurfaceKHR surface;
-    if (!SDL_Vulkan_CreateSurface(g_window, g_Instance, &surface))
-        C4_ERROR("failed to create Vulkan surface: %s", SDL_GetError());
+    // Setup the pipeline cache. This must be done before creating
+    // any pipeline.
+    {
+        String dir = cfg.pipeline_cache_dir;
+        if(dir.empty())
+        {
+            char *pref_path = SDL_GetPrefPath("quickgui", "pipeline_cache");
+            if(pref_path)
+            {
+                dir = pref_path;
+                SDL_free(pref_path);
+            }
+        }
+        SetupPipelineCache(dir.c_str());
+    }
 
-    // Create Framebuffers
-    int w, h;
-    SDL_GetWindowSize(g_window, &w, &h);
     ImGui_ImplVulkanH_Window* wd = &g_MainWindowData;
-    SetupVulkanWindow(wd, surface, w, h);
+    if(g_Offscreen)
+    {
+        SetupVulkanOffscreen(wd, window_width, window_height);
+    }
+    else
+    {
+        // Create Window Surface
+        VkSurfaceKHR surface;
+        if (!SDL_Vulkan_CreateSurface(g_window, g_Instance, &surface))
+            C4_ERROR("failed to create Vulkan surface: %s", SDL_GetError());
+
+        // Create Framebuffers
+        int w, h;
+        SDL_GetWindowSize(g_window, &w, &h);
+        SetupVulkanWindow(wd, surface, w, h);
+    }
 
     // Setup Dear ImGui context
     IMGUI_CHECKVERSION();
@@ -382,7 +1407,10 @@ bool gui_init(GuiConfig const& cfg)
     //ImPlot::SetColormap(ImPlotColormap_Deep);
 
     // Setup Platform/Renderer backends
-    ImGui_ImplSDL2_InitForVulkan(g_window);
+    if(!g_Offscreen)
+        ImGui_ImplSDL2_InitForVulkan(g_window);
+    else
+        io.DisplaySize = ImVec2((float)window_width, (float)window_height);
     ImGui_ImplVulkan_InitInfo init_info = {};
     init_info.Instance = g_Instance;
     init_info.PhysicalDevice = g_PhysicalDevice;
@@ -394,34 +1422,46 @@ bool gui_init(GuiConfig const& cfg)
     init_info.Allocator = g_Allocator;
     init_info.MinImageCount = g_MinImageCount;
     init_info.ImageCount = wd->ImageCount;
+    init_info.BindlessTextureCount = g_BindlessTextureCount;
     init_info.CheckVkResultFn = rhi::check_vk_result;
     ImGui_ImplVulkan_Init(&init_info, wd->RenderPass);
 
     quickgui::rhi::rhi_init();
     gui_acquire_assets();
+    g_render_thread.start(g_RenderThreadDepth);
 
+    QUICKGUI_LOGF("gui_init(): {}ms", fmsecs(now() - g_init_time).count());
     return true;
 }
 
 void gui_wait_idle_rhi()
 {
+    g_render_thread.drain();
     C4_CHECK_VK(vkDeviceWaitIdle(g_Device));
 }
 
 void gui_terminate()
 {
+    g_render_thread.stop();
+    g_RenderThreadDepth = 0;
     gui_release_assets();
     quickgui::rhi::rhi_terminate();
 
     ImGui_ImplVulkan_Shutdown();
-    ImGui_ImplSDL2_Shutdown();
+    if(!g_Offscreen)
+        ImGui_ImplSDL2_Shutdown();
     ImPlot::DestroyContext();
     ImGui::DestroyContext();
 
     CleanupVulkanWindow();
+    CleanupPipelineCache();
     CleanupVulkan();
+    rhi::host_alloc_terminate();
+    g_Allocator = nullptr;
 
-    SDL_DestroyWindow(g_window);
+    if(g_window)
+        SDL_DestroyWindow(g_window);
+    g_window = nullptr;
     SDL_Quit();
     g_gui_state.~GuiState();
 }
@@ -430,31 +1470,26 @@ void gui_terminate()
 void gui_acquire_assets()
 {
     ImGui_ImplVulkanH_Window* wd = &g_MainWindowData;
+    g_render_thread.drain(); // the queue is used below
 
     // Use any command queue
-    VkCommandPool command_pool = wd->Frames[wd->FrameIndex].CommandPool;
-    VkCommandBuffer command_buffer = wd->Frames[wd->FrameIndex].CommandBuffer;
+    ImGui_ImplVulkanH_Frame *fd = &wd->Frames[wd->FrameIndex];
+    VkCommandPool command_pool = fd->CommandPool;
+    VkCommandBuffer command_buffer = fd->CommandBuffer;
 
-    // reset the command buffer
+    // reset the command buffer once the frame's previous work is done
+    C4_CHECK_VK(vkWaitForFences(g_Device, 1, &fd->Fence, VK_TRUE, UINT64_MAX));
+    C4_CHECK_VK(vkResetFences(g_Device, 1, &fd->Fence));
     C4_CHECK_VK(vkResetCommandPool(g_Device, command_pool, 0));
     VkCommandBufferBeginInfo begin_info = {};
     begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
     begin_info.flags |= VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
     C4_CHECK_VK(vkBeginCommandBuffer(command_buffer, &begin_info));
 
-    // Load Fonts
-    // - If no fonts are loaded, dear imgui will use the default font. You can also load multiple fonts and use ImGui::PushFont()/PopFont() to select them.
-    // - AddFontFromFileTTF() will return the ImFont* so you can store it if you need to select the font among multiple.
-    // - If the file cannot be loaded, the function will return NULL. Please handle those errors in your application (e.g. use an assertion, or display an error and quit).
-    // - The fonts will be rasterized at a given size (w/ oversampling) and stored into a texture when calling ImFontAtlas::Build()/GetTexDataAsXXXX(), which ImGui_ImplXXXX_NewFrame below will call.
-    // - Read 'docs/FONTS.md' for more instructions and details.
-    //io.Fonts->AddFontDefault();
-    //io.Fonts->AddFontFromFileTTF("../../misc/fonts/Roboto-Medium.ttf", 16.0f);
-    //io.Fonts->AddFontFromFileTTF("../../misc/fonts/Cousine-Regular.ttf", 15.0f);
-    //io.Fonts->AddFontFromFileTTF("../../misc/fonts/DroidSans.ttf", 16.0f);
-    //io.Fonts->AddFontFromFileTTF("../../misc/fonts/ProggyTiny.ttf", 10.0f);
-    //ImFont* font = io.Fonts->AddFontFromFileTTF("c:\\Windows\\Fonts\\ArialUni.ttf", 18.0f, NULL, io.Fonts->GetGlyphRangesJapanese());
-    //IM_ASSERT(font != NULL);
+    // Load Fonts: the atlas is loaded from the cache, or rasterized
+    // and saved there. The texture upload is not waited for: the
+    // queue runs it before the first frame.
+    g_fonts.acquire();
     ImGui_ImplVulkan_CreateFontsTexture();
 
     g_gui_assets.acquire(command_buffer);
@@ -475,14 +1510,16 @@ void gui_acquire_assets()
     end_info.commandBufferCount = 1;
     end_info.pCommandBuffers = &command_buffer;
     C4_CHECK_VK(vkEndCommandBuffer(command_buffer));
-    C4_CHECK_VK(vkQueueSubmit(g_Queue, 1, &end_info, VK_NULL_HANDLE));
-
-    C4_CHECK_VK(vkDeviceWaitIdle(g_Device));
+    // do not wait: FrameStart() waits for the fence before reusing
+    // this frame
+    C4_CHECK_VK(vkQueueSubmit(g_Queue, 1, &end_info, fd->Fence));
 }
 
 
 void gui_release_assets()
 {
+    // the frames in flight may still use the assets
+    gui_wait_idle_rhi();
     g_gui_assets.release();
 }
 
@@ -491,8 +1528,56 @@ void gui_iter_events(GuiEventHandler fn, void *data)
     g_gui_state.iter_events(fn, data);
 }
 
+void gui_post_event(SDL_Event const& event)
+{
+    g_gui_state.posted_events.push(event);
+    g_idle_wait.invalidate();
+}
+
+void gui_set_target_fps(float fps)
+{
+    g_frame_limiter.reset(fps, fmsecs(g_frame_limiter.spin).count());
+}
+
+void gui_set_font_scale(float scale)
+{
+    g_fonts.set_scale(scale);
+}
+
+float gui_font_scale()
+{
+    return g_fonts.scale;
+}
+
+rhi::SwapchainState gui_swapchain_state()
+{
+    ImGui_ImplVulkanH_Window const& wd = g_MainWindowData;
+    return {(uint32_t)wd.Width, (uint32_t)wd.Height, wd.SurfaceFormat.format, wd.ImageUsage, g_SwapChainRebuild};
+}
+
+void gui_invalidate()
+{
+    g_idle_wait.invalidate();
+}
+
 bool gui_start_frame()
 {
+    g_idle_wait.wait();
+    g_frame_limiter.wait();
+    if(g_Offscreen)
+    {
+        // no platform backend: feed the frame time to imgui
+        const time_point t = now();
+        const float dt = g_first_frame_done ? fsecs(t - g_last_frame_time).count() : 0.f;
+        g_last_frame_time = t;
+        ImGui::GetIO().DeltaTime = dt > 0.f ? dt : 1.f / 60.f;
+        g_gui_state.push_posted_events();
+        ImGui_ImplVulkan_NewFrame();
+        ImGui::NewFrame();
+        FrameStart(&g_MainWindowData);
+        return true;
+    }
+
     // Poll and handle events (inputs, g_window resize, etc.)
     // You can read the io.WantCaptureMouse, io.WantCaptureKeyboard flags to tell if dear imgui wants to use your inputs.
     // - When io.WantCaptureMouse is true, do not dispatch mouse input data to your main application.
@@ -501,6 +1586,7 @@ bool gui_start_frame()
     SDL_Event event;
     while (SDL_PollEvent(&event))
     {
+        g_idle_wait.on_event(event);
         ImGui_ImplSDL2_ProcessEvent(&event);
         if (event.type == SDL_QUIT)
             return false;
@@ -533,17 +1619,25 @@ bool gui_start_frame()
                 break;
             }
         }
+        else if(event.type != g_idle_wait.wake_event)
+        {
+            g_gui_state.push_event(event);
+        }
     }
+    g_gui_state.push_posted_events();
 
+    g_SwapChainRebuild |= g_render_thread.take_rebuild();
     if (g_SwapChainRebuild)
     {
+        g_render_thread.drain();
         int width, height;
         SDL_GetWindowSize(g_window, &width, &height);
         if (width > 0 && height > 0)
         {
+            g_resize_time = now();
+            g_resize_pending = true;
             ImGui_ImplVulkan_SetMinImageCount(g_MinImageCount);
-            ImGui_ImplVulkanH_CreateOrResizeWindow(g_Instance, g_PhysicalDevice, g_Device, &g_MainWindowData, g_QueueFamily, g_Allocator, width, height, g_MinImageCount);
-            g_MainWindowData.FrameIndex = 0;
+            ResizeVulkanWindow(&g_MainWindowData, width, height);
             g_SwapChainRebuild = false;
         }
     }
@@ -570,8 +1664,32 @@ void gui_end_frame(ImVec4 clear_color)
     {
         ImGui_ImplVulkanH_Window* wd = &g_MainWindowData;
         wd->ClearValue.color = to_vk_clear_color(clear_color);
-        FrameRender(wd, draw_data);
-        FramePresent(wd);
+        g_image_loader.upload(rhi::g_rhi);
+        if(g_render_thread.depth)
+        {
+            gui::RenderThread::Snapshot &slot = g_render_thread.next_slot();
+            slot.copy(draw_data);
+            FrameCapture(wd, &slot.submit);
+            slot.present = !g_SwapChainRebuild;
+            g_render_thread.push();
+        }
+        else
+        {
+            FrameCapture(wd, &g_frame_submit);
+            FrameRender(wd, draw_data, &g_frame_submit);
+            if(!g_SwapChainRebuild)
+                g_SwapChainRebuild = FramePresent(wd, g_frame_submit);
+        }
+        if(C4_UNLIKELY(!g_first_frame_done))
+        {
+            g_first_frame_done = true;
+            QUICKGUI_LOGF("time to first frame: {}ms", fmsecs(now() - g_init_time).count());
+        }
+        if(C4_UNLIKELY(g_resize_pending))
+        {
+            g_resize_pending = false;
+            QUICKGUI_LOGF("resize to first frame: {}ms", fmsecs(now() - g_resize_time).count());
+        }
     }
 }
 
@@ -582,11 +1700,49 @@ void gui_end_frame(ImVec4 clear_color)
 
 quickgui::GuiAssets g_gui_assets;
 
+namespace {
+rhi::ImageLayout _gui_image_layout(rhi::ImageLayout layout, bool mipmaps)
+{
+    if(mipmaps && !layout.has_mips())
+        (void)rhi::g_rhi.with_mips(&layout);
+    return layout;
+}
+rhi::image_id _gui_image_load_file(const char *filename, bool mipmaps, VkCommandBuffer cmd_buf, rhi::UploadBuffer *upload_buffer)
+{
+    String buf = c4::fs::file_get_contents<String>(filename);
+    stb_image_data data({buf.data(), buf.size()}, RequiredChannels::four);
+    rhi::ImageLayout layout = _gui_image_layout(stb_layout(data), mipmaps);
+    if(upload_buffer)
+        return load_image_2d_rgba(filename, layout, data.to_span(), &rhi::g_rhi, cmd_buf, upload_buffer);
+    return load_image_2d_rgba(filename, layout, data.to_span(), &rhi::g_rhi, cmd_buf);
+}
+} // namespace
+
+void GuiImage::_add_texture(rhi::sampler_id sampler)
+{
+    VkSampler vk_sampler = rhi::g_rhi.get_sampler(sampler);
+    VkImageView vk_view = rhi::g_rhi.get_image_view(view_id);
+    const VkImageLayout vk_layout = layout().sampled_layout();
+    if(ImGui_ImplVulkan_HasBindlessTextures())
+        tex_index = ImGui_ImplVulkan_AddBindlessTexture(vk_sampler, vk_view, vk_layout);
+    else
+        desc_set = ImGui_ImplVulkan_AddTexture(vk_sampler, vk_view, vk_layout);
+}
+
+ImTextureID GuiImage::tex_id() const
+{
+    if(!resident() && this != &g_gui_assets.placeholder)
+        return g_gui_assets.placeholder.tex_id();
+    if(tex_index != no_tex_index)
+        return ImGui_ImplVulkan_BindlessTextureID(tex_index);
+    return (ImTextureID)desc_set;
+}
+
 void GuiImage::load_existing(rhi::image_id img, rhi::sampler_id sampler)
 {
     img_id = img;
-    view_id = rhi::g_rhi.make_image_view(rhi::g_rhi.get_image(img_id));
-    desc_set = ImGui_ImplVulkan_AddTexture(rhi::g_rhi.get_sampler(sampler), rhi::g_rhi.get_image_view(view_id));
+    view_id = rhi::g_rhi.make_image_view(rhi::g_rhi.get_image(img_id), 0);
+    _add_texture(sampler);
 }
 void GuiImage::load_existing(rhi::image_id img)
 {
@@ -628,49 +1784,77 @@ void GuiImage::load(const char *filename, ccharspan img_data, rhi::sampler_id sa
 
 void GuiImage::load(const char *filename, rhi::sampler_id sampler, VkCommandBuffer cmd_buf)
 {
-    img_id = load_image_2d_rgba(filename, &rhi::g_rhi, cmd_buf);
-    view_id = rhi::g_rhi.make_image_view(rhi::g_rhi.get_image(img_id));
+    img_id = _gui_image_load_file(filename, mipmaps, cmd_buf, nullptr);
+    view_id = rhi::g_rhi.make_image_view(rhi::g_rhi.get_image(img_id), 0);
     rhi::g_rhi.set_name(img_id, filename);
     rhi::g_rhi.set_name(view_id, filename);
-    desc_set = ImGui_ImplVulkan_AddTexture(rhi::g_rhi.get_sampler(sampler), rhi::g_rhi.get_image_view(view_id));
+    _add_texture(sampler);
 }
 void GuiImage::load(const char *filename, rhi::sampler_id sampler, VkCommandBuffer cmd_buf, rhi::UploadBuffer *upload_buffer)
 {
-    img_id = load_image_2d_rgba(filename, &rhi::g_rhi, cmd_buf, upload_buffer);
-    view_id = rhi::g_rhi.make_image_view(rhi::g_rhi.get_image(img_id));
+    img_id = _gui_image_load_file(filename, mipmaps, cmd_buf, upload_buffer);
+    view_id = rhi::g_rhi.make_image_view(rhi::g_rhi.get_image(img_id), 0);
     rhi::g_rhi.set_name(img_id, filename);
     rhi::g_rhi.set_name(view_id, filename);
-    desc_set = ImGui_ImplVulkan_AddTexture(rhi::g_rhi.get_sampler(sampler), rhi::g_rhi.get_image_view(view_id));
+    _add_texture(sampler);
 }
 
 void GuiImage::load(const char *filename, ccharspan img_data, rhi::ImageLayout const& layout, rhi::sampler_id sampler, VkCommandBuffer cmd_buf)
 {
-    img_id = load_image_2d_rgba(filename, layout, img_data, &rhi::g_rhi, cmd_buf);
-    view_id = rhi::g_rhi.make_image_view(rhi::g_rhi.get_image(img_id));
+    img_id = load_image_2d_rgba(filename, _gui_image_layout(layout, mipmaps), img_data, &rhi::g_rhi, cmd_buf);
+    view_id = rhi::g_rhi.make_image_view(rhi::g_rhi.get_image(img_id), 0);
     rhi::g_rhi.set_name(img_id, filename);
     rhi::g_rhi.set_name(view_id, filename);
-    desc_set = ImGui_ImplVulkan_AddTexture(rhi::g_rhi.get_sampler(sampler), rhi::g_rhi.get_image_view(view_id));
+    _add_texture(sampler);
 }
 void GuiImage::load(const char *filename, ccharspan img_data, rhi::ImageLayout const& layout, rhi::sampler_id sampler, VkCommandBuffer cmd_buf, rhi::UploadBuffer *upload_buffer)
 {
-    img_id = load_image_2d_rgba(filename, layout, img_data, &rhi::g_rhi, cmd_buf, upload_buffer);
-    view_id = rhi::g_rhi.make_image_view(rhi::g_rhi.get_image(img_id));
+    img_id = load_image_2d_rgba(filename, _gui_image_layout(layout, mipmaps), img_data, &rhi::g_rhi, cmd_buf, upload_buffer);
+    view_id = rhi::g_rhi.make_image_view(rhi::g_rhi.get_image(img_id), 0);
     rhi::g_rhi.set_name(img_id, filename);
     rhi::g_rhi.set_name(view_id, filename);
-    desc_set = ImGui_ImplVulkan_AddTexture(rhi::g_rhi.get_sampler(sampler), rhi::g_rhi.get_image_view(view_id));
+    _add_texture(sampler);
 }
 
 
+void GuiImage::load_async(const char *filename, LoadedFn on_loaded, void *data)
+{
+    load_async(filename, g_gui_assets.default_sampler, on_loaded, data);
+}
+void GuiImage::load_async(const char *filename, rhi::sampler_id sampler, LoadedFn on_loaded, void *data)
+{
+    destroy();
+    async_status = async_loading;
+    g_image_loader.request(this, filename, sampler, on_loaded, data);
+}
+
 void GuiImage::destroy()
 {
-    if(img_id)
-        rhi::g_rhi.destroy_image(img_id);
+    if(async_status == async_loading)
+        g_image_loader.cancel(this);
+    async_status = async_none;
+    if(atlas) // the texture belongs to the atlas
+        atlas->remove(this);
+    if(desc_set)
+        ImGui_ImplVulkan_RemoveTexture(desc_set);
+    if(tex_index != no_tex_index)
+        ImGui_ImplVulkan_RemoveBindlessTexture(tex_index);
     if(view_id)
         rhi::g_rhi.destroy_image_view(view_id);
+    if(img_id)
+        rhi::g_rhi.destroy_image(img_id);
+    desc_set = {};
+    tex_index = no_tex_index;
+    view_id = {};
+    img_id = {};
 }
 
 ImVec2 GuiImage::size() const
 {
+    if(atlas)
+        return ImVec2((float)atlas_rect.width, (float)atlas_rect.height);
+    if(!img_id)
+        return placeholder_size;
     auto const& rhi_img = rhi::g_rhi.get_image(img_id);
     float w = (float)rhi_img.layout.width;
     float h = (float)rhi_img.layout.height;
@@ -679,6 +1863,10 @@ ImVec2 GuiImage::size() const
 
 ImVec2 GuiImage::size(float scale) const
 {
+    if(atlas)
+        return ImVec2((float)atlas_rect.width * scale, (float)atlas_rect.height * scale);
+    if(!img_id)
+        return ImVec2(placeholder_size.x * scale, placeholder_size.y * scale);
     auto const& rhi_img = rhi::g_rhi.get_image(img_id);
     float w = (float)rhi_img.layout.width;
     float h = (float)rhi_img.layout.height;
@@ -687,64 +1875,206 @@ ImVec2 GuiImage::size(float scale) const
 
 ImVec2 GuiImage::size_with_width(float width, float scale) const
 {
-    auto const& rhi_img = rhi::g_rhi.get_image(img_id);
-    float w = (float)rhi_img.layout.width;
-    float h = (float)rhi_img.layout.height;
+    const ImVec2 sz = size();
+    float w = sz.x;
+    float h = sz.y;
     return ImVec2(width * scale, h * width / w * scale);
 }
 
 ImVec2 GuiImage::size_with_height(float height, float scale) const
 {
-    auto const& rhi_img = rhi::g_rhi.get_image(img_id);
-    float w = (float)rhi_img.layout.width;
-    float h = (float)rhi_img.layout.height;
+    const ImVec2 sz = size();
+    float w = sz.x;
+    float h = sz.y;
     return ImVec2(w * height / h * scale, height * scale);
 }
 
 ImVec2 GuiImage::size_with_maxdim(float maxval, float scale) const
 {
-    auto const& rhi_img = rhi::g_rhi.get_image(img_id);
-    float w = (float)rhi_img.layout.width;
-    float h = (float)rhi_img.layout.height;
+    const ImVec2 sz = size();
+    float w = sz.x;
+    float h = sz.y;
     return (w > h) ? size_with_width(maxval, scale) : size_with_height(maxval, scale);
 }
 
 ImVec2 GuiImage::size_with_mindim(float minval, float scale) const
 {
-    auto const& rhi_img = rhi::g_rhi.get_image(img_id);
-    float w = (float)rhi_img.layout.width;
-    float h = (float)rhi_img.layout.height;
+    const ImVec2 sz = size();
+    float w = sz.x;
+    float h = sz.y;
     return (w < h) ? size_with_width(minval, scale) : size_with_height(minval, scale);
 }
 
 void GuiImage::display() const
 {
-    ImGui::Image((ImTextureID)desc_set, size(1.f), uv_topl, uv_botr, tint_color, border_color);
+    ImGui::Image(tex_id(), size(1.f), uv_topl, uv_botr, tint_color, border_color);
 }
 
 void GuiImage::display(float scale) const
 {
-    ImGui::Image((ImTextureID)desc_set, size(scale), uv_topl, uv_botr, tint_color, border_color);
+    ImGui::Image(tex_id(), size(scale), uv_topl, uv_botr, tint_color, border_color);
 }
 
 void GuiImage::display(ImVec2 display_size) const
 {
-    ImGui::Image((ImTextureID)desc_set, display_size, uv_topl, uv_botr, tint_color, border_color);
+    ImGui::Image(tex_id(), display_size, uv_topl, uv_botr, tint_color, border_color);
 }
 
 void GuiImage::displaySub(ImVec2 topl, ImVec2 botr) const
 {
-    ImGui::Image((ImTextureID)desc_set, size(1.f), topl, botr, tint_color, border_color);
+    displaySub(topl, botr, size(1.f));
 }
 
 void GuiImage::displaySub(ImVec2 topl, ImVec2 botr, float scale) const
 {
-    ImGui::Image((ImTextureID)desc_set, size(scale), topl, botr, tint_color, border_color);
+    displaySub(topl, botr, size(scale));
 }
 
 void GuiImage::displaySub(ImVec2 topl, ImVec2 botr, ImVec2 display_size) const
 {
-    ImGui::Image((ImTextureID)desc_set, display_size, topl, botr, tint_color, border_color);
+    if(atlas) // map to the rect of the image
+    {
+        const ImVec2 uv_size(uv_botr.x - uv_topl.x, uv_botr.y - uv_topl.y);
+        topl = ImVec2(uv_topl.x + topl.x * uv_size.x, uv_topl.y + topl.y * uv_size.y);
+        botr = ImVec2(uv_topl.x + botr.x * uv_size.x, uv_topl.y + botr.y * uv_size.y);
+    }
+    ImGui::Image(tex_id(), display_size, topl, botr, tint_color, border_color);
+}
+
+
+//-----------------------------------------------------------------------------
+
+void GuiImageAtlas::init(uint32_t layer_width, uint32_t layer_height, uint32_t num_layers)
+{
+    init(layer_width, layer_height, num_layers, g_gui_assets.default_sampler);
+}
+
+void GuiImageAtlas::init(uint32_t layer_width, uint32_t layer_height, uint32_t num_layers, rhi::sampler_id sampler)
+{
+    C4_CHECK(!img_id);
+    C4_CHECK(num_layers > 0);
+    rhi::ImageLayout layout = rhi::ImageLayout::make_2d(VK_FORMAT_R8G8B8A8_UNORM, layer_width, layer_height);
+    layout.depth = num_layers;
+    img_id = rhi::g_rhi.make_image(layout.to_vk());
+    rhi::g_rhi.set_name(img_id, "gui_atlas");
+    rhi::Image const& img = rhi::g_rhi.get_image(img_id);
+    // the texels outside of the rects are never sampled, so the
+    // contents can be discarded: the sub-rect uploads then transition
+    // from the sampled layout
+    rhi::image_barrier(rhi::g_rhi.usr_cmd_buffer(), img,
+                       VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0,
+                       img.layout.sampled_layout(), VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+    rhi::g_rhi.mark_usr_cmd_buffer();
+    VkSampler vk_sampler = rhi::g_rhi.get_sampler(sampler);
+    layers.resize(num_layers);
+    for(uint32_t l : irange(num_layers))
+    {
+        LayerTexture &tex = layers[l];
+        tex.view_id = rhi::g_rhi.make_image_view(img, l);
+        VkImageView vk_view = rhi::g_rhi.get_image_view(tex.view_id);
+        if(ImGui_ImplVulkan_HasBindlessTextures())
+            tex.tex_index = ImGui_ImplVulkan_AddBindlessTexture(vk_sampler, vk_view, img.layout.sampled_layout());
+        else
+            tex.desc_set = ImGui_ImplVulkan_AddTexture(vk_sampler, vk_view, img.layout.sampled_layout());
+    }
+    packer.reset(layer_width, layer_height, num_layers);
+    g_image_loader.atlases.push_back(this);
+}
+
+void GuiImageAtlas::destroy()
+{
+    if(!img_id)
+        return;
+    auto &atlases = g_image_loader.atlases;
+    atlases.erase(std::remove(atlases.begin(), atlases.end(), this), atlases.end());
+    for(LayerTexture const& tex : layers)
+    {
+        if(tex.desc_set)
+            ImGui_ImplVulkan_RemoveTexture(tex.desc_set);
+        if(tex.tex_index != GuiImage::no_tex_index)
+            ImGui_ImplVulkan_RemoveBindlessTexture(tex.tex_index);
+        rhi::g_rhi.destroy_image_view(tex.view_id);
+    }
+    rhi::g_rhi.destroy_image(img_id);
+    img_id = {};
+    layers.clear();
+    pending.clear();
+    pending_data.clear();
+    packer = {};
+}
+
+bool GuiImageAtlas::add(GuiImage *img, ccharspan rgba, uint32_t width, uint32_t height)
+{
+    C4_CHECK(img_id);
+    C4_CHECK(rgba.size() == (size_t)width * (size_t)height * 4u);
+    img->destroy();
+    AtlasRect rect;
+    if(!packer.add(width, height, &rect))
+        return false;
+    // upload the rect together with its padding, cleared, so that
+    // nothing is left of a previous occupant
+    const uint32_t pad = packer.padding;
+    const Pending p = {{rect.layer, rect.x - pad, rect.y - pad, width + 2 * pad, height + 2 * pad}, pending_data.size(), img};
+    const size_t row_size = (size_t)p.rect.width * 4u;
+    pending_data.resize(p.offset + row_size * p.rect.height, '\0');
+    for(uint32_t row : irange(height))
+    {
+        char *dst = &pending_data[p.offset + (row + pad) * row_size + pad * 4u];
+        memcpy(dst, rgba.data() + (size_t)row * width * 4u, (size_t)width * 4u);
+    }
+    pending.push_back(p);
+    LayerTexture const& tex = layers[rect.layer];
+    const float w = (float)packer.width;
+    const float h = (float)packer.height;
+    img->atlas = this;
+    img->atlas_rect = rect;
+    img->desc_set = tex.desc_set;
+    img->tex_index = tex.tex_index;
+    img->uv_topl = ImVec2((float)rect.x / w, (float)rect.y / h);
+    img->uv_botr = ImVec2((float)(rect.x + width) / w, (float)(rect.y + height) / h);
+    return true;
+}
+
+void GuiImageAtlas::remove(GuiImage *img)
+{
+    C4_CHECK(img->atlas == this);
+    packer.remove(img->atlas_rect);
+    // the pixels may still be uploaded, to the rect which is now free
+    for(Pending &p : pending)
+        if(p.img == img)
+            p.img = nullptr;
+    img->atlas = nullptr;
+    img->atlas_rect = {};
+    img->atlas_uploaded = false;
+    img->desc_set = {};
+    img->tex_index = GuiImage::no_tex_index;
+    img->uv_topl = {0.f, 0.f};
+    img->uv_botr = {1.f, 1.f};
+}
+
+void GuiImageAtlas::_collect(std::vector<rhi::UploadRequest> *reqs) const
+{
+    for(Pending const& p : pending)
+    {
+        rhi::UploadRequest req;
+        req.img_id = img_id;
+        req.data = {pending_data.data() + p.offset, (size_t)p.rect.width * p.rect.height * 4u};
+        req.first_layer = p.rect.layer;
+        req.num_layers = 1;
+        req.offset = {(int32_t)p.rect.x, (int32_t)p.rect.y};
+        req.extent = {p.rect.width, p.rect.height};
+        reqs->push_back(req);
+    }
+}
+
+void GuiImageAtlas::_uploaded()
+{
+    // the copies precede the draws of the next frames
+    for(Pending const& p : pending)
+        if(p.img)
+            p.img->atlas_uploaded = true;
+    pending.clear();
+    pending_data.clear();
 }
 
 void GuiAssets::acquire(VkCommandBuffer cmd_buf)
@@ -754,15 +2084,31 @@ void GuiAssets::acquire(VkCommandBuffer cmd_buf)
     nearest_sampler = rhi::g_rhi.make_sampler(params.filter(VK_FILTER_NEAREST));
     rhi::g_rhi.set_name(default_sampler, "gui_sampler/default");
     rhi::g_rhi.set_name(nearest_sampler, "gui_sampler/nearest");
+    kernels.acquire(&rhi::g_rhi);
     //logo.load("./icons/logo.png", default_sampler, cmd_buf);
-    (void)cmd_buf;
+    // a dim checkerboard, for the images that are loading. This uses
+    // its own staging buffer, as the rhi buffer is for the frames.
+    {
+        constexpr const uint32_t dim = 8;
+        uint32_t texels[dim * dim];
+        for(uint32_t i : irange(dim))
+            for(uint32_t j : irange(dim))
+                texels[i * dim + j] = ((i ^ j) & 1u) ? UINT32_C(0x80505050) : UINT32_C(0x80303030);
+        const rhi::ImageLayout layout = rhi::ImageLayout::make_2d(VK_FORMAT_R8G8B8A8_UNORM, dim, dim);
+        (void)upload_buffer.require(rhi::g_rhi, layout.num_bytes());
+        placeholder.load("gui_placeholder", {(const char*)texels, sizeof(texels)}, layout, nearest_sampler, cmd_buf, &upload_buffer);
+    }
 }
 
 void GuiAssets::release()
 {
     //logo = {};
+    g_image_loader.stop();
+    placeholder.destroy();
+    upload_buffer.destroy(rhi::g_rhi);
     rhi::g_rhi.destroy_sampler(default_sampler);
     rhi::g_rhi.destroy_sampler(nearest_sampler);
+    kernels.release(&rhi::g_rhi);
 }
 
 } // namespace quickgui
@@ -2,8 +2,10 @@
 #define QUICKGUI_GUI_GUI_HPP_
 
 #include "quickgui/rhi.hpp"
+#include "quickgui/compute_kernels.hpp"
 #include "quickgui/imgui.hpp"
 #include "quickgui/imgview.hpp"
+#include "quickgui/atlas_packer.hpp"
 
 // this fwd-declaration is required
 typedef union SDL_Event SDL_Event;
@@ -17,13 +19,73 @@ namespace quickgui {
 
 struct GuiConfig
 {
+    enum PresentMode : uint8_t
+    {
+        present_fifo = 0,  ///< vsync; always available
+        present_mailbox,   ///< vsync without blocking; replaces the queued frame
+        present_immediate, ///< no vsync; may tear
+    };
     std::string window_name;
     std::string window_icon;
     uint32_t    window_width;
     uint32_t    window_height;
     uint32_t    clear_color; // input
     bool        debug_vulkan;
+    /** the initial font scale, see gui_set_font_scale(). 0 for 1. */
     float       font_scale;
+    /** a TTF file for the gui font. When empty, the imgui default
+     * font is used. */
+    std::string font_file;
+    /** the font size in pixels at scale 1. 0 for the default (13). */
+    float       font_size;
+    /** the font is rasterized once for each of these scales, so that
+     * changing to one of them is sharp and does not rebuild the atlas.
+     * When empty, only scale 1 is rasterized. Eg {1.f, 1.5f, 2.f} */
+    std::vector<float> font_prebaked_scales;
+    /** directory where the rasterized font atlas is cached between
+     * runs, so that it is not rebuilt at startup. When empty, the SDL
+     * preferences path is used. */
+    std::string font_cache_dir;
+    /** directory where the vulkan pipeline cache is persisted between
+     * runs. When empty, the SDL preferences path is used. */
+    std::string pipeline_cache_dir;
+    /** render offscreen, without SDL window nor swapchain, to images
+     * of window_width x window_height. No input is polled, and the
+     * frames can be read back with rhi::ImageGpu2Cpu::request_swapchain().
+     * Useful for automated runs and benchmarks on headless machines. */
+    bool        offscreen;
+    /** count the host memory allocated by the vulkan driver, see
+     * rhi::host_alloc_init() */
+    bool        track_vulkan_host_memory;
+    /** size of the arena for the transient driver allocations. Only
+     * used when track_vulkan_host_memory is set. */
+    size_t      vulkan_transient_arena_size;
+    /** falls back to fifo when not supported by the surface */
+    PresentMode present_mode;
+    /** how many frames the CPU can get ahead of the GPU. Lower is
+     * less latency. 0 to use all the swapchain images. */
+    uint32_t    frames_in_flight;
+    /** cap the frame rate. 0 for no cap. */
+    float       target_fps;
+    /** the frame limiter sleeps until this long before the frame
+     * deadline, and then spins. More is more accurate, but uses more
+     * CPU; 0 only sleeps. Eg 1.0 */
+    float       frame_limiter_spin_ms;
+    /** power saving: when nothing changed, block in gui_start_frame()
+     * until there is input, an invalidation (see gui_invalidate()),
+     * or the heartbeat is due. Ignored when offscreen. */
+    bool        lazy_rendering;
+    /** minimum redraw rate with lazy_rendering. 0 to redraw only on
+     * input or invalidation. Eg 1.0 */
+    float       idle_heartbeat_hz;
+    /** when not 0, gui_end_frame() hands a copy of the imgui draw
+     * data to a render thread, which records, submits and presents
+     * it while the application starts the next frame. This is the
+     * maximum number of queued frames (1 or 2); each holds one more
+     * swapchain image. Draw callbacks are then called from the render
+     * thread, and textures must be kept alive while their frames are
+     * queued; gui_wait_idle_rhi() waits for the queue. */
+    uint32_t    render_thread_depth;
 };
 
 
@@ -36,19 +98,67 @@ void gui_release_assets();
 
 bool gui_start_frame();
 void gui_end_frame(ImVec4 background);
+/** change the frame rate cap, see GuiConfig::target_fps */
+void gui_set_target_fps(float fps);
+/** with lazy rendering, request the next frame to be drawn. Widgets
+ * that animate should call this every frame. Thread-safe: wakes up a
+ * gui_start_frame() that is blocked waiting for events. */
+void gui_invalidate();
+/** scale the gui font: selects the prebaked font with the closest
+ * scale (see GuiConfig::font_prebaked_scales), and scales it by the
+ * remainder. Does not rebuild the font atlas. */
+void gui_set_font_scale(float scale);
+float gui_font_scale();
+/** the swapchain images of the current frame, for
+ * rhi::ImageGpu2Cpu::request_swapchain() */
+rhi::SwapchainState gui_swapchain_state();
 
+/** the handler returns true to consume the event. The events of the
+ * frame are those not handled by the gui itself, with consecutive
+ * mouse/finger motions merged, followed by the posted events. */
 using GuiEventHandler = bool (*)(SDL_Event const& event, void *data);
 void gui_iter_events(GuiEventHandler fn, void *data);
+/** post an event from any thread, eg a worker signalling that a
+ * result is ready. It is delivered by gui_iter_events() in the next
+ * frame, on the gui thread. Lock-free, other than waking up a frame
+ * blocked with GuiConfig::lazy_rendering. Use an event type obtained
+ * from SDL_RegisterEvents(). Only between gui_init() and
+ * gui_terminate(). */
+void gui_post_event(SDL_Event const& event);
+
+struct GuiImageAtlas;
 
 struct GuiImage
 {
     rhi::image_id      img_id = {};
     rhi::image_view_id view_id = {};
+    /** the texture is registered either in the bindless table (when
+     * the device supports descriptor indexing), or with its own
+     * descriptor set */
+    enum : uint32_t { no_tex_index = (uint32_t)-1 };
     VkDescriptorSet    desc_set = {};
+    uint32_t           tex_index = no_tex_index;
     ImVec2             uv_topl = {0.f, 0.f};
     ImVec2             uv_botr = {1.f, 1.f};
     ImVec4             tint_color = {1.f, 1.f, 1.f, 1.f};
     ImVec4             border_color = {0.f, 0.f, 0.f, 0.f};
+    /** when set before loading, the image gets a full mip chain
+     * generated on the GPU, so that displaying it at a size smaller
+     * than the original samples from the closest mip level. */
+    bool               mipmaps = false;
+    /** the state of load_async() */
+    enum AsyncStatus : uint8_t { async_none, async_loading, async_done, async_failed };
+    AsyncStatus        async_status = async_none;
+    /** the size reported while the image is not loaded, eg to reserve
+     * the layout space of a thumbnail */
+    ImVec2             placeholder_size = {64.f, 64.f};
+    /** when set, the image is a rect of the atlas, and shares its
+     * texture; see GuiImageAtlas::add() */
+    GuiImageAtlas     *atlas = nullptr;
+    AtlasRect          atlas_rect = {};
+    bool               atlas_uploaded = false; ///< the copy of the rect was recorded
+    /** called from the gui thread when load_async() finishes */
+    using LoadedFn = void (*)(GuiImage *img, bool ok, void *data);
     void load_existing(rhi::image_id id);
     void load_existing(rhi::image_id id, rhi::sampler_id sampler);
     void load(const char *filename);
@@ -61,7 +171,19 @@ struct GuiImage
     void load(const char *filename, ccharspan img_data, rhi::sampler_id sampler, rhi::ImageLayout const& layout, rhi::UploadBuffer *upload_buffer);
     void load(const char *filename, ccharspan img_data, rhi::ImageLayout const& layout, rhi::sampler_id sampler, VkCommandBuffer cmd_buf);
     void load(const char *filename, ccharspan img_data, rhi::ImageLayout const& layout, rhi::sampler_id sampler, VkCommandBuffer cmd_buf, rhi::UploadBuffer *upload_buffer);
+    /** load without blocking: the file is read and decoded by worker
+     * threads, and the decoded images are uploaded in a batch when a
+     * frame ends. Meanwhile, the image is displayed with the
+     * placeholder texture and placeholder_size. Completion is reported
+     * by async_status, and by on_loaded if given. The image must not
+     * be moved while loading; destroy() cancels the load. */
+    void load_async(const char *filename, LoadedFn on_loaded=nullptr, void *data=nullptr);
+    void load_async(const char *filename, rhi::sampler_id sampler, LoadedFn on_loaded=nullptr, void *data=nullptr);
+    /** whether the image can be displayed with its own texture, or
+     * with its atlas rect once the rect was uploaded */
+    bool resident() const { return img_id || atlas_uploaded; }
     void destroy();
+    ImTextureID tex_id() const;
     rhi::ImageLayout const& layout() const { return rhi::g_rhi.get_image(img_id).layout; }
     void display() const; ///< display with scale=1
     void display(float scale) const;
@@ -77,6 +199,52 @@ struct GuiImage
     ImVec2 size_with_maxdim(float maxval, float scale=1.f) const;
     /** size with dimensions at least */
     ImVec2 size_with_mindim(float minval, float scale=1.f) const;
+    void _add_texture(rhi::sampler_id sampler);
+};
+
+/** packs many small images into the layers of a single 2D array
+ * texture: they share one allocation, and the draws of the images on
+ * the same layer are batched by imgui. The format is RGBA8, without
+ * mips. The pixels are uploaded when the frame ends, in the same
+ * batch as GuiImage::load_async(). Each rect is surrounded by
+ * transparent padding, so that the filtering does not bleed from its
+ * neighbours. */
+struct GuiImageAtlas
+{
+    struct LayerTexture
+    {
+        rhi::image_view_id view_id = {};
+        VkDescriptorSet    desc_set = {};
+        uint32_t           tex_index = GuiImage::no_tex_index;
+    };
+    struct Pending
+    {
+        AtlasRect rect;   ///< including the padding
+        size_t    offset; ///< in pending_data
+        GuiImage *img;    ///< null once removed
+    };
+    AtlasPacker               packer;
+    rhi::image_id             img_id = {};
+    std::vector<LayerTexture> layers;
+    std::vector<Pending>      pending;
+    String                    pending_data;
+
+    /** create the texture. Call while a frame is recording, or
+     * between gui_acquire_assets() and the first frame. */
+    void init(uint32_t layer_width, uint32_t layer_height, uint32_t num_layers);
+    void init(uint32_t layer_width, uint32_t layer_height, uint32_t num_layers, rhi::sampler_id sampler);
+    /** the images added to the atlas must be destroyed before */
+    void destroy();
+    /** pack an image with width*height RGBA8 pixels, and make img
+     * display its rect. Until the frame ends and the rect is uploaded,
+     * the image is not resident, and displays the placeholder.
+     * @return false if there is no room left */
+    bool add(GuiImage *img, ccharspan rgba, uint32_t width, uint32_t height);
+    /** release the rect of the image, for reuse by a later add() of
+     * the same or smaller size. Called by GuiImage::destroy(). */
+    void remove(GuiImage *img);
+    void _collect(std::vector<rhi::UploadRequest> *reqs) const;
+    void _uploaded();
 };
 
 struct GuiAssets
@@ -84,6 +252,11 @@ struct GuiAssets
     using Image = GuiImage; // remove this
     rhi::sampler_id default_sampler;
     rhi::sampler_id nearest_sampler;
+    /** displayed by the images that are loading */
+    GuiImage        placeholder;
+    rhi::UploadBuffer upload_buffer;
+    /** the built-in compute kernels, eg for DynamicImage::reset_raw() */
+    rhi::ComputeKernels kernels;
     void acquire(VkCommandBuffer cmd_buf);
     void release();
 };
@@ -92,7 +265,23 @@ extern GuiAssets g_gui_assets;
 
 using gui_image = rhi::image_id;
 gui_image gui_load_image_2d_rgba(const char *filename);
+/** load a multi-page TIFF, eg a z-stack or a time series, into a 2D
+ * array image with one page per layer; see TiffFile for the supported
+ * files. The image is created and cleared right away, and the pages
+ * are read by a worker thread and uploaded in chunks when the frames
+ * end, so that the memory is bounded regardless of the file size.
+ * RGB pages are expanded to RGBA. Call while a frame is recording.
+ * @return an empty id if the file cannot be read, has more pages than
+ * the device supports layers, or has a format the device cannot
+ * sample with filtering (eg 32 bit integers) */
 gui_image gui_load_image_2d_array_tiff(const char *filename);
+/** the fraction of the layers of a streamed image that are uploaded:
+ * 1 when complete, or when the image is not streamed, and negative
+ * when a page could not be read */
+float gui_image_load_progress(gui_image img);
+/** stop streaming the image. Must be called before destroying an
+ * image whose progress is not 1, including one that failed. */
+void gui_image_load_cancel(gui_image img);
 
 struct stb_image_data;
 VkFormat stb_format(stb_image_data const& s);
@@ -0,0 +1,385 @@
+#include "quickgui/image_display.hpp"
+
+#include "quickgui/imgui_impl_vulkan.h"
+#include "quickgui/palettes.hpp"
+#include <c4/error.hpp>
+
+namespace quickgui {
+
+C4_SUPPRESS_WARNING_GCC_CLANG_PUSH
+C4_SUPPRESS_WARNING_GCC_CLANG("-Wold-style-cast")
+
+namespace {
+
+const uint32_t s_image_display_frag_spv[] = {
+#include "quickgui/shaders/image_display.frag.glsl.spv"
+};
+
+/** entries of each colormap */
+constexpr const uint32_t lut_size = 256;
+/** a descriptor set that was not drawn for this many frames is no
+ * longer used by the GPU, and can be rewritten */
+constexpr const int retire_frames = 8;
+/** descriptor sets in each pool of the displays */
+constexpr const uint32_t sets_per_pool = 64;
+
+template<class Palette>
+c4::cspan<ucolor> _palette()
+{
+    return c4::cspan<ucolor>(Palette::values, C4_COUNTOF(Palette::values));
+}
+
+/** the window value of a texel sampled as 1 */
+float _value_scale(VkFormat format)
+{
+    switch(format)
+    {
+    case VK_FORMAT_R8_UNORM:
+    case VK_FORMAT_R8G8_UNORM:
+    case VK_FORMAT_R8G8B8_UNORM:
+    case VK_FORMAT_R8G8B8A8_UNORM:
+    case VK_FORMAT_B8G8R8A8_UNORM:
+        return 255.f;
+    case VK_FORMAT_R8_SNORM:
+    case VK_FORMAT_R8G8_SNORM:
+    case VK_FORMAT_R8G8B8_SNORM:
+    case VK_FORMAT_R8G8B8A8_SNORM:
+        return 127.f;
+    case VK_FORMAT_R16_UNORM:
+    case VK_FORMAT_R16G16_UNORM:
+    case VK_FORMAT_R16G16B16_UNORM:
+    case VK_FORMAT_R16G16B16A16_UNORM:
+        return 65535.f;
+    case VK_FORMAT_R16_SNORM:
+    case VK_FORMAT_R16G16_SNORM:
+    case VK_FORMAT_R16G16B16_SNORM:
+    case VK_FORMAT_R16G16B16A16_SNORM:
+        return 32767.f;
+    case VK_FORMAT_R16_SFLOAT:
+    case VK_FORMAT_R16G16_SFLOAT:
+    case VK_FORMAT_R16G16B16_SFLOAT:
+    case VK_FORMAT_R16G16B16A16_SFLOAT:
+    case VK_FORMAT_R32_SFLOAT:
+    case VK_FORMAT_R32G32_SFLOAT:
+    case VK_FORMAT_R32G32B32_SFLOAT:
+    case VK_FORMAT_R32G32B32A32_SFLOAT:
+        return 1.f;
+    default:
+        C4_ERROR("format %d is not sampled as float", (int)format);
+    }
+    return 1.f;
+}
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+/** the pipeline and the colormaps, created by the first display and
+ * released with the last */
+struct ImageDisplay::Shared
+{
+    uint32_t              num_users = 0;
+    VkShaderModule        frag = VK_NULL_HANDLE;
+    VkDescriptorSetLayout set_layout = VK_NULL_HANDLE;
+    VkPipelineLayout      layout = VK_NULL_HANDLE;
+    VkPipeline            pipeline = VK_NULL_HANDLE;
+    rhi::sampler_id       lut_sampler = {};
+    GuiImage              colormaps; ///< one row of lut_size entries per colormap
+    rhi::UploadBuffer     upload_buffer; ///< the rhi buffer is for the frames
+    /** the sets of the images: a new pool is added when the others
+     * are full, so that the number of images is not bounded */
+    std::vector<VkDescriptorPool> pools;
+
+    void acquire()
+    {
+        if(num_users++)
+            return;
+        rhi::Rhi &r = rhi::g_rhi;
+        // pipeline
+        VkShaderModuleCreateInfo module_nfo = {};
+        module_nfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        module_nfo.codeSize = sizeof(s_image_display_frag_spv);
+        module_nfo.pCode = s_image_display_frag_spv;
+        C4_CHECK_VK(vkCreateShaderModule(r.m_device, &module_nfo, r.m_allocator, &frag));
+        VkDescriptorSetLayoutBinding bindings[2] = {};
+        for(uint32_t i : irange(2u))
+        {
+            bindings[i].binding = i;
+            bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            bindings[i].descriptorCount = 1;
+            bindings[i].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+        }
+        VkDescriptorSetLayoutCreateInfo set_nfo = {};
+        set_nfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        set_nfo.bindingCount = 2;
+        set_nfo.pBindings = bindings;
+        C4_CHECK_VK(vkCreateDescriptorSetLayout(r.m_device, &set_nfo, r.m_allocator, &set_layout));
+        VkPushConstantRange push_constants[2] = {};
+        push_constants[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+        push_constants[0].offset = 0;
+        push_constants[0].size = sizeof(float) * 4;
+        push_constants[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+        push_constants[1].offset = sizeof(float) * 4;
+        push_constants[1].size = sizeof(Constants);
+        VkPipelineLayoutCreateInfo layout_nfo = {};
+        layout_nfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        layout_nfo.setLayoutCount = 1;
+        layout_nfo.pSetLayouts = &set_layout;
+        layout_nfo.pushConstantRangeCount = 2;
+        layout_nfo.pPushConstantRanges = push_constants;
+        C4_CHECK_VK(vkCreatePipelineLayout(r.m_device, &layout_nfo, r.m_allocator, &layout));
+        pipeline = ImGui_ImplVulkan_CreateUserPipeline(frag, layout);
+        rhi::debug_marker_set_name(r.m_device, pipeline, "gui_image_display");
+        // colormaps
+        lut_sampler = r.make_sampler(r.build_sampler().address(VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE));
+        r.set_name(lut_sampler, "gui_image_display/colormaps");
+        std::vector<ucolor> texels(lut_size * num_colormaps);
+        auto row = [&](Colormap cm, c4::cspan<ucolor> colors, bool interpolate){
+            colormap_lut(colors, interpolate, c4::span<ucolor>(texels.data() + cm * lut_size, lut_size));
+        };
+        row(colormap_gray, _palette<palettes::grays>(), true);
+        row(colormap_viridis, _palette<palettes::viridis>(), true);
+        row(colormap_magma, _palette<palettes::magma>(), true);
+        row(colormap_inferno, _palette<palettes::inferno>(), true);
+        row(colormap_plasma, _palette<palettes::plasma>(), true);
+        row(colormap_d3_10, _palette<palettes::d3_10>(), false);
+        row(colormap_d3_20a, _palette<palettes::d3_20a>(), false);
+        static_assert(num_colormaps == 7, "add the row of the new colormap");
+        const rhi::ImageLayout img_layout = rhi::ImageLayout::make_2d(VK_FORMAT_R8G8B8A8_UNORM, lut_size, num_colormaps);
+        (void)upload_buffer.require(r, img_layout.num_bytes());
+        colormaps.load("gui_image_display/colormaps", {(const char*)texels.data(), img_layout.num_bytes()},
+                       img_layout, lut_sampler, r.usr_cmd_buffer(), &upload_buffer);
+        r.mark_usr_cmd_buffer();
+    }
+
+    VkDescriptorSet allocate_set(VkDescriptorPool *pool)
+    {
+        rhi::Rhi &r = rhi::g_rhi;
+        VkDescriptorSetAllocateInfo nfo = {};
+        nfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        nfo.descriptorSetCount = 1;
+        nfo.pSetLayouts = &set_layout;
+        VkDescriptorSet set = VK_NULL_HANDLE;
+        for(VkDescriptorPool p : pools)
+        {
+            nfo.descriptorPool = p;
+            if(vkAllocateDescriptorSets(r.m_device, &nfo, &set) == VK_SUCCESS)
+            {
+                *pool = p;
+                return set;
+            }
+        }
+        VkDescriptorPoolSize pool_size = {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2 * sets_per_pool};
+        VkDescriptorPoolCreateInfo pool_nfo = {};
+        pool_nfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        pool_nfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+        pool_nfo.maxSets = sets_per_pool;
+        pool_nfo.poolSizeCount = 1;
+        pool_nfo.pPoolSizes = &pool_size;
+        C4_CHECK_VK(vkCreateDescriptorPool(r.m_device, &pool_nfo, r.m_allocator, pool));
+        pools.push_back(*pool);
+        nfo.descriptorPool = *pool;
+        C4_CHECK_VK(vkAllocateDescriptorSets(r.m_device, &nfo, &set));
+        return set;
+    }
+
+    void release()
+    {
+        C4_CHECK(num_users > 0);
+        if(--num_users)
+            return;
+        rhi::Rhi &r = rhi::g_rhi;
+        // the displays freed their sets
+        for(VkDescriptorPool p : pools)
+            vkDestroyDescriptorPool(r.m_device, p, r.m_allocator);
+        pools.clear();
+        colormaps.destroy();
+        upload_buffer.destroy(r);
+        r.destroy_sampler(lut_sampler);
+        lut_sampler = {};
+        vkDestroyPipeline(r.m_device, pipeline, r.m_allocator);
+        vkDestroyPipelineLayout(r.m_device, layout, r.m_allocator);
+        vkDestroyDescriptorSetLayout(r.m_device, set_layout, r.m_allocator);
+        vkDestroyShaderModule(r.m_device, frag, r.m_allocator);
+        pipeline = VK_NULL_HANDLE;
+        layout = VK_NULL_HANDLE;
+        set_layout = VK_NULL_HANDLE;
+        frag = VK_NULL_HANDLE;
+    }
+};
+
+ImageDisplay::Shared ImageDisplay::s_shared;
+
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+void ImageDisplay::init()
+{
+    init(g_gui_assets.nearest_sampler);
+}
+
+void ImageDisplay::init(rhi::sampler_id sampler)
+{
+    C4_CHECK(!m_init);
+    s_shared.acquire();
+    m_sampler = sampler;
+    m_init = true;
+}
+
+void ImageDisplay::destroy()
+{
+    if(!m_init)
+        return;
+    rhi::Rhi &r = rhi::g_rhi;
+    for(TexSet const& ts : m_sets)
+        C4_CHECK_VK(vkFreeDescriptorSets(r.m_device, ts.pool, 1, &ts.set));
+    m_sets.clear();
+    for(uint32_t s : irange(num_frame_slots))
+    {
+        m_draws[s].clear();
+        m_draws_frame[s] = -1;
+    }
+    m_sampler = {};
+    m_init = false;
+    s_shared.release();
+}
+
+WindowLevel ImageDisplay::full_range(imgviewtype::data_type_e type)
+{
+    switch(type)
+    {
+    case imgviewtype::u8: return WindowLevel::from_range(0.f, 255.f);
+    case imgviewtype::i8: return WindowLevel::from_range(-128.f, 127.f);
+    case imgviewtype::u16: return WindowLevel::from_range(0.f, 65535.f);
+    case imgviewtype::i16: return WindowLevel::from_range(-32768.f, 32767.f);
+    case imgviewtype::f32: return WindowLevel::from_range(0.f, 1.f);
+    default:
+        C4_ERROR("the 32-bit integer images are not sampled as float");
+    }
+    return {};
+}
+
+const char* ImageDisplay::colormap_name(Colormap c)
+{
+    switch(c)
+    {
+    case colormap_gray: return "gray";
+    case colormap_viridis: return "viridis";
+    case colormap_magma: return "magma";
+    case colormap_inferno: return "inferno";
+    case colormap_plasma: return "plasma";
+    case colormap_d3_10: return "d3_10";
+    case colormap_d3_20a: return "d3_20a";
+    default: break;
+    }
+    return "unknown";
+}
+
+VkDescriptorSet ImageDisplay::_tex_set(GuiImage const& img)
+{
+    const int frame = ImGui::GetFrameCount();
+    TexSet *ts = nullptr;
+    for(TexSet &s : m_sets)
+    {
+        if(s.view_id == img.view_id)
+        {
+            s.last_frame = frame;
+            return s.set;
+        }
+        if(frame - s.last_frame > retire_frames && (!ts || s.last_frame < ts->last_frame))
+            ts = &s;
+    }
+    rhi::Rhi &r = rhi::g_rhi;
+    if(!ts)
+    {
+        m_sets.push_back({});
+        ts = &m_sets.back();
+        ts->set = s_shared.allocate_set(&ts->pool);
+    }
+    ts->view_id = img.view_id;
+    ts->last_frame = frame;
+    VkDescriptorImageInfo images[2] = {};
+    images[0].sampler = r.get_sampler(m_sampler);
+    images[0].imageView = r.get_image_view(img.view_id);
+    images[0].imageLayout = img.layout().sampled_layout();
+    images[1].sampler = r.get_sampler(s_shared.lut_sampler);
+    images[1].imageView = r.get_image_view(s_shared.colormaps.view_id);
+    images[1].imageLayout = s_shared.colormaps.layout().sampled_layout();
+    VkWriteDescriptorSet writes[2] = {};
+    for(uint32_t i : irange(2u))
+    {
+        writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].dstSet = ts->set;
+        writes[i].dstBinding = i;
+        writes[i].descriptorCount = 1;
+        writes[i].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        writes[i].pImageInfo = &images[i];
+    }
+    vkUpdateDescriptorSets(r.m_device, 2, writes, 0, nullptr);
+    return ts->set;
+}
+
+void ImageDisplay::display(GuiImage const& img, ImVec2 display_size)
+{
+    // the whole image: displaySub() maps to the rect of an atlas image
+    displaySub(img, ImVec2(0.f, 0.f), ImVec2(1.f, 1.f), display_size);
+}
+
+void ImageDisplay::displaySub(GuiImage const& img, ImVec2 uv_topl, ImVec2 uv_botr, ImVec2 display_size)
+{
+    C4_CHECK(m_init);
+    if(!img.img_id || img.atlas)
+    {
+        img.displaySub(uv_topl, uv_botr, display_size);
+        return;
+    }
+    const int frame = ImGui::GetFrameCount();
+    const uint32_t slot = (uint32_t)frame % num_frame_slots;
+    if(m_draws_frame[slot] != frame)
+    {
+        m_draws[slot].clear();
+        m_draws_frame[slot] = frame;
+    }
+    Draw &d = m_draws[slot].emplace_back();
+    d.set = _tex_set(img);
+    window_level.linear(_value_scale(img.layout().format), &d.constants.mul, &d.constants.add);
+    d.constants.inv_gamma = window_level.gamma > 0.f ? 1.f / window_level.gamma : 1.f;
+    d.constants.channel = channel;
+    d.constants.colormap_v = ((float)colormap + 0.5f) / (float)num_colormaps;
+    d.constants.lut_size = (float)lut_size;
+    // the image is drawn with the shader bound by the callback
+    ImDrawList *dl = ImGui::GetWindowDrawList();
+    dl->AddCallback(&_draw_callback, &d);
+    ImGui::Image(img.tex_id(), display_size, uv_topl, uv_botr, tint_color);
+    dl->AddCallback(ImDrawCallback_ResetRenderState, nullptr);
+}
+
+void ImageDisplay::_draw_callback(ImDrawList const* dl, ImDrawCmd const* cmd)
+{
+    C4_UNUSED(dl);
+    Draw const* d = (Draw const*)cmd->UserCallbackData;
+    ImGui_ImplVulkan_RenderState *rs = ImGui_ImplVulkan_GetRenderState();
+    VkCommandBuffer cb = rs->CommandBuffer;
+    vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_GRAPHICS, s_shared.pipeline);
+    vkCmdBindDescriptorSets(cb, VK_PIPELINE_BIND_POINT_GRAPHICS, s_shared.layout, 0, 1, &d->set, 0, nullptr);
+    vkCmdPushConstants(cb, s_shared.layout, VK_SHADER_STAGE_VERTEX_BIT, sizeof(float) * 0, sizeof(float) * 2, rs->Scale);
+    vkCmdPushConstants(cb, s_shared.layout, VK_SHADER_STAGE_VERTEX_BIT, sizeof(float) * 2, sizeof(float) * 2, rs->Translate);
+    vkCmdPushConstants(cb, s_shared.layout, VK_SHADER_STAGE_FRAGMENT_BIT, sizeof(float) * 4, sizeof(Constants), &d->constants);
+    rs->UserState = true;
+}
+
+void ImageDisplay::colorbar(ImVec2 size) const
+{
+    C4_CHECK(m_init);
+    const float v = ((float)colormap + 0.5f) / (float)num_colormaps;
+    ImGui::Image(s_shared.colormaps.tex_id(), size, ImVec2(0.f, v), ImVec2(1.f, v), tint_color);
+}
+
+C4_SUPPRESS_WARNING_GCC_CLANG_POP
+
+} // namespace quickgui
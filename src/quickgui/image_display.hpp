@@ -0,0 +1,115 @@
+#ifndef QUICKGUI_IMAGE_DISPLAY_HPP_
+#define QUICKGUI_IMAGE_DISPLAY_HPP_
+
+#include "quickgui/gui.hpp"
+#include "quickgui/window_level.hpp"
+#include <deque>
+#include <vector>
+
+namespace quickgui {
+
+/** displays images of any float-sampled format, eg the u16 and f32
+ * images of imgview_format(), with a shader that applies a window/
+ * level, a gamma and a colormap on the GPU. Changing the contrast
+ * costs nothing on the CPU, and the images need not be converted to
+ * rgba8. The shader is bound around each image with imgui draw
+ * callbacks. The pipeline and the colormaps are shared by all the
+ * displays. */
+struct ImageDisplay
+{
+    enum Colormap : uint32_t
+    {
+        colormap_gray,
+        colormap_viridis,
+        colormap_magma,
+        colormap_inferno,
+        colormap_plasma,
+        colormap_d3_10,  ///< categorical, in steps
+        colormap_d3_20a, ///< categorical, in steps
+        num_colormaps
+    };
+    /** display r, g and b, each with the window/level and the gamma,
+     * and without colormap */
+    enum : uint32_t { channel_rgb = 4u };
+
+    /** in the units of the image values, eg [0,65535] for u16 */
+    WindowLevel window_level = {};
+    Colormap    colormap = colormap_gray;
+    /** the channel mapped through the colormap, or channel_rgb */
+    uint32_t    channel = 0;
+    ImVec4      tint_color = {1.f, 1.f, 1.f, 1.f};
+
+public:
+
+    ImageDisplay() = default;
+    ~ImageDisplay() { destroy(); }
+    ImageDisplay(ImageDisplay const&) = delete;
+    ImageDisplay& operator= (ImageDisplay const&) = delete;
+
+    /** Call while a frame is recording: the first display creates the
+     * shared pipeline and uploads the colormaps. The images are
+     * sampled with the nearest sampler, unless given. */
+    void init();
+    void init(rhi::sampler_id sampler);
+    /** once the frames that drew with it are done, as with the images */
+    void destroy();
+
+    /** like GuiImage::display(). The image needs its own texture:
+     * when it is loading, or in an atlas, it is displayed as usual. */
+    void display(GuiImage const& img, ImVec2 display_size);
+    /** a rect of the image, in uv coordinates */
+    void displaySub(GuiImage const& img, ImVec2 uv_topl, ImVec2 uv_botr, ImVec2 display_size);
+    /** the colormap from vmin() on the left to vmax() on the right,
+     * without the gamma */
+    void colorbar(ImVec2 size) const;
+
+    /** the window/level spanning the range of the values of the data
+     * type, eg [0,65535] for u16, or [0,1] for f32 */
+    static WindowLevel full_range(imgviewtype::data_type_e type);
+    static const char* colormap_name(Colormap c);
+
+private:
+
+    /** the fragment push constants of image_display.frag */
+    struct Constants
+    {
+        float    mul, add;
+        float    inv_gamma;
+        uint32_t channel;
+        float    colormap_v; ///< the row of the colormap
+        float    lut_size;
+    };
+    struct Draw
+    {
+        VkDescriptorSet set;
+        Constants       constants;
+    };
+    /** the descriptor set of each image drawn recently */
+    struct TexSet
+    {
+        rhi::image_view_id view_id;
+        VkDescriptorSet    set;
+        VkDescriptorPool   pool; ///< where the set was allocated
+        int                last_frame;
+    };
+    /** the draws are recorded once their frame ends, or later in the
+     * render thread: keep the draw data of the frames that may be
+     * waiting, see GuiConfig::render_thread_depth */
+    enum : uint32_t { num_frame_slots = 4u };
+
+    struct Shared;
+    static Shared s_shared;
+
+    VkDescriptorSet _tex_set(GuiImage const& img);
+    static void _draw_callback(ImDrawList const* dl, ImDrawCmd const* cmd);
+
+    rhi::sampler_id   m_sampler = {};
+    std::vector<TexSet> m_sets;
+    std::deque<Draw>  m_draws[num_frame_slots]; ///< pointers are stable on push_back
+    int               m_draws_frame[num_frame_slots] = {-1, -1, -1, -1};
+    bool              m_init = false;
+};
+
+} // namespace quickgui
+
+#endif /* QUICKGUI_IMAGE_DISPLAY_HPP_ */
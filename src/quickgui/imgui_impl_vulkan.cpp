@@ -136,6 +136,23 @@ struct ImGui_ImplVulkan_Data
     VkDescriptorSet             FontDescriptorSet;
     VkCommandPool               FontCommandPool;
     VkCommandBuffer             FontCommandBuffer;
+    uint32_t                    FontBindlessIndex;
+    VkFence                     FontFence;              // Signaled when the font upload is done
+    VkBuffer                    FontUploadBuffer;       // Kept until FontFence is signaled
+    VkDeviceMemory              FontUploadBufferMemory;
+
+    // Bindless texture table (only when VulkanInitInfo.BindlessTextureCount > 0)
+    VkDescriptorSetLayout       BindlessSetLayout;
+    VkDescriptorPool            BindlessPool;
+    VkDescriptorSet             BindlessSet;
+    VkPipelineLayout            BindlessPipelineLayout;
+    VkPipeline                  BindlessPipeline;
+    VkShaderModule              ShaderModuleFragBindless;
+    uint32_t*                   BindlessSlots;          // The ImTextureID of a table entry is the address of its slot. Free slots chain to the next free index.
+    uint32_t                    BindlessFreeHead;
+
+    // State for the draw callbacks, see ImGui_ImplVulkan_GetRenderState()
+    ImGui_ImplVulkan_RenderState RenderState;
 
     // Render buffers for main window
     ImGui_ImplVulkanH_WindowRenderBuffers MainWindowRenderBuffers;
@@ -144,6 +161,7 @@ struct ImGui_ImplVulkan_Data
     {
         memset((void*)this, 0, sizeof(*this));
         BufferMemoryAlignment = 256;
+        FontBindlessIndex = (uint32_t)-1;
     }
 };
 
@@ -158,6 +176,8 @@ void ImGui_ImplVulkanH_DestroyFrameRenderBuffers(VkDevice device, ImGui_ImplVulk
 void ImGui_ImplVulkanH_DestroyWindowRenderBuffers(VkDevice device, ImGui_ImplVulkanH_WindowRenderBuffers* buffers, const VkAllocationCallbacks* allocator);
 void ImGui_ImplVulkanH_CreateWindowSwapChain(VkPhysicalDevice physical_device, VkDevice device, ImGui_ImplVulkanH_Window* wd, const VkAllocationCallbacks* allocator, int w, int h, uint32_t min_image_count);
 void ImGui_ImplVulkanH_CreateWindowCommandBuffers(VkPhysicalDevice physical_device, VkDevice device, ImGui_ImplVulkanH_Window* wd, uint32_t queue_family, const VkAllocationCallbacks* allocator);
+static void ImGui_ImplVulkanH_CreateWindowFramebuffers(VkDevice device, ImGui_ImplVulkanH_Window* wd, const VkAllocationCallbacks* allocator, VkImageLayout final_layout);
+static void ImGui_ImplVulkanH_CreateSwapchainFrames(VkPhysicalDevice physical_device, VkDevice device, ImGui_ImplVulkanH_Window* wd, const VkAllocationCallbacks* allocator, int w, int h, uint32_t min_image_count, VkSwapchainKHR old_swapchain);
 
 // Vulkan prototypes for use with custom loaders
 // (see description of IMGUI_IMPL_VULKAN_NO_PROTOTYPES in imgui_impl_vulkan.h
@@ -186,6 +206,7 @@ static bool g_FunctionsLoaded = true;
     IMGUI_VULKAN_FUNC_MAP_MACRO(vkCmdSetViewport) \
     IMGUI_VULKAN_FUNC_MAP_MACRO(vkCreateBuffer) \
     IMGUI_VULKAN_FUNC_MAP_MACRO(vkCreateCommandPool) \
+    IMGUI_VULKAN_FUNC_MAP_MACRO(vkCreateDescriptorPool) \
     IMGUI_VULKAN_FUNC_MAP_MACRO(vkCreateDescriptorSetLayout) \
     IMGUI_VULKAN_FUNC_MAP_MACRO(vkCreateFence) \
     IMGUI_VULKAN_FUNC_MAP_MACRO(vkCreateFramebuffer) \
@@ -200,6 +221,7 @@ static bool g_FunctionsLoaded = true;
     IMGUI_VULKAN_FUNC_MAP_MACRO(vkCreateSwapchainKHR) \
     IMGUI_VULKAN_FUNC_MAP_MACRO(vkDestroyBuffer) \
     IMGUI_VULKAN_FUNC_MAP_MACRO(vkDestroyCommandPool) \
+    IMGUI_VULKAN_FUNC_MAP_MACRO(vkDestroyDescriptorPool) \
     IMGUI_VULKAN_FUNC_MAP_MACRO(vkDestroyDescriptorSetLayout) \
     IMGUI_VULKAN_FUNC_MAP_MACRO(vkDestroyFence) \
     IMGUI_VULKAN_FUNC_MAP_MACRO(vkDestroyFramebuffer) \
@@ -220,6 +242,7 @@ static bool g_FunctionsLoaded = true;
     IMGUI_VULKAN_FUNC_MAP_MACRO(vkFreeDescriptorSets) \
     IMGUI_VULKAN_FUNC_MAP_MACRO(vkFreeMemory) \
     IMGUI_VULKAN_FUNC_MAP_MACRO(vkGetBufferMemoryRequirements) \
+    IMGUI_VULKAN_FUNC_MAP_MACRO(vkGetFenceStatus) \
     IMGUI_VULKAN_FUNC_MAP_MACRO(vkGetImageMemoryRequirements) \
     IMGUI_VULKAN_FUNC_MAP_MACRO(vkGetPhysicalDeviceMemoryProperties) \
     IMGUI_VULKAN_FUNC_MAP_MACRO(vkGetPhysicalDeviceSurfaceCapabilitiesKHR) \
@@ -230,8 +253,10 @@ static bool g_FunctionsLoaded = true;
     IMGUI_VULKAN_FUNC_MAP_MACRO(vkQueueSubmit) \
     IMGUI_VULKAN_FUNC_MAP_MACRO(vkQueueWaitIdle) \
     IMGUI_VULKAN_FUNC_MAP_MACRO(vkResetCommandPool) \
+    IMGUI_VULKAN_FUNC_MAP_MACRO(vkResetFences) \
     IMGUI_VULKAN_FUNC_MAP_MACRO(vkUnmapMemory) \
-    IMGUI_VULKAN_FUNC_MAP_MACRO(vkUpdateDescriptorSets)
+    IMGUI_VULKAN_FUNC_MAP_MACRO(vkUpdateDescriptorSets) \
+    IMGUI_VULKAN_FUNC_MAP_MACRO(vkWaitForFences)
 
 // Define function pointers
 #define IMGUI_VULKAN_FUNC_DEF(func) static PFN_##func func;
@@ -263,6 +288,13 @@ static uint32_t __glsl_shader_frag_spv[] =
 #include "quickgui/shaders/imgui.frag.glsl.spv"
 };
 
+// imgui_bindless.frag, compiled with:
+// # glslangValidator -V -x -o imgui_bindless.frag.u32 imgui_bindless.frag
+static uint32_t __glsl_shader_frag_bindless_spv[] =
+{
+#include "quickgui/shaders/imgui_bindless.frag.glsl.spv"
+};
+
 //-----------------------------------------------------------------------------
 // FUNCTIONS
 //-----------------------------------------------------------------------------
@@ -275,6 +307,19 @@ static ImGui_ImplVulkan_Data* ImGui_ImplVulkan_GetBackendData()
     return ImGui::GetCurrentContext() ? (ImGui_ImplVulkan_Data*)ImGui::GetIO().BackendRendererUserData : nullptr;
 }
 
+// A bindless ImTextureID points into the backend-owned slot array, so it
+// can never be confused with a VkDescriptorSet handle.
+static bool ImGui_ImplVulkan_IsBindlessTextureID(ImGui_ImplVulkan_Data* bd, ImTextureID tex_id, uint32_t* index)
+{
+    if (bd->BindlessSlots == nullptr)
+        return false;
+    const uint32_t* slot = (const uint32_t*)tex_id;
+    if (slot < bd->BindlessSlots || slot >= bd->BindlessSlots + bd->VulkanInitInfo.BindlessTextureCount)
+        return false;
+    *index = (uint32_t)(slot - bd->BindlessSlots);
+    return true;
+}
+
 static uint32_t ImGui_ImplVulkan_MemoryType(VkMemoryPropertyFlags properties, uint32_t type_bits)
 {
     ImGui_ImplVulkan_Data* bd = ImGui_ImplVulkan_GetBackendData();
@@ -331,6 +376,31 @@ static void CreateOrResizeBuffer(VkBuffer& buffer, VkDeviceMemory& buffer_memory
     p_buffer_size = req.size;
 }
 
+static void ImGui_ImplVulkan_SetupPushConstants(ImDrawData* draw_data, VkCommandBuffer command_buffer, VkPipelineLayout pipeline_layout)
+{
+    // Setup scale and translation:
+    // Our visible imgui space lies from draw_data->DisplayPps (top left) to draw_data->DisplayPos+data_data->DisplaySize (bottom right). DisplayPos is (0,0) for single viewport apps.
+    // They are kept in the render state, for the callbacks using their own pipeline.
+    ImGui_ImplVulkan_Data* bd = ImGui_ImplVulkan_GetBackendData();
+    float* scale = bd->RenderState.Scale;
+    scale[0] = 2.0f / draw_data->DisplaySize.x;
+    scale[1] = 2.0f / draw_data->DisplaySize.y;
+    float* translate = bd->RenderState.Translate;
+    translate[0] = -1.0f - draw_data->DisplayPos.x * scale[0];
+    translate[1] = -1.0f - draw_data->DisplayPos.y * scale[1];
+    vkCmdPushConstants(command_buffer, pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT, sizeof(float) * 0, sizeof(float) * 2, scale);
+    vkCmdPushConstants(command_buffer, pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT, sizeof(float) * 2, sizeof(float) * 2, translate);
+}
+
+// Switch to the bindless pipeline: the table is bound once, and each draw then only pushes its texture index.
+static void ImGui_ImplVulkan_SetupBindlessState(ImDrawData* draw_data, VkCommandBuffer command_buffer)
+{
+    ImGui_ImplVulkan_Data* bd = ImGui_ImplVulkan_GetBackendData();
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, bd->BindlessPipeline);
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, bd->BindlessPipelineLayout, 0, 1, &bd->BindlessSet, 0, nullptr);
+    ImGui_ImplVulkan_SetupPushConstants(draw_data, command_buffer, bd->BindlessPipelineLayout);
+}
+
 static void ImGui_ImplVulkan_SetupRenderState(ImDrawData* draw_data, VkPipeline pipeline, VkCommandBuffer command_buffer, ImGui_ImplVulkanH_FrameRenderBuffers* rb, int fb_width, int fb_height)
 {
     ImGui_ImplVulkan_Data* bd = ImGui_ImplVulkan_GetBackendData();
@@ -362,17 +432,7 @@ static void ImGui_ImplVulkan_SetupRenderState(ImDrawData* draw_data, VkPipeline
     }
 
     // Setup scale and translation:
-    // Our visible imgui space lies from draw_data->DisplayPps (top left) to draw_data->DisplayPos+data_data->DisplaySize (bottom right). DisplayPos is (0,0) for single viewport apps.
-    {
-        float scale[2];
-        scale[0] = 2.0f / draw_data->DisplaySize.x;
-        scale[1] = 2.0f / draw_data->DisplaySize.y;
-        float translate[2];
-        translate[0] = -1.0f - draw_data->DisplayPos.x * scale[0];
-        translate[1] = -1.0f - draw_data->DisplayPos.y * scale[1];
-        vkCmdPushConstants(command_buffer, bd->PipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, sizeof(float) * 0, sizeof(float) * 2, scale);
-        vkCmdPushConstants(command_buffer, bd->PipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, sizeof(float) * 2, sizeof(float) * 2, translate);
-    }
+    ImGui_ImplVulkan_SetupPushConstants(draw_data, command_buffer, bd->PipelineLayout);
 }
 
 // Render function
@@ -445,11 +505,19 @@ void ImGui_ImplVulkan_RenderDrawData(ImDrawData* draw_data, VkCommandBuffer comm
 
     // Setup desired Vulkan state
     ImGui_ImplVulkan_SetupRenderState(draw_data, pipeline, command_buffer, rb, fb_width, fb_height);
+    ImGui_ImplVulkan_RenderState* rs = &bd->RenderState;
+    rs->CommandBuffer = command_buffer;
+    rs->UserState = false;
 
     // Will project scissor/clipping rectangles into framebuffer space
     ImVec2 clip_off = draw_data->DisplayPos;         // (0,0) unless using multi-viewports
     ImVec2 clip_scale = draw_data->FramebufferScale; // (1,1) unless using retina display which are often (2,2)
 
+    // Bindless textures are drawn with their own pipeline; we switch lazily
+    // between it and the per-descriptor-set pipeline as the draw commands require.
+    bool bindless_bound = false;
+    uint32_t bindless_index = (uint32_t)-1;
+
     // Render command lists
     // (Because we merged all buffers into a single one, we maintain our own offset into them)
     int global_vtx_offset = 0;
@@ -465,7 +533,11 @@ void ImGui_ImplVulkan_RenderDrawData(ImDrawData* draw_data, VkCommandBuffer comm
                 // User callback, registered via ImDrawList::AddCallback()
                 // (ImDrawCallback_ResetRenderState is a special callback value used by the user to request the renderer to reset render state.)
                 if (pcmd->UserCallback == ImDrawCallback_ResetRenderState)
+                {
                     ImGui_ImplVulkan_SetupRenderState(draw_data, pipeline, command_buffer, rb, fb_width, fb_height);
+                    bindless_bound = false;
+                    rs->UserState = false;
+                }
                 else
                     pcmd->UserCallback(cmd_list, pcmd);
             }
@@ -491,15 +563,44 @@ void ImGui_ImplVulkan_RenderDrawData(ImDrawData* draw_data, VkCommandBuffer comm
                 scissor.extent.height = (uint32_t)(clip_max.y - clip_min.y);
                 vkCmdSetScissor(command_buffer, 0, 1, &scissor);
 
-                // Bind DescriptorSet with font or user texture
-                VkDescriptorSet desc_set[1] = { (VkDescriptorSet)pcmd->TextureId };
-                if (sizeof(ImTextureID) < sizeof(ImU64))
+                uint32_t tex_index;
+                if (rs->UserState)
+                {
+                    // The callback bound the pipeline and the texture
+                }
+                else if (ImGui_ImplVulkan_IsBindlessTextureID(bd, pcmd->TextureId, &tex_index))
+                {
+                    // Index into the bindless table with font or user texture
+                    if (!bindless_bound)
+                    {
+                        ImGui_ImplVulkan_SetupBindlessState(draw_data, command_buffer);
+                        bindless_bound = true;
+                        bindless_index = (uint32_t)-1;
+                    }
+                    if (tex_index != bindless_index)
+                    {
+                        vkCmdPushConstants(command_buffer, bd->BindlessPipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, sizeof(float) * 4, sizeof(uint32_t), &tex_index);
+                        bindless_index = tex_index;
+                    }
+                }
+                else
                 {
-                    // We don't support texture switches if ImTextureID hasn't been redefined to be 64-bit. Do a flaky check that other textures haven't been used.
-                    IM_ASSERT(pcmd->TextureId == (ImTextureID)bd->FontDescriptorSet);
-                    desc_set[0] = bd->FontDescriptorSet;
+                    if (bindless_bound)
+                    {
+                        vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+                        ImGui_ImplVulkan_SetupPushConstants(draw_data, command_buffer, bd->PipelineLayout);
+                        bindless_bound = false;
+                    }
+                    // Bind DescriptorSet with font or user texture
+                    VkDescriptorSet desc_set[1] = { (VkDescriptorSet)pcmd->TextureId };
+                    if (sizeof(ImTextureID) < sizeof(ImU64))
+                    {
+                        // We don't support texture switches if ImTextureID hasn't been redefined to be 64-bit. Do a flaky check that other textures haven't been used.
+                        IM_ASSERT(pcmd->TextureId == (ImTextureID)bd->FontDescriptorSet);
+                        desc_set[0] = bd->FontDescriptorSet;
+                    }
+                    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, bd->PipelineLayout, 0, 1, desc_set, 0, nullptr);
                 }
-                vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, bd->PipelineLayout, 0, 1, desc_set, 0, nullptr);
 
                 // Draw
                 vkCmdDrawIndexed(command_buffer, pcmd->ElemCount, 1, pcmd->IdxOffset + global_idx_offset, pcmd->VtxOffset + global_vtx_offset, 0);
@@ -518,6 +619,38 @@ void ImGui_ImplVulkan_RenderDrawData(ImDrawData* draw_data, VkCommandBuffer comm
     // We perform a call to vkCmdSetScissor() to set back a full viewport which is likely to fix things for 99% users but technically this is not perfect. (See github #4644)
     VkRect2D scissor = { { 0, 0 }, { (uint32_t)fb_width, (uint32_t)fb_height } };
     vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+    rs->CommandBuffer = VK_NULL_HANDLE;
+    rs->UserState = false;
+}
+
+ImGui_ImplVulkan_RenderState* ImGui_ImplVulkan_GetRenderState()
+{
+    ImGui_ImplVulkan_Data* bd = ImGui_ImplVulkan_GetBackendData();
+    IM_ASSERT(bd->RenderState.CommandBuffer != VK_NULL_HANDLE && "Only valid in the draw callbacks");
+    return &bd->RenderState;
+}
+
+// Release the font upload buffer once its copy is done. With wait=false, this returns false if the copy is still running.
+static bool ImGui_ImplVulkan_ReleaseFontUploadBuffer(bool wait)
+{
+    ImGui_ImplVulkan_Data* bd = ImGui_ImplVulkan_GetBackendData();
+    ImGui_ImplVulkan_InitInfo* v = &bd->VulkanInitInfo;
+    if (bd->FontUploadBuffer == VK_NULL_HANDLE)
+        return true;
+    if (wait)
+    {
+        VkResult err = vkWaitForFences(v->Device, 1, &bd->FontFence, VK_TRUE, UINT64_MAX);
+        check_vk_result(err);
+    }
+    else if (vkGetFenceStatus(v->Device, bd->FontFence) != VK_SUCCESS)
+    {
+        return false;
+    }
+    vkDestroyBuffer(v->Device, bd->FontUploadBuffer, v->Allocator);
+    vkFreeMemory(v->Device, bd->FontUploadBufferMemory, v->Allocator);
+    bd->FontUploadBuffer = VK_NULL_HANDLE;
+    bd->FontUploadBufferMemory = VK_NULL_HANDLE;
+    return true;
 }
 
 bool ImGui_ImplVulkan_CreateFontsTexture()
@@ -533,6 +666,7 @@ bool ImGui_ImplVulkan_CreateFontsTexture()
         vkQueueWaitIdle(v->Queue);
         ImGui_ImplVulkan_DestroyFontsTexture();
     }
+    ImGui_ImplVulkan_ReleaseFontUploadBuffer(/*wait*/true);
 
     // Create command pool/buffer
     if (bd->FontCommandPool == VK_NULL_HANDLE)
@@ -552,6 +686,18 @@ bool ImGui_ImplVulkan_CreateFontsTexture()
         err = vkAllocateCommandBuffers(v->Device, &info, &bd->FontCommandBuffer);
         check_vk_result(err);
     }
+    if (bd->FontFence == VK_NULL_HANDLE)
+    {
+        VkFenceCreateInfo info = {};
+        info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        err = vkCreateFence(v->Device, &info, v->Allocator, &bd->FontFence);
+        check_vk_result(err);
+    }
+    else
+    {
+        err = vkResetFences(v->Device, 1, &bd->FontFence);
+        check_vk_result(err);
+    }
 
     // Start command buffer
     {
@@ -694,7 +840,15 @@ bool ImGui_ImplVulkan_CreateFontsTexture()
     }
 
     // Store our identifier
-    io.Fonts->SetTexID((ImTextureID)bd->FontDescriptorSet);
+    if (bd->BindlessSlots != nullptr)
+    {
+        bd->FontBindlessIndex = ImGui_ImplVulkan_AddBindlessTexture(bd->FontSampler, bd->FontView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        io.Fonts->SetTexID(ImGui_ImplVulkan_BindlessTextureID(bd->FontBindlessIndex));
+    }
+    else
+    {
+        io.Fonts->SetTexID((ImTextureID)bd->FontDescriptorSet);
+    }
 
     // End command buffer
     VkSubmitInfo end_info = {};
@@ -703,14 +857,14 @@ bool ImGui_ImplVulkan_CreateFontsTexture()
     end_info.pCommandBuffers = &bd->FontCommandBuffer;
     err = vkEndCommandBuffer(bd->FontCommandBuffer);
     check_vk_result(err);
-    err = vkQueueSubmit(v->Queue, 1, &end_info, VK_NULL_HANDLE);
+    err = vkQueueSubmit(v->Queue, 1, &end_info, bd->FontFence);
     check_vk_result(err);
 
-    err = vkDeviceWaitIdle(v->Device);
-    check_vk_result(err);
-
-    vkDestroyBuffer(v->Device, upload_buffer, v->Allocator);
-    vkFreeMemory(v->Device, upload_buffer_memory, v->Allocator);
+    // Do not wait for the copy: the queue executes it before the frames
+    // using the texture. The upload buffer is released by NewFrame()
+    // once the fence is signaled.
+    bd->FontUploadBuffer = upload_buffer;
+    bd->FontUploadBufferMemory = upload_buffer_memory;
 
     return true;
 }
@@ -728,6 +882,11 @@ void ImGui_ImplVulkan_DestroyFontsTexture()
         bd->FontDescriptorSet = VK_NULL_HANDLE;
         io.Fonts->SetTexID(0);
     }
+    if (bd->FontBindlessIndex != (uint32_t)-1)
+    {
+        ImGui_ImplVulkan_RemoveBindlessTexture(bd->FontBindlessIndex);
+        bd->FontBindlessIndex = (uint32_t)-1;
+    }
 
     if (bd->FontView)   { vkDestroyImageView(v->Device, bd->FontView, v->Allocator); bd->FontView = VK_NULL_HANDLE; }
     if (bd->FontImage)  { vkDestroyImage(v->Device, bd->FontImage, v->Allocator); bd->FontImage = VK_NULL_HANDLE; }
@@ -756,9 +915,18 @@ static void ImGui_ImplVulkan_CreateShaderModules(VkDevice device, const VkAlloca
         VkResult err = vkCreateShaderModule(device, &frag_info, allocator, &bd->ShaderModuleFrag);
         check_vk_result(err);
     }
+    if (bd->ShaderModuleFragBindless == VK_NULL_HANDLE && bd->VulkanInitInfo.BindlessTextureCount > 0)
+    {
+        VkShaderModuleCreateInfo frag_info = {};
+        frag_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        frag_info.codeSize = sizeof(__glsl_shader_frag_bindless_spv);
+        frag_info.pCode = (uint32_t*)__glsl_shader_frag_bindless_spv;
+        VkResult err = vkCreateShaderModule(device, &frag_info, allocator, &bd->ShaderModuleFragBindless);
+        check_vk_result(err);
+    }
 }
 
-static void ImGui_ImplVulkan_CreatePipeline(VkDevice device, const VkAllocationCallbacks* allocator, VkPipelineCache pipelineCache, VkRenderPass renderPass, VkSampleCountFlagBits MSAASamples, VkPipeline* pipeline, uint32_t subpass)
+static void ImGui_ImplVulkan_CreatePipeline(VkDevice device, const VkAllocationCallbacks* allocator, VkPipelineCache pipelineCache, VkRenderPass renderPass, VkSampleCountFlagBits MSAASamples, VkPipeline* pipeline, uint32_t subpass, bool bindless = false, VkShaderModule user_frag = VK_NULL_HANDLE, VkPipelineLayout user_layout = VK_NULL_HANDLE)
 {
     ImGui_ImplVulkan_Data* bd = ImGui_ImplVulkan_GetBackendData();
     ImGui_ImplVulkan_CreateShaderModules(device, allocator);
@@ -770,7 +938,7 @@ static void ImGui_ImplVulkan_CreatePipeline(VkDevice device, const VkAllocationC
     stage[0].pName = "main";
     stage[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
     stage[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-    stage[1].module = bd->ShaderModuleFrag;
+    stage[1].module = user_frag ? user_frag : bindless ? bd->ShaderModuleFragBindless : bd->ShaderModuleFrag;
     stage[1].pName = "main";
 
     VkVertexInputBindingDescription binding_desc[1] = {};
@@ -855,7 +1023,7 @@ static void ImGui_ImplVulkan_CreatePipeline(VkDevice device, const VkAllocationC
     info.pDepthStencilState = &depth_info;
     info.pColorBlendState = &blend_info;
     info.pDynamicState = &dynamic_state;
-    info.layout = bd->PipelineLayout;
+    info.layout = user_layout ? user_layout : bindless ? bd->BindlessPipelineLayout : bd->PipelineLayout;
     info.renderPass = renderPass;
     info.subpass = subpass;
 
@@ -875,6 +1043,16 @@ static void ImGui_ImplVulkan_CreatePipeline(VkDevice device, const VkAllocationC
     check_vk_result(err);
 }
 
+VkPipeline ImGui_ImplVulkan_CreateUserPipeline(VkShaderModule frag_module, VkPipelineLayout pipeline_layout)
+{
+    ImGui_ImplVulkan_Data* bd = ImGui_ImplVulkan_GetBackendData();
+    ImGui_ImplVulkan_InitInfo* v = &bd->VulkanInitInfo;
+    IM_ASSERT(frag_module != VK_NULL_HANDLE && pipeline_layout != VK_NULL_HANDLE);
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    ImGui_ImplVulkan_CreatePipeline(v->Device, v->Allocator, v->PipelineCache, bd->RenderPass, v->MSAASamples, &pipeline, bd->Subpass, /*bindless*/false, frag_module, pipeline_layout);
+    return pipeline;
+}
+
 bool ImGui_ImplVulkan_CreateDeviceObjects()
 {
     ImGui_ImplVulkan_Data* bd = ImGui_ImplVulkan_GetBackendData();
@@ -933,6 +1111,84 @@ bool ImGui_ImplVulkan_CreateDeviceObjects()
 
     ImGui_ImplVulkan_CreatePipeline(v->Device, v->Allocator, v->PipelineCache, bd->RenderPass, v->MSAASamples, &bd->Pipeline, bd->Subpass);
 
+    if (v->BindlessTextureCount > 0)
+    {
+        if (!bd->BindlessSetLayout)
+        {
+            // A single large array of combined image samplers. Entries may be
+            // left unwritten, and may be written while the set is in use by
+            // frames still in flight.
+            VkDescriptorSetLayoutBinding binding[1] = {};
+            binding[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            binding[0].descriptorCount = v->BindlessTextureCount;
+            binding[0].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+            VkDescriptorBindingFlags binding_flags[1] = { VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT };
+            VkDescriptorSetLayoutBindingFlagsCreateInfo flags_info = {};
+            flags_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+            flags_info.bindingCount = 1;
+            flags_info.pBindingFlags = binding_flags;
+            VkDescriptorSetLayoutCreateInfo info = {};
+            info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+            info.pNext = &flags_info;
+            info.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+            info.bindingCount = 1;
+            info.pBindings = binding;
+            err = vkCreateDescriptorSetLayout(v->Device, &info, v->Allocator, &bd->BindlessSetLayout);
+            check_vk_result(err);
+        }
+
+        if (!bd->BindlessPool)
+        {
+            VkDescriptorPoolSize pool_size[1] = { { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, v->BindlessTextureCount } };
+            VkDescriptorPoolCreateInfo pool_info = {};
+            pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+            pool_info.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+            pool_info.maxSets = 1;
+            pool_info.poolSizeCount = 1;
+            pool_info.pPoolSizes = pool_size;
+            err = vkCreateDescriptorPool(v->Device, &pool_info, v->Allocator, &bd->BindlessPool);
+            check_vk_result(err);
+            VkDescriptorSetAllocateInfo alloc_info = {};
+            alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+            alloc_info.descriptorPool = bd->BindlessPool;
+            alloc_info.descriptorSetCount = 1;
+            alloc_info.pSetLayouts = &bd->BindlessSetLayout;
+            err = vkAllocateDescriptorSets(v->Device, &alloc_info, &bd->BindlessSet);
+            check_vk_result(err);
+        }
+
+        if (!bd->BindlessPipelineLayout)
+        {
+            // Constants: same as the regular pipeline, plus the texture index for the fragment stage
+            VkPushConstantRange push_constants[2] = {};
+            push_constants[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+            push_constants[0].offset = sizeof(float) * 0;
+            push_constants[0].size = sizeof(float) * 4;
+            push_constants[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+            push_constants[1].offset = sizeof(float) * 4;
+            push_constants[1].size = sizeof(uint32_t);
+            VkDescriptorSetLayout set_layout[1] = { bd->BindlessSetLayout };
+            VkPipelineLayoutCreateInfo layout_info = {};
+            layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+            layout_info.setLayoutCount = 1;
+            layout_info.pSetLayouts = set_layout;
+            layout_info.pushConstantRangeCount = 2;
+            layout_info.pPushConstantRanges = push_constants;
+            err = vkCreatePipelineLayout(v->Device, &layout_info, v->Allocator, &bd->BindlessPipelineLayout);
+            check_vk_result(err);
+        }
+
+        if (bd->BindlessSlots == nullptr)
+        {
+            bd->BindlessSlots = (uint32_t*)IM_ALLOC(sizeof(uint32_t) * v->BindlessTextureCount);
+            for (uint32_t i = 0; i < v->BindlessTextureCount; i++)
+                bd->BindlessSlots[i] = i + 1;
+            bd->BindlessFreeHead = 0;
+        }
+
+        ImGui_ImplVulkan_CreatePipeline(v->Device, v->Allocator, v->PipelineCache, bd->RenderPass, v->MSAASamples, &bd->BindlessPipeline, bd->Subpass, /*bindless*/true);
+    }
+
     return true;
 }
 
@@ -942,7 +1198,9 @@ void    ImGui_ImplVulkan_DestroyDeviceObjects()
     ImGui_ImplVulkan_InitInfo* v = &bd->VulkanInitInfo;
     ImGui_ImplVulkanH_DestroyWindowRenderBuffers(v->Device, &bd->MainWindowRenderBuffers, v->Allocator);
     ImGui_ImplVulkan_DestroyFontsTexture();
+    ImGui_ImplVulkan_ReleaseFontUploadBuffer(/*wait*/true);
 
+    if (bd->FontFence)            { vkDestroyFence(v->Device, bd->FontFence, v->Allocator); bd->FontFence = VK_NULL_HANDLE; }
     if (bd->FontCommandPool)      { vkDestroyCommandPool(v->Device, bd->FontCommandPool, v->Allocator); bd->FontCommandPool = VK_NULL_HANDLE; }
     if (bd->ShaderModuleVert)     { vkDestroyShaderModule(v->Device, bd->ShaderModuleVert, v->Allocator); bd->ShaderModuleVert = VK_NULL_HANDLE; }
     if (bd->ShaderModuleFrag)     { vkDestroyShaderModule(v->Device, bd->ShaderModuleFrag, v->Allocator); bd->ShaderModuleFrag = VK_NULL_HANDLE; }
@@ -950,6 +1208,12 @@ void    ImGui_ImplVulkan_DestroyDeviceObjects()
     if (bd->DescriptorSetLayout)  { vkDestroyDescriptorSetLayout(v->Device, bd->DescriptorSetLayout, v->Allocator); bd->DescriptorSetLayout = VK_NULL_HANDLE; }
     if (bd->PipelineLayout)       { vkDestroyPipelineLayout(v->Device, bd->PipelineLayout, v->Allocator); bd->PipelineLayout = VK_NULL_HANDLE; }
     if (bd->Pipeline)             { vkDestroyPipeline(v->Device, bd->Pipeline, v->Allocator); bd->Pipeline = VK_NULL_HANDLE; }
+    if (bd->ShaderModuleFragBindless) { vkDestroyShaderModule(v->Device, bd->ShaderModuleFragBindless, v->Allocator); bd->ShaderModuleFragBindless = VK_NULL_HANDLE; }
+    if (bd->BindlessPool)         { vkDestroyDescriptorPool(v->Device, bd->BindlessPool, v->Allocator); bd->BindlessPool = VK_NULL_HANDLE; bd->BindlessSet = VK_NULL_HANDLE; }
+    if (bd->BindlessSetLayout)    { vkDestroyDescriptorSetLayout(v->Device, bd->BindlessSetLayout, v->Allocator); bd->BindlessSetLayout = VK_NULL_HANDLE; }
+    if (bd->BindlessPipelineLayout) { vkDestroyPipelineLayout(v->Device, bd->BindlessPipelineLayout, v->Allocator); bd->BindlessPipelineLayout = VK_NULL_HANDLE; }
+    if (bd->BindlessPipeline)     { vkDestroyPipeline(v->Device, bd->BindlessPipeline, v->Allocator); bd->BindlessPipeline = VK_NULL_HANDLE; }
+    if (bd->BindlessSlots)        { IM_FREE(bd->BindlessSlots); bd->BindlessSlots = nullptr; }
 }
 
 bool    ImGui_ImplVulkan_LoadFunctions(PFN_vkVoidFunction(*loader_func)(const char* function_name, void* user_data), void* user_data)
@@ -1046,6 +1310,8 @@ void ImGui_ImplVulkan_NewFrame()
 
     if (!bd->FontDescriptorSet)
         ImGui_ImplVulkan_CreateFontsTexture();
+    else
+        ImGui_ImplVulkan_ReleaseFontUploadBuffer(/*wait*/false);
 }
 
 void ImGui_ImplVulkan_SetMinImageCount(uint32_t min_image_count)
@@ -1062,6 +1328,18 @@ void ImGui_ImplVulkan_SetMinImageCount(uint32_t min_image_count)
     bd->VulkanInitInfo.MinImageCount = min_image_count;
 }
 
+VkDeviceSize ImGui_ImplVulkan_GetRenderBuffersSize()
+{
+    ImGui_ImplVulkan_Data* bd = ImGui_ImplVulkan_GetBackendData();
+    if (bd == nullptr)
+        return 0;
+    VkDeviceSize size = 0;
+    ImGui_ImplVulkanH_WindowRenderBuffers* wrb = &bd->MainWindowRenderBuffers;
+    for (uint32_t i = 0; wrb->FrameRenderBuffers != nullptr && i < wrb->Count; i++)
+        size += wrb->FrameRenderBuffers[i].VertexBufferSize + wrb->FrameRenderBuffers[i].IndexBufferSize;
+    return size;
+}
+
 // Register a texture
 // FIXME: This is experimental in the sense that we are unsure how to best design/tackle this problem, please post to https://github.com/ocornut/imgui/pull/914 if you have suggestions.
 VkDescriptorSet ImGui_ImplVulkan_AddTexture(VkSampler sampler, VkImageView image_view, VkImageLayout image_layout)
@@ -1105,6 +1383,61 @@ void ImGui_ImplVulkan_RemoveTexture(VkDescriptorSet descriptor_set)
     vkFreeDescriptorSets(v->Device, v->DescriptorPool, 1, &descriptor_set);
 }
 
+bool ImGui_ImplVulkan_HasBindlessTextures()
+{
+    ImGui_ImplVulkan_Data* bd = ImGui_ImplVulkan_GetBackendData();
+    return bd != nullptr && bd->BindlessSlots != nullptr;
+}
+
+// Register a texture in the bindless table. Returns its index in the table.
+uint32_t ImGui_ImplVulkan_AddBindlessTexture(VkSampler sampler, VkImageView image_view, VkImageLayout image_layout)
+{
+    ImGui_ImplVulkan_Data* bd = ImGui_ImplVulkan_GetBackendData();
+    ImGui_ImplVulkan_InitInfo* v = &bd->VulkanInitInfo;
+    IM_ASSERT(bd->BindlessSlots != nullptr && "Bindless textures are not enabled: set ImGui_ImplVulkan_InitInfo::BindlessTextureCount");
+    IM_ASSERT(bd->BindlessFreeHead < v->BindlessTextureCount && "Bindless texture table is full");
+
+    // Pop a slot from the free list
+    const uint32_t index = bd->BindlessFreeHead;
+    bd->BindlessFreeHead = bd->BindlessSlots[index];
+    bd->BindlessSlots[index] = index;
+
+    // Update the table entry:
+    VkDescriptorImageInfo desc_image[1] = {};
+    desc_image[0].sampler = sampler;
+    desc_image[0].imageView = image_view;
+    desc_image[0].imageLayout = image_layout;
+    VkWriteDescriptorSet write_desc[1] = {};
+    write_desc[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write_desc[0].dstSet = bd->BindlessSet;
+    write_desc[0].dstArrayElement = index;
+    write_desc[0].descriptorCount = 1;
+    write_desc[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write_desc[0].pImageInfo = desc_image;
+    vkUpdateDescriptorSets(v->Device, 1, write_desc, 0, nullptr);
+    return index;
+}
+
+// The table entry is left as is: it is partially bound, so a stale entry is
+// harmless as long as no draw uses it, and it is overwritten when reused.
+void ImGui_ImplVulkan_RemoveBindlessTexture(uint32_t index)
+{
+    ImGui_ImplVulkan_Data* bd = ImGui_ImplVulkan_GetBackendData();
+    IM_ASSERT(bd->BindlessSlots != nullptr);
+    IM_ASSERT(index < bd->VulkanInitInfo.BindlessTextureCount);
+    IM_ASSERT(bd->BindlessSlots[index] == index && "texture index was already removed");
+    bd->BindlessSlots[index] = bd->BindlessFreeHead;
+    bd->BindlessFreeHead = index;
+}
+
+ImTextureID ImGui_ImplVulkan_BindlessTextureID(uint32_t index)
+{
+    ImGui_ImplVulkan_Data* bd = ImGui_ImplVulkan_GetBackendData();
+    IM_ASSERT(bd->BindlessSlots != nullptr);
+    IM_ASSERT(index < bd->VulkanInitInfo.BindlessTextureCount);
+    return (ImTextureID)(bd->BindlessSlots + index);
+}
+
 //-------------------------------------------------------------------------
 // Internal / Miscellaneous Vulkan Helpers
 // (Used by example's main.cpp. Used by multi-viewport features. PROBABLY NOT used by your own app.)
@@ -1195,12 +1528,14 @@ void ImGui_ImplVulkanH_CreateWindowCommandBuffers(VkPhysicalDevice physical_devi
     (void)physical_device;
     (void)allocator;
 
-    // Create Command Buffers
+    // Create Command Buffers. The frames kept across a resize already have them.
     VkResult err;
     for (uint32_t i = 0; i < wd->ImageCount; i++)
     {
         ImGui_ImplVulkanH_Frame* fd = &wd->Frames[i];
         ImGui_ImplVulkanH_FrameSemaphores* fsd = &wd->FrameSemaphores[i];
+        if (fd->CommandPool == VK_NULL_HANDLE)
+        {
         {
             VkCommandPoolCreateInfo info = {};
             info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
@@ -1226,6 +1561,7 @@ void ImGui_ImplVulkanH_CreateWindowCommandBuffers(VkPhysicalDevice physical_devi
             err = vkCreateFence(device, &info, allocator, &fd->Fence);
             check_vk_result(err);
         }
+        }
         {
             VkSemaphoreCreateInfo info = {};
             info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
@@ -1274,7 +1610,20 @@ void ImGui_ImplVulkanH_CreateWindowSwapChain(VkPhysicalDevice physical_device, V
         vkDestroyRenderPass(device, wd->RenderPass, allocator);
     if (wd->Pipeline)
         vkDestroyPipeline(device, wd->Pipeline, allocator);
+    wd->RenderPass = VK_NULL_HANDLE;
+    wd->Pipeline = VK_NULL_HANDLE;
 
+    ImGui_ImplVulkanH_CreateSwapchainFrames(physical_device, device, wd, allocator, w, h, min_image_count, old_swapchain);
+    if (old_swapchain)
+        vkDestroySwapchainKHR(device, old_swapchain, allocator);
+
+    ImGui_ImplVulkanH_CreateWindowFramebuffers(device, wd, allocator, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+}
+
+// Create the swapchain, and the frames for its images. The frames are zero-cleared.
+static void ImGui_ImplVulkanH_CreateSwapchainFrames(VkPhysicalDevice physical_device, VkDevice device, ImGui_ImplVulkanH_Window* wd, const VkAllocationCallbacks* allocator, int w, int h, uint32_t min_image_count, VkSwapchainKHR old_swapchain)
+{
+    VkResult err;
     // If min image count was not specified, request different count of images dependent on selected present mode
     if (min_image_count == 0)
         min_image_count = (uint32_t)ImGui_ImplVulkanH_GetMinImageCountFromPresentMode(wd->PresentMode);
@@ -1302,6 +1651,10 @@ void ImGui_ImplVulkanH_CreateWindowSwapChain(VkPhysicalDevice physical_device, V
             info.minImageCount = cap.minImageCount;
         else if (cap.maxImageCount != 0 && info.minImageCount > cap.maxImageCount)
             info.minImageCount = cap.maxImageCount;
+        // allow reading back the swapchain images
+        if (cap.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT)
+            info.imageUsage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        wd->ImageUsage = info.imageUsage;
 
         if (cap.currentExtent.width == 0xffffffff)
         {
@@ -1331,11 +1684,80 @@ void ImGui_ImplVulkanH_CreateWindowSwapChain(VkPhysicalDevice physical_device, V
         for (uint32_t i = 0; i < wd->ImageCount; i++)
             wd->Frames[i].Backbuffer = backbuffers[i];
     }
-    if (old_swapchain)
-        vkDestroySwapchainKHR(device, old_swapchain, allocator);
+}
 
-    // Create the Render Pass
-    if (wd->UseDynamicRendering == false)
+// Resize without waiting for the device: the swapchain is recreated from
+// the old one, and the frames keep their command pools and fences. The old
+// swapchain, views, framebuffers and semaphores are moved to retired, and
+// must be destroyed once the GPU is done with them.
+void ImGui_ImplVulkanH_ResizeWindow(VkPhysicalDevice physical_device, VkDevice device, ImGui_ImplVulkanH_Window* wd, uint32_t queue_family, const VkAllocationCallbacks* allocator, int w, int h, uint32_t min_image_count, ImGui_ImplVulkanH_RetiredWindow* retired)
+{
+    IM_ASSERT(g_FunctionsLoaded && "Need to call ImGui_ImplVulkan_LoadFunctions() if IMGUI_IMPL_VULKAN_NO_PROTOTYPES or VK_NO_PROTOTYPES are set!");
+    IM_ASSERT(wd->Swapchain != VK_NULL_HANDLE && wd->RenderPass != VK_NULL_HANDLE);
+    retired->Swapchain = wd->Swapchain;
+    retired->ImageCount = wd->ImageCount;
+    retired->Frames = wd->Frames;
+    retired->FrameSemaphores = wd->FrameSemaphores;
+    wd->Swapchain = VK_NULL_HANDLE;
+    wd->Frames = nullptr;
+    wd->FrameSemaphores = nullptr;
+    wd->ImageCount = 0;
+
+    ImGui_ImplVulkanH_CreateSwapchainFrames(physical_device, device, wd, allocator, w, h, min_image_count, retired->Swapchain);
+    const uint32_t num_kept = wd->ImageCount < retired->ImageCount ? wd->ImageCount : retired->ImageCount;
+    for (uint32_t i = 0; i < num_kept; i++)
+    {
+        ImGui_ImplVulkanH_Frame* fd = &wd->Frames[i];
+        ImGui_ImplVulkanH_Frame* old = &retired->Frames[i];
+        fd->CommandPool = old->CommandPool;
+        fd->CommandBuffer = old->CommandBuffer;
+        fd->CommandBuffer2 = old->CommandBuffer2;
+        fd->Fence = old->Fence;
+        old->CommandPool = VK_NULL_HANDLE;
+        old->CommandBuffer = VK_NULL_HANDLE;
+        old->CommandBuffer2 = VK_NULL_HANDLE;
+        old->Fence = VK_NULL_HANDLE;
+    }
+    // the render pass is kept: the format does not change
+    ImGui_ImplVulkanH_CreateWindowFramebuffers(device, wd, allocator, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+    // the extra frames, and the semaphores of all
+    ImGui_ImplVulkanH_CreateWindowCommandBuffers(physical_device, device, wd, queue_family, allocator);
+    wd->FrameIndex = 0;
+    wd->SemaphoreIndex = 0;
+}
+
+void ImGui_ImplVulkanH_DestroyRetiredWindow(VkDevice device, ImGui_ImplVulkanH_RetiredWindow* retired, const VkAllocationCallbacks* allocator)
+{
+    for (uint32_t i = 0; i < retired->ImageCount; i++)
+    {
+        ImGui_ImplVulkanH_Frame* fd = &retired->Frames[i];
+        if (fd->CommandPool) // not kept by the window
+        {
+            ImGui_ImplVulkanH_DestroyFrame(device, fd, allocator);
+        }
+        else
+        {
+            vkDestroyImageView(device, fd->BackbufferView, allocator);
+            vkDestroyFramebuffer(device, fd->Framebuffer, allocator);
+        }
+        ImGui_ImplVulkanH_DestroyFrameSemaphores(device, &retired->FrameSemaphores[i], allocator);
+    }
+    IM_FREE(retired->Frames);
+    IM_FREE(retired->FrameSemaphores);
+    if (retired->Swapchain)
+        vkDestroySwapchainKHR(device, retired->Swapchain, allocator);
+    retired->Swapchain = VK_NULL_HANDLE;
+    retired->ImageCount = 0;
+    retired->Frames = nullptr;
+    retired->FrameSemaphores = nullptr;
+}
+
+// Create the render pass, and the views and framebuffers of the backbuffers
+static void ImGui_ImplVulkanH_CreateWindowFramebuffers(VkDevice device, ImGui_ImplVulkanH_Window* wd, const VkAllocationCallbacks* allocator, VkImageLayout final_layout)
+{
+    VkResult err;
+    // Create the Render Pass, unless it is kept from a resize
+    if (wd->UseDynamicRendering == false && wd->RenderPass == VK_NULL_HANDLE)
     {
         VkAttachmentDescription attachment = {};
         attachment.format = wd->SurfaceFormat.format;
@@ -1345,7 +1767,7 @@ void ImGui_ImplVulkanH_CreateWindowSwapChain(VkPhysicalDevice physical_device, V
         attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
         attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
         attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        attachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+        attachment.finalLayout = final_layout;
         VkAttachmentReference color_attachment = {};
         color_attachment.attachment = 0;
         color_attachment.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
@@ -1428,6 +1850,68 @@ void ImGui_ImplVulkanH_CreateOrResizeWindow(VkInstance instance, VkPhysicalDevic
     ImGui_ImplVulkanH_CreateWindowCommandBuffers(physical_device, device, wd, queue_family, allocator);
 }
 
+// Create a window without surface nor swapchain: the frames render to
+// images owned by the window, which are left in TRANSFER_SRC_OPTIMAL.
+void ImGui_ImplVulkanH_CreateOffscreenWindow(VkPhysicalDevice physical_device, VkDevice device, ImGui_ImplVulkanH_Window* wd, uint32_t queue_family, const VkAllocationCallbacks* allocator, int width, int height, uint32_t image_count)
+{
+    IM_ASSERT(g_FunctionsLoaded && "Need to call ImGui_ImplVulkan_LoadFunctions() if IMGUI_IMPL_VULKAN_NO_PROTOTYPES or VK_NO_PROTOTYPES are set!");
+    IM_ASSERT(wd->Frames == nullptr && wd->Swapchain == VK_NULL_HANDLE && wd->Surface == VK_NULL_HANDLE);
+    IM_ASSERT(width > 0 && height > 0 && image_count > 0);
+    VkResult err;
+    wd->Width = width;
+    wd->Height = height;
+    wd->ImageCount = image_count;
+    wd->ImageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    wd->Frames = (ImGui_ImplVulkanH_Frame*)IM_ALLOC(sizeof(ImGui_ImplVulkanH_Frame) * wd->ImageCount);
+    wd->FrameSemaphores = (ImGui_ImplVulkanH_FrameSemaphores*)IM_ALLOC(sizeof(ImGui_ImplVulkanH_FrameSemaphores) * wd->ImageCount);
+    memset(wd->Frames, 0, sizeof(wd->Frames[0]) * wd->ImageCount);
+    memset(wd->FrameSemaphores, 0, sizeof(wd->FrameSemaphores[0]) * wd->ImageCount);
+
+    // Create the images
+    VkPhysicalDeviceMemoryProperties mem_props;
+    vkGetPhysicalDeviceMemoryProperties(physical_device, &mem_props);
+    for (uint32_t i = 0; i < wd->ImageCount; i++)
+    {
+        ImGui_ImplVulkanH_Frame* fd = &wd->Frames[i];
+        VkImageCreateInfo info = {};
+        info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        info.imageType = VK_IMAGE_TYPE_2D;
+        info.format = wd->SurfaceFormat.format;
+        info.extent.width = (uint32_t)width;
+        info.extent.height = (uint32_t)height;
+        info.extent.depth = 1;
+        info.mipLevels = 1;
+        info.arrayLayers = 1;
+        info.samples = VK_SAMPLE_COUNT_1_BIT;
+        info.tiling = VK_IMAGE_TILING_OPTIMAL;
+        info.usage = wd->ImageUsage;
+        info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        err = vkCreateImage(device, &info, allocator, &fd->Backbuffer);
+        check_vk_result(err);
+        VkMemoryRequirements req;
+        vkGetImageMemoryRequirements(device, fd->Backbuffer, &req);
+        VkMemoryAllocateInfo alloc_info = {};
+        alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        alloc_info.allocationSize = req.size;
+        alloc_info.memoryTypeIndex = 0xFFFFFFFF;
+        for (uint32_t t = 0; t < mem_props.memoryTypeCount && alloc_info.memoryTypeIndex == 0xFFFFFFFF; t++)
+            if ((req.memoryTypeBits & (1u << t)) && (mem_props.memoryTypes[t].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT))
+                alloc_info.memoryTypeIndex = t;
+        for (uint32_t t = 0; t < mem_props.memoryTypeCount && alloc_info.memoryTypeIndex == 0xFFFFFFFF; t++)
+            if (req.memoryTypeBits & (1u << t))
+                alloc_info.memoryTypeIndex = t;
+        IM_ASSERT(alloc_info.memoryTypeIndex != 0xFFFFFFFF);
+        err = vkAllocateMemory(device, &alloc_info, allocator, &fd->BackbufferMemory);
+        check_vk_result(err);
+        err = vkBindImageMemory(device, fd->Backbuffer, fd->BackbufferMemory, 0);
+        check_vk_result(err);
+    }
+
+    ImGui_ImplVulkanH_CreateWindowFramebuffers(device, wd, allocator, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+    ImGui_ImplVulkanH_CreateWindowCommandBuffers(physical_device, device, wd, queue_family, allocator);
+}
+
 void ImGui_ImplVulkanH_DestroyWindow(VkInstance instance, VkDevice device, ImGui_ImplVulkanH_Window* wd, const VkAllocationCallbacks* allocator)
 {
     vkDeviceWaitIdle(device); // FIXME: We could wait on the Queue if we had the queue in wd-> (otherwise VulkanH functions can't use globals)
@@ -1444,8 +1928,10 @@ void ImGui_ImplVulkanH_DestroyWindow(VkInstance instance, VkDevice device, ImGui
     wd->FrameSemaphores = nullptr;
     vkDestroyPipeline(device, wd->Pipeline, allocator);
     vkDestroyRenderPass(device, wd->RenderPass, allocator);
-    vkDestroySwapchainKHR(device, wd->Swapchain, allocator);
-    vkDestroySurfaceKHR(instance, wd->Surface, allocator);
+    if (wd->Swapchain)
+        vkDestroySwapchainKHR(device, wd->Swapchain, allocator);
+    if (wd->Surface)
+        vkDestroySurfaceKHR(instance, wd->Surface, nullptr); // created by SDL, without allocation callbacks
 
     *wd = ImGui_ImplVulkanH_Window();
 }
@@ -1463,6 +1949,15 @@ void ImGui_ImplVulkanH_DestroyFrame(VkDevice device, ImGui_ImplVulkanH_Frame* fd
 
     vkDestroyImageView(device, fd->BackbufferView, allocator);
     vkDestroyFramebuffer(device, fd->Framebuffer, allocator);
+
+    // the offscreen windows own their images
+    if (fd->BackbufferMemory)
+    {
+        vkDestroyImage(device, fd->Backbuffer, allocator);
+        vkFreeMemory(device, fd->BackbufferMemory, allocator);
+        fd->Backbuffer = VK_NULL_HANDLE;
+        fd->BackbufferMemory = VK_NULL_HANDLE;
+    }
 }
 
 void ImGui_ImplVulkanH_DestroyFrameSemaphores(VkDevice device, ImGui_ImplVulkanH_FrameSemaphores* fsd, const VkAllocationCallbacks* allocator)
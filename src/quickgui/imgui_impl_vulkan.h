@@ -69,6 +69,11 @@ struct ImGui_ImplVulkan_InitInfo
     bool                            UseDynamicRendering;    // Need to explicitly enable VK_KHR_dynamic_rendering extension to use this, even for Vulkan 1.3.
     VkFormat                        ColorAttachmentFormat;  // Required for dynamic rendering
 
+    // Bindless texture table (Optional)
+    // Need VK_EXT_descriptor_indexing (or Vulkan 1.2) with runtimeDescriptorArray, descriptorBindingPartiallyBound
+    // and descriptorBindingSampledImageUpdateAfterBind enabled on the device. 0 -> use only per-texture descriptor sets.
+    uint32_t                        BindlessTextureCount;
+
     // Allocation, Debugging
     const VkAllocationCallbacks*    Allocator;
     void                            (*CheckVkResultFn)(VkResult err);
@@ -82,6 +87,7 @@ IMGUI_IMPL_API void         ImGui_ImplVulkan_RenderDrawData(ImDrawData* draw_dat
 IMGUI_IMPL_API bool         ImGui_ImplVulkan_CreateFontsTexture();
 IMGUI_IMPL_API void         ImGui_ImplVulkan_DestroyFontsTexture();
 IMGUI_IMPL_API void         ImGui_ImplVulkan_SetMinImageCount(uint32_t min_image_count); // To override MinImageCount after initialization (e.g. if swap chain is recreated)
+IMGUI_IMPL_API VkDeviceSize ImGui_ImplVulkan_GetRenderBuffersSize(); // Device memory of the vertex and index buffers
 
 // Register a texture (VkDescriptorSet == ImTextureID)
 // FIXME: This is experimental in the sense that we are unsure how to best design/tackle this problem
@@ -89,6 +95,30 @@ IMGUI_IMPL_API void         ImGui_ImplVulkan_SetMinImageCount(uint32_t min_image
 IMGUI_IMPL_API VkDescriptorSet ImGui_ImplVulkan_AddTexture(VkSampler sampler, VkImageView image_view, VkImageLayout image_layout=VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 IMGUI_IMPL_API void            ImGui_ImplVulkan_RemoveTexture(VkDescriptorSet descriptor_set);
 
+// Register a texture in the bindless table (slot index <-> ImTextureID), when InitInfo::BindlessTextureCount > 0.
+// Draws keyed by these ids share a single descriptor set, and only the texture index is pushed per draw.
+IMGUI_IMPL_API bool            ImGui_ImplVulkan_HasBindlessTextures();
+IMGUI_IMPL_API uint32_t        ImGui_ImplVulkan_AddBindlessTexture(VkSampler sampler, VkImageView image_view, VkImageLayout image_layout=VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+IMGUI_IMPL_API void            ImGui_ImplVulkan_RemoveBindlessTexture(uint32_t index);
+IMGUI_IMPL_API ImTextureID     ImGui_ImplVulkan_BindlessTextureID(uint32_t index);
+
+// Custom shaders for some draws: a draw callback binds its own pipeline, descriptor sets and push constants,
+// and sets UserState. The following draws then only set their scissor rect before drawing, until
+// an ImDrawCallback_ResetRenderState callback restores the imgui state.
+struct ImGui_ImplVulkan_RenderState
+{
+    VkCommandBuffer                 CommandBuffer;
+    float                           Scale[2];               // The push constants of the imgui vertex shader
+    float                           Translate[2];
+    bool                            UserState;
+};
+// Only valid while the draw callbacks are called from ImGui_ImplVulkan_RenderDrawData()
+IMGUI_IMPL_API ImGui_ImplVulkan_RenderState* ImGui_ImplVulkan_GetRenderState();
+// Create a pipeline with the imgui vertex shader and state, and the given fragment shader.
+// The layout must have the push constant range of the vertex shader: 4 floats at offset 0.
+// Destroy with vkDestroyPipeline().
+IMGUI_IMPL_API VkPipeline      ImGui_ImplVulkan_CreateUserPipeline(VkShaderModule frag_module, VkPipelineLayout pipeline_layout);
+
 // Optional: load Vulkan functions with a custom function loader
 // This is only useful with IMGUI_IMPL_VULKAN_NO_PROTOTYPES / VK_NO_PROTOTYPES
 IMGUI_IMPL_API bool         ImGui_ImplVulkan_LoadFunctions(PFN_vkVoidFunction(*loader_func)(const char* function_name, void* user_data), void* user_data = nullptr);
@@ -111,9 +141,13 @@ IMGUI_IMPL_API bool         ImGui_ImplVulkan_LoadFunctions(PFN_vkVoidFunction(*l
 
 struct ImGui_ImplVulkanH_Frame;
 struct ImGui_ImplVulkanH_Window;
+struct ImGui_ImplVulkanH_RetiredWindow;
 
 // Helpers
 IMGUI_IMPL_API void                 ImGui_ImplVulkanH_CreateOrResizeWindow(VkInstance instance, VkPhysicalDevice physical_device, VkDevice device, ImGui_ImplVulkanH_Window* wnd, uint32_t queue_family, const VkAllocationCallbacks* allocator, int w, int h, uint32_t min_image_count);
+IMGUI_IMPL_API void                 ImGui_ImplVulkanH_ResizeWindow(VkPhysicalDevice physical_device, VkDevice device, ImGui_ImplVulkanH_Window* wnd, uint32_t queue_family, const VkAllocationCallbacks* allocator, int w, int h, uint32_t min_image_count, ImGui_ImplVulkanH_RetiredWindow* retired);
+IMGUI_IMPL_API void                 ImGui_ImplVulkanH_DestroyRetiredWindow(VkDevice device, ImGui_ImplVulkanH_RetiredWindow* retired, const VkAllocationCallbacks* allocator);
+IMGUI_IMPL_API void                 ImGui_ImplVulkanH_CreateOffscreenWindow(VkPhysicalDevice physical_device, VkDevice device, ImGui_ImplVulkanH_Window* wnd, uint32_t queue_family, const VkAllocationCallbacks* allocator, int w, int h, uint32_t image_count);
 IMGUI_IMPL_API void                 ImGui_ImplVulkanH_DestroyWindow(VkInstance instance, VkDevice device, ImGui_ImplVulkanH_Window* wnd, const VkAllocationCallbacks* allocator);
 IMGUI_IMPL_API VkSurfaceFormatKHR   ImGui_ImplVulkanH_SelectSurfaceFormat(VkPhysicalDevice physical_device, VkSurfaceKHR surface, const VkFormat* request_formats, int request_formats_count, VkColorSpaceKHR request_color_space);
 IMGUI_IMPL_API VkPresentModeKHR     ImGui_ImplVulkanH_SelectPresentMode(VkPhysicalDevice physical_device, VkSurfaceKHR surface, const VkPresentModeKHR* request_modes, int request_modes_count);
@@ -128,8 +162,10 @@ struct ImGui_ImplVulkanH_Frame
     VkCommandBuffer     CommandBuffer;
     VkCommandBuffer     CommandBuffer2;
     bool                CommandBuffer2Used;
+    bool                Recording;              // Started but not yet submitted: the fence is reset
     VkFence             Fence;
     VkImage             Backbuffer;
+    VkDeviceMemory      BackbufferMemory;       // Only for offscreen windows, which own their images
     VkImageView         BackbufferView;
     VkFramebuffer       Framebuffer;
 };
@@ -140,6 +176,17 @@ struct ImGui_ImplVulkanH_FrameSemaphores
     VkSemaphore         RenderCompleteSemaphore;
 };
 
+// What ImGui_ImplVulkanH_ResizeWindow() replaced, to be destroyed with
+// ImGui_ImplVulkanH_DestroyRetiredWindow() once the GPU no longer uses it.
+// The frames which were kept by the window have no command pool nor fence.
+struct ImGui_ImplVulkanH_RetiredWindow
+{
+    VkSwapchainKHR                      Swapchain;
+    uint32_t                            ImageCount;
+    ImGui_ImplVulkanH_Frame*            Frames;
+    ImGui_ImplVulkanH_FrameSemaphores*  FrameSemaphores;
+};
+
 // Helper structure to hold the data needed by one rendering context into one OS window
 // (Used by example's main.cpp. Used by multi-viewport features. Probably NOT used by your own engine/app.)
 struct ImGui_ImplVulkanH_Window
@@ -158,6 +205,7 @@ struct ImGui_ImplVulkanH_Window
     uint32_t            FrameIndex;             // Current frame being rendered to (0 <= FrameIndex < FrameInFlightCount)
     uint32_t            ImageCount;             // Number of simultaneous in-flight frames (returned by vkGetSwapchainImagesKHR, usually derived from min_image_count)
     uint32_t            SemaphoreIndex;         // Current set of swapchain wait semaphores we're using (needs to be distinct from per frame data)
+    VkImageUsageFlags   ImageUsage;             // Usage of the swapchain images
     ImGui_ImplVulkanH_Frame*            Frames;
     ImGui_ImplVulkanH_FrameSemaphores*  FrameSemaphores;
 
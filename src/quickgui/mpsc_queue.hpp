@@ -0,0 +1,84 @@
+#ifndef QUICKGUI_MPSC_QUEUE_HPP_
+#define QUICKGUI_MPSC_QUEUE_HPP_
+
+#include <atomic>
+#include <type_traits>
+#include <utility>
+
+namespace quickgui {
+
+/** unbounded multiple-producer single-consumer queue. Pushing is
+ * lock-free (other than the node allocation) and can be done from any
+ * thread; popping must be done always from the same thread. The
+ * consumer may not see an element while its push is still running.
+ *
+ * @see https://www.1024cores.net/home/lock-free-algorithms/queues/non-intrusive-mpsc-node-based-queue */
+template<class T>
+struct mpsc_queue
+{
+    static_assert(std::is_default_constructible_v<T>);
+
+private:
+
+    struct node
+    {
+        std::atomic<node*> next;
+        T value;
+    };
+
+    std::atomic<node*> m_head; ///< the last pushed node; written by the producers
+    node *m_tail;              ///< the stub node, before the first element; owned by the consumer
+
+public:
+
+    mpsc_queue() : m_head(), m_tail(new node{{nullptr}, T{}})
+    {
+        m_head.store(m_tail, std::memory_order_relaxed);
+    }
+
+    ~mpsc_queue()
+    {
+        T discard;
+        while(pop(&discard))
+            ;
+        delete m_tail;
+    }
+
+    mpsc_queue(mpsc_queue const&) = delete;
+    mpsc_queue& operator= (mpsc_queue const&) = delete;
+
+public:
+
+    /** can be called from any thread */
+    void push(T const& value)
+    {
+        node *n = new node{{nullptr}, value};
+        node *prev = m_head.exchange(n, std::memory_order_acq_rel);
+        prev->next.store(n, std::memory_order_release);
+    }
+
+    /** must be called always from the same thread
+     * @return false if there is no element */
+    bool pop(T *value)
+    {
+        node *tail = m_tail;
+        node *next = tail->next.load(std::memory_order_acquire);
+        if(!next)
+            return false;
+        *value = std::move(next->value);
+        m_tail = next; // next is the new stub
+        delete tail;
+        return true;
+    }
+
+    /** must be called from the consumer thread. Approximate when
+     * there are pushes running. */
+    bool empty() const
+    {
+        return m_tail->next.load(std::memory_order_acquire) == nullptr;
+    }
+};
+
+} // namespace quickgui
+
+#endif /* QUICKGUI_MPSC_QUEUE_HPP_ */
@@ -2,6 +2,7 @@
 
 #include "quickgui/primitive_draw_list.hpp"
 #include "quickgui/math.hpp"
+#include "quickgui/mem.hpp"
 #include "quickgui/color.hpp"
 
 namespace quickgui {
@@ -31,124 +32,337 @@ static ImVec2 _shadow_offset(ImVec2 canvas_size) noexcept
     const float canvas_dim = quickgui::max(canvas_size.x, canvas_size.y);
     return ImVec2{canvas_dim * OverlayCanvas::s_draw_shadow_offset, canvas_dim * OverlayCanvas::s_draw_shadow_offset};
 }
+
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+/** transform in place from subject coordinates to canvas coordinates:
+ * pts[i] * scale + offset, two points at a time with simd */
+static void _transform_points(ImVec2 *C4_RESTRICT pts, size_t num, ImVec2 scale, ImVec2 offset) noexcept
+{
+    static_assert(sizeof(ImVec2) == 2 * sizeof(float), "ImVec2 must be two packed floats");
+    size_t i = 0;
+#if defined(QUICKGUI_USE_SSE) || defined(QUICKGUI_USE_SSE2)
+    const __m128 s = _mm_setr_ps(scale.x, scale.y, scale.x, scale.y);
+    const __m128 o = _mm_setr_ps(offset.x, offset.y, offset.x, offset.y);
+    for( ; i + 2 <= num; i += 2)
+    {
+        float *p = &pts[i].x;
+        _mm_storeu_ps(p, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(p), s), o));
+    }
+#elif defined(QUICKGUI_USE_NEON)
+    const float sv[4] = {scale.x, scale.y, scale.x, scale.y};
+    const float ov[4] = {offset.x, offset.y, offset.x, offset.y};
+    const float32x4_t s = vld1q_f32(sv);
+    const float32x4_t o = vld1q_f32(ov);
+    for( ; i + 2 <= num; i += 2)
+    {
+        float *p = &pts[i].x;
+        vst1q_f32(p, vmlaq_f32(o, vld1q_f32(p), s));
+    }
+#endif
+    for( ; i < num; ++i)
+        pts[i] = offset + pts[i] * scale;
+}
+
+/** append the points of the primitive which need to be transformed */
+static void _push_points(PrimitiveDrawList const& primitives, PrimitiveDrawList::Primitive const& prim, std::vector<ImVec2> *pts)
+{
+    switch(prim.type)
+    {
+    case PrimitiveDrawList::text:
+        pts->push_back(prim.text.p);
+        break;
+    case PrimitiveDrawList::point:
+        pts->push_back(prim.point.p);
+        break;
+    case PrimitiveDrawList::line:
+        pts->push_back(prim.line.p);
+        pts->push_back(prim.line.q);
+        break;
+    case PrimitiveDrawList::rect:
+    case PrimitiveDrawList::rect_filled:
+        pts->push_back(prim.rect.r.Min);
+        pts->push_back(prim.rect.r.Max);
+        break;
+    case PrimitiveDrawList::poly:
+    {
+        ImVec2 const* first = primitives.m_points.data() + prim.poly.first_point;
+        pts->insert(pts->end(), first, first + prim.poly.num_points);
+        break;
+    }
+    case PrimitiveDrawList::circle:
+        pts->push_back(prim.circle.center);
+        break;
+    default:
+        C4_NOT_IMPLEMENTED();
+        break;
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+/** the primitives written as pre-triangulated quads straight into the
+ * buffers of the draw list, instead of going through its paths */
+C4_ALWAYS_INLINE bool _is_quads(PrimitiveDrawList::PrimitiveType_e type) noexcept
+{
+    return type == PrimitiveDrawList::point
+        || type == PrimitiveDrawList::line
+        || type == PrimitiveDrawList::rect
+        || type == PrimitiveDrawList::rect_filled;
+}
+
+/** the vertices and indices of a quads primitive, with its shadow */
+static void _quads_size(PrimitiveDrawList::PrimitiveType_e type, int *num_vtx, int *num_idx) noexcept
+{
+    const int copies = (OverlayCanvas::s_draw_shadow > 0.f && type != PrimitiveDrawList::rect_filled) ? 2 : 1;
+    switch(type)
+    {
+    case PrimitiveDrawList::point: // ring + 2 diagonals
+        *num_vtx = copies * (8 + 2 * 4);
+        *num_idx = copies * (24 + 2 * 6);
+        break;
+    case PrimitiveDrawList::line:
+    case PrimitiveDrawList::rect_filled:
+        *num_vtx = copies * 4;
+        *num_idx = copies * 6;
+        break;
+    case PrimitiveDrawList::rect: // ring
+        *num_vtx = copies * 8;
+        *num_idx = copies * 24;
+        break;
+    default:
+        C4_NOT_IMPLEMENTED();
+        break;
+    }
+}
+
+/** writes to the buffers obtained with ImDrawList::PrimReserve() */
+struct QuadWriter
+{
+    ImDrawVert *C4_RESTRICT vtx;
+    ImDrawIdx  *C4_RESTRICT idx;
+    unsigned int curr; ///< the index of the next vertex
+    ImVec2 uv;
+
+    explicit QuadWriter(ImDrawList *dl) noexcept
+        : vtx(dl->_VtxWritePtr)
+        , idx(dl->_IdxWritePtr)
+        , curr(dl->_VtxCurrentIdx)
+        , uv(ImGui::GetFontTexUvWhitePixel())
+    {}
+
+    void commit(ImDrawList *dl) noexcept
+    {
+        C4_ASSERT(vtx == dl->VtxBuffer.Data + dl->VtxBuffer.Size);
+        C4_ASSERT(idx == dl->IdxBuffer.Data + dl->IdxBuffer.Size);
+        dl->_VtxWritePtr = vtx;
+        dl->_IdxWritePtr = idx;
+        dl->_VtxCurrentIdx = curr;
+    }
+
+    C4_ALWAYS_INLINE void vert(ImVec2 pos, ImU32 col) noexcept
+    {
+        vtx->pos = pos;
+        vtx->uv = uv;
+        vtx->col = col;
+        ++vtx;
+    }
+    C4_ALWAYS_INLINE void tri(unsigned int a, unsigned int b, unsigned int c) noexcept
+    {
+        idx[0] = (ImDrawIdx)(curr + a);
+        idx[1] = (ImDrawIdx)(curr + b);
+        idx[2] = (ImDrawIdx)(curr + c);
+        idx += 3;
+    }
+
+    /** a convex quad, a-b-c-d in order */
+    void quad(ImVec2 a, ImVec2 b, ImVec2 c, ImVec2 d, ImU32 col) noexcept
+    {
+        vert(a, col);
+        vert(b, col);
+        vert(c, col);
+        vert(d, col);
+        tri(0, 1, 2);
+        tri(0, 2, 3);
+        curr += 4;
+    }
+
+    /** a segment as wide as 2*half_thickness */
+    void line(ImVec2 p, ImVec2 q, float half_thickness, ImU32 col) noexcept
+    {
+        const ImVec2 d = q - p;
+        const float d2 = dot(d);
+        const float s = d2 > 0.f ? half_thickness * rsqrt(d2) : 0.f;
+        const ImVec2 n = {-d.y * s, d.x * s};
+        quad(p + n, q + n, q - n, p - n, col);
+    }
+
+    /** the band between two nested axis-aligned rects */
+    void ring(ImVec2 omin, ImVec2 omax, ImVec2 imin, ImVec2 imax, ImU32 col) noexcept
+    {
+        vert(omin, col);                   // 0
+        vert({omax.x, omin.y}, col);       // 1
+        vert(omax, col);                   // 2
+        vert({omin.x, omax.y}, col);       // 3
+        vert(imin, col);                   // 4
+        vert({imax.x, imin.y}, col);       // 5
+        vert(imax, col);                   // 6
+        vert({imin.x, imax.y}, col);       // 7
+        for(unsigned int a = 0; a < 4; ++a)
+        {
+            const unsigned int b = (a + 1u) & 3u;
+            tri(a, b, 4u + b);
+            tri(a, 4u + b, 4u + a);
+        }
+        curr += 8;
+    }
+};
+
+/** p and q are the transformed points of the primitive. As with
+ * ImDrawList, the strokes are centered on the pixels. */
+static void _write_quads(QuadWriter &w, PrimitiveDrawList::Primitive const& prim,
+                         ImVec2 p, ImVec2 q, float half_point_size, ImU32 col) noexcept
+{
+    const ImVec2 half_pixel = {0.5f, 0.5f};
+    const float ht = 0.5f * prim.thickness;
+    switch(prim.type)
+    {
+    case PrimitiveDrawList::point:
+    {
+        p = p + half_pixel;
+        const float outer = half_point_size + ht;
+        const float inner = quickgui::max(half_point_size - ht, 0.f);
+        w.ring(p - outer, p + outer, p - inner, p + inner, col);
+        // diagonals across the square
+        w.line(p - half_point_size, p + half_point_size, ht, col);
+        w.line(ImVec2{p.x - half_point_size, p.y + half_point_size},
+               ImVec2{p.x + half_point_size, p.y - half_point_size}, ht, col);
+        break;
+    }
+    case PrimitiveDrawList::line:
+        w.line(p + half_pixel, q + half_pixel, ht, col);
+        break;
+    case PrimitiveDrawList::rect:
+    {
+        const ImVec2 min = {quickgui::min(p.x, q.x) + 0.5f, quickgui::min(p.y, q.y) + 0.5f};
+        const ImVec2 max = {quickgui::max(p.x, q.x) - 0.5f, quickgui::max(p.y, q.y) - 0.5f};
+        w.ring(min - ht, max + ht, min + ht, max - ht, col);
+        break;
+    }
+    case PrimitiveDrawList::rect_filled:
+        w.quad(p, ImVec2{q.x, p.y}, q, ImVec2{p.x, q.y}, col);
+        break;
+    default:
+        C4_NOT_IMPLEMENTED();
+        break;
+    }
+}
 } // anon namespace
 
 
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
 void OverlayCanvas::draw(PrimitiveDrawList const& primitives, ImVec2 primitives_subject_size,
                          ImVec2 canvas_position, ImVec2 canvas_size, ImDrawList *draw_list)
 {
-    // tr (ie transform): a lambda to transform from subject coordinates to canvas coordinates
-    auto trpos = [ssize=primitives_subject_size, csize=canvas_size, cpos=canvas_position](ImVec2 v){
-        return cpos + csize * (v / ssize);
-    };
+    // transform all the points at once, in the order of the primitives
+    m_transformed_points.clear();
+    for(PrimitiveDrawList::Primitive const& prim : primitives.m_primitives)
+        _push_points(primitives, prim, &m_transformed_points);
+    _transform_points(m_transformed_points.data(), m_transformed_points.size(),
+                      canvas_size / primitives_subject_size, canvas_position);
     // transform a length
     auto trlen = [ssize=minof(primitives_subject_size), csize=minof(canvas_size)](float len){
         return csize * (len / ssize);
     };
     // shadow offset position
-    auto sh = [offs=_shadow_offset(canvas_size)](ImVec2 p){
+    const ImVec2 offs = _shadow_offset(canvas_size);
+    auto sh = [offs](ImVec2 p){
         return p + offs;
     };
+    const float hps = _half_point_size(canvas_size);
     // https://github.com/ocornut/imgui/issues/1415
-    for(PrimitiveDrawList::Primitive const& prim : primitives.m_primitives)
+    ImVec2 *pts = m_transformed_points.data();
+    PrimitiveDrawList::Primitive const* C4_RESTRICT prims = primitives.m_primitives.data();
+    const size_t num_prims = primitives.m_primitives.size();
+    for(size_t i = 0; i < num_prims; )
     {
+        PrimitiveDrawList::Primitive const& prim = prims[i];
+        if(_is_quads(prim.type))
+        {
+            // reserve once for the whole run of consecutive quads
+            // primitives, keeping each reservation within the range
+            // of 16 bit indices
+            size_t end = i;
+            int num_vtx = 0, num_idx = 0;
+            for( ; end < num_prims && _is_quads(prims[end].type); ++end)
+            {
+                int nv = 0, ni = 0;
+                _quads_size(prims[end].type, &nv, &ni);
+                if(end > i && num_vtx + nv > s_max_vertices_per_reserve)
+                    break;
+                num_vtx += nv;
+                num_idx += ni;
+            }
+            draw_list->PrimReserve(num_idx, num_vtx);
+            QuadWriter w(draw_list);
+            for( ; i < end; ++i)
+            {
+                PrimitiveDrawList::Primitive const& qprim = prims[i];
+                const ImVec2 p = pts[0];
+                const ImVec2 q = qprim.type != PrimitiveDrawList::point ? pts[1] : p;
+                pts += qprim.type != PrimitiveDrawList::point ? 2 : 1;
+                // it is filled - no shadow needed
+                if(s_draw_shadow > 0.f && qprim.type != PrimitiveDrawList::rect_filled)
+                    _write_quads(w, qprim, sh(p), sh(q), hps, shadow(qprim.color));
+                _write_quads(w, qprim, p, q, hps, qprim.color);
+            }
+            w.commit(draw_list);
+            continue;
+        }
         switch(prim.type)
         {
         case PrimitiveDrawList::text:
         {
             const char *first = &primitives.m_characters[prim.text.first_char];
             const char *last = first + prim.text.num_chars;
-            const ImVec2 pos = trpos(prim.text.p);
+            const ImVec2 pos = *pts++;
             const ucolor shad = shadow(prim.color);
             if(s_draw_shadow > 0.f)
                 draw_list->AddText(sh(pos), shad, first, last);
             draw_list->AddText(pos, prim.color, first, last);
             break;
         }
-        case PrimitiveDrawList::point:
-        {
-            const float hps = _half_point_size(canvas_size);
-            const ImVec2 p = trpos(prim.point.p);
-            const ImVec2 topl = p + ImVec2{-hps, -hps};
-            const ImVec2 topr = p + ImVec2{ hps, -hps};
-            const ImVec2 botr = p + ImVec2{ hps,  hps};
-            const ImVec2 botl = p + ImVec2{-hps,  hps};
-            const ucolor shad = shadow(prim.color);
-            if(s_draw_shadow > 0.f)
-            {
-                const ImVec2 stopl = sh(topl);
-                const ImVec2 stopr = sh(topr);
-                const ImVec2 sbotr = sh(botr);
-                const ImVec2 sbotl = sh(botl);
-                // draw the square
-                draw_list->AddLine(stopl, stopr, shad, prim.thickness);
-                draw_list->AddLine(stopr, sbotr, shad, prim.thickness);
-                draw_list->AddLine(sbotr, sbotl, shad, prim.thickness);
-                draw_list->AddLine(sbotl, stopl, shad, prim.thickness);
-                // draw diagonals across the square
-                draw_list->AddLine(stopl, sbotr, shad, prim.thickness);
-                draw_list->AddLine(sbotl, stopr, shad, prim.thickness);
-            }
-            // draw the square
-            draw_list->AddLine(topl, topr, prim.color, prim.thickness);
-            draw_list->AddLine(topr, botr, prim.color, prim.thickness);
-            draw_list->AddLine(botr, botl, prim.color, prim.thickness);
-            draw_list->AddLine(botl, topl, prim.color, prim.thickness);
-            // draw diagonals across the square
-            draw_list->AddLine(topl, botr, prim.color, prim.thickness);
-            draw_list->AddLine(botl, topr, prim.color, prim.thickness);
-            break;
-        }
-        case PrimitiveDrawList::line:
-        {
-            const ImVec2 p = trpos(prim.line.p);
-            const ImVec2 q = trpos(prim.line.q);
-            const ucolor shad = shadow(prim.color);
-            if(s_draw_shadow > 0.f)
-                draw_list->AddLine(sh(p), sh(q), shad, prim.thickness);
-            draw_list->AddLine(p, q, prim.color, prim.thickness);
-            break;
-        }
-        case PrimitiveDrawList::rect:
-        {
-            const ImVec2 min = trpos(prim.rect.r.Min);
-            const ImVec2 max = trpos(prim.rect.r.Max);
-            const ucolor shad = shadow(prim.color);
-            if(s_draw_shadow > 0.f)
-                draw_list->AddRect(sh(min), sh(max), shad);
-            draw_list->AddRect(min, max, prim.color);
-            break;
-        }
-        case PrimitiveDrawList::rect_filled:
-        {
-            const ImVec2 min = trpos(prim.rect.r.Min);
-            const ImVec2 max = trpos(prim.rect.r.Max);
-            // it is filled - no shadow needed
-            draw_list->AddRectFilled(min, max, prim.color);
-            break;
-        }
         case PrimitiveDrawList::poly:
         {
-            if(prim.poly.num_points)
+            const int num_points = (int)prim.poly.num_points;
+            if(num_points)
             {
-                // need to transform all the points; we do it in place
-                m_transformed_points.resize(prim.poly.num_points);
                 if(s_draw_shadow > 0.f)
                 {
-                    const ucolor shad = shadow(prim.color);
-                    for(uint32_t p = prim.poly.first_point; p < prim.poly.num_points; ++p)
-                        m_transformed_points[p] = sh(trpos(primitives.m_points[p]));
-                    draw_list->AddPolyline(&m_transformed_points[0], (int)prim.poly.num_points, shad, /*flags*/{}, prim.thickness);
+                    // offset the points in place, and then restore them
+                    for(int p = 0; p < num_points; ++p)
+                        pts[p] = pts[p] + offs;
+                    draw_list->AddPolyline(pts, num_points, shadow(prim.color), /*flags*/{}, prim.thickness);
+                    for(int p = 0; p < num_points; ++p)
+                        pts[p] = pts[p] - offs;
                 }
-                for(uint32_t p = prim.poly.first_point; p < prim.poly.num_points; ++p)
-                    m_transformed_points[p] = trpos(primitives.m_points[p]);
-                draw_list->AddPolyline(&m_transformed_points[0], (int)prim.poly.num_points, prim.color, /*flags*/{}, prim.thickness);
+                draw_list->AddPolyline(pts, num_points, prim.color, /*flags*/{}, prim.thickness);
             }
+            pts += num_points;
             break;
         }
         case PrimitiveDrawList::circle:
         {
-            const ImVec2 center = trpos(prim.circle.center);
+            const ImVec2 center = *pts++;
             const float radius = trlen(prim.circle.radius);
             const ucolor shad = shadow(prim.color);
             if(s_draw_shadow > 0.f)
@@ -160,7 +374,9 @@ void OverlayCanvas::draw(PrimitiveDrawList const& primitives, ImVec2 primitives_
             C4_NOT_IMPLEMENTED();
             break;
         }
+        ++i;
     }
+    C4_ASSERT(pts == m_transformed_points.data() + m_transformed_points.size());
 }
 
 C4_SUPPRESS_WARNING_GCC_CLANG_POP
@@ -8,9 +8,13 @@ namespace quickgui {
 
 struct PrimitiveDrawList;
 
+/** draws a PrimitiveDrawList over a canvas, eg over a video. The
+ * points of all the primitives are transformed at once to the canvas,
+ * and the points, lines and rects are written as quads directly into
+ * the buffers of the draw list. */
 struct OverlayCanvas
 {
-    std::vector<ImVec2> m_transformed_points;
+    std::vector<ImVec2> m_transformed_points; ///< the points of all the primitives, in order
 
     OverlayCanvas() : m_transformed_points() { m_transformed_points.reserve(128); }
 
@@ -22,6 +26,7 @@ struct OverlayCanvas
     static inline constexpr const float s_min_point_square_size = 10.f; // min absolute pixels
     static inline constexpr const float s_draw_shadow = false; // fixme
     static inline constexpr const float s_draw_shadow_offset = 0.0015f; // fixme
+    static inline constexpr const int s_max_vertices_per_reserve = 1 << 15; // within 16 bit indices
 };
 
 } // namespace quickgui
@@ -185,6 +185,85 @@ struct d3_60
     };
 };
 
+
+/*
+ * sequential colormaps, for mapping values rather than categories:
+ * interpolate between the colors, see colormap_lut().
+ * The matplotlib colormaps are sampled as in https://cran.r-project.org/package=viridisLite
+ */
+
+struct grays
+{
+    _declare_values() {
+        _(00,00,00),
+        _(ff,ff,ff),
+    };
+};
+
+struct viridis
+{
+    _declare_values() {
+        _(44,01,54),
+        _(48,28,78),
+        _(3e,4a,89),
+        _(31,68,8e),
+        _(26,82,8e),
+        _(1f,9e,89),
+        _(35,b7,79),
+        _(6d,cd,59),
+        _(b4,de,2c),
+        _(fd,e7,25),
+    };
+};
+
+struct magma
+{
+    _declare_values() {
+        _(00,00,04),
+        _(18,0f,3e),
+        _(45,10,77),
+        _(72,1f,81),
+        _(9f,2f,7f),
+        _(cd,40,71),
+        _(f1,60,5d),
+        _(fd,95,67),
+        _(fe,c9,8d),
+        _(fc,fd,bf),
+    };
+};
+
+struct inferno
+{
+    _declare_values() {
+        _(00,00,04),
+        _(1b,0c,41),
+        _(4a,0c,6b),
+        _(78,1c,6d),
+        _(a5,2c,60),
+        _(cf,44,46),
+        _(ed,69,25),
+        _(fb,9b,06),
+        _(f7,d1,3d),
+        _(fc,ff,a4),
+    };
+};
+
+struct plasma
+{
+    _declare_values() {
+        _(0d,08,87),
+        _(47,03,9f),
+        _(73,01,a8),
+        _(9c,17,9e),
+        _(bd,37,86),
+        _(d8,57,6b),
+        _(ed,79,53),
+        _(fa,9e,3b),
+        _(fd,c9,26),
+        _(f0,f9,21),
+    };
+};
+
 } // namespace palettes
 #undef _
 #undef _declare_values
@@ -136,7 +136,7 @@ public:
     {
         const uint32_t first = (uint32_t)m_points.size();
         auto &prim = m_primitives.emplace_back();
-        prim.type = rect;
+        prim.type = poly;
         prim.poly.first_point = first;
         prim.poly.num_points = num_points;
         prim.color = color;
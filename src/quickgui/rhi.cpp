@@ -3,6 +3,7 @@
 #include "quickgui/mem.hpp"
 #include "quickgui/math.hpp"
 #include "quickgui/log.hpp"
+#include "quickgui/time.hpp"
 #include "imgui_impl_sdl2.h"
 #include "imgui_impl_vulkan.h"
 
@@ -12,8 +13,11 @@
 #include "quickgui/sdl.hpp"
 #include <SDL_vulkan.h>
 #include <numeric>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <cstdio>
 
-//#define IMGUI_UNLIMITED_FRAME_RATE
 #ifndef QUICKGUI_ENABLE_VULKAN_DEBUG
 #if defined(_DEBUG) || !defined(NDEBUG)
 #define QUICKGUI_ENABLE_VULKAN_DEBUG
@@ -41,6 +45,19 @@ VkDescriptorPool         g_DescriptorPool = VK_NULL_HANDLE;
 ImGui_ImplVulkanH_Window g_MainWindowData;
 uint32_t                 g_MinImageCount = 2;
 bool                     g_SwapChainRebuild = false;
+bool                     g_Offscreen = false; // render to images owned by the window, without surface nor swapchain
+VkPresentModeKHR         g_PresentMode = VK_PRESENT_MODE_FIFO_KHR; // requested; falls back to FIFO
+uint32_t                 g_FramesInFlight = 0; // 0 to use all the swapchain images
+std::vector<VkFence>     g_InFlightFences; // of the submitted frames, oldest first
+uint32_t                 g_RenderThreadDepth = 0; // frames queued to the render thread, each holding a swapchain image
+std::mutex               g_QueueMutex; // for the queue, the swapchain and g_InFlightFences, when there is a render thread
+struct RetiredWindow { ImGui_ImplVulkanH_RetiredWindow objs; VkFence fence; };
+std::vector<RetiredWindow> g_RetiredWindows; // left by resizes, destroyed once their fence is signaled
+std::string              g_PipelineCacheFile;
+uint32_t                 g_BindlessTextureCount = 0; // 0 when descriptor indexing is not available
+VkDeviceSize             g_HostImportAlignment = 0; // 0 when VK_EXT_external_memory_host is not available
+bool                     g_MemoryBudget = false; // VK_EXT_memory_budget is available
+std::atomic<VkDeviceSize> g_ImGuiBuffersSize{0}; // set when rendering, which may be on the render thread
 
 namespace quickgui::rhi {
 
@@ -50,6 +67,15 @@ Rhi &g_rhi = reinterpret_cast<Rhi&>(g_rhi_buf);
 void rhi_init()
 {
     new (&g_rhi_buf) Rhi(g_Device, g_PhysicalDevice, g_Allocator);
+    g_rhi.m_pipeline_cache = g_PipelineCache;
+    g_rhi.m_has_memory_budget = g_MemoryBudget;
+    if(g_HostImportAlignment)
+    {
+        g_rhi.m_host_import_alignment = g_HostImportAlignment;
+        g_rhi.m_get_host_pointer_props = (PFN_vkGetMemoryHostPointerPropertiesEXT)vkGetDeviceProcAddr(g_Device, "vkGetMemoryHostPointerPropertiesEXT");
+        if(!g_rhi.m_get_host_pointer_props)
+            g_rhi.m_host_import_alignment = 0;
+    }
 }
 
 void rhi_terminate()
@@ -57,6 +83,15 @@ void rhi_terminate()
     g_rhi.~Rhi();
 }
 
+// called from the frame loop below
+void gpu_profiler_frame_begin(VkCommandBuffer cmd, uint32_t frame_index);
+uint32_t gpu_profiler_frame_capture();
+void gpu_profiler_frame_end(uint32_t profiler_frame);
+void gpu_profiler_cleanup();
+// for the commands recorded after the frame is captured
+void debug_marker_region_begin(VkCommandBuffer cmd, const char *name, fcolor const& color, uint32_t profiler_frame);
+void debug_marker_region_end(VkCommandBuffer cmd, uint32_t profiler_frame);
+
 } // namespace quickgui::rhi
 
 
@@ -187,9 +222,20 @@ void SetupVulkan(const char **exts, uint32_t num_exts, quickgui::reusable_buffer
     // https://www.saschawillems.de/blog/2016/05/28/tutorial-on-using-vulkans-vk_ext_debug_marker-with-renderdoc/
 
     // Create Vulkan Instance
+    uint32_t instance_version = VK_API_VERSION_1_0;
     {
+        // vkEnumerateInstanceVersion() is not present on 1.0 loaders
+        auto enumerate_version = (PFN_vkEnumerateInstanceVersion)vkGetInstanceProcAddr(VK_NULL_HANDLE, "vkEnumerateInstanceVersion");
+        if(enumerate_version)
+            C4_CHECK_VK(enumerate_version(&instance_version));
+        instance_version = instance_version < VK_API_VERSION_1_2 ? instance_version : VK_API_VERSION_1_2;
+        VkApplicationInfo app_info = {};
+        app_info.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+        app_info.pEngineName = "quickgui";
+        app_info.apiVersion = instance_version;
         VkInstanceCreateInfo create_info = {};
         create_info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+        create_info.pApplicationInfo = &app_info;
         create_info.enabledExtensionCount = num_exts;
         create_info.ppEnabledExtensionNames = exts;
         #ifndef QUICKGUI_ENABLE_VULKAN_DEBUG  // create Vulkan Instance without any validation layer
@@ -239,15 +285,103 @@ void SetupVulkan(const char **exts, uint32_t num_exts, quickgui::reusable_buffer
         C4_CHECK(g_QueueFamily != (uint32_t)-1);
     }
 
+    // Query descriptor indexing, used for the bindless texture table
+    // of the gui. This is core in 1.2, and needs the extension before.
+    bool indexing_ext = false;
+    VkPhysicalDeviceProperties device_props;
+    vkGetPhysicalDeviceProperties(g_PhysicalDevice, &device_props);
+    if(instance_version >= VK_API_VERSION_1_1 && device_props.apiVersion >= VK_API_VERSION_1_1)
+    {
+        bool indexing_core = device_props.apiVersion >= VK_API_VERSION_1_2;
+        if(!indexing_core)
+        {
+            uint32_t count = 0;
+            C4_CHECK_VK(vkEnumerateDeviceExtensionProperties(g_PhysicalDevice, nullptr, &count, nullptr));
+            VkExtensionProperties *avail = exts_buf->reset<VkExtensionProperties>(count);
+            C4_CHECK_VK(vkEnumerateDeviceExtensionProperties(g_PhysicalDevice, nullptr, &count, avail));
+            for(uint32_t i = 0; i < count; ++i)
+                if(c4::to_csubstr(avail[i].extensionName) == VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME)
+                    indexing_ext = true;
+        }
+        if(indexing_core || indexing_ext)
+        {
+            VkPhysicalDeviceDescriptorIndexingFeatures indexing_features = {};
+            indexing_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+            VkPhysicalDeviceFeatures2 features = {};
+            features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+            features.pNext = &indexing_features;
+            vkGetPhysicalDeviceFeatures2(g_PhysicalDevice, &features);
+            VkPhysicalDeviceDescriptorIndexingProperties indexing_props = {};
+            indexing_props.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+            VkPhysicalDeviceProperties2 props2 = {};
+            props2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+            props2.pNext = &indexing_props;
+            vkGetPhysicalDeviceProperties2(g_PhysicalDevice, &props2);
+            // the shader indexes the table with a push constant
+            if(features.features.shaderSampledImageArrayDynamicIndexing
+               && indexing_features.runtimeDescriptorArray
+               && indexing_features.descriptorBindingPartiallyBound
+               && indexing_features.descriptorBindingSampledImageUpdateAfterBind)
+            {
+                uint32_t count = 4096u;
+                count = std::min(count, indexing_props.maxDescriptorSetUpdateAfterBindSampledImages);
+                count = std::min(count, indexing_props.maxDescriptorSetUpdateAfterBindSamplers);
+                count = std::min(count, indexing_props.maxPerStageDescriptorUpdateAfterBindSampledImages);
+                count = std::min(count, indexing_props.maxPerStageDescriptorUpdateAfterBindSamplers);
+                g_BindlessTextureCount = count;
+            }
+        }
+    }
+    QUICKGUI_LOGF_IF(g_BindlessTextureCount, "[vulkan] descriptor indexing: bindless texture table with {} entries", g_BindlessTextureCount);
+    QUICKGUI_LOGF_IF(!g_BindlessTextureCount, "[vulkan] descriptor indexing not available: using one descriptor set per texture");
+
+    // Query the import of host allocations, used to upload images
+    // straight from user memory, without the staging copy.
+    if(instance_version >= VK_API_VERSION_1_1 && device_props.apiVersion >= VK_API_VERSION_1_1)
+    {
+        uint32_t count = 0;
+        C4_CHECK_VK(vkEnumerateDeviceExtensionProperties(g_PhysicalDevice, nullptr, &count, nullptr));
+        VkExtensionProperties *avail = exts_buf->reset<VkExtensionProperties>(count);
+        C4_CHECK_VK(vkEnumerateDeviceExtensionProperties(g_PhysicalDevice, nullptr, &count, avail));
+        bool host_import_ext = false;
+        for(uint32_t i = 0; i < count; ++i)
+        {
+            c4::csubstr name = c4::to_csubstr(avail[i].extensionName);
+            if(name == VK_EXT_EXTERNAL_MEMORY_HOST_EXTENSION_NAME)
+                host_import_ext = true;
+            else if(name == VK_EXT_MEMORY_BUDGET_EXTENSION_NAME)
+                g_MemoryBudget = true;
+        }
+        if(host_import_ext)
+        {
+            VkPhysicalDeviceExternalMemoryHostPropertiesEXT host_props = {};
+            host_props.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTERNAL_MEMORY_HOST_PROPERTIES_EXT;
+            VkPhysicalDeviceProperties2 props2 = {};
+            props2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+            props2.pNext = &host_props;
+            vkGetPhysicalDeviceProperties2(g_PhysicalDevice, &props2);
+            g_HostImportAlignment = host_props.minImportedHostPointerAlignment;
+        }
+    }
+    QUICKGUI_LOGF_IF(g_HostImportAlignment, "[vulkan] external host memory: imports aligned to {}B", g_HostImportAlignment);
+    QUICKGUI_LOGF_IF(g_MemoryBudget, "[vulkan] memory budget: available");
+
     // Create Logical Device (with 1 queue)
     {
         // device extensions
-        const char** devexts = exts_buf->reset<const char*>(2);
+        const char** devexts = exts_buf->reset<const char*>(5);
         uint32_t devexts_count = 0;
-        devexts[devexts_count++] = "VK_KHR_swapchain";
+        if(!g_Offscreen)
+            devexts[devexts_count++] = "VK_KHR_swapchain";
         #ifdef QUICKGUI_ENABLE_VULKAN_DEBUG
         devexts[devexts_count++] = VK_EXT_DEBUG_MARKER_EXTENSION_NAME;
         #endif
+        if(g_BindlessTextureCount && indexing_ext)
+            devexts[devexts_count++] = VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME;
+        if(g_HostImportAlignment)
+            devexts[devexts_count++] = VK_EXT_EXTERNAL_MEMORY_HOST_EXTENSION_NAME;
+        if(g_MemoryBudget)
+            devexts[devexts_count++] = VK_EXT_MEMORY_BUDGET_EXTENSION_NAME;
         const float queue_priority[] = { 1.0f };
         VkDeviceQueueCreateInfo queue_info[1] = {};
         queue_info[0].sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
@@ -260,6 +394,19 @@ void SetupVulkan(const char **exts, uint32_t num_exts, quickgui::reusable_buffer
         create_info.pQueueCreateInfos = queue_info;
         create_info.enabledExtensionCount = devexts_count;
         create_info.ppEnabledExtensionNames = devexts;
+        // enable only the indexing features we use
+        VkPhysicalDeviceFeatures enabled_features = {};
+        VkPhysicalDeviceDescriptorIndexingFeatures enabled_indexing = {};
+        if(g_BindlessTextureCount)
+        {
+            enabled_features.shaderSampledImageArrayDynamicIndexing = VK_TRUE;
+            create_info.pEnabledFeatures = &enabled_features;
+            enabled_indexing.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+            enabled_indexing.runtimeDescriptorArray = VK_TRUE;
+            enabled_indexing.descriptorBindingPartiallyBound = VK_TRUE;
+            enabled_indexing.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+            create_info.pNext = &enabled_indexing;
+        }
         C4_CHECK_VK(vkCreateDevice(g_PhysicalDevice, &create_info, g_Allocator, &g_Device));
         vkGetDeviceQueue(g_Device, g_QueueFamily, 0, &g_Queue);
         quickgui::rhi::debug_marker_setup(g_Device);
@@ -293,6 +440,7 @@ void SetupVulkan(const char **exts, uint32_t num_exts, quickgui::reusable_buffer
 
 void CleanupVulkan()
 {
+    quickgui::rhi::gpu_profiler_cleanup();
     vkDestroyDescriptorPool(g_Device, g_DescriptorPool, g_Allocator);
 
     #ifdef QUICKGUI_ENABLE_VULKAN_DEBUG
@@ -303,6 +451,90 @@ void CleanupVulkan()
     vkDestroyInstance(g_Instance, g_Allocator);
 }
 
+/** check that the pipeline cache data was produced by this device and
+ * driver. The driver should reject incompatible data, but some are
+ * known to crash instead. */
+bool PipelineCacheIsCompatible(c4::csubstr data, VkPhysicalDeviceProperties const& props)
+{
+    // see VkPipelineCacheHeaderVersionOne
+    uint32_t header[4];
+    if(data.len < sizeof(header) + VK_UUID_SIZE)
+        return false;
+    memcpy(header, data.str, sizeof(header));
+    return header[0] >= sizeof(header) + VK_UUID_SIZE // headerSize
+        && header[1] == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+        && header[2] == props.vendorID
+        && header[3] == props.deviceID
+        && memcmp(data.str + sizeof(header), props.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+/** create the pipeline cache, loading it from a per-device file in
+ * the given directory. Pass a null directory to skip persistence. */
+void SetupPipelineCache(const char *dir)
+{
+    VkPhysicalDeviceProperties props = {};
+    vkGetPhysicalDeviceProperties(g_PhysicalDevice, &props);
+    std::string data;
+    g_PipelineCacheFile.clear();
+    if(dir && dir[0])
+    {
+        g_PipelineCacheFile = dir;
+        if(g_PipelineCacheFile.back() != '/' && g_PipelineCacheFile.back() != '\\')
+            g_PipelineCacheFile += '/';
+        char name[64];
+        snprintf(name, sizeof(name), "pipeline_cache_%04x_%04x.bin", props.vendorID, props.deviceID);
+        g_PipelineCacheFile += name;
+        if(c4::fs::file_exists(g_PipelineCacheFile.c_str()))
+        {
+            data = c4::fs::file_get_contents<std::string>(g_PipelineCacheFile.c_str());
+            if(!PipelineCacheIsCompatible(c4::to_csubstr(data), props))
+            {
+                QUICKGUI_LOGF("[vulkan] pipeline cache: discarding incompatible file {}", c4::to_csubstr(g_PipelineCacheFile));
+                data.clear();
+            }
+            else
+            {
+                QUICKGUI_LOGF("[vulkan] pipeline cache: loaded {}B from {}", data.size(), c4::to_csubstr(g_PipelineCacheFile));
+            }
+        }
+    }
+    VkPipelineCacheCreateInfo nfo = {};
+    nfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    nfo.initialDataSize = data.size();
+    nfo.pInitialData = data.empty() ? nullptr : data.data();
+    C4_CHECK_VK(vkCreatePipelineCache(g_Device, &nfo, g_Allocator, &g_PipelineCache));
+}
+
+/** save the pipeline cache to the file where it was loaded from, then
+ * destroy it */
+void CleanupPipelineCache()
+{
+    if(g_PipelineCache == VK_NULL_HANDLE)
+        return;
+    if(!g_PipelineCacheFile.empty())
+    {
+        size_t size = 0;
+        C4_CHECK_VK(vkGetPipelineCacheData(g_Device, g_PipelineCache, &size, nullptr));
+        std::string data(size, '\0');
+        C4_CHECK_VK(vkGetPipelineCacheData(g_Device, g_PipelineCache, &size, &data[0]));
+        data.resize(size);
+        // write to a temporary file first, so that an interrupted
+        // write does not leave a truncated cache behind
+        std::string tmp = g_PipelineCacheFile + ".tmp";
+        c4::fs::file_put_contents(tmp.c_str(), data);
+        bool ok = (std::rename(tmp.c_str(), g_PipelineCacheFile.c_str()) == 0);
+        if(!ok) // some platforms do not overwrite on rename
+        {
+            std::remove(g_PipelineCacheFile.c_str());
+            ok = (std::rename(tmp.c_str(), g_PipelineCacheFile.c_str()) == 0);
+        }
+        QUICKGUI_LOGF_IF(ok, "[vulkan] pipeline cache: saved {}B to {}", data.size(), c4::to_csubstr(g_PipelineCacheFile));
+        QUICKGUI_LOGF_IF(!ok, "[vulkan] pipeline cache: could not save to {}", c4::to_csubstr(g_PipelineCacheFile));
+    }
+    C4_DESTROY_VK(vkDestroyPipelineCache, g_Device, g_PipelineCache, g_Allocator);
+}
+
+
 // All the ImGui_ImplVulkanH_XXX structures/functions are optional helpers used by the demo.
 // Your real engine/app may not use them.
 void SetupVulkanWindow(ImGui_ImplVulkanH_Window* wd, VkSurfaceKHR surface, int width, int height)
@@ -327,14 +559,14 @@ void SetupVulkanWindow(ImGui_ImplVulkanH_Window* wd, VkSurfaceKHR surface, int w
     const VkColorSpaceKHR requestSurfaceColorSpace = VK_COLORSPACE_SRGB_NONLINEAR_KHR;
     wd->SurfaceFormat = ImGui_ImplVulkanH_SelectSurfaceFormat(g_PhysicalDevice, wd->Surface, requestSurfaceImageFormat, (size_t)C4_COUNTOF(requestSurfaceImageFormat), requestSurfaceColorSpace);
 
-    // Select Present Mode
-    #ifdef IMGUI_UNLIMITED_FRAME_RATE
-    VkPresentModeKHR present_modes[] = { VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_FIFO_KHR };
-    #else
-    VkPresentModeKHR present_modes[] = { VK_PRESENT_MODE_FIFO_KHR };
-    #endif
+    // Select Present Mode. FIFO is always available.
+    VkPresentModeKHR present_modes[] = { g_PresentMode, VK_PRESENT_MODE_FIFO_KHR };
     wd->PresentMode = ImGui_ImplVulkanH_SelectPresentMode(g_PhysicalDevice, wd->Surface, &present_modes[0], C4_COUNTOF(present_modes));
-    //printf("[vulkan] Selected PresentMode = %d\n", wd->PresentMode);
+    QUICKGUI_LOGF_IF(wd->PresentMode != g_PresentMode, "[vulkan] present mode {} not available: using FIFO", (int)g_PresentMode);
+    // mailbox needs an extra image to not block
+    g_MinImageCount = std::max(g_MinImageCount, (uint32_t)ImGui_ImplVulkanH_GetMinImageCountFromPresentMode(wd->PresentMode));
+    // the frames queued to the render thread were acquired but not yet presented
+    g_MinImageCount += g_RenderThreadDepth;
 
     // Create SwapChain, RenderPass, Framebuffer, etc.
     C4_CHECK(g_MinImageCount >= 2);
@@ -342,9 +574,82 @@ void SetupVulkanWindow(ImGui_ImplVulkanH_Window* wd, VkSurfaceKHR surface, int w
 }
 
 
+/** set up the window without surface nor swapchain: the frames are
+ * rendered to images of fixed size, which can be read back with
+ * ImageGpu2Cpu::request_swapchain() */
+void SetupVulkanOffscreen(ImGui_ImplVulkanH_Window* wd, int width, int height)
+{
+    wd->SurfaceFormat.format = VK_FORMAT_R8G8B8A8_UNORM;
+    wd->SurfaceFormat.colorSpace = VK_COLORSPACE_SRGB_NONLINEAR_KHR;
+    g_MinImageCount += g_RenderThreadDepth;
+    C4_CHECK(g_MinImageCount >= 2);
+    ImGui_ImplVulkanH_CreateOffscreenWindow(g_PhysicalDevice, g_Device, wd, g_QueueFamily, g_Allocator, width, height, g_MinImageCount);
+}
+
+
+/** destroy the objects left by resizes which the GPU no longer uses */
+void ReleaseRetiredWindows(bool wait)
+{
+    size_t num_left = 0;
+    for(RetiredWindow &rw : g_RetiredWindows)
+    {
+        if(wait)
+            C4_CHECK_VK(vkWaitForFences(g_Device, 1, &rw.fence, VK_TRUE, UINT64_MAX));
+        VkResult err = vkGetFenceStatus(g_Device, rw.fence);
+        if(err == VK_SUCCESS)
+        {
+            ImGui_ImplVulkanH_DestroyRetiredWindow(g_Device, &rw.objs, g_Allocator);
+            vkDestroyFence(g_Device, rw.fence, g_Allocator);
+        }
+        else
+        {
+            if(err != VK_NOT_READY)
+                C4_CHECK_VK(err);
+            g_RetiredWindows[num_left++] = rw;
+        }
+    }
+    g_RetiredWindows.resize(num_left);
+}
+
+
+/** resize the swapchain without waiting for the device. The frames
+ * keep their command pools and fences, and the old swapchain, views,
+ * framebuffers and semaphores are destroyed by FrameStart() once the
+ * queue work submitted before the resize is done. */
+void ResizeVulkanWindow(ImGui_ImplVulkanH_Window* wd, int width, int height)
+{
+    C4_CHECK(wd->Swapchain);
+    const quickgui::time_point t = quickgui::now();
+    std::lock_guard<std::mutex> lock(g_QueueMutex);
+    // a frame left started (eg when minimized) must be startable again
+    for(uint32_t i : quickgui::irange(wd->ImageCount))
+    {
+        ImGui_ImplVulkanH_Frame *fd = &wd->Frames[i];
+        if(fd->Recording)
+        {
+            C4_CHECK_VK(vkQueueSubmit(g_Queue, 0, nullptr, fd->Fence));
+            fd->Recording = false;
+        }
+    }
+    RetiredWindow rw = {};
+    VkFenceCreateInfo info = {};
+    info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    C4_CHECK_VK(vkCreateFence(g_Device, &info, g_Allocator, &rw.fence));
+    ImGui_ImplVulkanH_ResizeWindow(g_PhysicalDevice, g_Device, wd, g_QueueFamily, g_Allocator, width, height, g_MinImageCount, &rw.objs);
+    // signaled once the old images are no longer used
+    C4_CHECK_VK(vkQueueSubmit(g_Queue, 0, nullptr, rw.fence));
+    g_RetiredWindows.push_back(rw);
+    // the fences of the dropped frames are retired
+    g_InFlightFences.clear();
+    QUICKGUI_LOGF("swapchain resize: {}x{}, {} images, {}ms", wd->Width, wd->Height, wd->ImageCount, quickgui::fmsecs(quickgui::now() - t).count());
+}
+
+
 void CleanupVulkanWindow()
 {
+    g_InFlightFences.clear();
     ImGui_ImplVulkanH_DestroyWindow(g_Instance, g_Device, &g_MainWindowData, g_Allocator);
+    ReleaseRetiredWindows(/*wait*/true);
 }
 
 
@@ -363,10 +668,26 @@ bool FrameStart(ImGui_ImplVulkanH_Window *wd)
     //! creating problems in some scenarios. Investigate and fix.
     VkSemaphore image_acquired_semaphore = wd->FrameSemaphores[wd->SemaphoreIndex].ImageAcquiredSemaphore;
 
+    // limit the frames in flight, independently of the number of
+    // swapchain images: wait for the oldest submitted frames
+    std::unique_lock<std::mutex> lock(g_QueueMutex);
+    while(g_FramesInFlight && g_InFlightFences.size() >= g_FramesInFlight)
+    {
+        VkFence oldest = g_InFlightFences.front();
+        lock.unlock();
+        C4_CHECK_VK(vkWaitForFences(g_Device, 1, &oldest, VK_TRUE, UINT64_MAX));
+        lock.lock();
+        g_InFlightFences.erase(std::remove(g_InFlightFences.begin(), g_InFlightFences.end(), oldest), g_InFlightFences.end());
+    }
+
     // this call will bump FrameIndex
     const uint64_t timeout_ns = UINT64_MAX;//UINT64_C(60'000'000);
     const uint32_t prevFrameIndex = wd->FrameIndex;
-    VkResult err = vkAcquireNextImageKHR(g_Device, wd->Swapchain, timeout_ns, image_acquired_semaphore, VK_NULL_HANDLE, &wd->FrameIndex);
+    VkResult err = VK_SUCCESS;
+    if(wd->Swapchain)
+        err = vkAcquireNextImageKHR(g_Device, wd->Swapchain, timeout_ns, image_acquired_semaphore, VK_NULL_HANDLE, &wd->FrameIndex);
+    else // offscreen: cycle through the images
+        wd->FrameIndex = (wd->FrameIndex + 1) % wd->ImageCount;
     bool needs_rebuild = false;
     if(NeedsSwapchainRebuild(err))
         needs_rebuild = true;
@@ -378,6 +699,7 @@ bool FrameStart(ImGui_ImplVulkanH_Window *wd)
         if(wd->FrameIndex == prevFrameIndex)
             return needs_rebuild;
     }
+    lock.unlock();
 
     C4_ASSERT(wd->FrameIndex < wd->ImageCount);
     ImGui_ImplVulkanH_Frame* fd = &wd->Frames[wd->FrameIndex];
@@ -387,6 +709,15 @@ bool FrameStart(ImGui_ImplVulkanH_Window *wd)
         C4_CHECK_VK(vkWaitForFences(g_Device, 1, &fd->Fence, VK_TRUE, UINT64_MAX));
     }
     C4_CHECK_VK(vkResetFences(g_Device, 1, &fd->Fence));
+    fd->Recording = true;
+    // this frame's previous work is done
+    lock.lock();
+    g_InFlightFences.erase(std::remove(g_InFlightFences.begin(), g_InFlightFences.end(), fd->Fence), g_InFlightFences.end());
+    lock.unlock();
+    if(!g_RetiredWindows.empty())
+        ReleaseRetiredWindows(/*wait*/false);
+    quickgui::rhi::g_rhi.update_memory_usage();
+    quickgui::rhi::g_rhi.release_retired_host_imports();
 
     {
         C4_CHECK_VK(vkResetCommandPool(g_Device, fd->CommandPool, 0));
@@ -394,6 +725,12 @@ bool FrameStart(ImGui_ImplVulkanH_Window *wd)
         info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
         info.flags |= VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
         C4_CHECK_VK(vkBeginCommandBuffer(fd->CommandBuffer, &info));
+        // the fence was waited on, so the queries of this frame are
+        // ready. Reset them first in the first command buffer of the
+        // frame's submission, before any command buffer of the frame
+        // can write timestamps. This must be outside of the render
+        // pass.
+        quickgui::rhi::gpu_profiler_frame_begin(fd->CommandBuffer, wd->FrameIndex);
         C4_CHECK_VK(vkBeginCommandBuffer(fd->CommandBuffer2, &info));
         fd->CommandBuffer2Used = false;
     }
@@ -413,17 +750,52 @@ bool FrameStart(ImGui_ImplVulkanH_Window *wd)
 }
 
 
-void FrameRender(ImGui_ImplVulkanH_Window* wd, ImDrawData* draw_data)
+/** called from the application thread when the frame ends. After
+ * this, the next frame can be started while this one is rendered. */
+void FrameCapture(ImGui_ImplVulkanH_Window* wd, quickgui::rhi::FrameSubmit *fs)
 {
-    VkSemaphore image_acquired_semaphore  = wd->FrameSemaphores[wd->SemaphoreIndex].ImageAcquiredSemaphore;
-    VkSemaphore render_complete_semaphore = wd->FrameSemaphores[wd->SemaphoreIndex].RenderCompleteSemaphore;
-    ImGui_ImplVulkanH_Frame* fd = &wd->Frames[wd->FrameIndex];
-
-    // Recpfstdord dear imgui primitives into command buffer
+    quickgui::rhi::Rhi &rhi = quickgui::rhi::g_rhi;
+    // the frame is finished in FrameRender()
+    fs->profiler_frame = quickgui::rhi::gpu_profiler_frame_capture();
+    fs->frame_index = wd->FrameIndex;
+    fs->semaphore_index = wd->SemaphoreIndex;
+    wd->SemaphoreIndex = (wd->SemaphoreIndex + 1) % wd->ImageCount; // the next frame uses the next set of semaphores
+    // swap to keep the capacity of both
+    fs->frame_fences.swap(rhi.m_frame_fences);
+    rhi.m_frame_fences.clear();
+    fs->swapchain_readbacks.swap(rhi.m_swapchain_readbacks);
+    rhi.m_swapchain_readbacks.clear();
+    // the uploads of this frame were recorded
+    rhi.m_upload_buffer_in_use = false;
+}
+
+
+/** record the gui and submit the frame; can be called from the render thread */
+void FrameRender(ImGui_ImplVulkanH_Window* wd, ImDrawData* draw_data, quickgui::rhi::FrameSubmit *fs)
+{
+    VkSemaphore image_acquired_semaphore  = wd->FrameSemaphores[fs->semaphore_index].ImageAcquiredSemaphore;
+    VkSemaphore render_complete_semaphore = wd->FrameSemaphores[fs->semaphore_index].RenderCompleteSemaphore;
+    ImGui_ImplVulkanH_Frame* fd = &wd->Frames[fs->frame_index];
+
+    // Record dear imgui primitives into command buffer. This may be
+    // the render thread, so the profiler region is in the frame given
+    // by the app thread.
+    quickgui::rhi::debug_marker_region_begin(fd->CommandBuffer, "imgui", quickgui::fcolor(UINT32_C(0x7f'7f'7f'ff)), fs->profiler_frame);
     ImGui_ImplVulkan_RenderDrawData(draw_data, fd->CommandBuffer);
+    quickgui::rhi::debug_marker_region_end(fd->CommandBuffer, fs->profiler_frame);
+    g_ImGuiBuffersSize.store(ImGui_ImplVulkan_GetRenderBuffersSize(), std::memory_order_relaxed);
 
     // Submit command buffer
     vkCmdEndRenderPass(fd->CommandBuffer);
+    quickgui::rhi::gpu_profiler_frame_end(fs->profiler_frame);
+    const VkImageLayout backbuffer_layout = wd->Swapchain ? VK_IMAGE_LAYOUT_PRESENT_SRC_KHR : VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    for(quickgui::rhi::SwapchainReadback const& rb : fs->swapchain_readbacks)
+    {
+        rb.readback->_record_copy(fd->CommandBuffer, rb.entry, fd->Backbuffer, backbuffer_layout,
+                                  VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                                  VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0);
+    }
+    fs->swapchain_readbacks.clear();
 
     {
         VkPipelineStageFlags wait_stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
@@ -436,6 +808,11 @@ void FrameRender(ImGui_ImplVulkanH_Window* wd, ImDrawData* draw_data)
         info.pCommandBuffers = &fd->CommandBuffer;
         info.signalSemaphoreCount = 1;
         info.pSignalSemaphores = &render_complete_semaphore;
+        if(!wd->Swapchain) // offscreen: nothing to acquire or present
+        {
+            info.waitSemaphoreCount = 0;
+            info.signalSemaphoreCount = 0;
+        }
         if(fd->CommandBuffer2Used)
         {
             ++info.commandBufferCount;
@@ -444,33 +821,43 @@ void FrameRender(ImGui_ImplVulkanH_Window* wd, ImDrawData* draw_data)
             C4_CHECK_VK(vkEndCommandBuffer(fd->CommandBuffer2));
         }
         C4_CHECK_VK(vkEndCommandBuffer(fd->CommandBuffer));
+        std::lock_guard<std::mutex> lock(g_QueueMutex);
         C4_CHECK_VK(vkQueueSubmit(g_Queue, 1, &info, fd->Fence));
+        fd->Recording = false;
+        if(g_FramesInFlight)
+            g_InFlightFences.push_back(fd->Fence);
+        // an empty submission signals its fence once all the previous
+        // work in the queue is done
+        for(VkFence fence : fs->frame_fences)
+            C4_CHECK_VK(vkQueueSubmit(g_Queue, 0, nullptr, fence));
     }
+    fs->frame_fences.clear();
 }
 
 
-void FramePresent(ImGui_ImplVulkanH_Window* wd)
+/** @return true if the swap chain should be rebuilt. Can be called
+ * from the render thread. */
+bool FramePresent(ImGui_ImplVulkanH_Window* wd, quickgui::rhi::FrameSubmit const& fs)
 {
-    if(g_SwapChainRebuild)
-        return;
-    VkSemaphore render_complete_semaphore = wd->FrameSemaphores[wd->SemaphoreIndex].RenderCompleteSemaphore;
+    if(!wd->Swapchain) // offscreen
+        return false;
+    VkSemaphore render_complete_semaphore = wd->FrameSemaphores[fs.semaphore_index].RenderCompleteSemaphore;
     VkPresentInfoKHR info = {};
     info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
     info.waitSemaphoreCount = 1;
     info.pWaitSemaphores = &render_complete_semaphore;
     info.swapchainCount = 1;
     info.pSwapchains = &wd->Swapchain;
-    info.pImageIndices = &wd->FrameIndex;
-    VkResult err = vkQueuePresentKHR(g_Queue, &info);
-    if(NeedsSwapchainRebuild(err))
+    info.pImageIndices = &fs.frame_index;
+    VkResult err;
     {
-        g_SwapChainRebuild = true;
-        return;
+        std::lock_guard<std::mutex> lock(g_QueueMutex);
+        err = vkQueuePresentKHR(g_Queue, &info);
     }
+    if(NeedsSwapchainRebuild(err))
+        return true;
     C4_CHECK_VK(err);
-    wd->SemaphoreIndex = (wd->SemaphoreIndex + 1) % wd->ImageCount; // Now we can use the next set of semaphores
-    if(quickgui::rhi::g_rhi.m_upload_buffer_in_use)
-        quickgui::rhi::g_rhi.m_upload_buffer_in_use = false;
+    return false;
 }
 
 
@@ -563,6 +950,36 @@ uint32_t vk_mem_type(VkMemoryPropertyFlags properties, uint32_t type_bits)
     return UINT32_C(0xff'ff'ff'ff); // Unable to find memoryType
 }
 
+bool vk_format_supports_linear_sampling(VkFormat fmt, uint32_t width, uint32_t height)
+{
+    VkFormatProperties props;
+    vkGetPhysicalDeviceFormatProperties(g_PhysicalDevice, fmt, &props);
+    const VkFormatFeatureFlags needed = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT|VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+    if((props.linearTilingFeatures & needed) != needed)
+        return false;
+    VkImageFormatProperties img_props;
+    VkResult err = vkGetPhysicalDeviceImageFormatProperties(g_PhysicalDevice, fmt, VK_IMAGE_TYPE_2D, VK_IMAGE_TILING_LINEAR,
+                                                            VK_IMAGE_USAGE_SAMPLED_BIT, 0, &img_props);
+    if(err != VK_SUCCESS)
+        return false;
+    return width <= img_props.maxExtent.width && height <= img_props.maxExtent.height;
+}
+
+bool vk_format_supports_filtering(VkFormat fmt)
+{
+    VkFormatProperties props;
+    vkGetPhysicalDeviceFormatProperties(g_PhysicalDevice, fmt, &props);
+    const VkFormatFeatureFlags needed = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT|VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+    return (props.optimalTilingFeatures & needed) == needed;
+}
+
+uint32_t vk_max_image_array_layers()
+{
+    VkPhysicalDeviceProperties props;
+    vkGetPhysicalDeviceProperties(g_PhysicalDevice, &props);
+    return props.limits.maxImageArrayLayers;
+}
+
 uint32_t vk_num_bytes_per_pixel(VkFormat f)
 {
     // TODO ASSERT format is not compressed, not block
@@ -606,6 +1023,10 @@ uint32_t vk_num_bytes_per_pixel(VkFormat f)
         case VK_FORMAT_R8G8B8A8_UNORM:
         case VK_FORMAT_R8G8B8A8_SSCALED:
         case VK_FORMAT_R8G8B8A8_USCALED:
+        case VK_FORMAT_B8G8R8A8_SRGB:
+        case VK_FORMAT_B8G8R8A8_UNORM:
+        case VK_FORMAT_A2R10G10B10_UNORM_PACK32:
+        case VK_FORMAT_A2B10G10R10_UNORM_PACK32:
         case VK_FORMAT_R16G16_SINT:
         case VK_FORMAT_R16G16_UINT:
         case VK_FORMAT_R16G16_SNORM:
@@ -731,8 +1152,23 @@ void debug_marker_mark(VkCommandBuffer cmd, const char *name, fcolor const& colo
     vkCmdDebugMarkerInsert(cmd, &nfo);
 }
 
+uint32_t gpu_profiler_frame();
+void gpu_profiler_region_begin(VkCommandBuffer cmd, const char *name, uint32_t profiler_frame);
+void gpu_profiler_region_end(VkCommandBuffer cmd, uint32_t profiler_frame);
+
 void debug_marker_region_begin(VkCommandBuffer cmd, const char *name, fcolor const& color)
 {
+    debug_marker_region_begin(cmd, name, color, gpu_profiler_frame());
+}
+
+void debug_marker_region_end(VkCommandBuffer cmd)
+{
+    debug_marker_region_end(cmd, gpu_profiler_frame());
+}
+
+void debug_marker_region_begin(VkCommandBuffer cmd, const char *name, fcolor const& color, uint32_t profiler_frame)
+{
+    gpu_profiler_region_begin(cmd, name, profiler_frame);
     if(!vkCmdDebugMarkerBegin)
         return;
     VkDebugMarkerMarkerInfoEXT nfo = {};
@@ -742,22 +1178,497 @@ void debug_marker_region_begin(VkCommandBuffer cmd, const char *name, fcolor con
     vkCmdDebugMarkerBegin(cmd, &nfo);
 }
 
-void debug_marker_region_end(VkCommandBuffer cmd)
+void debug_marker_region_end(VkCommandBuffer cmd, uint32_t profiler_frame)
 {
+    gpu_profiler_region_end(cmd, profiler_frame);
     if(!vkCmdDebugMarkerEnd)
         return;
     vkCmdDebugMarkerEnd(cmd);
 }
 
 
+//-----------------------------------------------------------------------------
+
+namespace {
+struct GpuProfiler
+{
+    enum : uint32_t {
+        max_frames = 8,   ///< frames in flight with their own slot
+        max_regions = 64, ///< per frame
+        max_queries = 2 * max_regions,
+        max_depth = 16,
+        no_frame = max_frames,
+    };
+    /** a frame is recorded first by the app thread, and then by the
+     * render thread, so each keeps its own recording state */
+    struct Slot
+    {
+        GpuProfileRegion regions[max_regions];
+        uint32_t num_regions;
+        uint32_t stack[max_depth];
+        uint32_t stack_size;
+        uint32_t num_dropped; ///< open regions which are not measured
+    };
+    VkQueryPool pool = VK_NULL_HANDLE;
+    Slot        slots[max_frames] = {};
+    uint32_t    frame = no_frame; ///< the slot being recorded by the app thread
+    double      ms_per_tick = 0.;
+    uint64_t    tick_mask = 0;
+    bool        initialized = false;
+    bool        supported = false;
+    bool        enabled = false; ///< owned by the frame start, see g_gpu_profiler_enable
+    std::vector<GpuProfileRegion> results;
+    void init()
+    {
+        if(initialized)
+            return;
+        initialized = true;
+        uint32_t count = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(g_PhysicalDevice, &count, nullptr);
+        std::vector<VkQueueFamilyProperties> families(count);
+        vkGetPhysicalDeviceQueueFamilyProperties(g_PhysicalDevice, &count, families.data());
+        C4_CHECK(g_QueueFamily < count);
+        const uint32_t valid_bits = families[g_QueueFamily].timestampValidBits;
+        supported = valid_bits > 0;
+        tick_mask = valid_bits >= 64 ? ~UINT64_C(0) : ((UINT64_C(1) << valid_bits) - 1u);
+        VkPhysicalDeviceProperties props;
+        vkGetPhysicalDeviceProperties(g_PhysicalDevice, &props);
+        ms_per_tick = (double)props.limits.timestampPeriod * 1.e-6;
+    }
+};
+GpuProfiler g_gpu_profiler;
+/** set from any thread, and applied when a frame starts */
+std::atomic<bool> g_gpu_profiler_enable = false;
+} // namespace
+
+bool gpu_profiler_supported()
+{
+    g_gpu_profiler.init();
+    return g_gpu_profiler.supported;
+}
+
+bool gpu_profiler_enabled()
+{
+    return g_gpu_profiler_enable.load(std::memory_order_relaxed);
+}
+
+void gpu_profiler_enable(bool yes)
+{
+    // the slots may be recorded by the render thread: the change is
+    // applied by gpu_profiler_frame_begin()
+    GpuProfiler &p = g_gpu_profiler;
+    p.init();
+    g_gpu_profiler_enable.store(yes && p.supported, std::memory_order_relaxed);
+}
+
+c4::cspan<GpuProfileRegion> gpu_profiler_regions()
+{
+    return {g_gpu_profiler.results.data(), g_gpu_profiler.results.size()};
+}
+
+void gpu_profiler_frame_begin(VkCommandBuffer cmd, uint32_t frame_index)
+{
+    GpuProfiler &p = g_gpu_profiler;
+    p.frame = GpuProfiler::no_frame;
+    const bool enabled = g_gpu_profiler_enable.load(std::memory_order_relaxed);
+    if(enabled != p.enabled)
+    {
+        p.enabled = enabled;
+        p.results.clear();
+    }
+    if(frame_index >= GpuProfiler::max_frames)
+        return;
+    if(!p.enabled)
+    {
+        // the queries of the slot were not reset: do not read them
+        // when it is used again. The other slots may still be
+        // recorded by the render thread, and are cleared when they
+        // start.
+        p.slots[frame_index].num_regions = 0;
+        return;
+    }
+    if(!p.pool)
+    {
+        VkQueryPoolCreateInfo info = {};
+        info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        info.queryCount = GpuProfiler::max_frames * GpuProfiler::max_queries;
+        C4_CHECK_VK(vkCreateQueryPool(g_Device, &info, g_Allocator, &p.pool));
+    }
+    GpuProfiler::Slot &slot = p.slots[frame_index];
+    const uint32_t first = frame_index * GpuProfiler::max_queries;
+    if(slot.num_regions)
+    {
+        // no WAIT flag: if a region was left open, its end query is
+        // unavailable and the frame is skipped
+        uint64_t ticks[GpuProfiler::max_queries];
+        const uint32_t num_queries = 2u * slot.num_regions;
+        VkResult err = vkGetQueryPoolResults(g_Device, p.pool, first, num_queries,
+                                             sizeof(ticks), ticks, sizeof(uint64_t),
+                                             VK_QUERY_RESULT_64_BIT);
+        if(err == VK_SUCCESS)
+        {
+            p.results.assign(slot.regions, slot.regions + slot.num_regions);
+            for(uint32_t i : irange(slot.num_regions))
+            {
+                const uint64_t elapsed = (ticks[2u * i + 1u] - ticks[2u * i]) & p.tick_mask;
+                p.results[i].ms = (double)elapsed * p.ms_per_tick;
+            }
+        }
+        else if(err != VK_NOT_READY)
+        {
+            C4_CHECK_VK(err);
+        }
+        slot.num_regions = 0;
+    }
+    vkCmdResetQueryPool(cmd, p.pool, first, GpuProfiler::max_queries);
+    slot.stack_size = 0;
+    slot.num_dropped = 0;
+    p.frame = frame_index;
+}
+
+uint32_t gpu_profiler_frame_capture()
+{
+    const uint32_t frame = g_gpu_profiler.frame;
+    g_gpu_profiler.frame = GpuProfiler::no_frame;
+    return frame;
+}
+
+void gpu_profiler_frame_end(uint32_t profiler_frame)
+{
+    if(profiler_frame == GpuProfiler::no_frame)
+        return;
+    // a region left open has no end query, and the frame is skipped
+    // when its results are read
+    GpuProfiler::Slot const& slot = g_gpu_profiler.slots[profiler_frame];
+    QUICKGUI_LOGF_IF(slot.stack_size, "[vulkan] gpu profiler: {} regions left open", slot.stack_size);
+}
+
+uint32_t gpu_profiler_frame()
+{
+    return g_gpu_profiler.frame;
+}
+
+void gpu_profiler_region_begin(VkCommandBuffer cmd, const char *name, uint32_t profiler_frame)
+{
+    GpuProfiler &p = g_gpu_profiler;
+    if(profiler_frame == GpuProfiler::no_frame)
+        return;
+    GpuProfiler::Slot &slot = p.slots[profiler_frame];
+    // when a region is dropped, its children are dropped as well
+    if(slot.num_dropped || slot.num_regions == GpuProfiler::max_regions || slot.stack_size == GpuProfiler::max_depth)
+    {
+        ++slot.num_dropped;
+        return;
+    }
+    const uint32_t id = slot.num_regions++;
+    GpuProfileRegion &region = slot.regions[id];
+    const size_t len = std::min(strlen(name), (size_t)GpuProfileRegion::max_name_size - 1u);
+    memcpy(region.name, name, len);
+    region.name[len] = '\0';
+    region.depth = slot.stack_size;
+    region.ms = 0.;
+    slot.stack[slot.stack_size++] = id;
+    vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, p.pool, profiler_frame * GpuProfiler::max_queries + 2u * id);
+}
+
+void gpu_profiler_region_end(VkCommandBuffer cmd, uint32_t profiler_frame)
+{
+    GpuProfiler &p = g_gpu_profiler;
+    if(profiler_frame == GpuProfiler::no_frame)
+        return;
+    GpuProfiler::Slot &slot = p.slots[profiler_frame];
+    if(slot.num_dropped)
+    {
+        --slot.num_dropped;
+        return;
+    }
+    C4_CHECK(slot.stack_size > 0);
+    const uint32_t id = slot.stack[--slot.stack_size];
+    vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, p.pool, profiler_frame * GpuProfiler::max_queries + 2u * id + 1u);
+}
+
+void gpu_profiler_cleanup()
+{
+    GpuProfiler &p = g_gpu_profiler;
+    if(p.pool)
+        vkDestroyQueryPool(g_Device, p.pool, g_Allocator);
+    p = GpuProfiler{};
+    g_gpu_profiler_enable = false;
+}
+
+
+//-----------------------------------------------------------------------------
+
+namespace {
+struct HostAllocator
+{
+    enum : uint32_t { num_scopes = VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE + 1 };
+    /** the alignment of the arena start, and so the largest alignment
+     * it can serve */
+    enum : size_t { arena_alignment = 64 };
+    /** precedes each allocation */
+    struct Header
+    {
+        size_t   size;
+        uint32_t offset; ///< from the start of the raw block
+        uint32_t scope;
+    };
+    static_assert(sizeof(Header) == 16);
+    struct Scope
+    {
+        std::atomic<uint64_t> num_allocs{0};
+        std::atomic<uint64_t> num_frees{0};
+        std::atomic<uint64_t> bytes{0};
+        std::atomic<uint64_t> peak_bytes{0};
+        // for the allocation rate
+        uint64_t   rate_allocs = 0;
+        time_point rate_time = {};
+        float      allocs_per_sec = 0.f;
+    };
+    VkAllocationCallbacks callbacks = {};
+    Scope       scopes[num_scopes];
+    bool        enabled = false;
+    // the arena for the transient allocations
+    std::mutex  arena_mutex;
+    char       *arena = nullptr;
+    size_t      arena_size = 0;
+    size_t      arena_pos = 0;
+    size_t      arena_live = 0; ///< allocations not yet freed
+    std::atomic<uint64_t> arena_hits{0};
+
+    void count_alloc(uint32_t scope, size_t size)
+    {
+        Scope &sc = scopes[scope];
+        sc.num_allocs.fetch_add(1, std::memory_order_relaxed);
+        const uint64_t bytes = sc.bytes.fetch_add(size, std::memory_order_relaxed) + size;
+        uint64_t peak = sc.peak_bytes.load(std::memory_order_relaxed);
+        while(bytes > peak && !sc.peak_bytes.compare_exchange_weak(peak, bytes, std::memory_order_relaxed))
+            ;
+    }
+    void count_free(uint32_t scope, size_t size)
+    {
+        Scope &sc = scopes[scope];
+        sc.num_frees.fetch_add(1, std::memory_order_relaxed);
+        sc.bytes.fetch_sub(size, std::memory_order_relaxed);
+    }
+    bool in_arena(void const* mem) const
+    {
+        return (char const*)mem >= arena && (char const*)mem < arena + arena_size;
+    }
+    void* alloc(size_t size, size_t alignment, VkSystemAllocationScope scope)
+    {
+        C4_ASSERT((uint32_t)scope < num_scopes);
+        // the header must fit before the aligned block
+        alignment = alignment > sizeof(Header) ? alignment : sizeof(Header);
+        char *raw = nullptr;
+        char *mem = nullptr;
+        if(arena && scope == VK_SYSTEM_ALLOCATION_SCOPE_COMMAND && alignment <= arena_alignment)
+        {
+            std::lock_guard<std::mutex> lock(arena_mutex);
+            const size_t pos = next_multiple(arena_pos, alignment) + alignment;
+            if(pos + size <= arena_size)
+            {
+                raw = arena + arena_pos;
+                mem = arena + pos;
+                arena_pos = pos + size;
+                ++arena_live;
+                arena_hits.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        if(!mem)
+        {
+            raw = (char*)c4::aalloc(size + alignment, alignment);
+            if(!raw)
+                return nullptr;
+            mem = raw + alignment;
+        }
+        Header *hdr = (Header*)mem - 1;
+        hdr->size = size;
+        hdr->offset = (uint32_t)(mem - raw);
+        hdr->scope = (uint32_t)scope;
+        count_alloc(hdr->scope, size);
+        return mem;
+    }
+    void free(void *mem)
+    {
+        if(!mem)
+            return;
+        Header const* hdr = (Header const*)mem - 1;
+        count_free(hdr->scope, hdr->size);
+        if(in_arena(mem))
+        {
+            std::lock_guard<std::mutex> lock(arena_mutex);
+            C4_ASSERT(arena_live > 0);
+            if(--arena_live == 0)
+                arena_pos = 0;
+            return;
+        }
+        c4::afree((char*)mem - hdr->offset);
+    }
+    void* realloc(void *orig, size_t size, size_t alignment, VkSystemAllocationScope scope)
+    {
+        if(!orig)
+            return alloc(size, alignment, scope);
+        if(!size)
+        {
+            free(orig);
+            return nullptr;
+        }
+        void *mem = alloc(size, alignment, scope);
+        if(mem)
+        {
+            const size_t prev_size = ((Header const*)orig - 1)->size;
+            memcpy(mem, orig, prev_size < size ? prev_size : size);
+            free(orig);
+        }
+        return mem;
+    }
+    float allocs_per_sec(Scope &sc)
+    {
+        const time_point t = now();
+        const uint64_t num = sc.num_allocs.load(std::memory_order_relaxed);
+        const float dt = fsecs(t - sc.rate_time).count();
+        if(dt >= 1.f)
+        {
+            sc.allocs_per_sec = (float)(num - sc.rate_allocs) / dt;
+            sc.rate_allocs = num;
+            sc.rate_time = t;
+        }
+        return sc.allocs_per_sec;
+    }
+};
+HostAllocator g_host_allocator;
+
+VKAPI_ATTR void* VKAPI_CALL host_alloc_fn(void *ud, size_t size, size_t alignment, VkSystemAllocationScope scope)
+{
+    return ((HostAllocator*)ud)->alloc(size, alignment, scope);
+}
+VKAPI_ATTR void* VKAPI_CALL host_realloc_fn(void *ud, void *orig, size_t size, size_t alignment, VkSystemAllocationScope scope)
+{
+    return ((HostAllocator*)ud)->realloc(orig, size, alignment, scope);
+}
+VKAPI_ATTR void VKAPI_CALL host_free_fn(void *ud, void *mem)
+{
+    ((HostAllocator*)ud)->free(mem);
+}
+// the driver allocates this memory itself, and only notifies
+VKAPI_ATTR void VKAPI_CALL host_internal_alloc_fn(void *ud, size_t size, VkInternalAllocationType, VkSystemAllocationScope scope)
+{
+    ((HostAllocator*)ud)->count_alloc((uint32_t)scope, size);
+}
+VKAPI_ATTR void VKAPI_CALL host_internal_free_fn(void *ud, size_t size, VkInternalAllocationType, VkSystemAllocationScope scope)
+{
+    ((HostAllocator*)ud)->count_free((uint32_t)scope, size);
+}
+} // namespace
+
+VkAllocationCallbacks* host_alloc_init(size_t transient_arena_size)
+{
+    HostAllocator &h = g_host_allocator;
+    C4_CHECK(!h.enabled);
+    for(HostAllocator::Scope &sc : h.scopes)
+    {
+        sc.num_allocs = 0;
+        sc.num_frees = 0;
+        sc.bytes = 0;
+        sc.peak_bytes = 0;
+        sc.rate_allocs = 0;
+        sc.rate_time = now();
+        sc.allocs_per_sec = 0.f;
+    }
+    h.arena_hits = 0;
+    h.arena_pos = 0;
+    h.arena_live = 0;
+    h.arena_size = transient_arena_size;
+    h.arena = transient_arena_size ? (char*)c4::aalloc(transient_arena_size, HostAllocator::arena_alignment) : nullptr;
+    h.callbacks.pUserData = &h;
+    h.callbacks.pfnAllocation = &host_alloc_fn;
+    h.callbacks.pfnReallocation = &host_realloc_fn;
+    h.callbacks.pfnFree = &host_free_fn;
+    h.callbacks.pfnInternalAllocation = &host_internal_alloc_fn;
+    h.callbacks.pfnInternalFree = &host_internal_free_fn;
+    h.enabled = true;
+    QUICKGUI_LOGF("[vulkan] counting host allocations, transient arena={}B", transient_arena_size);
+    return &h.callbacks;
+}
+
+void host_alloc_terminate()
+{
+    HostAllocator &h = g_host_allocator;
+    if(!h.enabled)
+        return;
+    const HostAllocStats stats = host_alloc_stats(VK_SYSTEM_ALLOCATION_SCOPE_MAX_ENUM);
+    QUICKGUI_LOGF("[vulkan] host allocations: {} allocs, peak={}B, leaked={}B", stats.num_allocs, stats.peak_bytes, stats.bytes);
+    // keep the arena if the driver still holds some of its memory
+    if(h.arena && !h.arena_live)
+    {
+        c4::afree(h.arena);
+        h.arena = nullptr;
+        h.arena_size = 0;
+    }
+    h.enabled = false;
+}
+
+bool host_alloc_enabled()
+{
+    return g_host_allocator.enabled;
+}
+
+HostAllocStats host_alloc_stats(VkSystemAllocationScope scope)
+{
+    HostAllocator &h = g_host_allocator;
+    HostAllocStats stats = {};
+    for(uint32_t i : irange((uint32_t)HostAllocator::num_scopes))
+    {
+        if(scope != VK_SYSTEM_ALLOCATION_SCOPE_MAX_ENUM && (uint32_t)scope != i)
+            continue;
+        HostAllocator::Scope &sc = h.scopes[i];
+        stats.num_allocs += sc.num_allocs.load(std::memory_order_relaxed);
+        stats.num_frees += sc.num_frees.load(std::memory_order_relaxed);
+        stats.bytes += sc.bytes.load(std::memory_order_relaxed);
+        // the peaks of the scopes are not simultaneous, so this is an upper bound
+        stats.peak_bytes += sc.peak_bytes.load(std::memory_order_relaxed);
+        stats.allocs_per_sec += h.allocs_per_sec(sc);
+    }
+    return stats;
+}
+
+uint64_t host_alloc_arena_hits()
+{
+    return g_host_allocator.arena_hits.load(std::memory_order_relaxed);
+}
+
+
+//-----------------------------------------------------------------------------
+
+void image_barrier(VkCommandBuffer cmd, Image const& img,
+                   VkImageLayout from, VkPipelineStageFlags src_stage, VkAccessFlags src_access,
+                   VkImageLayout to, VkPipelineStageFlags dst_stage, VkAccessFlags dst_access)
+{
+    VkImageMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask = src_access;
+    barrier.dstAccessMask = dst_access;
+    barrier.oldLayout = from;
+    barrier.newLayout = to;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = img.handle;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+    barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+    vkCmdPipelineBarrier(cmd, src_stage, dst_stage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
 
 fence_id FenceCollection::reset(fence_id id, VkFenceCreateInfo const& info, VkDevice dev, VkAllocationCallbacks const* alloc)
 {
-    if(!id)
-        id = add_handle();
+    id = reset_handle(id);
     VkFence &handle = get_handle(id);
     C4_DESTROY_VK(vkDestroyFence, dev, handle, alloc);
     C4_CHECK_VK(vkCreateFence(dev, &info, alloc, &handle));
@@ -766,15 +1677,17 @@ fence_id FenceCollection::reset(fence_id id, VkFenceCreateInfo const& info, VkDe
 
 void FenceCollection::destroy(fence_id id, VkDevice v, VkAllocationCallbacks const* a)
 {
-    handle_type &handle = get_handle(id);
+    handle_type &handle = get_handle_checked(id);
     C4_DESTROY_VK(vkDestroyFence, v, handle, a);
+    remove_handle(id);
 }
 
 void FenceCollection::destroy_all(VkDevice v, VkAllocationCallbacks const* a)
 {
-    for(auto &fence : handles)
+    for_each_handle([&](VkFence &fence){
         C4_DESTROY_VK(vkDestroyFence, v, fence, a);
-    handles.clear();
+    });
+    clear_handles();
 }
 
 
@@ -784,24 +1697,32 @@ void FenceCollection::destroy_all(VkDevice v, VkAllocationCallbacks const* a)
 
 buffer_id BufferCollection::reset(buffer_id id, VkBufferCreateInfo const& nfo, uint32_t mem_type, VkDevice dev, VkAllocationCallbacks const* alloc)
 {
-    if(!id)
-        id = add_handle();
+    id = reset_handle(id);
     auto &buf = get_handle(id);
     buf.destroy(dev, alloc);
     buf.create(nfo, mem_type, dev, alloc);
     return id;
 }
 
+buffer_id BufferCollection::import_host(void *mem, VkDeviceSize size, uint32_t mem_type_bits, VkDevice dev, VkAllocationCallbacks const* alloc)
+{
+    buffer_id id = add_handle();
+    get_handle(id).import_host(mem, size, mem_type_bits, dev, alloc);
+    return id;
+}
+
 void BufferCollection::destroy(buffer_id id, VkDevice v, VkAllocationCallbacks const* a)
 {
-    get_handle(id).destroy(v, a);
+    get_handle_checked(id).destroy(v, a);
+    remove_handle(id);
 }
 
 void BufferCollection::destroy_all(VkDevice v, VkAllocationCallbacks const* a)
 {
-    for(auto &buf : handles)
+    for_each_handle([&](Buffer &buf){
         buf.destroy(v, a);
-    handles.clear();
+    });
+    clear_handles();
 }
 
 
@@ -818,25 +1739,59 @@ void Buffer::create(VkBufferCreateInfo const& nfo, uint32_t mem_type_bits, VkDev
     alloc_info.memoryTypeIndex = vk_mem_type(mem_type_bits, req.memoryTypeBits);
     C4_CHECK_VK(vkAllocateMemory(dev, &alloc_info, alloc, &mem));
     C4_CHECK_VK(vkBindBufferMemory(dev, handle, mem, 0));
+    mem_size = req.size;
 }
 
-void Buffer::destroy(VkDevice v, VkAllocationCallbacks const* a)
+void Buffer::import_host(void *host_mem, VkDeviceSize host_size, uint32_t host_mem_type_bits, VkDevice dev, VkAllocationCallbacks const* alloc)
 {
-    C4_DESTROY_VK(vkDestroyBuffer, v, handle, a);
-    C4_DESTROY_MEM_VK(v, mem, a);
-    size = {};
-    alignment = {};
-}
-
-
-//-----------------------------------------------------------------------------
-//-----------------------------------------------------------------------------
+    size = host_size;
+    VkExternalMemoryBufferCreateInfo ext_nfo = {};
+    ext_nfo.sType = VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_BUFFER_CREATE_INFO;
+    ext_nfo.handleTypes = VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT;
+    VkBufferCreateInfo nfo = {};
+    nfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    nfo.pNext = &ext_nfo;
+    nfo.size = host_size;
+    nfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    nfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    C4_CHECK_VK(vkCreateBuffer(dev, &nfo, alloc, &handle));
+    VkMemoryRequirements req = {};
+    vkGetBufferMemoryRequirements(dev, handle, &req);
+    alignment = req.alignment;
+    const uint32_t type_bits = req.memoryTypeBits & host_mem_type_bits;
+    C4_CHECK(type_bits != 0);
+    VkImportMemoryHostPointerInfoEXT import_nfo = {};
+    import_nfo.sType = VK_STRUCTURE_TYPE_IMPORT_MEMORY_HOST_POINTER_INFO_EXT;
+    import_nfo.handleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT;
+    import_nfo.pHostPointer = host_mem;
+    VkMemoryAllocateInfo alloc_info = {};
+    alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    alloc_info.pNext = &import_nfo;
+    alloc_info.allocationSize = host_size;
+    alloc_info.memoryTypeIndex = 0;
+    while(!(type_bits & (1u << alloc_info.memoryTypeIndex)))
+        ++alloc_info.memoryTypeIndex;
+    C4_CHECK_VK(vkAllocateMemory(dev, &alloc_info, alloc, &mem));
+    C4_CHECK_VK(vkBindBufferMemory(dev, handle, mem, 0));
+}
+
+void Buffer::destroy(VkDevice v, VkAllocationCallbacks const* a)
+{
+    C4_DESTROY_VK(vkDestroyBuffer, v, handle, a);
+    C4_DESTROY_MEM_VK(v, mem, a);
+    size = {};
+    alignment = {};
+    mem_size = {};
+}
+
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
 
 image_id ImageCollection::reset(image_id id, VkImageCreateInfo const& C4_RESTRICT nfo, uint32_t mem_bits, VkDevice dev, VkAllocationCallbacks const* alloc)
 {
-    if(!id)
-        id = add_handle();
+    id = reset_handle(id);
     auto &img = get_handle(id);
     img.destroy(dev, alloc);
     img.create(nfo, mem_bits, dev, alloc);
@@ -845,14 +1800,16 @@ image_id ImageCollection::reset(image_id id, VkImageCreateInfo const& C4_RESTRIC
 
 void ImageCollection::destroy(image_id id, VkDevice v, VkAllocationCallbacks const* a)
 {
-    get_handle(id).destroy(v, a);
+    get_handle_checked(id).destroy(v, a);
+    remove_handle(id);
 }
 
 void ImageCollection::destroy_all(VkDevice v, VkAllocationCallbacks const* a)
 {
-    for(auto &image : handles)
+    for_each_handle([&](Image &image){
         image.destroy(v, a);
-    handles.clear();
+    });
+    clear_handles();
 }
 
 
@@ -863,8 +1820,11 @@ void Image::create(ImageLayout const& C4_RESTRICT layout_, uint32_t mem_bits, Vk
     create(nfo, mem_bits, v, a);
 }
 
-void Image::create(VkImageCreateInfo const& C4_RESTRICT nfo, uint32_t mem_bits, VkDevice v, VkAllocationCallbacks const* a)
+void Image::create(VkImageCreateInfo const& C4_RESTRICT nfo_, uint32_t mem_bits, VkDevice v, VkAllocationCallbacks const* a)
 {
+    VkImageCreateInfo nfo = nfo_;
+    if(nfo.mipLevels > 1) // the mips are generated with blits
+        nfo.usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
     C4_CHECK_VK(vkCreateImage(v, &nfo, a, &handle));
     layout = ImageLayout::make(nfo);
     VkMemoryRequirements req;
@@ -873,20 +1833,28 @@ void Image::create(VkImageCreateInfo const& C4_RESTRICT nfo, uint32_t mem_bits,
     alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
     alloc_info.allocationSize = req.size;
     alloc_info.memoryTypeIndex = vk_mem_type(mem_bits, req.memoryTypeBits);
+    // host-visible device-local memory is preferred for linear
+    // images, but not every device has it
+    const VkMemoryPropertyFlags host_local = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT|VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+    if(alloc_info.memoryTypeIndex == UINT32_C(0xff'ff'ff'ff) && (mem_bits & host_local) == host_local)
+        alloc_info.memoryTypeIndex = vk_mem_type(mem_bits & ~(VkMemoryPropertyFlags)VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, req.memoryTypeBits);
     C4_CHECK_VK(vkAllocateMemory(v, &alloc_info, a, &mem));
     C4_CHECK_VK(vkBindImageMemory(v, handle, mem, 0));
+    mem_size = req.size;
 }
 
 void Image::destroy(VkDevice v, VkAllocationCallbacks const* a)
 {
     C4_DESTROY_VK(vkDestroyImage, v, handle, a);
     C4_DESTROY_MEM_VK(v, mem, a);
+    mem_size = {};
     layout.clear();
 }
 
 void Image::destroy_mem(VkDevice v, VkAllocationCallbacks const* a)
 {
     C4_DESTROY_MEM_VK(v, mem, a);
+    mem_size = {};
 }
 
 //-----------------------------------------------------------------------------
@@ -910,7 +1878,7 @@ void copy_buffer_to_image(VkCommandBuffer cmd, VkBuffer buf, VkImage img, VkBuff
     barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
     barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
     barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT|VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
 }
 
 
@@ -920,8 +1888,25 @@ void copy_buffer_to_image(VkCommandBuffer cmd, VkBuffer buf, VkImage img, VkBuff
 
 image_view_id ImageViewCollection::reset(image_view_id id, Image const& img, VkDevice dev, VkAllocationCallbacks const* alloc)
 {
-    if(!id)
-        id = add_handle();
+    id = reset_handle(id);
+    VkImageView &imgview = get_handle(id);
+    C4_DESTROY_VK(vkDestroyImageView, dev, imgview, alloc);
+    VkImageViewCreateInfo info = {};
+    info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    info.image = img.handle;
+    info.viewType = img.layout.view_type();
+    info.format = img.layout.format;
+    info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    info.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+    info.subresourceRange.layerCount = img.layout.depth;
+    C4_CHECK_VK(vkCreateImageView(dev, &info, alloc, &imgview));
+    return id;
+}
+
+image_view_id ImageViewCollection::reset(image_view_id id, Image const& img, uint32_t layer, VkDevice dev, VkAllocationCallbacks const* alloc)
+{
+    C4_CHECK(layer < img.layout.depth);
+    id = reset_handle(id);
     VkImageView &imgview = get_handle(id);
     C4_DESTROY_VK(vkDestroyImageView, dev, imgview, alloc);
     VkImageViewCreateInfo info = {};
@@ -930,7 +1915,8 @@ image_view_id ImageViewCollection::reset(image_view_id id, Image const& img, VkD
     info.viewType = VK_IMAGE_VIEW_TYPE_2D;
     info.format = img.layout.format;
     info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    info.subresourceRange.levelCount = 1;
+    info.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+    info.subresourceRange.baseArrayLayer = layer;
     info.subresourceRange.layerCount = 1;
     C4_CHECK_VK(vkCreateImageView(dev, &info, alloc, &imgview));
     return id;
@@ -938,14 +1924,16 @@ image_view_id ImageViewCollection::reset(image_view_id id, Image const& img, VkD
 
 void ImageViewCollection::destroy(image_view_id id, VkDevice v, VkAllocationCallbacks const* a)
 {
-    C4_DESTROY_VK(vkDestroyImageView, v, get_handle(id), a);
+    C4_DESTROY_VK(vkDestroyImageView, v, get_handle_checked(id), a);
+    remove_handle(id);
 }
 
 void ImageViewCollection::destroy_all(VkDevice v, VkAllocationCallbacks const* a)
 {
-    for(auto &imgview: handles)
+    for_each_handle([&](VkImageView &imgview){
         C4_DESTROY_VK(vkDestroyImageView, v, imgview, a);
-    handles.clear();
+    });
+    clear_handles();
 }
 
 
@@ -955,8 +1943,7 @@ void ImageViewCollection::destroy_all(VkDevice v, VkAllocationCallbacks const* a
 
 sampler_id SamplerCollection::reset(sampler_id id, VkSamplerCreateInfo const& info, VkDevice dev, VkAllocationCallbacks const* alloc)
 {
-    if(!id)
-        id = add_handle();
+    id = reset_handle(id);
     VkSampler &handle = get_handle(id);
     C4_DESTROY_VK(vkDestroySampler, dev, handle, alloc);
     C4_CHECK_VK(vkCreateSampler(dev, &info, alloc, &handle));
@@ -965,14 +1952,106 @@ sampler_id SamplerCollection::reset(sampler_id id, VkSamplerCreateInfo const& in
 
 void SamplerCollection::destroy(sampler_id id, VkDevice v, VkAllocationCallbacks const* a)
 {
-    C4_DESTROY_VK(vkDestroySampler, v, get_handle(id), a);
+    C4_DESTROY_VK(vkDestroySampler, v, get_handle_checked(id), a);
+    remove_handle(id);
 }
 
 void SamplerCollection::destroy_all(VkDevice v, VkAllocationCallbacks const* a)
 {
-    for(auto &sampler : handles)
+    for_each_handle([&](VkSampler &sampler){
         C4_DESTROY_VK(vkDestroySampler, v, sampler, a);
-    handles.clear();
+    });
+    clear_handles();
+}
+
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+void ComputePipeline::create(ComputeShader const& shader, VkPipelineCache cache, VkDevice dev, VkAllocationCallbacks const* alloc)
+{
+    C4_CHECK(!shader.code.empty());
+    C4_CHECK(shader.bindings.size() <= 16);
+    push_constants_size = shader.push_constants_size;
+    local_size[0] = shader.local_size_x;
+    local_size[1] = shader.local_size_y;
+    local_size[2] = shader.local_size_z;
+    {
+        VkShaderModuleCreateInfo nfo = {};
+        nfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        nfo.codeSize = shader.code.size() * sizeof(uint32_t);
+        nfo.pCode = shader.code.data();
+        C4_CHECK_VK(vkCreateShaderModule(dev, &nfo, alloc, &module));
+    }
+    {
+        VkDescriptorSetLayoutBinding bindings[16] = {};
+        for(uint32_t i : irange((uint32_t)shader.bindings.size()))
+        {
+            bindings[i].binding = i;
+            bindings[i].descriptorType = shader.bindings[i];
+            bindings[i].descriptorCount = 1;
+            bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        }
+        VkDescriptorSetLayoutCreateInfo nfo = {};
+        nfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        nfo.bindingCount = (uint32_t)shader.bindings.size();
+        nfo.pBindings = bindings;
+        C4_CHECK_VK(vkCreateDescriptorSetLayout(dev, &nfo, alloc, &set_layout));
+    }
+    {
+        VkPushConstantRange range = {};
+        range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        range.size = push_constants_size;
+        VkPipelineLayoutCreateInfo nfo = {};
+        nfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        nfo.setLayoutCount = 1;
+        nfo.pSetLayouts = &set_layout;
+        nfo.pushConstantRangeCount = push_constants_size ? 1u : 0u;
+        nfo.pPushConstantRanges = &range;
+        C4_CHECK_VK(vkCreatePipelineLayout(dev, &nfo, alloc, &layout));
+    }
+    {
+        VkComputePipelineCreateInfo nfo = {};
+        nfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        nfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        nfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        nfo.stage.module = module;
+        nfo.stage.pName = "main";
+        nfo.layout = layout;
+        C4_CHECK_VK(vkCreateComputePipelines(dev, cache, 1, &nfo, alloc, &handle));
+    }
+}
+
+void ComputePipeline::destroy(VkDevice v, VkAllocationCallbacks const* a)
+{
+    C4_DESTROY_VK(vkDestroyPipeline, v, handle, a);
+    C4_DESTROY_VK(vkDestroyPipelineLayout, v, layout, a);
+    C4_DESTROY_VK(vkDestroyDescriptorSetLayout, v, set_layout, a);
+    C4_DESTROY_VK(vkDestroyShaderModule, v, module, a);
+}
+
+compute_pipeline_id ComputePipelineCollection::reset(compute_pipeline_id id, ComputeShader const& shader, VkPipelineCache cache, VkDevice dev, VkAllocationCallbacks const* alloc)
+{
+    id = reset_handle(id);
+    ComputePipeline &pipeline = get_handle(id);
+    pipeline.destroy(dev, alloc);
+    pipeline.create(shader, cache, dev, alloc);
+    return id;
+}
+
+void ComputePipelineCollection::destroy(compute_pipeline_id id, VkDevice v, VkAllocationCallbacks const* a)
+{
+    get_handle_checked(id).destroy(v, a);
+    remove_handle(id);
+}
+
+void ComputePipelineCollection::destroy_all(VkDevice v, VkAllocationCallbacks const* a)
+{
+    for_each_handle([&](ComputePipeline &pipeline){
+        pipeline.destroy(v, a);
+    });
+    clear_handles();
 }
 
 
@@ -1053,9 +2132,24 @@ Rhi::Rhi(VkDevice device, VkPhysicalDevice phys_device, VkAllocationCallbacks co
     , m_samplers()
     , m_images()
     , m_buffers()
+    , m_compute_pipelines()
     , m_non_coherent_atom_size(64)
-    , m_upload_buffer()
+    , m_pipeline_cache(VK_NULL_HANDLE)
+    , m_descriptor_pool(VK_NULL_HANDLE)
+    , m_upload_slots()
+    , m_upload_slot(0)
     , m_upload_buffer_in_use(false)
+    , m_linear_writes(-1)
+    , m_linear_device_local(false)
+    , m_host_import_alignment(0)
+    , m_get_host_pointer_props(nullptr)
+    , m_host_imports()
+    , m_has_memory_budget(false)
+    , m_memory_usage()
+    , m_memory_soft_limit(0)
+    , m_memory_eviction_handlers()
+    , m_frame_fences()
+    , m_swapchain_readbacks()
 {
     if(m_phys_device != VK_NULL_HANDLE)
     {
@@ -1063,18 +2157,104 @@ Rhi::Rhi(VkDevice device, VkPhysicalDevice phys_device, VkAllocationCallbacks co
         vkGetPhysicalDeviceProperties(m_phys_device, &props);
         m_non_coherent_atom_size = props.limits.nonCoherentAtomSize; // typically 64B
     }
+    if(m_device != VK_NULL_HANDLE)
+    {
+        VkDescriptorPoolSize pool_sizes[] = {
+            { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 256 },
+            { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 256 },
+            { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 256 },
+            { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 256 },
+        };
+        VkDescriptorPoolCreateInfo nfo = {};
+        nfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        nfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+        nfo.maxSets = 256;
+        nfo.poolSizeCount = (uint32_t)C4_COUNTOF(pool_sizes);
+        nfo.pPoolSizes = pool_sizes;
+        C4_CHECK_VK(vkCreateDescriptorPool(m_device, &nfo, m_allocator, &m_descriptor_pool));
+    }
 }
 
 Rhi::~Rhi()
 {
     VkDevice v = m_device;
     VkAllocationCallbacks const* a = m_allocator;
+    m_compute_pipelines.destroy_all(v, a);
+    m_host_imports.clear(); // the buffers and fences are destroyed below
+    C4_DESTROY_VK(vkDestroyDescriptorPool, v, m_descriptor_pool, a);
     m_buffers.destroy_all(v, a);
     m_images.destroy_all(v, a);
     m_samplers.destroy_all(v, a);
     m_image_views.destroy_all(v, a);
     m_fences.destroy_all(v, a);
-    m_upload_buffer.destroy(*this);
+    for(UploadSlot &slot : m_upload_slots)
+        slot.buf.destroy(*this);
+}
+
+void Rhi::update_memory_usage()
+{
+    MemoryUsage &mu = m_memory_usage;
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budget = {};
+    budget.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+    VkPhysicalDeviceMemoryProperties2 props = {};
+    props.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+    if(m_has_memory_budget)
+    {
+        props.pNext = &budget;
+        vkGetPhysicalDeviceMemoryProperties2(m_phys_device, &props);
+    }
+    else
+    {
+        vkGetPhysicalDeviceMemoryProperties(m_phys_device, &props.memoryProperties);
+    }
+    mu.has_budget = m_has_memory_budget;
+    mu.num_heaps = props.memoryProperties.memoryHeapCount;
+    for(uint32_t i : irange(mu.num_heaps))
+    {
+        MemoryHeapUsage &heap = mu.heaps[i];
+        heap.size = props.memoryProperties.memoryHeaps[i].size;
+        heap.flags = props.memoryProperties.memoryHeaps[i].flags;
+        heap.usage = m_has_memory_budget ? budget.heapUsage[i] : 0;
+        heap.budget = m_has_memory_budget ? budget.heapBudget[i] : heap.size;
+    }
+    mu.images = 0;
+    m_images.for_each_handle([&](Image const& img){ mu.images += img.mem_size; });
+    mu.buffers = 0;
+    m_buffers.for_each_handle([&](Buffer const& buf){ mu.buffers += buf.mem_size; });
+    mu.upload_buffer = 0;
+    for(UploadSlot const& slot : m_upload_slots)
+        mu.upload_buffer += slot.buf.m_buf.mem_size;
+    // the buffers are resized when rendering, which may be on the
+    // render thread: read the size it stored then
+    mu.imgui_buffers = g_ImGuiBuffersSize.load(std::memory_order_relaxed);
+    // eviction
+    if(m_memory_eviction_handlers.empty())
+        return;
+    VkDeviceSize excess = 0;
+    if(m_memory_soft_limit && mu.total() > m_memory_soft_limit)
+        excess = mu.total() - m_memory_soft_limit;
+    for(uint32_t i : irange(mu.num_heaps))
+    {
+        MemoryHeapUsage const& heap = mu.heaps[i];
+        if(mu.has_budget && (heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) && heap.usage > heap.budget)
+            excess = std::max(excess, heap.usage - heap.budget);
+    }
+    if(excess)
+        for(MemoryEvictionHandler const& h : m_memory_eviction_handlers)
+            h.fn(excess, h.data);
+}
+
+void Rhi::add_memory_eviction_handler(MemoryEvictionFn fn, void *data)
+{
+    m_memory_eviction_handlers.push_back({fn, data});
+}
+
+void Rhi::remove_memory_eviction_handler(MemoryEvictionFn fn, void *data)
+{
+    auto &h = m_memory_eviction_handlers;
+    h.erase(std::remove_if(h.begin(), h.end(), [&](MemoryEvictionHandler const& e){
+        return e.fn == fn && e.data == data;
+    }), h.end());
 }
 
 VkCommandBuffer Rhi::usr_cmd_buffer()
@@ -1088,17 +2268,99 @@ void Rhi::mark_usr_cmd_buffer()
     g_MainWindowData.Frames[g_MainWindowData.FrameIndex].CommandBuffer2Used = true;
 }
 
+image_id Rhi::reset_image(image_id id, VkImageCreateInfo const& C4_RESTRICT nfo, uint32_t mem_bits)
+{
+    C4_CHECK_MSG(nfo.mipLevels <= 1 || format_supports_blit(nfo.format),
+                 "format %d does not support blit: cannot generate mips", (int)nfo.format);
+    return m_images.reset(id, nfo, mem_bits, m_device, m_allocator);
+}
+
+bool Rhi::format_supports_blit(VkFormat fmt, bool *linear) const
+{
+    VkFormatProperties props;
+    vkGetPhysicalDeviceFormatProperties(m_phys_device, fmt, &props);
+    const VkFormatFeatureFlags features = props.optimalTilingFeatures;
+    if(linear)
+        *linear = (features & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT);
+    return (features & VK_FORMAT_FEATURE_BLIT_SRC_BIT) && (features & VK_FORMAT_FEATURE_BLIT_DST_BIT);
+}
+
+bool Rhi::with_mips(ImageLayout *layout) const
+{
+    if(!format_supports_blit(layout->format))
+    {
+        QUICKGUI_LOGF("[vulkan] format {} does not support blit: the image has no mips", (int)layout->format);
+        return false;
+    }
+    layout->with_mips();
+    return true;
+}
+
+bool Rhi::fence_submitted(VkFence fence) const
+{
+    return std::find(m_frame_fences.begin(), m_frame_fences.end(), fence) == m_frame_fences.end();
+}
+
+namespace {
+constexpr const VkMemoryPropertyFlags linear_image_mem = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+    | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+    | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+} // namespace
+
+bool Rhi::prefers_linear_writes(size_t num_bytes)
+{
+    if(m_linear_writes < 0)
+    {
+        m_linear_writes = 0;
+        const ImageLayout layout = ImageLayout::make_2d(VK_FORMAT_R8G8B8A8_UNORM, 512, 512);
+        if(!vk_format_supports_linear_sampling(layout.format, layout.width, layout.height))
+            return false;
+        ImageLayout linear_layout = layout;
+        linear_layout.linear = true;
+        Image img;
+        img.create(linear_layout.to_vk(), linear_image_mem, m_device, m_allocator);
+        VkMemoryRequirements req;
+        vkGetImageMemoryRequirements(m_device, img.handle, &req);
+        m_linear_device_local = vk_mem_type(linear_image_mem, req.memoryTypeBits) != UINT32_C(0xff'ff'ff'ff);
+        VkBufferCreateInfo bnfo = {};
+        bnfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bnfo.size = layout.num_bytes();
+        bnfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+        bnfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        Buffer buf;
+        buf.create(bnfo, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, m_device, m_allocator);
+        std::vector<char> src(layout.num_bytes());
+        for(size_t i : irange(src.size()))
+            src[i] = (char)(i * 31u);
+        auto time_writes = [&](VkDeviceMemory mem){
+            void *dst = nullptr;
+            C4_CHECK_VK(vkMapMemory(m_device, mem, 0, VK_WHOLE_SIZE, 0, &dst));
+            const time_point start = now();
+            for(int rep = 0; rep < 4; ++rep)
+                memcpy(dst, src.data(), src.size());
+            const fmsecs elapsed = now() - start;
+            vkUnmapMemory(m_device, mem);
+            return elapsed.count();
+        };
+        const float linear_ms = time_writes(img.mem);
+        const float staging_ms = time_writes(buf.mem);
+        // sampling the linear images may be slower than sampling
+        // the optimal ones, so the host writes must be a clear win
+        m_linear_writes = linear_ms < staging_ms ? 1 : 0;
+        QUICKGUI_LOGF("[vulkan] host writes: linear image={}ms (device local={}) staging buffer={}ms",
+                      linear_ms, m_linear_device_local, staging_ms);
+        img.destroy(m_device, m_allocator);
+        buf.destroy(m_device, m_allocator);
+    }
+    // sampling from host memory is slow for big images
+    return m_linear_writes && (m_linear_device_local || num_bytes <= (size_t(1) << 20));
+}
+
 VkDeviceSize Rhi::required_buffer_size(VkDeviceSize wanted, VkDeviceSize texelSize) const
 {
     C4_ASSERT(m_non_coherent_atom_size > 0);
     const VkDeviceSize lcm = std::lcm(m_non_coherent_atom_size, texelSize);
     const VkDeviceSize result = next_multiple(wanted, lcm);
-    printf("wanted=%lu(0x%x) noncoherentatomsize=%zu(0x%x) result=%zu(0x%x) rem=%zu(0x%xu)\n",
-           wanted, (unsigned)wanted,
-           m_non_coherent_atom_size, (unsigned)m_non_coherent_atom_size,
-           result, (unsigned)result,
-           result % m_non_coherent_atom_size, (unsigned)(result % m_non_coherent_atom_size)
-        );
     C4_ASSERT(result >= wanted);
     C4_ASSERT((result % m_non_coherent_atom_size) == VkDeviceSize(0));
     C4_ASSERT((result % texelSize) == VkDeviceSize(0));
@@ -1109,7 +2371,39 @@ size_t Rhi::use_upload_buffer_with(size_t wanted_upload_size)
 {
     C4_CHECK(!m_upload_buffer_in_use);
     m_upload_buffer_in_use = true;
-    return m_upload_buffer.require(*this, wanted_upload_size);
+    // take the first slot whose copies are done. The fences of the
+    // previous frames may not be submitted yet (eg by the render
+    // thread), which only makes them not ready.
+    uint32_t found = (uint32_t)m_upload_slots.size();
+    for(uint32_t i : irange((uint32_t)m_upload_slots.size()))
+    {
+        UploadSlot &slot = m_upload_slots[i];
+        if(slot.pending)
+        {
+            VkResult err = vkGetFenceStatus(m_device, get_fence(slot.fence));
+            if(err == VK_NOT_READY)
+                continue;
+            C4_CHECK_VK(err);
+            slot.pending = false;
+        }
+        found = i;
+        break;
+    }
+    if(found == m_upload_slots.size())
+    {
+        VkFenceCreateInfo fnfo = {};
+        fnfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        m_upload_slots.push_back({UploadBuffer{}, make_fence(fnfo), false});
+    }
+    m_upload_slot = found;
+    UploadSlot &slot = m_upload_slots[found];
+    VkFence fence = get_fence(slot.fence);
+    C4_CHECK_VK(vkResetFences(m_device, 1, &fence));
+    m_frame_fences.push_back(fence);
+    slot.pending = true;
+    // the GPU is done with this slot, so growing it can free the
+    // previous buffer right away
+    return slot.buf.require(*this, wanted_upload_size);
 }
 
 void Rhi::upload_image(image_id id, ImageLayout const& layout, ccharspan data, VkCommandBuffer cmdbuf)
@@ -1118,56 +2412,479 @@ void Rhi::upload_image(image_id id, ImageLayout const& layout, ccharspan data, V
     size_t num_bytes = layout.num_bytes();
     (void)use_upload_buffer_with(num_bytes);
     // copy to the staging upload buffer
-    VkDeviceSize offset = m_upload_buffer.add(*this, data.data(), data.size(), (VkDeviceSize)layout.num_bytes_per_pixel()); // this ensures adequate room
+    UploadBuffer &upload_buffer = _frame_upload_buffer();
+    VkDeviceSize offset = upload_buffer.add(*this, data.data(), data.size(), (VkDeviceSize)layout.num_bytes_per_pixel()); // this ensures adequate room
     // now upload
-    upload_image(id, layout, data, cmdbuf, &m_upload_buffer, offset);
+    upload_image(id, layout, data, cmdbuf, &upload_buffer, offset);
 }
 
-void Rhi::upload_image(image_id id, ImageLayout const& layout, ccharspan data, VkCommandBuffer cmdbuf, UploadBuffer *upload_buffer, VkDeviceSize upload_buffer_offset)
+namespace {
+VkImageMemoryBarrier _upload_barrier_pre(Image const& img, uint32_t first_layer, uint32_t num_layers)
 {
-    auto &img = get_image(id);
-    C4_ASSERT(data.size() == layout.num_bytes());C4_UNUSED(data);
-    // copy the staging buffer to the image, ensuring synchronization
-    VkBufferImageCopy region = {};
-    // see https://stackoverflow.com/questions/46501832/vulkan-vkbufferimagecopy-for-partial-transfer
-    region.bufferOffset = upload_buffer_offset;
-    region.bufferRowLength = layout.width;
-    region.bufferImageHeight = layout.height;
-    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    region.imageSubresource.layerCount = 1; // FIXME
-    region.imageExtent.width = img.layout.width;
-    region.imageExtent.height = img.layout.height;
-    region.imageExtent.depth = img.layout.depth;
     VkImageMemoryBarrier barrier = {};
     barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
     barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED; // the contents of these layers are fully overwritten
     barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
     barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
     barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
     barrier.image = img.handle;
-    barrier.subresourceRange.aspectMask = region.imageSubresource.aspectMask;
-    barrier.subresourceRange.levelCount = 1; // FIXME
-    barrier.subresourceRange.layerCount = 1; // FIXME
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.levelCount = img.layout.mip_levels; // the mips will be overwritten as well
+    barrier.subresourceRange.baseArrayLayer = first_layer;
+    barrier.subresourceRange.layerCount = num_layers;
+    return barrier;
+}
+VkImageMemoryBarrier _upload_barrier_post(VkImageMemoryBarrier barrier)
+{
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    return barrier;
+}
+VkBufferImageCopy _upload_region(ImageLayout const& layout, VkDeviceSize buffer_offset, uint32_t first_layer, uint32_t num_layers)
+{
+    // see https://stackoverflow.com/questions/46501832/vulkan-vkbufferimagecopy-for-partial-transfer
+    VkBufferImageCopy region = {};
+    region.bufferOffset = buffer_offset;
+    region.bufferRowLength = layout.width;
+    region.bufferImageHeight = layout.height; // this is also the layer stride
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.baseArrayLayer = first_layer;
+    region.imageSubresource.layerCount = num_layers;
+    region.imageExtent.width = layout.width;
+    region.imageExtent.height = layout.height;
+    region.imageExtent.depth = 1; // layers are not depth slices
+    return region;
+}
+} // namespace
+
+void Rhi::upload_image(image_id id, ImageLayout const& layout, ccharspan data, VkCommandBuffer cmdbuf, UploadBuffer *upload_buffer, VkDeviceSize upload_buffer_offset)
+{
+    C4_ASSERT(data.size() == layout.num_bytes());C4_UNUSED(data);
+    C4_ASSERT(layout.depth == get_image(id).layout.depth);C4_UNUSED(layout);
+    _upload_image_from(id, upload_buffer->m_buf, upload_buffer_offset, cmdbuf);
+}
+
+void Rhi::_upload_image_from(image_id id, VkBuffer src, VkDeviceSize src_offset, VkCommandBuffer cmdbuf)
+{
+    auto &img = get_image(id);
+    // copy the buffer to the image, ensuring synchronization
+    VkBufferImageCopy region = _upload_region(img.layout, src_offset, 0, img.layout.depth);
+    VkImageMemoryBarrier barrier = _upload_barrier_pre(img, 0, img.layout.depth);
     vkCmdPipelineBarrier(cmdbuf, VK_PIPELINE_STAGE_HOST_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
-    vkCmdCopyBufferToImage(cmdbuf, upload_buffer->m_buf, img.handle, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+    vkCmdCopyBufferToImage(cmdbuf, src, img.handle, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+    if(img.layout.has_mips())
+    {
+        generate_mips(img, 0, img.layout.depth, cmdbuf);
+        return;
+    }
+    barrier = _upload_barrier_post(barrier);
+    vkCmdPipelineBarrier(cmdbuf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT|VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+bool Rhi::can_import_host_memory(void const* mem, size_t size) const
+{
+    return m_host_import_alignment
+        && mem != nullptr
+        && size != 0
+        && ((uintptr_t)mem % m_host_import_alignment) == 0
+        && (size % m_host_import_alignment) == 0;
+}
+
+Rhi::HostImport* Rhi::_find_host_import(void const* mem, bool retired)
+{
+    for(HostImport &hi : m_host_imports)
+        if(hi.retired == retired && (char const*)mem >= hi.mem && (char const*)mem < hi.mem + hi.size)
+            return &hi;
+    return nullptr;
+}
+
+bool Rhi::_host_import_submitted(HostImport const& hi) const
+{
+    return fence_submitted(m_fences.get_handle(hi.fence));
+}
+
+void Rhi::upload_image_from_host(image_id id, ccharspan data, VkCommandBuffer cmdbuf)
+{
+    ImageLayout const& layout = get_image(id).layout;
+    C4_CHECK(data.size() == layout.num_bytes());
+    HostImport *hi = _find_host_import(data.data());
+    if(hi && (char const*)data.end() > hi->mem + hi->size)
+    {
+        // the data grew past the import: import it again
+        release_host_memory(hi->mem);
+        hi = nullptr;
+    }
+    if(!hi && can_import_host_memory(data.data(), data.size()))
+    {
+        void *mem = (void*)data.data();
+        VkMemoryHostPointerPropertiesEXT props = {};
+        props.sType = VK_STRUCTURE_TYPE_MEMORY_HOST_POINTER_PROPERTIES_EXT;
+        VkResult err = m_get_host_pointer_props(m_device, VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT, mem, &props);
+        if(err == VK_SUCCESS && props.memoryTypeBits)
+        {
+            VkFenceCreateInfo fnfo = {};
+            fnfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+            HostImport nhi = {};
+            nhi.mem = data.data();
+            nhi.size = data.size();
+            nhi.buf = m_buffers.import_host(mem, (VkDeviceSize)nhi.size, props.memoryTypeBits, m_device, m_allocator);
+            nhi.fence = make_fence(fnfo);
+            nhi.pending = false;
+            nhi.retired = false;
+            m_host_imports.push_back(nhi);
+            hi = &m_host_imports.back();
+        }
+    }
+    const VkDeviceSize offset = hi ? (VkDeviceSize)(data.data() - hi->mem) : 0;
+    if(!hi || offset % layout.num_bytes_per_pixel())
+    {
+        // fallback: copy to the staging buffer
+        upload_image(id, layout, data, cmdbuf);
+        return;
+    }
+    VkFence fence = get_fence(hi->fence);
+    if(!hi->pending || _host_import_submitted(*hi))
+    {
+        // a previous upload may still be in flight
+        if(hi->pending)
+            C4_CHECK_VK(vkWaitForFences(m_device, 1, &fence, VK_TRUE, UINT64_MAX));
+        C4_CHECK_VK(vkResetFences(m_device, 1, &fence));
+        m_frame_fences.push_back(fence);
+        hi->pending = true;
+    }
+    _upload_image_from(id, get_buffer(hi->buf).handle, offset, cmdbuf);
+}
+
+bool Rhi::host_memory_in_use(void const* mem)
+{
+    for(HostImport const& hi : m_host_imports)
+        if(hi.retired && (char const*)mem >= hi.mem && (char const*)mem < hi.mem + hi.size)
+            return true;
+    HostImport *hi = _find_host_import(mem);
+    if(!hi || !hi->pending)
+        return false;
+    if(!_host_import_submitted(*hi))
+        return true;
+    VkResult err = vkGetFenceStatus(m_device, get_fence(hi->fence));
+    if(err == VK_NOT_READY)
+        return true;
+    C4_CHECK_VK(err);
+    hi->pending = false;
+    return false;
+}
+
+void Rhi::release_host_memory(void const* mem)
+{
+    HostImport *hi = _find_host_import(mem);
+    if(!hi)
+        return;
+    if(hi->pending)
+    {
+        if(!_host_import_submitted(*hi))
+        {
+            // the fence cannot be waited before the frame is
+            // submitted: drop the import after the frame is done
+            hi->retired = true;
+            return;
+        }
+        VkFence fence = get_fence(hi->fence);
+        C4_CHECK_VK(vkWaitForFences(m_device, 1, &fence, VK_TRUE, UINT64_MAX));
+    }
+    _destroy_host_import(hi);
+}
+
+void Rhi::release_retired_host_imports()
+{
+    for(size_t i = 0; i < m_host_imports.size(); )
+    {
+        HostImport *hi = &m_host_imports[i];
+        if(hi->retired && _host_import_submitted(*hi))
+        {
+            VkResult err = vkGetFenceStatus(m_device, get_fence(hi->fence));
+            if(err != VK_NOT_READY)
+            {
+                C4_CHECK_VK(err);
+                _destroy_host_import(hi);
+                continue;
+            }
+        }
+        ++i;
+    }
+}
+
+void Rhi::_destroy_host_import(HostImport *hi)
+{
+    destroy_buffer(hi->buf);
+    destroy_fence(hi->fence);
+    m_host_imports.erase(m_host_imports.begin() + (hi - m_host_imports.data()));
+}
+
+void Rhi::upload_images(c4::span<const UploadRequest> reqs, VkCommandBuffer cmdbuf)
+{
+    upload_images(reqs, cmdbuf, nullptr);
+}
+
+void Rhi::upload_images(c4::span<const UploadRequest> reqs, VkCommandBuffer cmdbuf, UploadBuffer *upload_buffer)
+{
+    if(reqs.empty())
+        return;
+    auto num_layers_of = [](UploadRequest const& req, ImageLayout const& layout){
+        return req.num_layers ? req.num_layers : layout.depth - req.first_layer;
+    };
+    // compute the offset of each source in the staging buffer. Each
+    // offset must be a multiple of the texel size (for the copy) and of
+    // the non-coherent atom size (for the flush).
+    std::vector<VkDeviceSize> offsets(reqs.size());
+    VkDeviceSize total = 0;
+    for(size_t i : irange(reqs.size()))
+    {
+        UploadRequest const& req = reqs[i];
+        ImageLayout const& layout = get_image(req.img_id).layout;
+        C4_CHECK(req.first_layer < layout.depth);
+        const uint32_t num_layers = num_layers_of(req, layout);
+        C4_CHECK(req.first_layer + num_layers <= layout.depth);
+        uint32_t width = layout.width;
+        uint32_t height = layout.height;
+        if(req.extent.width)
+        {
+            C4_CHECK(!layout.has_mips());
+            C4_CHECK(req.offset.x >= 0 && req.offset.y >= 0);
+            C4_CHECK((uint32_t)req.offset.x + req.extent.width <= layout.width);
+            C4_CHECK((uint32_t)req.offset.y + req.extent.height <= layout.height);
+            width = req.extent.width;
+            height = req.extent.height;
+        }
+        C4_CHECK(req.data.size() == num_layers * width * height * layout.num_bytes_per_pixel());
+        const VkDeviceSize texel_size = layout.num_bytes_per_pixel();
+        offsets[i] = next_multiple(total, std::lcm(m_non_coherent_atom_size, texel_size));
+        total = offsets[i] + required_buffer_size(req.data.size(), texel_size);
+    }
+    // pack all the sources with a single map/flush
+    if(!upload_buffer)
+    {
+        (void)use_upload_buffer_with(total);
+        upload_buffer = &_frame_upload_buffer();
+    }
+    else
+        (void)upload_buffer->require(*this, total);
+    C4_CHECK(total <= upload_buffer->m_buf.size);
+    void *map = nullptr;
+    C4_CHECK_VK(vkMapMemory(m_device, upload_buffer->m_buf.mem, 0, total, /*flags*/0, &map));
+    for(size_t i : irange(reqs.size()))
+        memcpy((char*)map + offsets[i], reqs[i].data.data(), reqs[i].data.size());
+    VkMappedMemoryRange range = {};
+    range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+    range.memory = upload_buffer->m_buf.mem;
+    range.offset = 0;
+    range.size = total;
+    C4_CHECK_VK(vkFlushMappedMemoryRanges(m_device, 1, &range));
+    vkUnmapMemory(m_device, upload_buffer->m_buf.mem);
+    upload_buffer->m_pos = total;
+    // one barrier batch, one copy per destination, one barrier batch.
+    // The requests are merged per image and layer before building the
+    // barriers, so that each layer is transitioned once, from its
+    // actual layout: the layers written whole are discarded, and those
+    // only written by sub-rects keep their other texels, and are in
+    // the sampled layout.
+    enum : uint8_t { layer_untouched = 0, layer_sub_rect = 1, layer_whole = 2 };
+    std::vector<Image const*> imgs;
+    std::vector<std::vector<uint8_t>> img_layers;
+    for(UploadRequest const& req : reqs)
+    {
+        Image const& img = get_image(req.img_id);
+        size_t pos = (size_t)(std::find(imgs.begin(), imgs.end(), &img) - imgs.begin());
+        if(pos == imgs.size())
+        {
+            imgs.push_back(&img);
+            img_layers.emplace_back(img.layout.depth, (uint8_t)layer_untouched);
+        }
+        const uint8_t use = req.extent.width ? layer_sub_rect : layer_whole;
+        for(uint32_t l : irange(req.first_layer, req.first_layer + num_layers_of(req, img.layout)))
+            img_layers[pos][l] = std::max(img_layers[pos][l], use);
+    }
+    std::vector<VkImageMemoryBarrier> barriers;
+    std::vector<Image const*> barrier_imgs;
+    barriers.reserve(reqs.size());
+    barrier_imgs.reserve(reqs.size());
+    VkPipelineStageFlags src_stages = VK_PIPELINE_STAGE_HOST_BIT;
+    for(size_t i : irange(imgs.size()))
+    {
+        Image const& img = *imgs[i];
+        std::vector<uint8_t> const& layers = img_layers[i];
+        // one barrier for each run of layers with the same use
+        for(uint32_t first = 0; first < img.layout.depth; )
+        {
+            const uint8_t use = layers[first];
+            uint32_t last = first + 1;
+            while(last < img.layout.depth && layers[last] == use)
+                ++last;
+            if(use != layer_untouched)
+            {
+                VkImageMemoryBarrier barrier = _upload_barrier_pre(img, first, last - first);
+                if(use == layer_sub_rect)
+                {
+                    barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+                    barrier.oldLayout = img.layout.sampled_layout();
+                    src_stages |= VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT|VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+                }
+                barriers.push_back(barrier);
+                barrier_imgs.push_back(&img);
+            }
+            first = last;
+        }
+    }
+    vkCmdPipelineBarrier(cmdbuf, src_stages, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, (uint32_t)barriers.size(), barriers.data());
+    // the copies are not ordered among themselves: a copy that
+    // overlaps a previous one of the batch (eg a sub-rect over a whole
+    // layer, or an atlas rect reused in the same frame) must wait for it
+    struct Written
+    {
+        VkImage  img;
+        uint32_t first_layer, num_layers;
+        VkOffset2D offset;
+        VkExtent2D extent;
+    };
+    std::vector<Written> written;
+    written.reserve(reqs.size());
+    for(size_t i : irange(reqs.size()))
+    {
+        UploadRequest const& req = reqs[i];
+        Image const& img = get_image(req.img_id);
+        VkBufferImageCopy region = _upload_region(img.layout, offsets[i], req.first_layer, num_layers_of(req, img.layout));
+        if(req.extent.width)
+        {
+            region.bufferRowLength = req.extent.width;
+            region.bufferImageHeight = req.extent.height;
+            region.imageOffset.x = req.offset.x;
+            region.imageOffset.y = req.offset.y;
+            region.imageExtent.width = req.extent.width;
+            region.imageExtent.height = req.extent.height;
+        }
+        const Written w = {img.handle, req.first_layer, region.imageSubresource.layerCount,
+                           {region.imageOffset.x, region.imageOffset.y},
+                           {region.imageExtent.width, region.imageExtent.height}};
+        auto overlaps = [&w](Written const& o){
+            return o.img == w.img
+                && o.first_layer < w.first_layer + w.num_layers && w.first_layer < o.first_layer + o.num_layers
+                && o.offset.x < w.offset.x + (int32_t)w.extent.width && w.offset.x < o.offset.x + (int32_t)o.extent.width
+                && o.offset.y < w.offset.y + (int32_t)w.extent.height && w.offset.y < o.offset.y + (int32_t)o.extent.height;
+        };
+        if(std::any_of(written.begin(), written.end(), overlaps))
+        {
+            VkMemoryBarrier mb = {};
+            mb.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            mb.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            mb.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            vkCmdPipelineBarrier(cmdbuf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &mb, 0, nullptr, 0, nullptr);
+            written.clear();
+        }
+        written.push_back(w);
+        vkCmdCopyBufferToImage(cmdbuf, upload_buffer->m_buf, img.handle, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+    }
+    // images with mips get their final transition when generating
+    // the mips; the others are transitioned here in a single batch
+    size_t num_post = 0;
+    for(size_t b : irange(barriers.size()))
+    {
+        VkImageSubresourceRange const& range_ = barriers[b].subresourceRange;
+        Image const* img = barrier_imgs[b];
+        if(img->layout.has_mips())
+            generate_mips(*img, range_.baseArrayLayer, range_.layerCount, cmdbuf);
+        else
+            barriers[num_post++] = _upload_barrier_post(barriers[b]);
+    }
+    if(num_post)
+        vkCmdPipelineBarrier(cmdbuf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT|VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, (uint32_t)num_post, barriers.data());
+}
+
+void Rhi::generate_mips(Image const& img, uint32_t first_layer, uint32_t num_layers, VkCommandBuffer cmdbuf)
+{
+    // see https://vulkan-tutorial.com/Generating_Mipmaps
+    C4_ASSERT(first_layer + num_layers <= img.layout.depth);
+    bool linear = false;
+    C4_CHECK(format_supports_blit(img.layout.format, &linear));
+    VkImageMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = img.handle;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseArrayLayer = first_layer;
+    barrier.subresourceRange.layerCount = num_layers;
+    barrier.subresourceRange.levelCount = 1;
+    int32_t w = (int32_t)img.layout.width;
+    int32_t h = (int32_t)img.layout.height;
+    for(uint32_t level = 1; level < img.layout.mip_levels; ++level)
+    {
+        // the previous level becomes the blit source
+        barrier.subresourceRange.baseMipLevel = level - 1;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        vkCmdPipelineBarrier(cmdbuf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+        VkImageBlit blit = {};
+        blit.srcOffsets[1] = {w, h, 1};
+        blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        blit.srcSubresource.mipLevel = level - 1;
+        blit.srcSubresource.baseArrayLayer = first_layer;
+        blit.srcSubresource.layerCount = num_layers;
+        w = w > 1 ? w / 2 : 1;
+        h = h > 1 ? h / 2 : 1;
+        blit.dstOffsets[1] = {w, h, 1};
+        blit.dstSubresource = blit.srcSubresource;
+        blit.dstSubresource.mipLevel = level;
+        vkCmdBlitImage(cmdbuf,
+                       img.handle, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                       img.handle, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                       1, &blit, linear ? VK_FILTER_LINEAR : VK_FILTER_NEAREST);
+        // the previous level is now done
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        vkCmdPipelineBarrier(cmdbuf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT|VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+    }
+    // the last level was only written to
+    barrier.subresourceRange.baseMipLevel = img.layout.mip_levels - 1;
     barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
     barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
     barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
     barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-    vkCmdPipelineBarrier(cmdbuf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+    vkCmdPipelineBarrier(cmdbuf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT|VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
 }
 
 
 //-----------------------------------------------------------------------------
 
+void ImageDynamicCpu2Gpu::flip()
+{
+    if(linear)
+    {
+        // the image leaving the display is sampled up to the current
+        // frame, which now signals its fence
+        VkFence fence = this->fence(rgpu);
+        if(rhi->fence_submitted(fence))
+        {
+            C4_CHECK_VK(vkWaitForFences(rhi->m_device, 1, &fence, VK_TRUE, UINT64_MAX));
+            C4_CHECK_VK(vkResetFences(rhi->m_device, 1, &fence));
+            rhi->m_frame_fences.push_back(fence);
+        }
+    }
+    wcpu = (wcpu + 1) % num_entries;
+    rgpu = (rgpu + 1) % num_entries;
+}
+
 void ImageDynamicCpu2Gpu::set_name(Rhi *rhi_, const char *name)
 {
     for(uint32_t idx : irange(num_entries))
         rhi_->set_name(img_ids[idx], name);
 }
 
-void ImageDynamicCpu2Gpu::reset(Rhi *rhi_, VkImageCreateInfo const& C4_RESTRICT info)
+void ImageDynamicCpu2Gpu::reset(Rhi *rhi_, VkImageCreateInfo const& C4_RESTRICT info, WriteMode mode)
 {
     // For b:
     //
@@ -1193,13 +2910,32 @@ void ImageDynamicCpu2Gpu::reset(Rhi *rhi_, VkImageCreateInfo const& C4_RESTRICT
     //     0. start over at 1.
 //static_assert(num_entries > 1);
     rhi = rhi_;
+    _release_raw();
     rgpu = 0;
     wcpu = (rgpu + 1) % num_entries;
     const uint32_t nbpp = vk_num_bytes_per_pixel(info.format);
     const uint32_t num_bytes = nbpp * info.extent.width * info.extent.height * info.extent.depth * info.arrayLayers;
     VkDevice v = rhi->m_device;
+    linear = false;
+    if(mode != write_staging)
+    {
+        const bool supported = info.mipLevels == 1 && info.arrayLayers == 1 && info.extent.depth == 1
+            && vk_format_supports_linear_sampling(info.format, info.extent.width, info.extent.height);
+        QUICKGUI_LOGF_IF(mode == write_linear && !supported, "[vulkan] linear writes are not supported for this image; using staging copies");
+        linear = supported && (mode == write_linear || rhi->prefers_linear_writes(num_bytes));
+    }
+    if(linear)
+    {
+        _reset_linear(info);
+        // the callers of the automatic mode expect tightly packed rows
+        if(mode == write_linear || row_pitch == (VkDeviceSize)nbpp * info.extent.width)
+            return;
+        linear = false;
+    }
+    row_pitch = (VkDeviceSize)nbpp * info.extent.width;
     for(uint32_t idx : irange(num_entries))
     {
+        imgmem[idx] = {};
         // create VkImage i with UNDEFINED layout backed by DEVICE_LOCAL memory
         img_ids[idx] = rhi->reset_image(img_ids[idx], info, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
         // create VkBuffer b with UNDEFINED backed by HOST_VISIBLE memory
@@ -1221,8 +2957,135 @@ void ImageDynamicCpu2Gpu::reset(Rhi *rhi_, VkImageCreateInfo const& C4_RESTRICT
     }
 }
 
+void ImageDynamicCpu2Gpu::_reset_linear(VkImageCreateInfo const& C4_RESTRICT info)
+{
+    VkDevice v = rhi->m_device;
+    VkImageCreateInfo linfo = info;
+    linfo.tiling = VK_IMAGE_TILING_LINEAR;
+    linfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT;
+    linfo.initialLayout = VK_IMAGE_LAYOUT_PREINITIALIZED;
+    for(uint32_t idx : irange(num_entries))
+    {
+        img_ids[idx] = rhi->reset_image(img_ids[idx], linfo, linear_image_mem);
+        VkImageSubresource subresource = {};
+        subresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        VkSubresourceLayout sublayout = {};
+        vkGetImageSubresourceLayout(v, img(idx).handle, &subresource, &sublayout);
+        // the pitch is the same for all the images
+        row_pitch = sublayout.rowPitch;
+        void* mapped = nullptr;
+        C4_CHECK_VK(vkMapMemory(v, img(idx).mem, sublayout.offset, sublayout.size, 0, &mapped));
+        imgmem[idx] = {(char*)mapped, (size_t)sublayout.size};
+        imgready[idx] = false;
+        if(buf_ids[idx])
+        {
+            rhi->destroy_buffer(buf_ids[idx]);
+            buf_ids[idx] = {};
+            bufmem[idx] = {};
+        }
+        VkFenceCreateInfo fnfo = {};
+        fnfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        fnfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+        fence_ids[idx] = rhi->reset_fence(fence_ids[idx], fnfo);
+    }
+}
+
+void ImageDynamicCpu2Gpu::reset_raw(Rhi *rhi_, VkImageCreateInfo const& C4_RESTRICT info, compute_pipeline_id kernel_, size_t raw_bytes)
+{
+    C4_CHECK_MSG(info.format == VK_FORMAT_R8G8B8A8_UNORM, "the kernels write rgba8 images");
+    C4_CHECK(info.mipLevels == 1 && info.arrayLayers == 1 && info.extent.depth == 1);
+    rhi = rhi_;
+    _release_raw();
+    rgpu = 0;
+    wcpu = (rgpu + 1) % num_entries;
+    linear = false;
+    row_pitch = {};
+    kernel = kernel_;
+    C4_CHECK(rhi->get_compute_pipeline(kernel).push_constants_size <= sizeof(kernel_params));
+    // the kernels read the source as 32-bit words
+    const size_t num_bytes = next_multiple(raw_bytes, size_t(4));
+    VkDevice v = rhi->m_device;
+    VkImageCreateInfo inf = info;
+    inf.usage |= VK_IMAGE_USAGE_STORAGE_BIT|VK_IMAGE_USAGE_SAMPLED_BIT;
+    for(uint32_t idx : irange(num_entries))
+    {
+        imgmem[idx] = {};
+        img_ids[idx] = rhi->reset_image(img_ids[idx], inf, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        view_ids[idx] = rhi->reset_image_view(view_ids[idx], img(idx));
+        VkBufferCreateInfo bnfo = {};
+        bnfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bnfo.size = num_bytes;
+        bnfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+        bnfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        buf_ids[idx] = rhi->reset_buffer(buf_ids[idx], bnfo, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+        void* mapped = nullptr;
+        C4_CHECK_VK(vkMapMemory(v, buf(idx).mem, 0, num_bytes, 0, &mapped));
+        bufmem[idx] = {(char*)mapped, num_bytes};
+        passes[idx].reset(rhi, kernel);
+        const ComputeResource resources[] = {
+            ComputeResource::storage_buffer(buf(idx).handle, 0, num_bytes),
+            ComputeResource::storage_image(rhi->get_image_view(view_ids[idx])),
+        };
+        passes[idx].bind(resources);
+        VkFenceCreateInfo fnfo = {};
+        fnfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        fnfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+        fence_ids[idx] = rhi->reset_fence(fence_ids[idx], fnfo);
+    }
+}
+
+void ImageDynamicCpu2Gpu::_release_raw()
+{
+    if(!kernel)
+        return;
+    for(uint32_t idx : irange(num_entries))
+    {
+        passes[idx].destroy();
+        if(view_ids[idx])
+            rhi->destroy_image_view(view_ids[idx]);
+        view_ids[idx] = {};
+    }
+    kernel = {};
+}
+
+void ImageDynamicCpu2Gpu::_finish_raw(ccharspan written)
+{
+    C4_ASSERT(written.begin() >= bufmem[wcpu].begin());
+    C4_ASSERT(written.end()   <= bufmem[wcpu].end());
+    Image const& curr_img = img(wcpu);
+    VkCommandBuffer cmd = rhi->usr_cmd_buffer();
+    rhi->mark_usr_cmd_buffer();
+    VkMappedMemoryRange mmr = {};
+    mmr.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+    mmr.memory = buf(wcpu).mem;
+    mmr.offset = 0;
+    mmr.size = VK_WHOLE_SIZE;
+    C4_CHECK_VK(vkFlushMappedMemoryRanges(rhi->m_device, 1, &mmr));
+    VkBufferMemoryBarrier bbarrier = {};
+    bbarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    bbarrier.srcAccessMask = VK_ACCESS_HOST_WRITE_BIT;
+    bbarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    bbarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    bbarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    bbarrier.buffer = buf(wcpu).handle;
+    bbarrier.offset = 0;
+    bbarrier.size = VK_WHOLE_SIZE;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_HOST_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 1, &bbarrier, 0, nullptr);
+    // the previous contents are overwritten, and the previous reads
+    // were in the fragment shader
+    image_barrier(cmd, curr_img,
+                  VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+                  VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+    passes[wcpu].dispatch(cmd, kernel_params, curr_img.layout.width, curr_img.layout.height);
+    image_barrier(cmd, curr_img,
+                  VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+                  VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+}
+
 charspan ImageDynamicCpu2Gpu::start_wcpu()
 {
+    if(kernel)
+        return bufmem[wcpu];
     ImageLayout const& layout_ = layout();
     VkOffset3D first = {};
     VkOffset3D last = {0, c4::szconv<int32_t>(layout_.height), 0};
@@ -1231,6 +3094,11 @@ charspan ImageDynamicCpu2Gpu::start_wcpu()
 
 void ImageDynamicCpu2Gpu::finish_wcpu(ccharspan written)
 {
+    if(kernel)
+    {
+        _finish_raw(written);
+        return;
+    }
     ImageLayout const& layout_ = layout();
     VkOffset3D first = {};
     VkOffset3D last = {0, c4::szconv<int32_t>(layout_.height), 0};
@@ -1239,6 +3107,20 @@ void ImageDynamicCpu2Gpu::finish_wcpu(ccharspan written)
 
 charspan ImageDynamicCpu2Gpu::start_wcpu(VkOffset3D first, VkOffset3D last)
 {
+    C4_CHECK_MSG(!kernel, "raw mode: use the whole-image start_wcpu()");
+    if(linear)
+    {
+        // the image may still be sampled by the frames in flight. Its
+        // fence is not submitted when the image was displayed in the
+        // current frame, and then the previous frames are done with it.
+        VkFence fence = this->fence(wcpu);
+        if(rhi->fence_submitted(fence))
+            C4_CHECK_VK(vkWaitForFences(rhi->m_device, 1, &fence, VK_TRUE, UINT64_MAX));
+        const VkDeviceSize nbpp = vk_num_bytes_per_pixel(img(wcpu).layout.format);
+        const VkDeviceSize begin = (VkDeviceSize)first.y * row_pitch + (VkDeviceSize)first.x * nbpp;
+        const VkDeviceSize end = (VkDeviceSize)last.y * row_pitch + (VkDeviceSize)last.x * nbpp;
+        return imgmem[wcpu].subspan((size_t)begin, (size_t)(end - begin));
+    }
     VkDevice v = rhi->m_device;
     VkCommandBuffer cmd = rhi->usr_cmd_buffer();
     rhi->mark_usr_cmd_buffer();
@@ -1267,9 +3149,28 @@ charspan ImageDynamicCpu2Gpu::start_wcpu(VkOffset3D first, VkOffset3D last)
 
 void ImageDynamicCpu2Gpu::finish_wcpu(VkOffset3D first, VkOffset3D last, ccharspan written)
 {
+    C4_CHECK_MSG(!kernel, "raw mode: use the whole-image finish_wcpu()");
     C4_ASSERT(last.x >= first.x);
     C4_ASSERT(last.y >= first.y);
     C4_ASSERT(last.z >= first.z);
+    if(linear)
+    {
+        // the memory is coherent, and the host writes are visible to
+        // the commands submitted afterwards
+        C4_ASSERT(written.begin() >= imgmem[wcpu].begin());
+        C4_ASSERT(written.end()   <= imgmem[wcpu].end());
+        C4_UNUSED(written);
+        if(!imgready[wcpu])
+        {
+            VkCommandBuffer cmd = rhi->usr_cmd_buffer();
+            rhi->mark_usr_cmd_buffer();
+            image_barrier(cmd, img(wcpu),
+                          VK_IMAGE_LAYOUT_PREINITIALIZED, VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_WRITE_BIT,
+                          VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+            imgready[wcpu] = true;
+        }
+        return;
+    }
     auto &curr_buf = buf(wcpu);
     auto &curr_img = img(wcpu);
     VkDevice v = rhi->m_device;
@@ -1320,7 +3221,7 @@ void ImageDynamicCpu2Gpu::finish_wcpu(VkOffset3D first, VkOffset3D last, ccharsp
     ibarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
     ibarrier.image = curr_img.handle;
     ibarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    ibarrier.subresourceRange.levelCount = 1;
+    ibarrier.subresourceRange.levelCount = curr_img.layout.mip_levels;
     ibarrier.subresourceRange.layerCount = 1;
     vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_HOST_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &ibarrier);
     // b8. Do vkCmdCopy* from b to i
@@ -1336,13 +3237,263 @@ void ImageDynamicCpu2Gpu::finish_wcpu(VkOffset3D first, VkOffset3D last, ccharsp
     region.imageSubresource.layerCount = 1;
     vkCmdCopyBufferToImage(cmd, curr_buf.handle, curr_img.handle, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
     // b9. Synchronize to make known i is ready
+    if(curr_img.layout.has_mips())
+    {
+        rhi->generate_mips(curr_img, 0, 1, cmd);
+        return;
+    }
     ibarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
     ibarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
     ibarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
     ibarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &ibarrier);
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT|VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &ibarrier);
+}
+
+
+//-----------------------------------------------------------------------------
+
+void ImageGpu2Cpu::reset(Rhi *rhi_)
+{
+    destroy();
+    rhi = rhi_;
+    // cached memory is much faster to read from the CPU
+    mem_flags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT|VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+    if(vk_mem_type(mem_flags, ~UINT32_C(0)) == UINT32_C(0xff'ff'ff'ff))
+        mem_flags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT|VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    VkFenceCreateInfo fnfo = {};
+    fnfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    for(uint32_t idx : irange(num_entries))
+        fence_ids[idx] = rhi->make_fence(fnfo);
+}
+
+void ImageGpu2Cpu::destroy()
+{
+    if(!rhi)
+        return;
+    VkDevice v = rhi->m_device;
+    for(uint32_t idx : irange(num_entries))
+    {
+        if(ring.pending(idx))
+        {
+            VkFence fence = rhi->get_fence(fence_ids[idx]);
+            C4_CHECK_VK(vkWaitForFences(v, 1, &fence, VK_TRUE, UINT64_MAX));
+        }
+        if(buf_ids[idx])
+            rhi->destroy_buffer(buf_ids[idx]); // implicitly unmaps
+        rhi->destroy_fence(fence_ids[idx]);
+        buf_ids[idx] = {};
+        fence_ids[idx] = {};
+        bufmem[idx] = {};
+        readouts[idx] = {};
+    }
+    ring.clear();
+    rhi = nullptr;
 }
 
+uint32_t ImageGpu2Cpu::_start_request(uint32_t width, uint32_t height, VkFormat format)
+{
+    C4_CHECK(rhi);
+    const size_t num_bytes = (size_t)vk_num_bytes_per_pixel(format) * width * height;
+    const uint32_t entry = ring.start();
+    if(entry == num_entries)
+        return entry;
+    if(bufmem[entry].size() < num_bytes)
+    {
+        // the entry is not in flight, so its buffer can be replaced
+        VkBufferCreateInfo bnfo = {};
+        bnfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bnfo.size = num_bytes;
+        bnfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        bnfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        buf_ids[entry] = rhi->reset_buffer(buf_ids[entry], bnfo, mem_flags);
+        void* mapped = nullptr;
+        C4_CHECK_VK(vkMapMemory(rhi->m_device, rhi->get_buffer(buf_ids[entry]).mem, 0, num_bytes, 0, &mapped));
+        bufmem[entry] = {(char*)mapped, num_bytes};
+    }
+    VkFence fence = rhi->get_fence(fence_ids[entry]);
+    C4_CHECK_VK(vkResetFences(rhi->m_device, 1, &fence));
+    rhi->m_frame_fences.push_back(fence);
+    Readout &r = readouts[entry];
+    r.data = {bufmem[entry].data(), num_bytes};
+    r.width = width;
+    r.height = height;
+    r.format = format;
+    r.request = ring.requests[entry];
+    r.entry = entry;
+    return entry;
+}
+
+void ImageGpu2Cpu::_record_copy(VkCommandBuffer cmd, uint32_t entry, VkImage img, VkImageLayout layout,
+                                VkPipelineStageFlags stage, VkAccessFlags access,
+                                VkPipelineStageFlags next_stage, VkAccessFlags next_access)
+{
+    C4_ASSERT(entry < num_entries);
+    C4_ASSERT(ring.pending(entry));
+    Readout const& r = readouts[entry];
+    VkImageMemoryBarrier ibarrier = {};
+    ibarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    ibarrier.srcAccessMask = access;
+    ibarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    ibarrier.oldLayout = layout;
+    ibarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    ibarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    ibarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    ibarrier.image = img;
+    ibarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    ibarrier.subresourceRange.levelCount = 1;
+    ibarrier.subresourceRange.layerCount = 1;
+    vkCmdPipelineBarrier(cmd, stage, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &ibarrier);
+    VkBufferImageCopy region = {};
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.layerCount = 1;
+    region.imageExtent = {r.width, r.height, 1};
+    vkCmdCopyImageToBuffer(cmd, img, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, rhi->get_buffer(buf_ids[entry]).handle, 1, &region);
+    // return the image to its layout, and make the copy visible to the host
+    ibarrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    ibarrier.dstAccessMask = next_access;
+    ibarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    ibarrier.newLayout = layout;
+    VkBufferMemoryBarrier bbarrier = {};
+    bbarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    bbarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    bbarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    bbarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    bbarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    bbarrier.buffer = rhi->get_buffer(buf_ids[entry]).handle;
+    bbarrier.size = VK_WHOLE_SIZE;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, next_stage|VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &bbarrier, 1, &ibarrier);
+}
+
+bool ImageGpu2Cpu::request(Image const& img, VkImageLayout layout)
+{
+    VkCommandBuffer cmd = rhi->usr_cmd_buffer();
+    if(!request(img, layout, cmd))
+        return false;
+    rhi->mark_usr_cmd_buffer();
+    return true;
+}
+
+bool ImageGpu2Cpu::request(Image const& img, VkImageLayout layout, VkCommandBuffer cmd)
+{
+    C4_CHECK(img.layout.readback);
+    const uint32_t entry = _start_request(img.layout.width, img.layout.height, img.layout.format);
+    if(entry == num_entries)
+        return false;
+    // the previous and next users of the image are not known
+    _record_copy(cmd, entry, img.handle, layout,
+                 VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_ACCESS_MEMORY_WRITE_BIT,
+                 VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_ACCESS_MEMORY_READ_BIT|VK_ACCESS_MEMORY_WRITE_BIT);
+    return true;
+}
+
+bool ImageGpu2Cpu::request_swapchain(SwapchainState const& sc)
+{
+    // the copy is recorded against the image of this frame, which a
+    // rebuild would destroy before the frame is rendered
+    if(!(sc.usage & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) || sc.rebuilding)
+        return false;
+    const uint32_t entry = _start_request(sc.width, sc.height, sc.format);
+    if(entry == num_entries)
+        return false;
+    rhi->m_swapchain_readbacks.push_back({this, entry});
+    return true;
+}
+
+bool ImageGpu2Cpu::acquire(Readout *readout)
+{
+    if(!rhi)
+        return false;
+    // the copies complete in order, so only the oldest is checked
+    const uint32_t entry = ring.oldest_pending();
+    if(entry == num_entries)
+        return false;
+    VkResult err = vkGetFenceStatus(rhi->m_device, rhi->get_fence(fence_ids[entry]));
+    if(err == VK_NOT_READY)
+        return false;
+    C4_CHECK_VK(err);
+    if(!(mem_flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT))
+    {
+        VkMappedMemoryRange mmr = {};
+        mmr.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+        mmr.memory = rhi->get_buffer(buf_ids[entry]).mem;
+        mmr.offset = 0;
+        mmr.size = VK_WHOLE_SIZE;
+        C4_CHECK_VK(vkInvalidateMappedMemoryRanges(rhi->m_device, 1, &mmr));
+    }
+    ring.complete(entry);
+    *readout = readouts[entry];
+    return true;
+}
+
+void ImageGpu2Cpu::release(Readout const& readout)
+{
+    ring.release(readout.entry, readout.request);
+}
+
+
+
+//-----------------------------------------------------------------------------
+
+void ComputePass::reset(Rhi *rhi_, compute_pipeline_id pipeline_)
+{
+    destroy();
+    rhi = rhi_;
+    pipeline = pipeline_;
+    VkDescriptorSetLayout set_layout = rhi->get_compute_pipeline(pipeline).set_layout;
+    VkDescriptorSetAllocateInfo nfo = {};
+    nfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    nfo.descriptorPool = rhi->m_descriptor_pool;
+    nfo.descriptorSetCount = 1;
+    nfo.pSetLayouts = &set_layout;
+    C4_CHECK_VK(vkAllocateDescriptorSets(rhi->m_device, &nfo, &set));
+}
+
+void ComputePass::destroy()
+{
+    if(set != VK_NULL_HANDLE)
+    {
+        C4_CHECK_VK(vkFreeDescriptorSets(rhi->m_device, rhi->m_descriptor_pool, 1, &set));
+        set = VK_NULL_HANDLE;
+    }
+    pipeline = {};
+}
+
+void ComputePass::bind(c4::cspan<ComputeResource> resources)
+{
+    C4_CHECK(set != VK_NULL_HANDLE);
+    C4_CHECK(resources.size() <= 16);
+    VkWriteDescriptorSet writes[16] = {};
+    for(uint32_t i : irange((uint32_t)resources.size()))
+    {
+        ComputeResource const& r = resources[i];
+        writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].dstSet = set;
+        writes[i].dstBinding = i;
+        writes[i].descriptorCount = 1;
+        writes[i].descriptorType = r.type;
+        if(r.type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER || r.type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER)
+            writes[i].pBufferInfo = &r.buffer;
+        else
+            writes[i].pImageInfo = &r.image;
+    }
+    vkUpdateDescriptorSets(rhi->m_device, (uint32_t)resources.size(), writes, 0, nullptr);
+}
+
+void ComputePass::dispatch(VkCommandBuffer cmd, void const* push_constants, uint32_t width, uint32_t height, uint32_t depth)
+{
+    ComputePipeline const& p = rhi->get_compute_pipeline(pipeline);
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, p.handle);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, p.layout, 0, 1, &set, 0, nullptr);
+    if(p.push_constants_size)
+    {
+        C4_ASSERT(push_constants != nullptr);
+        vkCmdPushConstants(cmd, p.layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, p.push_constants_size, push_constants);
+    }
+    vkCmdDispatch(cmd,
+                  compute_num_groups(width, p.local_size[0]),
+                  compute_num_groups(height, p.local_size[1]),
+                  compute_num_groups(depth, p.local_size[2]));
+}
 
 } // namespace rhi
 } // namespace quickgui
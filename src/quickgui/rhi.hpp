@@ -3,6 +3,7 @@
 
 #include <cstdint>
 #include <cstddef>
+#include <cstring>
 #include <vector>
 #include <vulkan/vulkan.h>
 #include <c4/span.hpp>
@@ -34,6 +35,14 @@ void check_vk_result(VkResult err);
 
 uint32_t vk_num_bytes_per_pixel(VkFormat fmt);
 uint32_t vk_mem_type(VkMemoryPropertyFlags properties, uint32_t type_bits);
+/** whether images of this format and size can be created with linear
+ * tiling and sampled with linear filtering */
+bool vk_format_supports_linear_sampling(VkFormat fmt, uint32_t width, uint32_t height);
+/** whether images of this format can be sampled with linear filtering,
+ * with the optimal tiling */
+bool vk_format_supports_filtering(VkFormat fmt);
+/** the maximum number of layers of an image: maxImageArrayLayers */
+uint32_t vk_max_image_array_layers();
 
 void enable_vk_debug(bool yes);
 
@@ -43,6 +52,12 @@ void debug_marker_mark(VkCommandBuffer cmd, const char *name, fcolor const& C4_R
 void debug_marker_region_begin(VkCommandBuffer cmd, const char *name, fcolor const& C4_RESTRICT color);
 void debug_marker_region_end(VkCommandBuffer cmd);
 
+struct Image;
+/** record a pipeline barrier over all the levels and layers of the image */
+void image_barrier(VkCommandBuffer cmd, Image const& img,
+                   VkImageLayout from, VkPipelineStageFlags src_stage, VkAccessFlags src_access,
+                   VkImageLayout to, VkPipelineStageFlags dst_stage, VkAccessFlags dst_access);
+
 inline void debug_marker_mark(VkCommandBuffer cmd, const char *name, uint32_t color=UINT32_C(0x7f'7f'7f'ff))
 {
     debug_marker_mark(cmd, name, fcolor(color));
@@ -81,6 +96,10 @@ inline void debug_marker_set_name(VkDevice device, vk_resource_type_ handle, con
     {
         debug_marker_set_name(device, (uint64_t)handle, VK_DEBUG_REPORT_OBJECT_TYPE_SAMPLER_EXT, name);
     }
+    else if constexpr(std::is_same_v<restype, VkPipeline>)
+    {
+        debug_marker_set_name(device, (uint64_t)handle, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, name);
+    }
     else
     {
         C4_STATIC_ERROR(restype, "unknown resource type");
@@ -88,6 +107,64 @@ inline void debug_marker_set_name(VkDevice device, vk_resource_type_ handle, con
 }
 
 
+//-----------------------------------------------------------------------------
+
+/** GPU time spent in a debug marker region. When the profiler is
+ * enabled, debug_marker_region_begin() and debug_marker_region_end()
+ * also write timestamp queries. Each frame in flight has its own
+ * slot in the query pool. A slot is read back only once its frame's
+ * fence has signaled, so reading the results never stalls. */
+struct GpuProfileRegion
+{
+    enum : uint32_t { max_name_size = 32 };
+    char     name[max_name_size];
+    uint32_t depth; ///< nesting level of the region
+    double   ms;
+};
+
+/** has no effect when the queue does not support timestamps. Can be
+ * called at any time: it applies from the next frame that starts */
+void gpu_profiler_enable(bool yes);
+bool gpu_profiler_enabled();
+bool gpu_profiler_supported();
+/** the regions of the most recent frame whose results are available,
+ * in the order in which they were begun. Regions recorded outside of
+ * the frame command buffers are not measured. */
+c4::cspan<GpuProfileRegion> gpu_profiler_regions();
+
+
+//-----------------------------------------------------------------------------
+
+/** host memory allocated by the vulkan driver through the counting
+ * VkAllocationCallbacks. See host_alloc_init(). */
+struct HostAllocStats
+{
+    uint64_t num_allocs;     ///< including reallocations
+    uint64_t num_frees;
+    uint64_t bytes;          ///< currently allocated
+    uint64_t peak_bytes;
+    float    allocs_per_sec; ///< measured over the last second or so
+};
+
+/** set up the counting VkAllocationCallbacks. They must be in place
+ * before creating the instance, and be used for every vulkan object
+ * (as g_Allocator and Rhi::m_allocator). When transient_arena_size is
+ * not zero, the allocations with VK_SYSTEM_ALLOCATION_SCOPE_COMMAND,
+ * which live only for the duration of a vulkan call, are served from
+ * a bump arena of that size, which is rewound once all of them are
+ * freed; those not fitting in the arena, or aligned to more than 64
+ * bytes, go to the heap. */
+VkAllocationCallbacks* host_alloc_init(size_t transient_arena_size);
+/** call after destroying the instance */
+void host_alloc_terminate();
+bool host_alloc_enabled();
+/** stats of one allocation scope, or of all the scopes with
+ * VK_SYSTEM_ALLOCATION_SCOPE_MAX_ENUM */
+HostAllocStats host_alloc_stats(VkSystemAllocationScope scope);
+/** number of transient allocations served from the arena */
+uint64_t host_alloc_arena_hits();
+
+
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
@@ -117,6 +194,8 @@ struct SamplerBuilder
     C4_ALWAYS_INLINE SamplerBuilder &address_v(VkSamplerAddressMode mode) noexcept { info.addressModeV = mode; return *this; }
     C4_ALWAYS_INLINE SamplerBuilder &address_w(VkSamplerAddressMode mode) noexcept { info.addressModeW = mode; return *this; }
     C4_ALWAYS_INLINE SamplerBuilder &address(VkSamplerAddressMode mode) noexcept { info.addressModeU = info.addressModeV = info.addressModeW = mode; return *this; }
+    C4_ALWAYS_INLINE SamplerBuilder &lod(float min_lod, float max_lod) noexcept { info.minLod = min_lod; info.maxLod = max_lod; return *this; }
+    C4_ALWAYS_INLINE SamplerBuilder &lod_bias(float bias) noexcept { info.mipLodBias = bias; return *this; }
 };
 
 
@@ -154,7 +233,11 @@ struct ImageLayout
     uint32_t width = {};
     uint32_t height = {};
     uint32_t depth = 1; // for texture arrays
+    uint32_t mip_levels = 1;
     bool     force_tex_array = true;
+    bool     storage = false; ///< whether compute kernels can write to the image
+    bool     readback = false; ///< whether the image can be copied to the CPU
+    bool     linear = false; ///< linear tiling, so that the host can write the texels directly
 
     void clear() { memset(this, 0, sizeof(ImageLayout)); }
 
@@ -167,6 +250,23 @@ struct ImageLayout
     VkImageViewType view_type() const { return is_2d_array() ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D; }
     VkExtent3D extent() const { VkExtent3D xt; xt.width = width; xt.height = height; xt.depth = depth; return xt; }
 
+    bool has_mips() const { return mip_levels > 1; }
+    /** the number of levels of the full mip chain for the given size */
+    static uint32_t num_mips(uint32_t w, uint32_t h)
+    {
+        uint32_t n = 1;
+        for(uint32_t dim = w > h ? w : h; dim > 1; dim >>= 1)
+            ++n;
+        return n;
+    }
+    /** set the full mip chain for this layout */
+    ImageLayout& with_mips() { mip_levels = num_mips(width, height); return *this; }
+    /** allow writes from compute kernels. Storage images must not
+     * use an srgb format. */
+    ImageLayout& with_storage() { storage = true; return *this; }
+    /** allow copying the image back to the CPU, see ImageGpu2Cpu */
+    ImageLayout& with_readback() { readback = true; return *this; }
+
     static ImageLayout make_2d(VkFormat fmt, uint32_t w, uint32_t h)
     {
         ImageLayout tex;
@@ -197,10 +297,21 @@ struct ImageLayout
         tex.width = nfo.extent.width;
         tex.height = nfo.extent.height;
         tex.depth = nfo.arrayLayers > 1 ? nfo.arrayLayers : nfo.extent.depth;
+        tex.mip_levels = nfo.mipLevels;
         tex.force_tex_array = nfo.arrayLayers > 1;
+        tex.storage = (nfo.usage & VK_IMAGE_USAGE_STORAGE_BIT) != 0;
+        tex.readback = (nfo.usage & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) != 0;
+        tex.linear = nfo.tiling == VK_IMAGE_TILING_LINEAR;
         return tex;
     }
 
+    /** the layout of the image while it is sampled. The host can
+     * only write to linear images in the GENERAL layout. */
+    VkImageLayout sampled_layout() const
+    {
+        return linear ? VK_IMAGE_LAYOUT_GENERAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    }
+
     VkImageCreateInfo to_vk() const
     {
         VkImageCreateInfo nfo = {};
@@ -210,13 +321,25 @@ struct ImageLayout
         nfo.extent.width = width;
         nfo.extent.height = height;
         nfo.extent.depth = 1;
-        nfo.mipLevels = 1;
+        nfo.mipLevels = mip_levels ? mip_levels : 1;
         nfo.arrayLayers = depth;
         nfo.samples = VK_SAMPLE_COUNT_1_BIT;
         nfo.tiling = VK_IMAGE_TILING_OPTIMAL;
         nfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+        // the mips are blitted from the previous level, and the
+        // readbacks copy the image to a buffer
+        if(mip_levels > 1 || readback)
+            nfo.usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        if(storage)
+            nfo.usage |= VK_IMAGE_USAGE_STORAGE_BIT;
         nfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
         nfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        if(linear)
+        {
+            nfo.tiling = VK_IMAGE_TILING_LINEAR;
+            nfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT;
+            nfo.initialLayout = VK_IMAGE_LAYOUT_PREINITIALIZED;
+        }
         return nfo;
     }
 };
@@ -229,6 +352,7 @@ struct Image
 {
     VkImage handle = VK_NULL_HANDLE;
     VkDeviceMemory mem = VK_NULL_HANDLE;
+    VkDeviceSize mem_size = {}; ///< the size of the allocation
     ImageLayout layout = {};
     void create(VkImageCreateInfo const& C4_RESTRICT nfo, uint32_t mem_type, VkDevice v, VkAllocationCallbacks const* a);
     void create(ImageLayout const& C4_RESTRICT layout, uint32_t mem_type, VkDevice dev, VkAllocationCallbacks const* alloc);
@@ -248,7 +372,11 @@ struct Buffer
     VkDeviceMemory mem = VK_NULL_HANDLE;
     VkDeviceSize size = {};
     VkDeviceSize alignment = {};
+    VkDeviceSize mem_size = {}; ///< the size of the allocation. 0 for imported host memory
     void create(VkBufferCreateInfo const& nfo, uint32_t mem_type, VkDevice dev, VkAllocationCallbacks const* alloc);
+    /** create a transfer source buffer over host memory, with
+     * VK_EXT_external_memory_host. The memory must outlive the buffer. */
+    void import_host(void *mem, VkDeviceSize size, uint32_t mem_type_bits, VkDevice dev, VkAllocationCallbacks const* alloc);
     void destroy(VkDevice v, VkAllocationCallbacks const* a);
     void destroy_mem(VkDevice v, VkAllocationCallbacks const* a);
     inline operator VkBuffer () const { return handle; }
@@ -256,6 +384,34 @@ struct Buffer
 };
 
 
+/** the SPIR-V code of a compute kernel, and the shape of its
+ * interface: all the resources are in set 0, and binding i has
+ * type bindings[i]. */
+struct ComputeShader
+{
+    c4::cspan<uint32_t>         code = {};
+    c4::cspan<VkDescriptorType> bindings = {};
+    uint32_t                    push_constants_size = 0;
+    uint32_t                    local_size_x = 16; ///< must match the shader
+    uint32_t                    local_size_y = 16; ///< must match the shader
+    uint32_t                    local_size_z = 1;  ///< must match the shader
+};
+
+struct ComputePipeline
+{
+    VkShaderModule        module = VK_NULL_HANDLE;
+    VkDescriptorSetLayout set_layout = VK_NULL_HANDLE;
+    VkPipelineLayout      layout = VK_NULL_HANDLE;
+    VkPipeline            handle = VK_NULL_HANDLE;
+    uint32_t              push_constants_size = 0;
+    uint32_t              local_size[3] = {1, 1, 1};
+    void create(ComputeShader const& shader, VkPipelineCache cache, VkDevice dev, VkAllocationCallbacks const* alloc);
+    void destroy(VkDevice v, VkAllocationCallbacks const* a);
+    inline operator VkPipeline () const { return handle; }
+    inline operator bool () const { return handle != VK_NULL_HANDLE; }
+};
+
+
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
@@ -263,37 +419,123 @@ struct Buffer
 template<class HandleType>
 struct HandleCollection
 {
-    enum : size_t { none = (size_t)-1 };
-    /** an opaque type-safe id */
+    enum : uint32_t { none = (uint32_t)-1 };
+    /** an opaque type-safe id: the index of a slot, plus the generation
+     * of the slot when the id was handed out. Released slots are
+     * reused, and their generation is bumped, so that stale ids can
+     * be detected. */
     class id_type
     {
         friend struct HandleCollection;
     protected:
-        size_t _id = none;
+        uint32_t _id = none;
+        uint32_t _gen = 0;
     public:
         inline operator bool () const { return _id != none; }
+        inline bool operator== (id_type that) const { return _id == that._id && _gen == that._gen; }
+        inline bool operator!= (id_type that) const { return _id != that._id || _gen != that._gen; }
     };
 
 public:
 
     using handle_type = HandleType;
-    std::vector<HandleType> handles;
+    std::vector<HandleType> handles;     ///< indexed by slot. released slots have a null handle.
+    std::vector<uint32_t>   generations; ///< indexed by slot
+    std::vector<uint32_t>   live_pos;    ///< indexed by slot: position in live_slots, or none if released
+    std::vector<uint32_t>   live_slots;  ///< dense list of the slots in use
+    std::vector<uint32_t>   free_slots;  ///< released slots, ready for reuse
 
     template<class ...CtorArgs>
-    id_type add_handle(CtorArgs ...args)
+    id_type add_handle(CtorArgs&& ...args)
     {
         id_type id;
-        id._id = handles.size();
-        handles.emplace_back(std::forward<CtorArgs>(args)...);
+        if(!free_slots.empty())
+        {
+            id._id = free_slots.back();
+            free_slots.pop_back();
+            handles[id._id] = HandleType(std::forward<CtorArgs>(args)...);
+        }
+        else
+        {
+            id._id = (uint32_t)handles.size();
+            handles.emplace_back(std::forward<CtorArgs>(args)...);
+            generations.push_back(0);
+            live_pos.push_back(none);
+        }
+        id._gen = generations[id._id];
+        live_pos[id._id] = (uint32_t)live_slots.size();
+        live_slots.push_back(id._id);
         return id;
     }
 
+    /** the id to reset: a new handle for a null id. Otherwise the id
+     * must be valid: a stale id is an error, rather than silently
+     * becoming a new handle. */
+    id_type reset_handle(id_type id)
+    {
+        if(!id)
+            return add_handle();
+        C4_CHECK_MSG(is_valid(id), "stale id: slot=%u gen=%u", id._id, id._gen);
+        return id;
+    }
+
+    /** release the slot of this id, making it available for reuse.
+     * The handle must have been destroyed already. A stale id, eg of
+     * a double destroy, is an error: releasing its slot again would
+     * hand out the slot twice. */
+    void remove_handle(id_type id)
+    {
+        C4_CHECK_MSG(is_valid(id), "stale id: slot=%u gen=%u", id._id, id._gen);
+        C4_ASSERT(!handles[id._id]);
+        ++generations[id._id];
+        // swap-remove from the dense list
+        const uint32_t pos = live_pos[id._id];
+        const uint32_t moved = live_slots.back();
+        live_slots[pos] = moved;
+        live_pos[moved] = pos;
+        live_slots.pop_back();
+        live_pos[id._id] = none;
+        free_slots.push_back(id._id);
+    }
+
+    void clear_handles()
+    {
+        handles.clear();
+        generations.clear();
+        live_pos.clear();
+        live_slots.clear();
+        free_slots.clear();
+    }
+
+    /** true if the id was handed out by this collection and its slot
+     * was not released since */
+    bool is_valid(id_type id) const
+    {
+        return id._id < handles.size()
+            && generations[id._id] == id._gen
+            && live_pos[id._id] != none;
+    }
+
+    /** the number of handles in use */
+    size_t num_handles() const { return live_slots.size(); }
+
+    /** iterate over the handles in use, in dense order */
+    template<class Fn>
+    void for_each_handle(Fn &&fn)
+    {
+        for(uint32_t slot : live_slots)
+            std::forward<Fn>(fn)(handles[slot]);
+    }
+
     //! short-lived references! referencial integrity is not guaranteed,
     //! as an insertion may change the reference.
-    HandleType const& get_handle(id_type id) const { C4_ASSERT(id); return handles[id._id]; }
+    HandleType const& get_handle(id_type id) const { C4_ASSERT(id); C4_ASSERT(is_valid(id)); return handles[id._id]; }
     //! short-lived references! referencial integrity is not guaranteed,
     //! as an insertion may change the reference.
-    HandleType & get_handle(id_type id) { C4_ASSERT(id); return handles[id._id]; }
+    HandleType & get_handle(id_type id) { C4_ASSERT(id); C4_ASSERT(is_valid(id)); return handles[id._id]; }
+    //! like get_handle(), but checking the id also in release builds,
+    //! eg before destroying the handle
+    HandleType & get_handle_checked(id_type id) { C4_CHECK_MSG(is_valid(id), "stale id: slot=%u gen=%u", id._id, id._gen); return handles[id._id]; }
 
     virtual ~HandleCollection()
     {
@@ -315,6 +557,7 @@ using fence_id = FenceCollection::id_type;
 struct BufferCollection : public HandleCollection<Buffer>
 {
     id_type reset(id_type id, VkBufferCreateInfo const& C4_RESTRICT info, uint32_t mem_bits, VkDevice dev, VkAllocationCallbacks const* alloc);
+    id_type import_host(void *mem, VkDeviceSize size, uint32_t mem_type_bits, VkDevice dev, VkAllocationCallbacks const* alloc);
     void destroy(id_type id, VkDevice dev, VkAllocationCallbacks const* alloc);
     void destroy_all(VkDevice dev, VkAllocationCallbacks const* alloc);
 };
@@ -332,7 +575,11 @@ using image_id = ImageCollection::id_type;
 
 struct ImageViewCollection : public HandleCollection<VkImageView>
 {
+    /** create a view over all the layers of the image: 2D if the image
+     * has a single layer, 2D_ARRAY otherwise */
     id_type reset(id_type id, Image const& img, VkDevice dev, VkAllocationCallbacks const* alloc);
+    /** create a 2D view over a single layer of the image */
+    id_type reset(id_type id, Image const& img, uint32_t layer, VkDevice dev, VkAllocationCallbacks const* alloc);
     void destroy(id_type id, VkDevice dev, VkAllocationCallbacks const* alloc);
     void destroy_all(VkDevice dev, VkAllocationCallbacks const* alloc);
 };
@@ -348,9 +595,36 @@ struct SamplerCollection : public HandleCollection<VkSampler>
 using sampler_id = SamplerCollection::id_type;
 
 
+struct ComputePipelineCollection : public HandleCollection<ComputePipeline>
+{
+    id_type reset(id_type id, ComputeShader const& shader, VkPipelineCache cache, VkDevice dev, VkAllocationCallbacks const* alloc);
+    void destroy(id_type id, VkDevice dev, VkAllocationCallbacks const* alloc);
+    void destroy_all(VkDevice dev, VkAllocationCallbacks const* alloc);
+};
+using compute_pipeline_id = ComputePipelineCollection::id_type;
+
+
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
+
+/** one destination of a batched upload. The source data must be
+ * tightly packed, and contain the layers [first_layer,
+ * first_layer+num_layers) one after the other. */
+struct UploadRequest
+{
+    image_id   img_id = {};
+    ccharspan  data = {};
+    uint32_t   first_layer = 0;
+    uint32_t   num_layers = 0; ///< 0 means all the layers from first_layer
+    /** when the extent is not zero, only this rect of the layers is
+     * written, and the other texels are kept, eg for a texture atlas.
+     * The image must then be in its sampled layout, and must not have
+     * mips. */
+    VkOffset2D offset = {};
+    VkExtent2D extent = {};
+};
+
 struct UploadBuffer
 {
     Buffer m_buf = {};
@@ -368,6 +642,73 @@ struct UploadBuffer
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
 
+/** device memory of one heap */
+struct MemoryHeapUsage
+{
+    VkDeviceSize      size;
+    VkDeviceSize      usage;  ///< by this process. Only with VK_EXT_memory_budget
+    VkDeviceSize      budget; ///< available to this process. The heap size without VK_EXT_memory_budget
+    VkMemoryHeapFlags flags;
+};
+
+/** device memory in use, updated once per frame by
+ * Rhi::update_memory_usage() */
+struct MemoryUsage
+{
+    MemoryHeapUsage heaps[VK_MAX_MEMORY_HEAPS];
+    uint32_t        num_heaps;
+    bool            has_budget; ///< whether VK_EXT_memory_budget is available
+    // our own accounting, by collection
+    VkDeviceSize    images;
+    VkDeviceSize    buffers;
+    VkDeviceSize    upload_buffer;
+    VkDeviceSize    imgui_buffers; ///< vertex and index buffers
+    VkDeviceSize    total() const { return images + buffers + upload_buffer + imgui_buffers; }
+};
+
+/** called when the memory usage goes over the soft limit (or over a
+ * heap budget), with the number of bytes that should be freed.
+ *
+ * The handlers run at the start of a frame, while the previous frames
+ * may still be sampling the resources to evict. A handler must stop
+ * using them right away, but destroy them only once those frames are
+ * done: eg add a fence to Rhi::m_frame_fences and destroy them when it
+ * is signaled. The memory is then freed a few frames later. */
+using MemoryEvictionFn = void (*)(VkDeviceSize excess, void *data);
+
+
+/** the swapchain images of the current frame, to read them back with
+ * ImageGpu2Cpu::request_swapchain() */
+struct SwapchainState
+{
+    uint32_t          width;
+    uint32_t          height;
+    VkFormat          format;
+    VkImageUsageFlags usage;
+    bool              rebuilding; ///< the images are about to be recreated
+};
+
+struct ImageGpu2Cpu;
+/** a copy of the swapchain image, to be recorded after the gui is rendered */
+struct SwapchainReadback
+{
+    ImageGpu2Cpu *readback;
+    uint32_t      entry;
+};
+
+/** what is needed to submit and present a frame, captured when the
+ * frame ends, so that the submission can be done in a render thread
+ * while the next frame is started */
+struct FrameSubmit
+{
+    uint32_t                       frame_index = 0;
+    uint32_t                       profiler_frame = 0; ///< the gpu profiler slot, finished when rendering
+    uint32_t                       semaphore_index = 0;
+    std::vector<VkFence>           frame_fences;
+    std::vector<SwapchainReadback> swapchain_readbacks;
+};
+
+
 /** Render Hardware Interface */
 struct Rhi
 {
@@ -379,11 +720,62 @@ struct Rhi
     SamplerCollection             m_samplers;
     ImageCollection               m_images;
     BufferCollection              m_buffers;
+    ComputePipelineCollection     m_compute_pipelines;
     VkDeviceSize                  m_non_coherent_atom_size;
+    VkPipelineCache               m_pipeline_cache;
+    VkDescriptorPool              m_descriptor_pool; ///< for the compute passes
 
-    UploadBuffer                  m_upload_buffer;
+    /** a staging buffer of the frames in flight, with the fence
+     * signaled once the frame that last copied from it is done */
+    struct UploadSlot
+    {
+        UploadBuffer buf;
+        fence_id     fence;
+        bool         pending;
+    };
+    /** a frame uses one slot, and the slots which are still read by
+     * the GPU are not reused, so a frame never overwrites (nor frees,
+     * when growing) the staging memory of a frame in flight */
+    std::vector<UploadSlot>       m_upload_slots;
+    uint32_t                      m_upload_slot; ///< the slot of the current frame
     bool                          m_upload_buffer_in_use;
 
+    /** whether the host writes to linear images are about as fast as
+     * to a staging buffer. -1 until measured. */
+    int8_t                        m_linear_writes;
+    bool                          m_linear_device_local; ///< whether linear images get device-local memory
+
+    /** host memory imported as buffers (VK_EXT_external_memory_host),
+     * with the fence of its last upload */
+    struct HostImport
+    {
+        char const* mem;
+        size_t      size;
+        buffer_id   buf;
+        fence_id    fence;
+        bool        pending;
+        bool        retired; ///< released while its upload is in the current frame
+    };
+    VkDeviceSize                  m_host_import_alignment; ///< 0 when the import is not available
+    PFN_vkGetMemoryHostPointerPropertiesEXT m_get_host_pointer_props;
+    std::vector<HostImport>       m_host_imports;
+
+    bool                          m_has_memory_budget; ///< VK_EXT_memory_budget is enabled
+    MemoryUsage                   m_memory_usage;
+    /** the eviction handlers are called when m_memory_usage.total()
+     * goes over this. 0 for no limit */
+    VkDeviceSize                  m_memory_soft_limit;
+    struct MemoryEvictionHandler
+    {
+        MemoryEvictionFn fn;
+        void            *data;
+    };
+    std::vector<MemoryEvictionHandler> m_memory_eviction_handlers;
+
+    /** fences to signal once the current frame is done */
+    std::vector<VkFence>           m_frame_fences;
+    std::vector<SwapchainReadback> m_swapchain_readbacks;
+
 public:
 
     Rhi();
@@ -393,13 +785,79 @@ public:
 public:
 
     VkDeviceSize required_buffer_size(VkDeviceSize wanted, VkDeviceSize texelSize) const;
+    /** acquire the staging buffer of the current frame, with room
+     * for @p upload_size bytes. Once per frame. */
     size_t use_upload_buffer_with(size_t upload_size);
+    UploadBuffer& _frame_upload_buffer() { return m_upload_slots[m_upload_slot].buf; }
     void   upload_image(image_id id, ImageLayout const& layout, ccharspan tex_data, VkCommandBuffer cmdbuf, UploadBuffer *upload_buffer, VkDeviceSize upload_buffer_offset);
     void   upload_image(image_id id, ImageLayout const& layout, ccharspan tex_data, VkCommandBuffer cmdbuf);
+    /** upload several images (or layers of images) at once: all the
+     * sources are packed into the staging buffer with a single map,
+     * and the command buffer gets one barrier batch, one copy per
+     * request and one final barrier batch. The requests may mix whole
+     * layers and sub-rects of the same image, and may overlap: they
+     * are written in order. */
+    void   upload_images(c4::span<const UploadRequest> reqs, VkCommandBuffer cmdbuf, UploadBuffer *upload_buffer);
+    /** using the staging buffer of the current frame, see
+     * use_upload_buffer_with() */
+    void   upload_images(c4::span<const UploadRequest> reqs, VkCommandBuffer cmdbuf);
+    /** fill levels [1,mip_levels) of the given layers by successively
+     * blitting from the previous level. Expects all the levels in
+     * TRANSFER_DST_OPTIMAL; leaves them in SHADER_READ_ONLY_OPTIMAL. */
+    void   generate_mips(Image const& img, uint32_t first_layer, uint32_t num_layers, VkCommandBuffer cmdbuf);
+
+    /** upload an image straight from host memory, eg a frame from a
+     * decoder pool. When VK_EXT_external_memory_host is available and
+     * the data address and size are multiples of
+     * m_host_import_alignment (usually the page size), the data is
+     * imported as a buffer (once, and then reused), and the GPU
+     * copies from it without the staging memcpy. The memory must then
+     * stay unchanged while host_memory_in_use(), and
+     * release_host_memory() must be called before freeing it.
+     * Otherwise this falls back to the staging buffer, and the memory
+     * can be reused right away. */
+    void   upload_image_from_host(image_id id, ccharspan data, VkCommandBuffer cmdbuf);
+    bool   can_import_host_memory(void const* mem, size_t size) const;
+    /** whether the GPU may still read an upload from this memory */
+    bool   host_memory_in_use(void const* mem);
+    /** drop the import containing this memory, waiting for its last
+     * upload. When that upload is in the current frame, the import is
+     * dropped once the frame is done, and the memory must stay valid
+     * while host_memory_in_use(). */
+    void   release_host_memory(void const* mem);
+    /** drop the released imports whose last upload is done. Called
+     * at the start of each frame. */
+    void   release_retired_host_imports();
+    void   _upload_image_from(image_id id, VkBuffer src, VkDeviceSize src_offset, VkCommandBuffer cmdbuf);
+    HostImport* _find_host_import(void const* mem, bool retired=false);
+    void   _destroy_host_import(HostImport *hi);
+    bool   _host_import_submitted(HostImport const& hi) const;
+
+    /** query the heap budgets and sum the memory of the collections.
+     * Then call the eviction handlers if the usage is over the soft
+     * limit, or over the budget of a device-local heap. Called at the
+     * start of each frame. */
+    void   update_memory_usage();
+    MemoryUsage const& memory_usage() const { return m_memory_usage; }
+    void   set_memory_soft_limit(VkDeviceSize limit) { m_memory_soft_limit = limit; }
+    /** eg for a texture cache to drop its least recently used
+     * entries. See MemoryEvictionFn for when they can be destroyed. */
+    void   add_memory_eviction_handler(MemoryEvictionFn fn, void *data);
+    void   remove_memory_eviction_handler(MemoryEvictionFn fn, void *data);
 
     // HACK
     VkCommandBuffer usr_cmd_buffer();
     void            mark_usr_cmd_buffer();
+    /** whether a fence added to the current frame was submitted,
+     * ie it can be waited on */
+    bool            fence_submitted(VkFence fence) const;
+
+    /** whether host-written linear images of this size should be
+     * preferred over staging copies. The first call runs a short
+     * benchmark of the host writes to both kinds of memory, and the
+     * linear images are preferred only when they are written faster
+     * than the staging buffers. */
+    bool prefers_linear_writes(size_t num_bytes);
 
 public:
 
@@ -422,17 +880,29 @@ public:
     void          set_name  (Buffer const& buf, const char *name) { debug_marker_set_name(m_device, buf.handle, name); }
 
     // images
-    [[nodiscard]] image_id make_image(VkImageCreateInfo const& C4_RESTRICT nfo, uint32_t mem_bits=VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) { return m_images.reset({}, nfo, mem_bits, m_device, m_allocator); }
-    [[nodiscard]] image_id reset_image(image_id id, VkImageCreateInfo const& C4_RESTRICT nfo, uint32_t mem_bits=VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) { return m_images.reset(id, nfo, mem_bits, m_device, m_allocator); }
+    /** the images with mips must have a format that supports blit,
+     * see with_mips() */
+    [[nodiscard]] image_id make_image(VkImageCreateInfo const& C4_RESTRICT nfo, uint32_t mem_bits=VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) { return reset_image({}, nfo, mem_bits); }
+    [[nodiscard]] image_id reset_image(image_id id, VkImageCreateInfo const& C4_RESTRICT nfo, uint32_t mem_bits=VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    /** whether images of this format can be used as source and
+     * destination of vkCmdBlitImage(), as required to generate mips.
+     * @p linear is set to whether the blit can use linear filtering. */
+    bool format_supports_blit(VkFormat fmt, bool *linear=nullptr) const;
+    /** add the mips to the layout if its format supports them.
+     * @return false, logging it, if the format does not support blit */
+    bool with_mips(ImageLayout *layout) const;
     void         destroy_image(image_id id) { return m_images.destroy(id, m_device, m_allocator); }
     Image      & get_image(image_id id)        { return m_images.get_handle(id); }
     Image const& get_image(image_id id) const  { return m_images.get_handle(id); }
     void         set_name (image_id id     , const char *name) { debug_marker_set_name(m_device, get_image(id).handle, name); }
     void         set_name (Image const& img, const char *name) { debug_marker_set_name(m_device, img.handle, name); }
 
-    // image views
+    // image views: of all the layers with the view type of the layout,
+    // or of a single layer as a 2D view, eg for sampling with sampler2D
     [[nodiscard]] image_view_id make_image_view(Image const& img) { return m_image_views.reset({}, img, m_device, m_allocator); }
     [[nodiscard]] image_view_id reset_image_view(image_view_id id, Image const& img) { return m_image_views.reset(id, img, m_device, m_allocator); }
+    [[nodiscard]] image_view_id make_image_view(Image const& img, uint32_t layer) { return m_image_views.reset({}, img, layer, m_device, m_allocator); }
+    [[nodiscard]] image_view_id reset_image_view(image_view_id id, Image const& img, uint32_t layer) { return m_image_views.reset(id, img, layer, m_device, m_allocator); }
     void               destroy_image_view(image_view_id id) { return m_image_views.destroy(id, m_device, m_allocator); }
     VkImageView      & get_image_view(image_view_id id)       { return m_image_views.get_handle(id); }
     VkImageView const& get_image_view(image_view_id id) const { return m_image_views.get_handle(id); }
@@ -449,6 +919,95 @@ public:
     void             set_name   (sampler_id id       , const char *name) { debug_marker_set_name(m_device, get_sampler(id), name); }
     void             set_name   (VkSampler const& smp, const char *name) { debug_marker_set_name(m_device, smp, name); }
 
+    // compute pipelines
+    [[nodiscard]] compute_pipeline_id make_compute_pipeline(ComputeShader const& shader) { return m_compute_pipelines.reset({}, shader, m_pipeline_cache, m_device, m_allocator); }
+    [[nodiscard]] compute_pipeline_id reset_compute_pipeline(compute_pipeline_id id, ComputeShader const& shader) { return m_compute_pipelines.reset(id, shader, m_pipeline_cache, m_device, m_allocator); }
+    void                   destroy_compute_pipeline(compute_pipeline_id id) { return m_compute_pipelines.destroy(id, m_device, m_allocator); }
+    ComputePipeline      & get_compute_pipeline(compute_pipeline_id id)       { return m_compute_pipelines.get_handle(id); }
+    ComputePipeline const& get_compute_pipeline(compute_pipeline_id id) const { return m_compute_pipelines.get_handle(id); }
+    void                   set_name(compute_pipeline_id id, const char *name) { debug_marker_set_name(m_device, get_compute_pipeline(id).handle, name); }
+
+};
+
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+/** the number of workgroups of @p local_size invocations needed to
+ * cover @p num_invocations; the excess invocations must be discarded
+ * by the kernel */
+C4_CONST inline uint32_t compute_num_groups(uint32_t num_invocations, uint32_t local_size)
+{
+    C4_ASSERT(local_size > 0);
+    return (num_invocations + local_size - 1u) / local_size;
+}
+
+
+/** one resource bound to a compute kernel */
+struct ComputeResource
+{
+    VkDescriptorType       type = {};
+    VkDescriptorImageInfo  image = {};
+    VkDescriptorBufferInfo buffer = {};
+
+    /** an image written (or read) by the kernel. It must be in the
+     * GENERAL layout during the dispatch. */
+    static ComputeResource storage_image(VkImageView view)
+    {
+        ComputeResource r;
+        r.type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        r.image.imageView = view;
+        r.image.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+        return r;
+    }
+    /** an image sampled by the kernel, in SHADER_READ_ONLY_OPTIMAL */
+    static ComputeResource sampled_image(VkImageView view, VkSampler sampler)
+    {
+        ComputeResource r;
+        r.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        r.image.sampler = sampler;
+        r.image.imageView = view;
+        r.image.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        return r;
+    }
+    /** a buffer created with VK_BUFFER_USAGE_STORAGE_BUFFER_BIT */
+    static ComputeResource storage_buffer(VkBuffer buf, VkDeviceSize offset=0, VkDeviceSize range=VK_WHOLE_SIZE)
+    {
+        ComputeResource r;
+        r.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        r.buffer.buffer = buf;
+        r.buffer.offset = offset;
+        r.buffer.range = range;
+        return r;
+    }
+};
+
+
+/** a compute pipeline together with the descriptor set of its
+ * resources. The resources cannot be rebound while a dispatch is
+ * pending on the GPU, so use one pass per frame in flight. */
+struct ComputePass
+{
+    Rhi                *rhi = {};
+    compute_pipeline_id pipeline = {};
+    VkDescriptorSet     set = VK_NULL_HANDLE;
+
+    void reset(Rhi *rhi, compute_pipeline_id pipeline);
+    void destroy();
+    /** write the resources, in binding order */
+    void bind(c4::cspan<ComputeResource> resources);
+    /** dispatch enough workgroups to cover the given number of
+     * invocations */
+    void dispatch(VkCommandBuffer cmd, void const* push_constants, uint32_t width, uint32_t height, uint32_t depth=1);
+    /** dispatch with a params struct having width and height members,
+     * and pushed as the constants of the kernel */
+    template<class Params>
+    void dispatch(VkCommandBuffer cmd, Params const& params)
+    {
+        C4_ASSERT(sizeof(Params) == rhi->get_compute_pipeline(pipeline).push_constants_size);
+        dispatch(cmd, &params, params.width, params.height);
+    }
 };
 
 
@@ -457,32 +1016,73 @@ public:
 //-----------------------------------------------------------------------------
 
 /** an image that is frequently updated from the CPU
+ *
+ * The pixels are either written to a staging buffer and then copied
+ * to the image, or (in linear mode) written straight into the mapped
+ * memory of a linear image. The linear mode saves the copy and its
+ * barriers. There is one entry for the CPU writes, one for the display
+ * and one for the previous display, which may still be sampled by the
+ * frames in flight. The fence of each linear image is added to the
+ * last frame which may sample it, and a write waits only on that
+ * fence, which is usually signaled already.
+ *
+ * In raw mode (see reset_raw()), the buffer holds the pixels in their
+ * source encoding, eg yuv or rgb8, and a compute kernel converts them
+ * into the image instead of the copy.
  *
  * @see https://stackoverflow.com/questions/40574668/how-to-update-texture-for-every-frame-in-vulkan/40575629
  */
 struct ImageDynamicCpu2Gpu
 {
-    static inline constexpr const uint32_t num_entries = 2;
+    static inline constexpr const uint32_t num_entries = 3;
+
+    enum WriteMode : uint8_t
+    {
+        write_auto,    ///< linear when supported and measured to be faster, and when the rows are tightly packed
+        write_staging, ///< write to a buffer, then copy it to the image
+        write_linear,  ///< write to the image memory. The rows are row_pitch bytes apart.
+    };
 
     Rhi        *rhi = {};
     fence_id    fence_ids[num_entries] = {};
     image_id    img_ids[num_entries] = {};
     buffer_id   buf_ids[num_entries] = {};
     charspan    bufmem[num_entries] = {}; ///< the mapped buffer memory
+    charspan    imgmem[num_entries] = {}; ///< the mapped image memory (linear mode only)
+    bool        imgready[num_entries] = {}; ///< whether the linear image was moved to the GENERAL layout
+    image_view_id view_ids[num_entries] = {}; ///< the storage views (raw mode only)
+    ComputePass passes[num_entries] = {}; ///< (raw mode only)
+    compute_pipeline_id kernel = {}; ///< the conversion kernel (raw mode only)
+    uint32_t    kernel_params[8] = {}; ///< the push constants of the kernel
+    VkDeviceSize row_pitch = {};
+    bool        linear = {};
     uint32_t    wcpu = {}; ///< the index of the image/buffer where the CPU is currently writing
     uint32_t    rgpu = {}; ///< the index of the image/buffer where the GPU is currently reading
 
     void     set_name(Rhi *rhi, const char *name);
-    void     reset(Rhi *rhi, VkImageCreateInfo const& C4_RESTRICT nfo);
+    void     reset(Rhi *rhi, VkImageCreateInfo const& C4_RESTRICT nfo, WriteMode mode=write_staging);
+    void     _reset_linear(VkImageCreateInfo const& C4_RESTRICT nfo);
+    /** upload the frames raw and convert them on the GPU with a kernel
+     * taking (storage_buffer src, storage_image dst), eg
+     * ComputeKernels::convert_channels or ComputeKernels::yuv2rgb. The
+     * image must be a single R8G8B8A8_UNORM level and layer. Set the
+     * params of the kernel before the first finish_wcpu(). Only the
+     * whole-image start_wcpu()/finish_wcpu() can be used. */
+    void     reset_raw(Rhi *rhi, VkImageCreateInfo const& C4_RESTRICT nfo, compute_pipeline_id kernel, size_t raw_bytes);
+    void     _release_raw();
+    void     _finish_raw(ccharspan written);
+    template<class Params>
+    void     set_kernel_params(Params const& params)
+    {
+        static_assert(sizeof(Params) <= sizeof(kernel_params), "params too big");
+        C4_ASSERT(sizeof(Params) == rhi->get_compute_pipeline(kernel).push_constants_size);
+        memcpy(kernel_params, &params, sizeof(Params));
+    }
     charspan start_wcpu();
     void     finish_wcpu(ccharspan written);
     charspan start_wcpu(VkOffset3D first, VkOffset3D last);
     void     finish_wcpu(VkOffset3D first, VkOffset3D last, ccharspan written);
-    void     flip()
-    {
-        wcpu = (wcpu + 1) % num_entries;
-        rgpu = (rgpu + 1) % num_entries;
-    }
+    void     flip();
     ImageLayout const& layout() const { return rhi->get_image(img_ids[rgpu]).layout; }
     VkFence  fence(uint32_t which) { C4_ASSERT(which < num_entries); C4_ASSERT(fence_ids[which]); return rhi->get_fence(fence_ids[which]); }
     Buffer&  buf(uint32_t which) { C4_ASSERT(which < num_entries); C4_ASSERT(buf_ids[which]); return rhi->get_buffer(buf_ids[which]); }
@@ -491,6 +1091,117 @@ struct ImageDynamicCpu2Gpu
     Image&   img_wgpu() { return img(rgpu); }
 };
 
+
+/** the state of the entries of a ring of readbacks, apart from their
+ * GPU resources: an entry is started (pending) by a request, completed
+ * (held) when its fence is signaled, and freed when released. The
+ * entries complete in the order of their requests. */
+template<uint32_t N>
+struct ReadbackRing
+{
+    enum EntryState : uint8_t { entry_free, entry_pending, entry_held };
+
+    EntryState states[N] = {};
+    uint64_t   requests[N] = {}; ///< the number of the request of each entry
+    uint64_t   num_requests = {};
+
+    /** @return the started entry, or N when none is free */
+    uint32_t start()
+    {
+        uint32_t entry = 0;
+        while(entry < N && states[entry] != entry_free)
+            ++entry;
+        if(entry == N)
+            return entry;
+        states[entry] = entry_pending;
+        requests[entry] = num_requests++;
+        return entry;
+    }
+    /** @return the pending entry with the oldest request, or N */
+    uint32_t oldest_pending() const
+    {
+        uint32_t entry = N;
+        for(uint32_t idx = 0; idx < N; ++idx)
+            if(states[idx] == entry_pending && (entry == N || requests[idx] < requests[entry]))
+                entry = idx;
+        return entry;
+    }
+    void complete(uint32_t entry)
+    {
+        C4_CHECK(entry < N);
+        C4_CHECK(states[entry] == entry_pending);
+        states[entry] = entry_held;
+    }
+    void release(uint32_t entry, uint64_t request)
+    {
+        C4_CHECK(entry < N);
+        C4_CHECK(states[entry] == entry_held);
+        C4_CHECK(requests[entry] == request);
+        states[entry] = entry_free;
+    }
+    bool pending(uint32_t entry) const { C4_ASSERT(entry < N); return states[entry] == entry_pending; }
+    void clear() { *this = {}; }
+};
+
+
+/** asynchronous readback of images to the CPU, eg for screenshots or
+ * to record the gui. Each copy is recorded in the command buffers of
+ * the current frame, into its own host-visible buffer, and is
+ * signaled by its own fence. A readout is handed out once its fence
+ * is signaled, usually a few frames later, so neither the CPU nor the
+ * GPU waits. When all the buffers are in flight or held, the requests
+ * are dropped. Only the first layer and mip level are copied.
+ *
+ * Do not destroy this object between a request and the end of the
+ * frame where it was made. */
+struct ImageGpu2Cpu
+{
+    static inline constexpr const uint32_t num_entries = 4;
+
+    struct Readout
+    {
+        ccharspan data = {}; ///< tightly packed rows
+        uint32_t  width = {};
+        uint32_t  height = {};
+        VkFormat  format = {};
+        uint64_t  request = {}; ///< the number of the request
+        uint32_t  entry = {};
+    };
+
+    Rhi        *rhi = {};
+    fence_id    fence_ids[num_entries] = {};
+    buffer_id   buf_ids[num_entries] = {};
+    charspan    bufmem[num_entries] = {}; ///< the mapped buffer memory
+    Readout     readouts[num_entries] = {};
+    ReadbackRing<num_entries> ring = {};
+    VkMemoryPropertyFlags mem_flags = {};
+
+    void reset(Rhi *rhi);
+    void destroy();
+    /** copy an image which is in @p layout, and leave it in that
+     * layout. The image must have been created with_readback().
+     * The copy is recorded in the user command buffer of the frame.
+     * @return false if the request was dropped */
+    bool request(Image const& img, VkImageLayout layout);
+    bool request(Image const& img, VkImageLayout layout, VkCommandBuffer cmd);
+    /** copy the swapchain image once the gui of the current frame is
+     * rendered. The format is usually B8G8R8A8. Get @p sc with
+     * gui_swapchain_state().
+     * @return false if the request was dropped, or if the swapchain
+     * images cannot be read */
+    bool request_swapchain(SwapchainState const& sc);
+    /** get the oldest readout which is complete, without waiting.
+     * The data is valid until the readout is released. */
+    bool acquire(Readout *readout);
+    void release(Readout const& readout);
+
+    uint32_t _start_request(uint32_t width, uint32_t height, VkFormat format);
+    void     _record_copy(VkCommandBuffer cmd, uint32_t entry, VkImage img, VkImageLayout layout,
+                          VkPipelineStageFlags stage, VkAccessFlags access,
+                          VkPipelineStageFlags next_stage, VkAccessFlags next_access);
+};
+
+
 C4_SUPPRESS_WARNING_GCC_CLANG_POP
 
 } // namespace rhi
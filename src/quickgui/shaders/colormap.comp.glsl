@@ -0,0 +1,17 @@
+#version 450 core
+// map the first channel of an image through a color lookup table into rgba8
+layout(local_size_x = 16, local_size_y = 16) in;
+layout(set=0, binding=0) uniform sampler2D src;
+layout(set=0, binding=1) readonly buffer Lut { uint colors[]; } lut; // packed rgba8
+layout(set=0, binding=2, rgba8) uniform writeonly image2D dst;
+layout(push_constant) uniform uPushConstant { uint width; uint height; uint lut_size; float vmin; float vmax; } pc;
+void main()
+{
+    uvec2 px = gl_GlobalInvocationID.xy;
+    if(px.x >= pc.width || px.y >= pc.height)
+        return;
+    float val = texelFetch(src, ivec2(px), 0).r;
+    float t = clamp((val - pc.vmin) / (pc.vmax - pc.vmin), 0.0, 1.0);
+    uint idx = min(uint(t * float(pc.lut_size - 1u) + 0.5), pc.lut_size - 1u);
+    imageStore(dst, ivec2(px), unpackUnorm4x8(lut.colors[idx]));
+}
@@ -0,0 +1,32 @@
+#version 450 core
+// expand tightly packed 8-bit pixels with 1 to 4 channels into rgba8
+layout(local_size_x = 16, local_size_y = 16) in;
+layout(set=0, binding=0) readonly buffer Src { uint bytes[]; } src;
+layout(set=0, binding=1, rgba8) uniform writeonly image2D dst;
+layout(push_constant) uniform uPushConstant { uint width; uint height; uint row_pitch; uint num_channels; uint flags; } pc;
+const uint kSwapRB = 1u;
+const uint kVFlip = 2u;
+float src_byte(uint pos)
+{
+    return float((src.bytes[pos >> 2] >> ((pos & 3u) * 8u)) & 0xffu) / 255.0;
+}
+void main()
+{
+    uvec2 px = gl_GlobalInvocationID.xy;
+    if(px.x >= pc.width || px.y >= pc.height)
+        return;
+    uint row = ((pc.flags & kVFlip) != 0u) ? (pc.height - 1u - px.y) : px.y;
+    uint pos = row * pc.row_pitch + px.x * pc.num_channels;
+    vec4 c;
+    if(pc.num_channels == 1u)
+        c = vec4(vec3(src_byte(pos)), 1.0);
+    else if(pc.num_channels == 2u)
+        c = vec4(vec3(src_byte(pos)), src_byte(pos + 1u));
+    else if(pc.num_channels == 3u)
+        c = vec4(src_byte(pos), src_byte(pos + 1u), src_byte(pos + 2u), 1.0);
+    else
+        c = vec4(src_byte(pos), src_byte(pos + 1u), src_byte(pos + 2u), src_byte(pos + 3u));
+    if((pc.flags & kSwapRB) != 0u)
+        c.rgb = c.bgr;
+    imageStore(dst, ivec2(px), c);
+}
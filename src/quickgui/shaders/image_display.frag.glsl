@@ -0,0 +1,24 @@
+#version 450 core
+// display the values of an image: window/level, gamma, and a color table
+layout(location = 0) out vec4 fColor;
+layout(set=0, binding=0) uniform sampler2D sTexture;
+layout(set=0, binding=1) uniform sampler2D sColormaps; // one color table per row
+layout(push_constant) uniform uPushConstant {
+    layout(offset=16) float mul; float add; float inv_gamma; uint channel; float colormap_v; float lut_size;
+} pc;
+layout(location = 0) in struct { vec4 Color; vec2 UV; } In;
+void main()
+{
+    vec4 texel = texture(sTexture, In.UV.st);
+    if(pc.channel >= 4u) // rgb: window each channel, without color table
+    {
+        vec3 t = clamp(texel.rgb * pc.mul + pc.add, 0.0, 1.0);
+        fColor = In.Color * vec4(pow(t, vec3(pc.inv_gamma)), 1.0);
+        return;
+    }
+    float t = clamp(texel[pc.channel] * pc.mul + pc.add, 0.0, 1.0);
+    t = pow(t, pc.inv_gamma);
+    // t=0 and t=1 land on the centers of the first and last entries
+    float u = (t * (pc.lut_size - 1.0) + 0.5) / pc.lut_size;
+    fColor = In.Color * texture(sColormaps, vec2(u, pc.colormap_v));
+}
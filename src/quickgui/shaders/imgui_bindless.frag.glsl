@@ -0,0 +1,10 @@
+#version 450 core
+#extension GL_EXT_nonuniform_qualifier : require
+layout(location = 0) out vec4 fColor;
+layout(set=0, binding=0) uniform sampler2D sTextures[];
+layout(push_constant) uniform uPushConstant { layout(offset=16) uint uTexture; } pc;
+layout(location = 0) in struct { vec4 Color; vec2 UV; } In;
+void main()
+{
+    fColor = In.Color * texture(sTextures[pc.uTexture], In.UV.st);
+}
@@ -0,0 +1,17 @@
+#version 450 core
+// flip an rgba8 image vertically, in place: each invocation swaps two rows
+layout(local_size_x = 16, local_size_y = 16) in;
+layout(set=0, binding=0, rgba8) uniform image2D img;
+layout(push_constant) uniform uPushConstant { uint width; uint height; } pc;
+void main()
+{
+    uvec2 px = gl_GlobalInvocationID.xy;
+    if(px.x >= pc.width || px.y >= pc.height / 2u)
+        return;
+    ivec2 top = ivec2(px);
+    ivec2 bot = ivec2(px.x, pc.height - 1u - px.y);
+    vec4 ctop = imageLoad(img, top);
+    vec4 cbot = imageLoad(img, bot);
+    imageStore(img, top, cbot);
+    imageStore(img, bot, ctop);
+}
@@ -0,0 +1,57 @@
+#version 450 core
+// convert 4:2:0 YUV (planar I420/YV12 or semi-planar NV12) into rgba8
+layout(local_size_x = 16, local_size_y = 16) in;
+layout(set=0, binding=0) readonly buffer Src { uint bytes[]; } src;
+layout(set=0, binding=1, rgba8) uniform writeonly image2D dst;
+layout(push_constant) uniform uPushConstant {
+    uint width; uint height;
+    uint y_offset; uint y_pitch;
+    uint u_offset; uint v_offset; uint uv_pitch;
+    uint flags;
+} pc;
+const uint kNV12 = 1u;
+const uint kBT709 = 2u;
+const uint kFullRange = 4u;
+float src_byte(uint pos)
+{
+    return float((src.bytes[pos >> 2] >> ((pos & 3u) * 8u)) & 0xffu);
+}
+void main()
+{
+    uvec2 px = gl_GlobalInvocationID.xy;
+    if(px.x >= pc.width || px.y >= pc.height)
+        return;
+    uvec2 cpx = px / 2u;
+    float Y = src_byte(pc.y_offset + px.y * pc.y_pitch + px.x);
+    float U, V;
+    if((pc.flags & kNV12) != 0u)
+    {
+        uint pos = pc.u_offset + cpx.y * pc.uv_pitch + 2u * cpx.x;
+        U = src_byte(pos);
+        V = src_byte(pos + 1u);
+    }
+    else
+    {
+        U = src_byte(pc.u_offset + cpx.y * pc.uv_pitch + cpx.x);
+        V = src_byte(pc.v_offset + cpx.y * pc.uv_pitch + cpx.x);
+    }
+    float y, u, v;
+    if((pc.flags & kFullRange) != 0u)
+    {
+        y = Y / 255.0;
+        u = (U - 128.0) / 255.0;
+        v = (V - 128.0) / 255.0;
+    }
+    else
+    {
+        y = (Y - 16.0) / 219.0;
+        u = (U - 128.0) / 224.0;
+        v = (V - 128.0) / 224.0;
+    }
+    vec3 rgb;
+    if((pc.flags & kBT709) != 0u)
+        rgb = vec3(y + 1.5748 * v, y - 0.187324 * u - 0.468124 * v, y + 1.8556 * u);
+    else
+        rgb = vec3(y + 1.402 * v, y - 0.344136 * u - 0.714136 * v, y + 1.772 * u);
+    imageStore(dst, ivec2(px), vec4(clamp(rgb, 0.0, 1.0), 1.0));
+}
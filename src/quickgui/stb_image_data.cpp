@@ -1,6 +1,7 @@
 #include "quickgui/stb_image_data.hpp"
 #include <c4/error.hpp>
 #include <c4/szconv.hpp>
+#include <limits>
 
 C4_SUPPRESS_WARNING_MSVC_PUSH
 C4_SUPPRESS_WARNING_GCC_CLANG_PUSH
@@ -32,25 +33,44 @@ stb_image_data::stb_image_data(quickgui::ccharspan file_contents, RequiredChanne
     , height()
     , num_channels()
 {
-    int len = c4::szconv<int>(file_contents.size());
+    const bool ok = try_load(file_contents, channels);
+    C4_CHECK_MSG(ok, "failed reading image: %s", stbi_failure_reason());
+}
+
+stb_image_data::~stb_image_data()
+{
+    clear();
+}
+
+bool stb_image_data::try_load(quickgui::ccharspan file_contents, RequiredChannels channels)
+{
+    clear();
+    if(file_contents.size() > (size_t)std::numeric_limits<int>::max())
+        return false;
+    int len = (int)file_contents.size();
     stbi_uc const *buffer = (stbi_uc const*) file_contents.data();
     int required_channels = channels == RequiredChannels::defer ? 0 : (int)channels;
     int w = 0, h = 0, nch = 0;
     data = (char*)stbi_load_from_memory(buffer, len, &w, &h, &nch, required_channels);
-    C4_CHECK_MSG(data, "failed reading image: %s", stbi_failure_reason());
-    C4_CHECK(w > 0);
-    C4_CHECK(h > 0);
-    C4_CHECK(nch > 0);
-    C4_CHECK(nch <= 4);
+    if(!data)
+        return false;
+    if(w <= 0 || h <= 0 || nch <= 0 || nch > 4)
+    {
+        clear();
+        return false;
+    }
     width = (uint32_t)w;
     height = (uint32_t)h;
     num_channels = (channels == RequiredChannels::defer ? (uint32_t)nch : (uint32_t)channels);
+    return true;
 }
 
-stb_image_data::~stb_image_data()
+void stb_image_data::clear()
 {
     if(data)
         stbi_image_free(data);
+    data = nullptr;
+    width = height = num_channels = 0;
 }
 
 C4_SUPPRESS_WARNING_GCC_CLANG_POP
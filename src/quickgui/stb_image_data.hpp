@@ -23,9 +23,21 @@ struct stb_image_data
     char *data;
     uint32_t width, height, num_channels;
 
+    stb_image_data() : data(), width(), height(), num_channels() {}
     stb_image_data(quickgui::ccharspan file_contents, RequiredChannels channels=RequiredChannels::defer);
     ~stb_image_data();
 
+    stb_image_data(stb_image_data const&) = delete;
+    stb_image_data& operator= (stb_image_data const&) = delete;
+
+    /** decode, replacing the current data. Unlike the constructor,
+     * this does not error out on invalid images, eg when decoding in a
+     * worker thread.
+     * @return false if the image could not be decoded */
+    bool try_load(quickgui::ccharspan file_contents, RequiredChannels channels=RequiredChannels::defer);
+    /** release the data */
+    void clear();
+
     size_t data_size() const
     {
         constexpr const uint32_t num_bytes_per_channel = 1;
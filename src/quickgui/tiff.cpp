@@ -0,0 +1,449 @@
+#include "quickgui/tiff.hpp"
+
+#include <c4/platform.hpp>
+#include <cstring>
+#include <algorithm>
+
+#ifdef C4_UNIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace quickgui {
+
+C4_SUPPRESS_WARNING_GCC_CLANG_PUSH
+C4_SUPPRESS_WARNING_GCC_CLANG("-Wold-style-cast")
+
+namespace {
+
+enum : uint16_t
+{
+    tag_new_subfile_type = 254,
+    tag_image_width = 256,
+    tag_image_length = 257,
+    tag_bits_per_sample = 258,
+    tag_compression = 259,
+    tag_strip_offsets = 273,
+    tag_samples_per_pixel = 277,
+    tag_rows_per_strip = 278,
+    tag_strip_byte_counts = 279,
+    tag_planar_configuration = 284,
+    tag_predictor = 317,
+    tag_tile_width = 322,
+    tag_tile_length = 323,
+    tag_tile_offsets = 324,
+    tag_tile_byte_counts = 325,
+    tag_sample_format = 339,
+};
+
+enum : uint16_t
+{
+    compression_none = 1,
+    compression_packbits = 32773,
+};
+
+bool native_is_little_endian()
+{
+    const uint16_t one = 1;
+    return *(const uint8_t*)&one == 1;
+}
+
+size_t type_size(uint16_t type)
+{
+    switch(type)
+    {
+    case 1: case 2: case 6: case 7: return 1; // BYTE, ASCII, SBYTE, UNDEFINED
+    case 3: case 8: return 2;                 // SHORT, SSHORT
+    case 4: case 9: case 11: case 13: return 4; // LONG, SLONG, FLOAT, IFD
+    case 5: case 10: case 12: case 16: case 17: case 18: return 8; // RATIONAL, SRATIONAL, DOUBLE, LONG8, SLONG8, IFD8
+    }
+    return 0;
+}
+
+void swap_bytes(char *data, size_t num_bytes, size_t word_size)
+{
+    for(size_t i = 0; i + word_size <= num_bytes; i += word_size)
+        std::reverse(data + i, data + i + word_size);
+}
+
+/** @return false if the data is truncated, or overflows the output */
+bool unpack_bits(const char *src, size_t src_size, char *dst, size_t dst_size)
+{
+    size_t i = 0, o = 0;
+    while(o < dst_size && i < src_size)
+    {
+        const int8_t n = (int8_t)src[i++];
+        if(n >= 0) // copy the next n+1 bytes
+        {
+            const size_t count = (size_t)n + 1u;
+            if(i + count > src_size || o + count > dst_size)
+                return false;
+            memcpy(dst + o, src + i, count);
+            i += count;
+            o += count;
+        }
+        else if(n != -128) // repeat the next byte 1-n times
+        {
+            const size_t count = (size_t)(1 - n);
+            if(i >= src_size || o + count > dst_size)
+                return false;
+            memset(dst + o, src[i++], count);
+            o += count;
+        }
+    }
+    return o == dst_size;
+}
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+imgviewtype::data_type_e TiffPage::data_type() const
+{
+    switch(sample_format)
+    {
+    case 1:
+        return bits_per_sample == 8 ? imgviewtype::u8 : (bits_per_sample == 16 ? imgviewtype::u16 : imgviewtype::u32);
+    case 2:
+        return bits_per_sample == 8 ? imgviewtype::i8 : (bits_per_sample == 16 ? imgviewtype::i16 : imgviewtype::i32);
+    }
+    return imgviewtype::f32;
+}
+
+bool TiffFile::open(const char *filename)
+{
+    close();
+#ifdef C4_UNIX
+    const int fd = ::open(filename, O_RDONLY);
+    if(fd >= 0)
+    {
+        struct stat st;
+        if(fstat(fd, &st) == 0 && st.st_size > 0)
+        {
+            void *map = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if(map != MAP_FAILED)
+            {
+                m_map = map;
+                m_map_size = (size_t)st.st_size;
+                m_data = {(const char*)map, m_map_size};
+            }
+        }
+        ::close(fd); // the mapping stays valid
+    }
+#endif
+    if(!m_map)
+    {
+        m_file = std::fopen(filename, "rb");
+        if(!m_file)
+            return _fail("could not open the file");
+#ifdef _WIN32
+        _fseeki64(m_file, 0, SEEK_END);
+        m_file_size = (uint64_t)_ftelli64(m_file);
+#else
+        fseeko(m_file, 0, SEEK_END);
+        m_file_size = (uint64_t)ftello(m_file);
+#endif
+    }
+    return _parse();
+}
+
+bool TiffFile::open(ccharspan data)
+{
+    close();
+    m_data = data;
+    return _parse();
+}
+
+void TiffFile::close()
+{
+#ifdef C4_UNIX
+    if(m_map)
+        munmap(m_map, m_map_size);
+#endif
+    if(m_file)
+        std::fclose(m_file);
+    m_map = nullptr;
+    m_map_size = 0;
+    m_file = nullptr;
+    m_file_size = 0;
+    m_data = {};
+    pages.clear();
+    m_error.clear();
+}
+
+bool TiffFile::_fail(const char *msg)
+{
+    m_error = msg;
+    pages.clear();
+    return false;
+}
+
+bool TiffFile::_read(uint64_t offset, size_t size, void *dst)
+{
+    if(!m_file)
+    {
+        if(offset > m_data.size() || size > m_data.size() - offset)
+            return false;
+        memcpy(dst, m_data.data() + offset, size);
+        return true;
+    }
+    if(offset > m_file_size || size > m_file_size - offset)
+        return false;
+#ifdef _WIN32
+    if(_fseeki64(m_file, (int64_t)offset, SEEK_SET) != 0)
+        return false;
+#else
+    if(fseeko(m_file, (off_t)offset, SEEK_SET) != 0)
+        return false;
+#endif
+    return std::fread(dst, 1, size, m_file) == size;
+}
+
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+bool TiffFile::_parse()
+{
+    char order[2];
+    if(!_read(0, 2, order))
+        return _fail("truncated header");
+    if(order[0] == 'I' && order[1] == 'I')
+        m_swap = !native_is_little_endian();
+    else if(order[0] == 'M' && order[1] == 'M')
+        m_swap = native_is_little_endian();
+    else
+        return _fail("not a TIFF file");
+    // read an unsigned integer of the file byte order
+    auto read_uint = [this](uint64_t offset, size_t size, uint64_t *val){
+        char buf[8];
+        if(!_read(offset, size, buf))
+            return false;
+        if(m_swap)
+            std::reverse(buf, buf + size);
+        switch(size)
+        {
+        case 2: { uint16_t v; memcpy(&v, buf, 2); *val = v; break; }
+        case 4: { uint32_t v; memcpy(&v, buf, 4); *val = v; break; }
+        default: { uint64_t v; memcpy(&v, buf, 8); *val = v; break; }
+        }
+        return true;
+    };
+    uint64_t magic = 0;
+    if(!read_uint(2, 2, &magic))
+        return _fail("truncated header");
+    const bool bigtiff = (magic == 43);
+    if(magic != 42 && !bigtiff)
+        return _fail("not a TIFF file");
+    const size_t offset_size = bigtiff ? 8u : 4u;
+    const size_t count_size = bigtiff ? 8u : 2u;
+    const size_t entry_size = bigtiff ? 20u : 12u;
+    uint64_t ifd = 0;
+    if(!read_uint(bigtiff ? 8u : 4u, offset_size, &ifd))
+        return _fail("truncated header");
+    const uint64_t file_size = m_file ? m_file_size : (uint64_t)m_data.size();
+    // each directory takes at least this much, so a file with more
+    // directories has them in a cycle
+    const uint64_t max_directories = file_size / (count_size + offset_size);
+    uint64_t num_directories = 0;
+    std::vector<uint64_t> bits;
+    while(ifd)
+    {
+        if(++num_directories > max_directories)
+            return _fail("the directories form a cycle");
+        uint64_t num_entries = 0;
+        if(!read_uint(ifd, count_size, &num_entries))
+            return _fail("truncated directory");
+        TiffPage page;
+        bool skip = false;
+        uint64_t planar = 1, predictor = 1;
+        for(uint64_t e = 0; e < num_entries; ++e)
+        {
+            const uint64_t entry = ifd + count_size + e * entry_size;
+            uint64_t tag, type, count;
+            if(!read_uint(entry, 2, &tag) || !read_uint(entry + 2, 2, &type) || !read_uint(entry + 4, bigtiff ? 8u : 4u, &count))
+                return _fail("truncated directory");
+            const size_t tsize = type_size((uint16_t)type);
+            if(tsize == 0 || count > file_size / tsize)
+                continue;
+            // the values are inline when they fit in the offset field
+            uint64_t values = entry + 4 + offset_size;
+            if(count * tsize > offset_size && !read_uint(values, offset_size, &values))
+                return _fail("truncated directory");
+            auto read_array = [&](std::vector<uint64_t> *out){
+                if(type != 3 && type != 4 && type != 16)
+                    return false;
+                out->resize((size_t)count);
+                for(size_t i = 0; i < (size_t)count; ++i)
+                    if(!read_uint(values + i * tsize, tsize, &(*out)[i]))
+                        return false;
+                return true;
+            };
+            uint64_t val = 0;
+            switch(tag)
+            {
+            case tag_strip_offsets:
+            case tag_tile_offsets:
+                if(!read_array(&page.offsets))
+                    return _fail("bad strip or tile offsets");
+                continue;
+            case tag_strip_byte_counts:
+            case tag_tile_byte_counts:
+                if(!read_array(&page.byte_counts))
+                    return _fail("bad strip or tile byte counts");
+                continue;
+            case tag_bits_per_sample:
+                if(!read_array(&bits) || bits.empty())
+                    return _fail("bad bits per sample");
+                for(uint64_t b : bits)
+                    if(b != bits[0])
+                        return _fail("the channels have different bits per sample");
+                page.bits_per_sample = (uint16_t)bits[0];
+                continue;
+            default:
+                break;
+            }
+            if(type != 3 && type != 4 && type != 16)
+                continue;
+            if(!read_uint(values, tsize, &val))
+                return _fail("truncated directory");
+            switch(tag)
+            {
+            case tag_new_subfile_type: skip = (val & 1u); break;
+            case tag_image_width: page.width = (uint32_t)val; break;
+            case tag_image_length: page.height = (uint32_t)val; break;
+            case tag_compression: page.compression = (uint16_t)val; break;
+            case tag_samples_per_pixel: page.samples_per_pixel = (uint16_t)val; break;
+            case tag_rows_per_strip: page.rows_per_strip = (uint32_t)std::min<uint64_t>(val, UINT32_MAX); break;
+            case tag_planar_configuration: planar = val; break;
+            case tag_predictor: predictor = val; break;
+            case tag_tile_width: page.tile_width = (uint32_t)val; break;
+            case tag_tile_length: page.tile_height = (uint32_t)val; break;
+            case tag_sample_format: page.sample_format = (uint16_t)val; break;
+            default: break;
+            }
+        }
+        if(!read_uint(ifd + count_size + num_entries * entry_size, offset_size, &ifd))
+            return _fail("truncated directory");
+        if(skip) // a reduced-resolution image
+            continue;
+        if(!page.width || !page.height)
+            return _fail("the page has no size");
+        if(page.compression != compression_none && page.compression != compression_packbits)
+            return _fail("unsupported compression: only none and PackBits are supported");
+        if(predictor != 1)
+            return _fail("unsupported predictor");
+        if(planar != 1 && page.samples_per_pixel > 1)
+            return _fail("unsupported planar configuration: the channels must be interleaved");
+        if(page.samples_per_pixel < 1 || page.samples_per_pixel > 4)
+            return _fail("unsupported number of channels");
+        if(page.sample_format < 1 || page.sample_format > 3)
+            return _fail("unsupported sample format");
+        if(page.sample_format == 3 ? (page.bits_per_sample != 32) : (page.bits_per_sample != 8 && page.bits_per_sample != 16 && page.bits_per_sample != 32))
+            return _fail("unsupported bits per sample");
+        if(page.rows_per_strip == 0 || page.rows_per_strip > page.height)
+            page.rows_per_strip = page.height;
+        size_t num_blocks = (page.height + page.rows_per_strip - 1) / page.rows_per_strip;
+        if(page.tile_width || page.tile_height)
+        {
+            if(!page.tile_width || !page.tile_height)
+                return _fail("bad tile size");
+            num_blocks = (size_t)((page.width + page.tile_width - 1) / page.tile_width)
+                       * (size_t)((page.height + page.tile_height - 1) / page.tile_height);
+        }
+        if(page.offsets.size() != num_blocks || page.byte_counts.size() != num_blocks)
+            return _fail("the number of strips or tiles does not match the size");
+        pages.push_back(std::move(page));
+    }
+    if(pages.empty())
+        return _fail("the file has no pages");
+    return true;
+}
+
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+bool TiffFile::_read_block(TiffPage const& p, size_t block, size_t expected, char *dst)
+{
+    const uint64_t offset = p.offsets[block];
+    const uint64_t count = p.byte_counts[block];
+    if(p.compression == compression_none)
+    {
+        // some writers store the last strip shorter than its rows
+        if(count < expected)
+        {
+            memset(dst + count, 0, expected - (size_t)count);
+            return _read(offset, (size_t)count, dst);
+        }
+        return _read(offset, expected, dst);
+    }
+    if(count > (uint64_t)SIZE_MAX)
+        return false;
+    if(!m_file) // decode from the mapping, without copying
+    {
+        if(offset > m_data.size() || count > m_data.size() - offset)
+            return false;
+        return unpack_bits(m_data.data() + offset, (size_t)count, dst, expected);
+    }
+    m_buf.resize((size_t)count);
+    return _read(offset, (size_t)count, m_buf.data())
+        && unpack_bits(m_buf.data(), m_buf.size(), dst, expected);
+}
+
+bool TiffFile::read_page(size_t page, char *dst)
+{
+    if(page >= pages.size())
+        return false;
+    TiffPage const& p = pages[page];
+    const size_t bpp = p.bytes_per_pixel();
+    const size_t row_size = (size_t)p.width * bpp;
+    if(!p.tile_width)
+    {
+        for(size_t s = 0; s < p.offsets.size(); ++s)
+        {
+            const size_t first_row = s * p.rows_per_strip;
+            const size_t num_rows = std::min<size_t>(p.rows_per_strip, p.height - first_row);
+            if(!_read_block(p, s, num_rows * row_size, dst + first_row * row_size))
+            {
+                m_error = "could not read a strip";
+                return false;
+            }
+        }
+    }
+    else
+    {
+        const size_t tile_row_size = (size_t)p.tile_width * bpp;
+        std::vector<char> tile(tile_row_size * p.tile_height);
+        const size_t ntx = (p.width + p.tile_width - 1) / p.tile_width;
+        for(size_t t = 0; t < p.offsets.size(); ++t)
+        {
+            // the tiles at the border are padded to the full tile size
+            if(!_read_block(p, t, tile.size(), tile.data()))
+            {
+                m_error = "could not read a tile";
+                return false;
+            }
+            const size_t x0 = (t % ntx) * p.tile_width;
+            const size_t y0 = (t / ntx) * p.tile_height;
+            const size_t w = std::min<size_t>(p.tile_width, p.width - x0);
+            const size_t h = std::min<size_t>(p.tile_height, p.height - y0);
+            for(size_t row = 0; row < h; ++row)
+                memcpy(dst + (y0 + row) * row_size + x0 * bpp, tile.data() + row * tile_row_size, w * bpp);
+        }
+    }
+    if(m_swap && p.bits_per_sample > 8)
+        swap_bytes(dst, p.num_bytes(), p.bits_per_sample / 8u);
+    return true;
+}
+
+C4_SUPPRESS_WARNING_GCC_CLANG_POP
+
+} // namespace quickgui
@@ -0,0 +1,89 @@
+#ifndef QUICKGUI_TIFF_HPP_
+#define QUICKGUI_TIFF_HPP_
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+#include <c4/span.hpp>
+#include "quickgui/imgview.hpp"
+#include "quickgui/string.hpp"
+
+namespace quickgui {
+
+/** the layout of a TIFF page (an image file directory) */
+struct TiffPage
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint16_t bits_per_sample = 1;
+    uint16_t samples_per_pixel = 1;
+    uint16_t sample_format = 1; ///< 1: unsigned, 2: signed, 3: float
+    uint16_t compression = 1;   ///< 1: none, 32773: PackBits
+    uint32_t rows_per_strip = 0;
+    uint32_t tile_width = 0;    ///< 0 when in strips
+    uint32_t tile_height = 0;
+    std::vector<uint64_t> offsets;     ///< of the strips or tiles
+    std::vector<uint64_t> byte_counts;
+
+    imgviewtype::data_type_e data_type() const;
+    size_t bytes_per_pixel() const { return (size_t)samples_per_pixel * bits_per_sample / 8u; }
+    size_t num_bytes() const { return (size_t)width * height * bytes_per_pixel(); }
+    bool same_layout(TiffPage const& that) const
+    {
+        return width == that.width && height == that.height
+            && bits_per_sample == that.bits_per_sample
+            && samples_per_pixel == that.samples_per_pixel
+            && sample_format == that.sample_format;
+    }
+};
+
+/** a minimal reader for multi-page TIFF stacks (classic and BigTIFF,
+ * either byte order): uncompressed or PackBits, in strips or tiles,
+ * with 1 to 4 interleaved channels of 8/16/32-bit integers or 32-bit
+ * floats. Reduced-resolution pages (thumbnails) are skipped. The file
+ * is mmapped where possible, so that the pages are read on demand
+ * without buffering the whole file. */
+struct TiffFile
+{
+    std::vector<TiffPage> pages;
+
+public:
+
+    TiffFile() = default;
+    ~TiffFile() { close(); }
+    TiffFile(TiffFile const&) = delete;
+    TiffFile& operator= (TiffFile const&) = delete;
+
+    /** read the page layouts. @return false if the file cannot be
+     * read, or is not a supported TIFF; see error() */
+    bool open(const char *filename);
+    /** read from memory, which must outlive the reader */
+    bool open(ccharspan data);
+    void close();
+
+    /** decode a page into dst, which must have page.num_bytes(), as
+     * rows of interleaved samples in the native byte order */
+    bool read_page(size_t page, char *dst);
+
+    const char *error() const { return m_error.c_str(); }
+
+private:
+
+    bool _parse();
+    bool _fail(const char *msg);
+    bool _read(uint64_t offset, size_t size, void *dst);
+    bool _read_block(TiffPage const& p, size_t block, size_t expected, char *dst);
+
+    ccharspan m_data = {};   ///< mmapped or user data
+    void     *m_map = nullptr;
+    size_t    m_map_size = 0;
+    FILE     *m_file = nullptr; ///< when the file could not be mmapped
+    uint64_t  m_file_size = 0;
+    bool      m_swap = false;   ///< the file byte order is not the native one
+    String    m_error;
+    std::vector<char> m_buf;
+};
+
+} // namespace quickgui
+
+#endif /* QUICKGUI_TIFF_HPP_ */
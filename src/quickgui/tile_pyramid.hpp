@@ -0,0 +1,123 @@
+#ifndef QUICKGUI_TILE_PYRAMID_HPP_
+#define QUICKGUI_TILE_PYRAMID_HPP_
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace quickgui {
+
+/** a tile of a level of a TilePyramid */
+struct TileKey
+{
+    uint32_t level;
+    uint32_t tx, ty;
+    uint64_t packed() const { return ((uint64_t)level << 56) | ((uint64_t)ty << 28) | (uint64_t)tx; }
+    static TileKey unpack(uint64_t k) { return {(uint32_t)(k >> 56), (uint32_t)(k & 0x0fff'ffffu), (uint32_t)((k >> 28) & 0x0fff'ffffu)}; }
+    bool operator== (TileKey const& that) const { return level == that.level && tx == that.tx && ty == that.ty; }
+};
+
+/** the geometry of a multi-resolution tiled image: level 0 is the
+ * full resolution, and each level halves the previous one (rounding
+ * up), down to the first that fits in a single tile. */
+struct TilePyramid
+{
+    uint64_t width = 0;
+    uint64_t height = 0;
+    uint32_t tile_size = 0;
+    uint32_t num_levels = 0;
+
+public:
+
+    void reset(uint64_t width_, uint64_t height_, uint32_t tile_size_)
+    {
+        width = width_;
+        height = height_;
+        tile_size = tile_size_;
+        num_levels = 1;
+        while(level_width(num_levels - 1) > tile_size || level_height(num_levels - 1) > tile_size)
+            ++num_levels;
+    }
+
+    uint64_t level_width(uint32_t level) const { return shrink(width, level); }
+    uint64_t level_height(uint32_t level) const { return shrink(height, level); }
+    uint32_t num_tiles_x(uint32_t level) const { return (uint32_t)((level_width(level) + tile_size - 1) / tile_size); }
+    uint32_t num_tiles_y(uint32_t level) const { return (uint32_t)((level_height(level) + tile_size - 1) / tile_size); }
+
+    /** the pixels of the tile in its level; smaller at the right and
+     * bottom borders */
+    void tile_rect(TileKey k, uint64_t *x, uint64_t *y, uint32_t *w, uint32_t *h) const
+    {
+        *x = (uint64_t)k.tx * tile_size;
+        *y = (uint64_t)k.ty * tile_size;
+        *w = (uint32_t)(level_width(k.level) - *x < tile_size ? level_width(k.level) - *x : tile_size);
+        *h = (uint32_t)(level_height(k.level) - *y < tile_size ? level_height(k.level) - *y : tile_size);
+    }
+
+    /** the scale of a level relative to level 0 */
+    double level_scale(uint32_t level) const { return 1.0 / (double)((uint64_t)1 << level); }
+
+    /** the coarsest level that still has at least one texel per
+     * screen pixel, when displaying level 0 at the given scale (screen
+     * pixels per level 0 pixel) */
+    uint32_t level_for_scale(double scale) const
+    {
+        uint32_t level = 0;
+        while(level + 1 < num_levels && scale * (double)((uint64_t)2 << level) <= 1.0)
+            ++level;
+        return level;
+    }
+
+    /** the tile covering the same area in the next coarser level */
+    static TileKey parent(TileKey k) { return {k.level + 1, k.tx / 2, k.ty / 2}; }
+
+    /** append the tiles of the level that intersect the rect, given in
+     * level 0 pixels */
+    void visible_tiles(uint32_t level, double x0, double y0, double x1, double y1, std::vector<TileKey> *tiles) const
+    {
+        const double s = level_scale(level) / (double)tile_size;
+        const uint32_t ntx = num_tiles_x(level);
+        const uint32_t nty = num_tiles_y(level);
+        auto first = [](double v) { return v <= 0.0 ? 0u : (uint32_t)v; };
+        auto last = [](double v, uint32_t n) { return v <= 0.0 ? 0u : (v >= (double)n ? n : (uint32_t)v + 1u); };
+        const uint32_t tx0 = first(x0 * s), tx1 = last(x1 * s, ntx);
+        const uint32_t ty0 = first(y0 * s), ty1 = last(y1 * s, nty);
+        for(uint32_t ty = ty0; ty < ty1; ++ty)
+            for(uint32_t tx = tx0; tx < tx1; ++tx)
+                tiles->push_back({level, tx, ty});
+    }
+
+    static uint64_t shrink(uint64_t dim, uint32_t level)
+    {
+        const uint64_t div = (uint64_t)1 << level;
+        return (dim + div - 1) / div;
+    }
+};
+
+
+/** make the next level of an RGBA8 image, averaging each 2x2 block.
+ * The odd row/column at the border is averaged with itself. dst must
+ * have TilePyramid::shrink(src_width, 1) x TilePyramid::shrink(src_height, 1)
+ * pixels. */
+inline void tile_pyramid_downsample_rgba8(const uint8_t *src, uint64_t src_width, uint64_t src_height, uint8_t *dst)
+{
+    const uint64_t dst_width = TilePyramid::shrink(src_width, 1);
+    const uint64_t dst_height = TilePyramid::shrink(src_height, 1);
+    for(uint64_t y = 0; y < dst_height; ++y)
+    {
+        const uint8_t *row0 = src + (2 * y) * src_width * 4u;
+        const uint8_t *row1 = (2 * y + 1 < src_height) ? row0 + src_width * 4u : row0;
+        uint8_t *out = dst + y * dst_width * 4u;
+        for(uint64_t x = 0; x < dst_width; ++x)
+        {
+            const uint64_t c0 = 2 * x * 4u;
+            const uint64_t c1 = (2 * x + 1 < src_width) ? c0 + 4u : c0;
+            for(uint64_t c = 0; c < 4; ++c)
+                out[x * 4u + c] = (uint8_t)(((uint32_t)row0[c0 + c] + row0[c1 + c] + row1[c0 + c] + row1[c1 + c] + 2u) / 4u);
+        }
+    }
+}
+
+} // namespace quickgui
+
+#endif /* QUICKGUI_TILE_PYRAMID_HPP_ */
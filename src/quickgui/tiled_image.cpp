@@ -0,0 +1,394 @@
+#include "quickgui/tiled_image.hpp"
+
+#include "quickgui/log.hpp"
+#include <c4/format.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace quickgui {
+
+C4_SUPPRESS_WARNING_GCC_CLANG_PUSH
+C4_SUPPRESS_WARNING_GCC_CLANG("-Wold-style-cast")
+
+void TiledImage::reset(uint64_t width, uint64_t height, ReadFn read_fn, void *read_data)
+{
+    destroy();
+    m_pyramid.reset(width, height, tile_size);
+    m_read_fn = read_fn;
+    m_read_data = read_data;
+    _start();
+}
+
+void TiledImage::reset(const uint8_t *rgba, uint64_t width, uint64_t height)
+{
+    destroy();
+    m_pyramid.reset(width, height, tile_size);
+    m_level0 = rgba;
+    m_levels.resize(m_pyramid.num_levels);
+    for(uint32_t level = 1; level < m_pyramid.num_levels; ++level)
+    {
+        const uint8_t *prev = level > 1 ? m_levels[level - 1].data() : m_level0;
+        m_levels[level].resize(m_pyramid.level_width(level) * m_pyramid.level_height(level) * 4u);
+        tile_pyramid_downsample_rgba8(prev, m_pyramid.level_width(level - 1), m_pyramid.level_height(level - 1), m_levels[level].data());
+    }
+    m_read_fn = &_read_levels;
+    m_read_data = this;
+    _start();
+}
+
+void TiledImage::_start()
+{
+    C4_CHECK(m_read_fn);
+    C4_CHECK(tile_size + 3u <= cache_layer_size);
+    m_cache.init(cache_layer_size, cache_layer_size, cache_layers);
+    m_frame = 0;
+    scale = 0.0;
+    m_quit = false;
+    m_thread = std::thread([this]{ _run(); });
+}
+
+void TiledImage::destroy()
+{
+    if(m_thread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_quit = true;
+            m_requests.clear();
+        }
+        m_cv.notify_all();
+        m_thread.join();
+    }
+    Loaded *l;
+    while(m_loaded.pop(&l))
+        delete l;
+    for(Loaded *r : m_ready)
+        delete r;
+    for(Loaded *f : m_free)
+        delete f;
+    m_ready.clear();
+    m_free.clear();
+    for(auto &r : m_resident)
+        r.second.img.destroy();
+    m_resident.clear();
+    m_cache.destroy();
+    m_levels.clear();
+    m_level0 = nullptr;
+    m_read_fn = nullptr;
+    m_read_data = nullptr;
+}
+
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+bool TiledImage::_read_levels(void *data, uint32_t level, uint64_t x, uint64_t y, uint32_t w, uint32_t h, uint8_t *rgba)
+{
+    TiledImage const* self = (TiledImage const*)data;
+    const uint8_t *src = level ? self->m_levels[level].data() : self->m_level0;
+    const uint64_t src_width = self->m_pyramid.level_width(level);
+    for(uint32_t row = 0; row < h; ++row)
+        memcpy(rgba + (size_t)row * w * 4u, src + ((y + row) * src_width + x) * 4u, (size_t)w * 4u);
+    return true;
+}
+
+bool TiledImage::_read_tile(Loaded *l, std::vector<uint8_t> *buf) const
+{
+    uint64_t x, y;
+    uint32_t w, h;
+    m_pyramid.tile_rect(l->key, &x, &y, &w, &h);
+    l->width = w;
+    l->height = h;
+    // read the tile with its border, where there are neighbours
+    const uint64_t rx0 = x ? x - 1 : 0;
+    const uint64_t ry0 = y ? y - 1 : 0;
+    const uint64_t rx1 = std::min(x + w + 1, m_pyramid.level_width(l->key.level));
+    const uint64_t ry1 = std::min(y + h + 1, m_pyramid.level_height(l->key.level));
+    const uint32_t rw = (uint32_t)(rx1 - rx0);
+    const uint32_t rh = (uint32_t)(ry1 - ry0);
+    buf->resize((size_t)rw * rh * 4u);
+    if(!m_read_fn(m_read_data, l->key.level, rx0, ry0, rw, rh, buf->data()))
+        return false;
+    // all the tiles take the same space in the cache, so that an
+    // evicted slot fits any other tile. Where there is no neighbour,
+    // the border repeats the edge.
+    const uint32_t dim = tile_size + 2u;
+    l->pixels.resize((size_t)dim * dim * 4u);
+    const uint32_t ix = (uint32_t)(x - rx0);
+    const uint32_t iy = (uint32_t)(y - ry0);
+    const uint32_t left = ix ? ix - 1u : 0u;
+    const uint32_t right = std::min(ix + w, rw - 1u);
+    for(uint32_t row = 0; row < h + 2u; ++row)
+    {
+        const int64_t sy = std::clamp((int64_t)iy + (int64_t)row - 1, (int64_t)0, (int64_t)rh - 1);
+        const uint8_t *src = buf->data() + (size_t)sy * rw * 4u;
+        uint8_t *dst = l->pixels.data() + (size_t)row * dim * 4u;
+        memcpy(dst, src + (size_t)left * 4u, 4u);
+        memcpy(dst + 4u, src + (size_t)ix * 4u, (size_t)w * 4u);
+        memcpy(dst + (size_t)(w + 1u) * 4u, src + (size_t)right * 4u, 4u);
+    }
+    return true;
+}
+
+void TiledImage::_run()
+{
+    std::vector<uint8_t> buf;
+    while(true)
+    {
+        Loaded *l = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_reading = UINT64_MAX;
+            m_cv.wait(lock, [this]{ return m_quit || !m_requests.empty(); });
+            if(m_quit)
+                return;
+            const TileKey key = m_requests.front();
+            m_requests.erase(m_requests.begin());
+            m_reading = key.packed();
+            if(m_free.empty())
+            {
+                l = new Loaded;
+            }
+            else
+            {
+                l = m_free.back();
+                m_free.pop_back();
+            }
+            l->key = key;
+        }
+        l->ok = _read_tile(l, &buf);
+        m_loaded.push(l);
+        gui_invalidate(); // wake up a lazy frame
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+TiledImage::Resident const* TiledImage::_find(TileKey k) const
+{
+    auto it = m_resident.find(k.packed());
+    // the tiles that failed to read are kept without an image, so
+    // that they are not requested again. The tiles added to the cache
+    // are drawn from the frame after their upload was recorded: until
+    // then, their slot may still hold the pixels of an evicted tile,
+    // and their ancestor is drawn instead.
+    return (it != m_resident.end() && it->second.img.resident()) ? &it->second : nullptr;
+}
+
+bool TiledImage::_evict_lru()
+{
+    const uint32_t top = m_pyramid.num_levels - 1u;
+    auto lru = m_resident.end();
+    for(auto it = m_resident.begin(); it != m_resident.end(); ++it)
+    {
+        if(it->second.last_used == m_frame || TileKey::unpack(it->first).level == top)
+            continue;
+        if(lru == m_resident.end() || it->second.last_used < lru->second.last_used)
+            lru = it;
+    }
+    if(lru == m_resident.end())
+        return false;
+    lru->second.img.destroy();
+    m_resident.erase(lru);
+    return true;
+}
+
+void TiledImage::_upload()
+{
+    Loaded *l;
+    while(m_loaded.pop(&l))
+        m_ready.push_back(l);
+    const uint32_t dim = tile_size + 2u;
+    uint32_t num_uploads = 0;
+    size_t num_taken = 0;
+    for( ; num_taken < m_ready.size() && num_uploads < max_uploads_per_frame; ++num_taken)
+    {
+        l = m_ready[num_taken];
+        const uint64_t key = l->key.packed();
+        // drop the tiles that went out of view while reading
+        if(m_resident.count(key) || std::find(m_visible.begin(), m_visible.end(), l->key) == m_visible.end())
+            continue;
+        Resident &r = m_resident[key];
+        r.last_used = m_frame;
+        if(!l->ok)
+        {
+            QUICKGUI_LOGF("tiled image: could not read tile {}: {},{}", l->key.level, l->key.tx, l->key.ty);
+            continue;
+        }
+        while(!m_cache.add(&r.img, {(const char*)l->pixels.data(), l->pixels.size()}, dim, dim))
+        {
+            if(!_evict_lru())
+                break;
+        }
+        if(!r.img.atlas) // the cache is full of visible tiles
+        {
+            m_resident.erase(key);
+            ++num_taken;
+            break;
+        }
+        ++num_uploads;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_free.insert(m_free.end(), m_ready.begin(), m_ready.begin() + (std::ptrdiff_t)num_taken);
+    }
+    m_ready.erase(m_ready.begin(), m_ready.begin() + (std::ptrdiff_t)num_taken);
+}
+
+void TiledImage::_request()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // replace the previous requests: the tiles that are no longer
+        // visible are not read
+        m_requests.clear();
+        for(TileKey k : m_visible)
+        {
+            const uint64_t key = k.packed();
+            if(m_resident.count(key) || key == m_reading)
+                continue;
+            if(std::find_if(m_ready.begin(), m_ready.end(), [key](Loaded const* l){ return l->key.packed() == key; }) != m_ready.end())
+                continue;
+            m_requests.push_back(k);
+        }
+        if(m_requests.empty())
+            return;
+    }
+    m_cv.notify_one();
+}
+
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+void TiledImage::fit(ImVec2 size)
+{
+    center_x = 0.5 * (double)m_pyramid.width;
+    center_y = 0.5 * (double)m_pyramid.height;
+    scale = std::min((double)size.x / (double)m_pyramid.width, (double)size.y / (double)m_pyramid.height);
+}
+
+void TiledImage::_draw_tile(ImDrawList *dl, ImVec2 canvas_center, TileKey k, Resident const& r) const
+{
+    uint64_t x, y;
+    uint32_t w, h;
+    m_pyramid.tile_rect(k, &x, &y, &w, &h);
+    const double texel = (double)((uint64_t)1 << k.level); // in level 0 pixels
+    const ImVec2 topl(canvas_center.x + (float)(((double)x * texel - center_x) * scale),
+                      canvas_center.y + (float)(((double)y * texel - center_y) * scale));
+    const ImVec2 botr(topl.x + (float)((double)w * texel * scale),
+                      topl.y + (float)((double)h * texel * scale));
+    // skip the border
+    AtlasRect const& rect = r.img.atlas_rect;
+    const float aw = (float)m_cache.packer.width;
+    const float ah = (float)m_cache.packer.height;
+    const ImVec2 uv0((float)(rect.x + 1u) / aw, (float)(rect.y + 1u) / ah);
+    const ImVec2 uv1((float)(rect.x + 1u + w) / aw, (float)(rect.y + 1u + h) / ah);
+    dl->AddImage(r.img.tex_id(), topl, botr, uv0, uv1);
+}
+
+void TiledImage::draw(ImVec2 size)
+{
+    if(!m_read_fn)
+        return;
+    ImGui::PushID(this);
+    ImGui::InvisibleButton("##tiled_image", size);
+    ImGui::PopID();
+    const ImVec2 p0 = ImGui::GetItemRectMin();
+    const ImVec2 p1 = ImGui::GetItemRectMax();
+    size = ImGui::GetItemRectSize();
+    if(scale <= 0.0)
+        fit(size);
+    const ImVec2 canvas_center(0.5f * (p0.x + p1.x), 0.5f * (p0.y + p1.y));
+    ImGuiIO const& io = ImGui::GetIO();
+    if(ImGui::IsItemActive() && ImGui::IsMouseDragging(ImGuiMouseButton_Left, 0.f))
+    {
+        center_x -= (double)io.MouseDelta.x / scale;
+        center_y -= (double)io.MouseDelta.y / scale;
+    }
+    if(ImGui::IsItemHovered() && io.MouseWheel != 0.f)
+    {
+        // keep the point under the cursor
+        const double mx = (double)(io.MousePos.x - canvas_center.x);
+        const double my = (double)(io.MousePos.y - canvas_center.y);
+        const double ix = center_x + mx / scale;
+        const double iy = center_y + my / scale;
+        const double min_scale = 0.5 * std::min((double)size.x / (double)m_pyramid.width, (double)size.y / (double)m_pyramid.height);
+        scale = std::clamp(scale * std::pow(1.25, (double)io.MouseWheel), min_scale, 64.0);
+        center_x = ix - mx / scale;
+        center_y = iy - my / scale;
+    }
+    ++m_frame;
+    // the visible tiles at the level of the zoom, closest to the
+    // center first, after the coarsest tile
+    const uint32_t level = m_pyramid.level_for_scale(scale);
+    const TileKey top = {m_pyramid.num_levels - 1u, 0u, 0u};
+    const double half_w = 0.5 * (double)size.x / scale;
+    const double half_h = 0.5 * (double)size.y / scale;
+    m_visible.clear();
+    if(level != top.level)
+        m_visible.push_back(top);
+    m_pyramid.visible_tiles(level, center_x - half_w, center_y - half_h, center_x + half_w, center_y + half_h, &m_visible);
+    const double tile_dim = (double)m_pyramid.tile_size / m_pyramid.level_scale(level);
+    auto dist = [&](TileKey k){
+        const double dx = ((double)k.tx + 0.5) * tile_dim - center_x;
+        const double dy = ((double)k.ty + 0.5) * tile_dim - center_y;
+        return dx * dx + dy * dy;
+    };
+    std::sort(m_visible.begin() + (level != top.level), m_visible.end(), [&](TileKey a, TileKey b){
+        return dist(a) < dist(b);
+    });
+    for(TileKey k : m_visible)
+    {
+        auto it = m_resident.find(k.packed());
+        if(it != m_resident.end())
+            it->second.last_used = m_frame;
+    }
+    // the missing tiles are covered by their closest ancestor in the
+    // cache, drawn first, coarsest first. These are found before the
+    // upload, so that they are not evicted by it.
+    m_fallbacks.clear();
+    for(TileKey k : m_visible)
+    {
+        if(k.level != level || _find(k))
+            continue;
+        for(TileKey a = k; a.level < top.level; )
+        {
+            a = TilePyramid::parent(a);
+            if(_find(a))
+            {
+                m_fallbacks.push_back(a);
+                break;
+            }
+        }
+    }
+    std::sort(m_fallbacks.begin(), m_fallbacks.end(), [](TileKey a, TileKey b){
+        return a.level > b.level || (a.level == b.level && a.packed() < b.packed());
+    });
+    m_fallbacks.erase(std::unique(m_fallbacks.begin(), m_fallbacks.end()), m_fallbacks.end());
+    for(TileKey k : m_fallbacks)
+        m_resident.find(k.packed())->second.last_used = m_frame;
+    _upload();
+    _request();
+    ImDrawList *dl = ImGui::GetWindowDrawList();
+    dl->PushClipRect(p0, p1, true);
+    for(TileKey k : m_fallbacks)
+        _draw_tile(dl, canvas_center, k, *_find(k));
+    for(TileKey k : m_visible)
+        if(k.level == level)
+            if(Resident const* r = _find(k))
+                _draw_tile(dl, canvas_center, k, *r);
+    dl->PopClipRect();
+    if(!m_ready.empty()) // more uploads are due
+        gui_invalidate();
+}
+
+C4_SUPPRESS_WARNING_GCC_CLANG_POP
+
+} // namespace quickgui
@@ -0,0 +1,125 @@
+#ifndef QUICKGUI_TILED_IMAGE_HPP_
+#define QUICKGUI_TILED_IMAGE_HPP_
+
+#include "quickgui/gui.hpp"
+#include "quickgui/tile_pyramid.hpp"
+#include "quickgui/mpsc_queue.hpp"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace quickgui {
+
+/** a viewer for images larger than a texture, eg microscopy or
+ * satellite images. The image is read as a pyramid of tiles by a
+ * worker thread, and the tiles visible at the level matching the zoom
+ * are kept in a GPU cache (a GuiImageAtlas), evicting the least
+ * recently used. While the tiles of a level are streaming, their area
+ * is drawn from the coarser levels in the cache, so panning and
+ * zooming never wait for the reads. The single tile of the coarsest
+ * level is never evicted. */
+struct TiledImage
+{
+    /** read a rect of a level into w*h RGBA8 pixels. Called from the
+     * worker thread. Eg read from a pyramidal TIFF, or copy from an
+     * mmapped file with the levels one after the other.
+     * @return false on error */
+    using ReadFn = bool (*)(void *data, uint32_t level, uint64_t x, uint64_t y, uint32_t w, uint32_t h, uint8_t *rgba);
+
+    // set these before reset()
+    /** the tiles get a border of one texel from their neighbours, so
+     * that the filtering is seamless. The default fits 8x8 tiles in
+     * each layer of the cache. */
+    uint32_t tile_size = 252;
+    uint32_t cache_layer_size = 2048;
+    uint32_t cache_layers = 4;
+    /** tiles uploaded in each frame, at most */
+    uint32_t max_uploads_per_frame = 16;
+
+    /** the view: the image point at the center of the widget, in level
+     * 0 pixels, and the screen pixels per level 0 pixel. A scale of 0
+     * fits the image in the next draw(). */
+    double center_x = 0.0;
+    double center_y = 0.0;
+    double scale = 0.0;
+
+public:
+
+    TiledImage() = default;
+    ~TiledImage() { destroy(); }
+    TiledImage(TiledImage const&) = delete;
+    TiledImage& operator= (TiledImage const&) = delete;
+
+    /** Call while a frame is recording, as it creates the cache. */
+    void reset(uint64_t width, uint64_t height, ReadFn read_fn, void *read_data);
+    /** build the coarser levels from a RGBA8 image in memory, which
+     * must outlive the viewer. The levels are built in this call, and
+     * take a third of the image memory. */
+    void reset(const uint8_t *rgba, uint64_t width, uint64_t height);
+    /** wait for the worker, and release the cache */
+    void destroy();
+
+    /** draw in a widget of the given size, zooming around the cursor
+     * with the mouse wheel, and panning by dragging. Call every frame. */
+    void draw(ImVec2 size);
+    /** set the view to show the whole image in the widget */
+    void fit(ImVec2 size);
+
+    TilePyramid const& pyramid() const { return m_pyramid; }
+    size_t num_resident_tiles() const { return m_resident.size(); }
+
+private:
+
+    struct Loaded
+    {
+        TileKey              key;
+        uint32_t             width, height; ///< without the border
+        bool                 ok;
+        std::vector<uint8_t> pixels; ///< (tile_size+2)^2, with the border
+    };
+    struct Resident
+    {
+        GuiImage img;
+        uint64_t last_used;
+    };
+
+    void _start();
+    void _run();
+    bool _read_tile(Loaded *l, std::vector<uint8_t> *buf) const;
+    void _upload();
+    void _request();
+    bool _evict_lru();
+    Resident const* _find(TileKey k) const;
+    void _draw_tile(ImDrawList *dl, ImVec2 canvas_center, TileKey k, Resident const& r) const;
+    static bool _read_levels(void *data, uint32_t level, uint64_t x, uint64_t y, uint32_t w, uint32_t h, uint8_t *rgba);
+
+    TilePyramid       m_pyramid;
+    ReadFn            m_read_fn = nullptr;
+    void             *m_read_data = nullptr;
+    /** the levels built by reset(rgba); level 0 is not copied */
+    const uint8_t    *m_level0 = nullptr;
+    std::vector<std::vector<uint8_t>> m_levels;
+
+    GuiImageAtlas     m_cache;
+    std::unordered_map<uint64_t, Resident> m_resident;
+    uint64_t          m_frame = 0;
+    std::vector<TileKey> m_visible; ///< the tiles wanted in this frame
+    std::vector<TileKey> m_fallbacks;
+
+    std::thread       m_thread;
+    std::mutex        m_mutex;
+    std::condition_variable m_cv;
+    // guarded by the mutex
+    std::vector<TileKey> m_requests; ///< in priority order
+    uint64_t          m_reading = UINT64_MAX;
+    std::vector<Loaded*> m_free;
+    bool              m_quit = false;
+    // pushed by the worker
+    mpsc_queue<Loaded*> m_loaded;
+    std::vector<Loaded*> m_ready; ///< loaded, waiting for the upload
+};
+
+} // namespace quickgui
+
+#endif /* QUICKGUI_TILED_IMAGE_HPP_ */
@@ -203,6 +203,130 @@ void vulkan_window(WidgetState *st)
         st->debug_vulkan = debug;
         rhi::enable_vk_debug(debug);
     }
+    if(rhi::host_alloc_enabled() && ImGui::CollapsingHeader("Host memory", ImGuiTreeNodeFlags_DefaultOpen))
+    {
+        if(ImGui::BeginTable("host memory", 6, ImGuiTableFlags_RowBg|ImGuiTableFlags_BordersInnerV))
+        {
+            char buf[32];
+            ImGui::TableSetupColumn("scope");
+            ImGui::TableSetupColumn("allocs");
+            ImGui::TableSetupColumn("frees");
+            ImGui::TableSetupColumn("bytes");
+            ImGui::TableSetupColumn("peak");
+            ImGui::TableSetupColumn("allocs/s");
+            ImGui::TableHeadersRow();
+            auto row = [&buf](const char *name, rhi::HostAllocStats const& stats){
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(name);
+                setcol(buf, stats.num_allocs);
+                setcol(buf, stats.num_frees);
+                setcol(buf, stats.bytes);
+                setcol(buf, stats.peak_bytes);
+                setcol(buf, c4::fmt::real(stats.allocs_per_sec, 1));
+            };
+            row("command", rhi::host_alloc_stats(VK_SYSTEM_ALLOCATION_SCOPE_COMMAND));
+            row("object", rhi::host_alloc_stats(VK_SYSTEM_ALLOCATION_SCOPE_OBJECT));
+            row("cache", rhi::host_alloc_stats(VK_SYSTEM_ALLOCATION_SCOPE_CACHE));
+            row("device", rhi::host_alloc_stats(VK_SYSTEM_ALLOCATION_SCOPE_DEVICE));
+            row("instance", rhi::host_alloc_stats(VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE));
+            row("total", rhi::host_alloc_stats(VK_SYSTEM_ALLOCATION_SCOPE_MAX_ENUM));
+            ImGui::EndTable();
+        }
+        ImGui::Text("transient arena hits: %llu", (unsigned long long)rhi::host_alloc_arena_hits());
+    }
+    if(ImGui::CollapsingHeader("Device memory", ImGuiTreeNodeFlags_DefaultOpen))
+    {
+        rhi::MemoryUsage const& mu = rhi::g_rhi.memory_usage();
+        auto mb = [](VkDeviceSize bytes){ return c4::fmt::real((double)bytes / (1024. * 1024.), 1); };
+        if(ImGui::BeginTable("heaps", 5, ImGuiTableFlags_RowBg|ImGuiTableFlags_BordersInnerV))
+        {
+            char buf[32];
+            ImGui::TableSetupColumn("heap");
+            ImGui::TableSetupColumn("local");
+            ImGui::TableSetupColumn("usage MB");
+            ImGui::TableSetupColumn("budget MB");
+            ImGui::TableSetupColumn("size MB");
+            ImGui::TableHeadersRow();
+            for(uint32_t i = 0; i < mu.num_heaps; ++i)
+            {
+                rhi::MemoryHeapUsage const& heap = mu.heaps[i];
+                ImGui::TableNextRow();
+                setcol(buf, i);
+                setcol(buf, (heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) ? "yes" : "no");
+                if(mu.has_budget)
+                    setcol(buf, mb(heap.usage));
+                else
+                    setcol(buf, "-");
+                setcol(buf, mb(heap.budget));
+                setcol(buf, mb(heap.size));
+            }
+            ImGui::EndTable();
+        }
+        if(ImGui::BeginTable("collections", 2, ImGuiTableFlags_RowBg|ImGuiTableFlags_BordersInnerV))
+        {
+            char buf[32];
+            ImGui::TableSetupColumn("allocated by");
+            ImGui::TableSetupColumn("MB");
+            ImGui::TableHeadersRow();
+            auto row = [&](const char *name, VkDeviceSize bytes){
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(name);
+                setcol(buf, mb(bytes));
+            };
+            row("images", mu.images);
+            row("buffers", mu.buffers);
+            row("upload buffer", mu.upload_buffer);
+            row("imgui buffers", mu.imgui_buffers);
+            row("total", mu.total());
+            ImGui::EndTable();
+        }
+        uint32_t limit_mb = (uint32_t)(rhi::g_rhi.m_memory_soft_limit / (1024u * 1024u));
+        ImGui::PushItemWidth(ImGui::GetFontSize() * 8);
+        if(ImGui::InputScalar("Soft limit (MB, 0=none)", ImGuiDataType_U32, &limit_mb))
+            rhi::g_rhi.set_memory_soft_limit((VkDeviceSize)limit_mb * 1024u * 1024u);
+        ImGui::PopItemWidth();
+    }
+    ImGui::End();
+}
+
+void gpu_profiler_window(WidgetState *st)
+{
+    if(!st->show_gpu_profiler_window)
+        return;
+    ImGui::Begin("GPU profiler", &st->show_gpu_profiler_window);
+    if(!rhi::gpu_profiler_supported())
+    {
+        ImGui::TextUnformatted("timestamps are not supported by the queue");
+        ImGui::End();
+        return;
+    }
+    bool enabled = rhi::gpu_profiler_enabled();
+    if(ImGui::Checkbox("Enable", &enabled))
+        rhi::gpu_profiler_enable(enabled);
+    c4::cspan<rhi::GpuProfileRegion> regions = rhi::gpu_profiler_regions();
+    if(enabled && ImGui::BeginTable("regions", 2, ImGuiTableFlags_RowBg|ImGuiTableFlags_BordersInnerV))
+    {
+        char buf[32];
+        ImGui::TableSetupColumn("region");
+        ImGui::TableSetupColumn("ms", ImGuiTableColumnFlags_WidthFixed, 80.f);
+        ImGui::TableHeadersRow();
+        for(rhi::GpuProfileRegion const& region : regions)
+        {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            // Indent(0) would use the default spacing
+            const float indent = (float)region.depth * ImGui::GetStyle().IndentSpacing;
+            if(region.depth)
+                ImGui::Indent(indent);
+            ImGui::TextUnformatted(region.name);
+            if(region.depth)
+                ImGui::Unindent(indent);
+            setcol(buf, c4::fmt::real(region.ms, 3));
+        }
+        ImGui::EndTable();
+    }
     ImGui::End();
 }
 
@@ -241,15 +365,17 @@ void demo(WidgetState *st)
                 (double)(1000.f / ImGui::GetIO().Framerate),
                 (double)ImGui::GetIO().Framerate);
     ImGui::Checkbox("Vulkan Widget", &st->show_vulkan_window);
+    ImGui::Checkbox("GPU profiler Widget", &st->show_gpu_profiler_window);
     #ifdef QUICKGUI_WITH_DEMOS
     ImGui::Checkbox("Imgui demo Widget", &st->show_demo_widget);
     ImGui::Checkbox("Implot demo Widget", &st->show_plot_demo_widget);
     #endif
-    ImGuiIO& io = ImGui::GetIO();
     const float MIN_SCALE = 0.3f;
     const float MAX_SCALE = 2.0f;
     ImGui::PushItemWidth(ImGui::GetFontSize() * 8);
-    ImGui::DragFloat("Font scale", &io.FontGlobalScale, 0.005f, MIN_SCALE, MAX_SCALE, "%.2f", ImGuiSliderFlags_AlwaysClamp);
+    float font_scale = gui_font_scale();
+    if(ImGui::DragFloat("Font scale", &font_scale, 0.005f, MIN_SCALE, MAX_SCALE, "%.2f", ImGuiSliderFlags_AlwaysClamp))
+        gui_set_font_scale(font_scale);
     ImGui::PopItemWidth();
     ImGui::ColorEdit3("Clear color", (float*)&st->clear_color);
     #ifdef QUICKGUI_WITH_DEMOS
@@ -298,22 +424,34 @@ void DynamicImage::set_name(const char *name)
     rhi_img.set_name(&rhi::g_rhi, name);
 }
 
-void DynamicImage::reset(uint32_t width, uint32_t height, VkFormat format)
+void DynamicImage::reset(uint32_t width, uint32_t height, VkFormat format, bool mipmaps)
 {
     rhi::ImageLayout layout = {};
     layout.width = width;
     layout.height = height;
     layout.format = format;
+    if(mipmaps)
+        (void)rhi::g_rhi.with_mips(&layout);
     rhi_img.reset(&rhi::g_rhi, layout.to_vk());
     flip_count = 0;
     for(size_t i : irange(RhiImage::num_entries))
         gui_img[i].load_existing(rhi_img.img_ids[i], g_gui_assets.default_sampler);
 }
 
+void DynamicImage::_reset_raw(uint32_t width, uint32_t height, rhi::compute_pipeline_id kernel, size_t raw_bytes)
+{
+    const rhi::ImageLayout layout = rhi::ImageLayout::make_2d(VK_FORMAT_R8G8B8A8_UNORM, width, height).with_storage();
+    rhi_img.reset_raw(&rhi::g_rhi, layout.to_vk(), kernel, raw_bytes);
+    flip_count = 0;
+    for(size_t i : irange(RhiImage::num_entries))
+        gui_img[i].load_existing(rhi_img.img_ids[i], g_gui_assets.default_sampler);
+}
+
 void DynamicImage::flip()
 {
     rhi_img.flip();
     ++flip_count;
+    gui_invalidate();
 }
 
 C4_SUPPRESS_WARNING_GCC_CLANG_POP
@@ -247,7 +247,22 @@ struct DynamicImage
     size_t flip_count = 0;
 public:
     void set_name(const char* name);
-    void reset(uint32_t width, uint32_t height, VkFormat format);
+    void reset(uint32_t width, uint32_t height, VkFormat format, bool mipmaps=false);
+    /** the frames are written raw, and converted to rgba8 on the GPU
+     * by @p kernel, eg g_gui_assets.kernels.yuv2rgb, with @p params:
+     *
+     *   img.reset_raw(w, h, g_gui_assets.kernels.yuv2rgb, rhi::Yuv2RgbParams::make_i420(w, h));
+     *   ...
+     *   img.rhi_img.finish_wcpu(read_frame(img.rhi_img.start_wcpu()));
+     *   img.flip();
+     */
+    template<class Params>
+    void reset_raw(uint32_t width, uint32_t height, rhi::compute_pipeline_id kernel, Params const& params)
+    {
+        _reset_raw(width, height, kernel, params.src_size());
+        rhi_img.set_kernel_params(params);
+    }
+    void _reset_raw(uint32_t width, uint32_t height, rhi::compute_pipeline_id kernel, size_t raw_bytes);
     bool ready_for_display() const { return flip_count > RhiImage::num_entries; }
     GuiAssets::Image      & curr_img()       { return gui_img[rhi_img.rgpu]; }
     GuiAssets::Image const& curr_img() const { return gui_img[rhi_img.rgpu]; }
@@ -267,6 +282,7 @@ namespace widgets {
 struct WidgetState
 {
     bool show_vulkan_window = false;
+    bool show_gpu_profiler_window = false;
     // VULKAN
     bool debug_vulkan = false;
     // DEMOS
@@ -374,6 +390,8 @@ struct ImgCanvasSizeWidgets
 
 
 void vulkan_window(WidgetState *st);
+/** GPU time of the debug marker regions, see rhi::gpu_profiler_regions() */
+void gpu_profiler_window(WidgetState *st);
 void events(WidgetState *st);
 
 void demo(WidgetState *st);
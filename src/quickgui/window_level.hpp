@@ -0,0 +1,85 @@
+#ifndef QUICKGUI_WINDOW_LEVEL_HPP_
+#define QUICKGUI_WINDOW_LEVEL_HPP_
+
+#include <cmath>
+#include <c4/error.hpp>
+#include <c4/span.hpp>
+#include "quickgui/color.hpp"
+
+namespace quickgui {
+
+/** maps the values of an image to display intensities: the values in
+ * the window [level - width/2, level + width/2] are spread over [0,1],
+ * clamping outside, and then raised to 1/gamma. */
+struct WindowLevel
+{
+    float level = 0.5f;
+    float width = 1.f;
+    float gamma = 1.f;
+
+public:
+
+    static WindowLevel from_range(float vmin, float vmax, float gamma=1.f)
+    {
+        return {0.5f * (vmin + vmax), vmax - vmin, gamma};
+    }
+    float vmin() const { return level - 0.5f * width; }
+    float vmax() const { return level + 0.5f * width; }
+
+    /** the coefficients of t = v * mul + add, before the clamping. The
+     * values may be given in other units than the window, eg as the
+     * normalized values sampled from a R16_UNORM texture, with
+     * value_scale the window value of v=1 (eg 65535). A window of
+     * width 0 becomes a step at the level. */
+    void linear(float value_scale, float *mul, float *add) const
+    {
+        const float w = std::fabs(width) > min_width ? width : min_width;
+        *mul = value_scale / w;
+        *add = 0.5f - level / w;
+    }
+    /** on the CPU, with the same arithmetic as the shader */
+    float map(float v) const
+    {
+        float mul, add;
+        linear(1.f, &mul, &add);
+        float t = v * mul + add;
+        t = t < 0.f ? 0.f : (t > 1.f ? 1.f : t);
+        return gamma == 1.f ? t : std::pow(t, 1.f / gamma);
+    }
+
+    static constexpr const float min_width = 1e-20f;
+};
+
+
+/** resample the colors of a palette (see palettes.hpp) into the
+ * entries of a color table, from the first color to the last. With
+ * interpolate, the colors are blended linearly between the palette
+ * colors; otherwise, each color is repeated over an equal share of
+ * the table, as suits categorical palettes. */
+inline void colormap_lut(c4::cspan<ucolor> colors, bool interpolate, c4::span<ucolor> lut)
+{
+    C4_CHECK(!colors.empty());
+    const size_t n = lut.size();
+    const size_t nc = colors.size();
+    for(size_t i = 0; i < n; ++i)
+    {
+        if(!interpolate || nc == 1 || n == 1)
+        {
+            lut[i] = colors[i * nc / n];
+            continue;
+        }
+        const float pos = (float)i * (float)(nc - 1) / (float)(n - 1);
+        size_t c = (size_t)pos;
+        if(c >= nc - 1)
+            c = nc - 2;
+        const float f = pos - (float)c;
+        ucolor const& a = colors[c];
+        ucolor const& b = colors[c + 1];
+        auto blend = [f](uint8_t x, uint8_t y){ return (uint8_t)((float)x + f * ((float)y - (float)x) + 0.5f); };
+        lut[i] = ucolor(blend(a.r, b.r), blend(a.g, b.g), blend(a.b, b.b), blend(a.a, b.a));
+    }
+}
+
+} // namespace quickgui
+
+#endif /* QUICKGUI_WINDOW_LEVEL_HPP_ */
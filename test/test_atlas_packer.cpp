@@ -0,0 +1,113 @@
+#include <quickgui/atlas_packer.hpp>
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+using namespace quickgui;
+
+namespace {
+/** whether the rects overlap, each with its padding around */
+bool overlap(AtlasRect const& a, AtlasRect const& b, uint32_t padding)
+{
+    if(a.layer != b.layer)
+        return false;
+    return a.x < b.x + b.width + 2 * padding && b.x < a.x + a.width + 2 * padding
+        && a.y < b.y + b.height + 2 * padding && b.y < a.y + a.height + 2 * padding;
+}
+} // namespace
+
+TEST_CASE("atlas_packer.fit")
+{
+    AtlasPacker packer;
+    packer.reset(64, 64, 2, 1);
+    std::vector<AtlasRect> rects;
+    const uint32_t sizes[][2] = {{10, 10}, {20, 8}, {5, 12}, {30, 30}, {7, 7}, {12, 3}, {40, 20}, {16, 16}};
+    for(auto const& sz : sizes)
+    {
+        AtlasRect r;
+        REQUIRE(packer.add(sz[0], sz[1], &r));
+        CHECK(r.width == sz[0]);
+        CHECK(r.height == sz[1]);
+        CHECK(r.layer < 2);
+        CHECK(r.x >= 1);
+        CHECK(r.y >= 1);
+        CHECK(r.x + r.width + 1 <= 64);
+        CHECK(r.y + r.height + 1 <= 64);
+        for(AtlasRect const& other : rects)
+            CHECK(!overlap(r, other, 1));
+        rects.push_back(r);
+    }
+}
+
+TEST_CASE("atlas_packer.padding")
+{
+    // the padded rects of neighbours do not share texels
+    AtlasPacker packer;
+    packer.reset(64, 64, 1, 2);
+    AtlasRect a, b;
+    REQUIRE(packer.add(10, 10, &a));
+    REQUIRE(packer.add(10, 10, &b));
+    CHECK(a.x == 2);
+    CHECK(a.y == 2);
+    CHECK(b.x == a.x + a.width + 4);
+    CHECK(b.y == a.y);
+    REQUIRE(packer.add(10, 30, &b)); // on a new shelf
+    CHECK(b.x == 2);
+    CHECK(b.y == a.y + a.height + 4);
+}
+
+TEST_CASE("atlas_packer.too_large")
+{
+    AtlasPacker packer;
+    packer.reset(32, 32, 1, 1);
+    AtlasRect r;
+    CHECK(!packer.add(31, 4, &r));
+    CHECK(!packer.add(4, 31, &r));
+    CHECK(!packer.add(0, 4, &r));
+    CHECK(packer.add(30, 30, &r));
+    CHECK(!packer.add(1, 1, &r)); // full
+}
+
+TEST_CASE("atlas_packer.reclaim")
+{
+    AtlasPacker packer;
+    packer.reset(32, 32, 1, 1);
+    AtlasRect a, b, c;
+    REQUIRE(packer.add(14, 30, &a));
+    REQUIRE(packer.add(14, 30, &b));
+    CHECK(!packer.add(14, 30, &c));
+    CHECK(packer.num_rects(0) == 2);
+    packer.remove(a);
+    CHECK(packer.num_rects(0) == 1);
+    CHECK(!packer.add(16, 30, &c)); // larger than the removed rect
+    REQUIRE(packer.add(10, 20, &c)); // reuses the removed rect
+    CHECK(c.x == a.x);
+    CHECK(c.y == a.y);
+    CHECK(c.width == 10);
+    CHECK(c.height == 20);
+    packer.remove(c);
+    packer.remove(b);
+    CHECK(packer.num_rects(0) == 0);
+    // the empty layer is reclaimed whole
+    CHECK(packer.add(30, 30, &c));
+    CHECK(c.x == 1);
+    CHECK(c.y == 1);
+}
+
+TEST_CASE("atlas_packer.reused_slot_keeps_its_size")
+{
+    AtlasPacker packer;
+    packer.reset(32, 32, 1, 1);
+    AtlasRect a, b, c;
+    REQUIRE(packer.add(14, 30, &a));
+    REQUIRE(packer.add(14, 30, &b));
+    packer.remove(a);
+    REQUIRE(packer.add(4, 4, &c)); // takes the slot of a
+    CHECK(c.x == a.x);
+    CHECK(c.y == a.y);
+    packer.remove(c);
+    // the whole slot is free again, not only 4x4
+    REQUIRE(packer.add(14, 30, &c));
+    CHECK(c.x == a.x);
+    CHECK(c.y == a.y);
+    CHECK(packer.num_rects(0) == 2);
+}
@@ -0,0 +1,70 @@
+#include <quickgui/compute_kernels.hpp>
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+using namespace quickgui::rhi;
+
+TEST_CASE("compute_kernels.num_groups")
+{
+    CHECK(compute_num_groups(0, 16) == 0);
+    CHECK(compute_num_groups(1, 16) == 1);
+    CHECK(compute_num_groups(15, 16) == 1);
+    CHECK(compute_num_groups(16, 16) == 1);
+    CHECK(compute_num_groups(17, 16) == 2);
+    CHECK(compute_num_groups(1920, 16) == 120);
+    CHECK(compute_num_groups(1080, 16) == 68);
+    CHECK(compute_num_groups(7, 1) == 7);
+    // the groups always cover the invocations, with less than a group in excess
+    for(uint32_t local : {1u, 8u, 16u, 32u})
+    {
+        for(uint32_t n = 1; n < 200; ++n)
+        {
+            const uint32_t g = compute_num_groups(n, local);
+            CHECK(g * local >= n);
+            CHECK((g - 1u) * local < n);
+        }
+    }
+}
+
+TEST_CASE("compute_kernels.convert_channels")
+{
+    const ConvertChannelsParams p = ConvertChannelsParams::make(5, 3, 3, ConvertChannelsParams::swap_rb);
+    CHECK(p.width == 5);
+    CHECK(p.height == 3);
+    CHECK(p.row_pitch == 15);
+    CHECK(p.num_channels == 3);
+    CHECK(p.flags == ConvertChannelsParams::swap_rb);
+    CHECK(p.src_size() == 45);
+    CHECK(sizeof(ConvertChannelsParams) == 5 * sizeof(uint32_t));
+}
+
+TEST_CASE("compute_kernels.yuv2rgb_i420")
+{
+    const Yuv2RgbParams p = Yuv2RgbParams::make_i420(6, 4, Yuv2RgbParams::nv12|Yuv2RgbParams::bt709);
+    CHECK(p.y_offset == 0);
+    CHECK(p.y_pitch == 6);
+    CHECK(p.u_offset == 24);
+    CHECK(p.v_offset == 24 + 6);
+    CHECK(p.uv_pitch == 3);
+    CHECK(p.flags == Yuv2RgbParams::bt709);
+    CHECK(p.src_size() == 24 + 6 + 6);
+    // odd sizes round the chroma planes up
+    const Yuv2RgbParams q = Yuv2RgbParams::make_i420(5, 3);
+    CHECK(q.uv_pitch == 3);
+    CHECK(q.u_offset == 15);
+    CHECK(q.v_offset == 15 + 6);
+    CHECK(q.src_size() == 15 + 6 + 6);
+}
+
+TEST_CASE("compute_kernels.yuv2rgb_nv12")
+{
+    const Yuv2RgbParams p = Yuv2RgbParams::make_nv12(6, 4);
+    CHECK(p.u_offset == 24);
+    CHECK(p.uv_pitch == 6);
+    CHECK((p.flags & Yuv2RgbParams::nv12) != 0);
+    CHECK(p.src_size() == 24 + 12);
+    const Yuv2RgbParams q = Yuv2RgbParams::make_nv12(5, 3);
+    CHECK(q.uv_pitch == 6);
+    CHECK(q.src_size() == 15 + 12);
+    CHECK(sizeof(Yuv2RgbParams) == 8 * sizeof(uint32_t));
+}
@@ -0,0 +1,111 @@
+#include <quickgui/font_cache.hpp>
+#include <quickgui/imgui.hpp>
+#include <cstring>
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+using namespace quickgui;
+
+TEST_CASE("font_cache.key")
+{
+    ImFontAtlas atlas;
+    const float scales[] = {1.f, 2.f};
+    FontAtlasSpec spec = {};
+    spec.scales = {scales, 2};
+    const uint64_t key = font_atlas_key(&atlas, spec);
+    CHECK(font_atlas_key(&atlas, spec) == key);
+    spec.size = 14.f;
+    CHECK(font_atlas_key(&atlas, spec) != key);
+    spec.size = 0.f;
+    spec.scales = {scales, 1};
+    CHECK(font_atlas_key(&atlas, spec) != key);
+    spec.scales = {scales, 2};
+    atlas.TexGlyphPadding += 1;
+    CHECK(font_atlas_key(&atlas, spec) != key);
+}
+
+TEST_CASE("font_cache.roundtrip")
+{
+    const float scales[] = {1.f, 1.5f};
+    FontAtlasSpec spec = {};
+    spec.scales = {scales, 2};
+    ImFontAtlas built;
+    font_atlas_build(&built, spec);
+    REQUIRE(built.Fonts.Size == 2);
+    const uint64_t key = font_atlas_key(&built, spec);
+    String data;
+    font_atlas_save(&built, key, &data);
+    //
+    ImFontAtlas loaded;
+    REQUIRE(font_atlas_load(&loaded, key, {data.data(), data.size()}));
+    CHECK(loaded.IsBuilt());
+    CHECK(loaded.TexWidth == built.TexWidth);
+    CHECK(loaded.TexHeight == built.TexHeight);
+    CHECK(memcmp(loaded.TexPixelsAlpha8, built.TexPixelsAlpha8, (size_t)built.TexWidth * (size_t)built.TexHeight) == 0);
+    REQUIRE(loaded.Fonts.Size == built.Fonts.Size);
+    for(int i = 0; i < built.Fonts.Size; ++i)
+    {
+        ImFont const* b = built.Fonts[i];
+        ImFont const* l = loaded.Fonts[i];
+        CHECK(l->FontSize == b->FontSize);
+        CHECK(l->Ascent == b->Ascent);
+        CHECK(l->Descent == b->Descent);
+        REQUIRE(l->Glyphs.Size == b->Glyphs.Size);
+        CHECK(l->IndexLookup.Size == b->IndexLookup.Size);
+        CHECK(l->FallbackChar == b->FallbackChar);
+        const ImFontGlyph *gb = b->FindGlyph((ImWchar)'A');
+        const ImFontGlyph *gl = l->FindGlyph((ImWchar)'A');
+        REQUIRE(gb != nullptr);
+        REQUIRE(gl != nullptr);
+        CHECK(gl->AdvanceX == gb->AdvanceX);
+        CHECK(gl->U0 == gb->U0);
+        CHECK(gl->V1 == gb->V1);
+    }
+    CHECK(loaded.Fonts[1]->FontSize == doctest::Approx(1.5f * loaded.Fonts[0]->FontSize));
+    // the custom rects, used eg to draw the mouse cursors
+    REQUIRE(loaded.CustomRects.Size == built.CustomRects.Size);
+    CHECK(loaded.PackIdMouseCursors == built.PackIdMouseCursors);
+    CHECK(loaded.PackIdLines == built.PackIdLines);
+    for(int i = 0; i < built.CustomRects.Size; ++i)
+    {
+        CHECK(loaded.CustomRects[i].X == built.CustomRects[i].X);
+        CHECK(loaded.CustomRects[i].Y == built.CustomRects[i].Y);
+        CHECK(loaded.CustomRects[i].Width == built.CustomRects[i].Width);
+        CHECK(loaded.CustomRects[i].Height == built.CustomRects[i].Height);
+        CHECK((loaded.CustomRects[i].Font == nullptr) == (built.CustomRects[i].Font == nullptr));
+    }
+    ImVec2 bofs, bsize, bborder[2], bfill[2];
+    ImVec2 lofs, lsize, lborder[2], lfill[2];
+    REQUIRE(built.GetMouseCursorTexData(ImGuiMouseCursor_Arrow, &bofs, &bsize, bborder, bfill));
+    REQUIRE(loaded.GetMouseCursorTexData(ImGuiMouseCursor_Arrow, &lofs, &lsize, lborder, lfill));
+    CHECK(lsize.x == bsize.x);
+    CHECK(lsize.y == bsize.y);
+    CHECK(lfill[0].x == bfill[0].x);
+    CHECK(lfill[0].y == bfill[0].y);
+}
+
+TEST_CASE("font_cache.rejects_invalid")
+{
+    FontAtlasSpec spec = {};
+    ImFontAtlas built;
+    font_atlas_build(&built, spec);
+    const uint64_t key = font_atlas_key(&built, spec);
+    String data;
+    font_atlas_save(&built, key, &data);
+    {
+        ImFontAtlas loaded;
+        CHECK_FALSE(font_atlas_load(&loaded, key + 1, {data.data(), data.size()}));
+        CHECK(loaded.Fonts.empty());
+    }
+    {
+        ImFontAtlas loaded;
+        CHECK_FALSE(font_atlas_load(&loaded, key, {data.data(), data.size() - 1}));
+        CHECK(loaded.Fonts.empty());
+        CHECK(loaded.TexPixelsAlpha8 == nullptr);
+    }
+    {
+        ImFontAtlas loaded;
+        CHECK_FALSE(font_atlas_load(&loaded, key, {data.data(), 16}));
+        CHECK(loaded.Fonts.empty());
+    }
+}
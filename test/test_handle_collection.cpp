@@ -0,0 +1,141 @@
+#include <quickgui/rhi.hpp>
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+struct DummyHandle
+{
+    int val = 0;
+    DummyHandle() = default;
+    DummyHandle(int v) : val(v) {}
+    operator bool () const { return val != 0; }
+};
+
+struct DummyCollection : public quickgui::rhi::HandleCollection<DummyHandle>
+{
+    id_type make(int val) { return add_handle(val); }
+    id_type reset(id_type id, int val) { id = reset_handle(id); get_handle(id).val = val; return id; }
+    void destroy(id_type id) { get_handle(id).val = 0; remove_handle(id); }
+    void destroy_all()
+    {
+        for_each_handle([](DummyHandle &h){ h.val = 0; });
+        clear_handles();
+    }
+    std::vector<int> live_values()
+    {
+        std::vector<int> vals;
+        for_each_handle([&](DummyHandle const& h){ vals.push_back(h.val); });
+        return vals;
+    }
+};
+using dummy_id = DummyCollection::id_type;
+
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+TEST_CASE("handle_collection.empty_id")
+{
+    DummyCollection coll;
+    dummy_id id;
+    CHECK(!id);
+    CHECK(!coll.is_valid(id));
+    CHECK(coll.num_handles() == 0);
+}
+
+TEST_CASE("handle_collection.create_destroy")
+{
+    DummyCollection coll;
+    dummy_id a = coll.make(1);
+    dummy_id b = coll.make(2);
+    dummy_id c = coll.make(3);
+    CHECK(a);
+    CHECK(coll.is_valid(a));
+    CHECK(coll.is_valid(b));
+    CHECK(coll.is_valid(c));
+    CHECK(a != b);
+    CHECK(b != c);
+    CHECK(coll.num_handles() == 3);
+    CHECK(coll.get_handle(a).val == 1);
+    CHECK(coll.get_handle(b).val == 2);
+    CHECK(coll.get_handle(c).val == 3);
+    coll.destroy(b);
+    CHECK(coll.num_handles() == 2);
+    CHECK(coll.is_valid(a));
+    CHECK(!coll.is_valid(b));
+    CHECK(coll.is_valid(c));
+    CHECK(coll.get_handle(a).val == 1);
+    CHECK(coll.get_handle(c).val == 3);
+    coll.destroy_all();
+    CHECK(coll.num_handles() == 0);
+    CHECK(!coll.is_valid(a));
+    CHECK(!coll.is_valid(c));
+}
+
+TEST_CASE("handle_collection.slot_reuse")
+{
+    DummyCollection coll;
+    dummy_id a = coll.make(1);
+    dummy_id b = coll.make(2);
+    coll.destroy(a);
+    dummy_id c = coll.make(3);
+    // the slot was reused: the storage did not grow
+    CHECK(coll.handles.size() == 2);
+    CHECK(coll.num_handles() == 2);
+    // ... but the stale id is detected
+    CHECK(!coll.is_valid(a));
+    CHECK(a != c);
+    CHECK(coll.is_valid(b));
+    CHECK(coll.is_valid(c));
+    CHECK(coll.get_handle(c).val == 3);
+    // many create/destroy cycles do not grow the storage
+    for(int i = 0; i < 100; ++i)
+        coll.destroy(coll.make(10 + i));
+    CHECK(coll.handles.size() == 3);
+    CHECK(coll.num_handles() == 2);
+    coll.destroy_all();
+}
+
+TEST_CASE("handle_collection.dense_iteration")
+{
+    DummyCollection coll;
+    dummy_id ids[5];
+    for(int i = 0; i < 5; ++i)
+        ids[i] = coll.make(i + 1);
+    CHECK(coll.live_values() == std::vector<int>{1, 2, 3, 4, 5});
+    coll.destroy(ids[1]);
+    CHECK(coll.live_values() == std::vector<int>{1, 5, 3, 4});
+    coll.destroy(ids[0]);
+    CHECK(coll.live_values() == std::vector<int>{4, 5, 3});
+    coll.destroy(ids[3]);
+    CHECK(coll.live_values() == std::vector<int>{3, 5});
+    dummy_id d = coll.make(6);
+    CHECK(coll.live_values() == std::vector<int>{3, 5, 6});
+    CHECK(coll.get_handle(d).val == 6);
+    coll.destroy_all();
+}
+
+TEST_CASE("handle_collection.reset")
+{
+    DummyCollection coll;
+    // a null id gets a new handle
+    dummy_id a = coll.reset({}, 1);
+    CHECK(coll.is_valid(a));
+    CHECK(coll.num_handles() == 1);
+    CHECK(coll.get_handle(a).val == 1);
+    // a valid id keeps its slot
+    dummy_id a2 = coll.reset(a, 2);
+    CHECK(a2 == a);
+    CHECK(coll.num_handles() == 1);
+    CHECK(coll.get_handle(a).val == 2);
+    CHECK(coll.get_handle_checked(a).val == 2);
+    coll.destroy(a);
+    CHECK(coll.num_handles() == 0);
+    // the released slot is handed out only once
+    dummy_id b = coll.make(3);
+    dummy_id c = coll.make(4);
+    CHECK(b != c);
+    CHECK(coll.handles.size() == 2);
+    CHECK(coll.free_slots.empty());
+    coll.destroy_all();
+}
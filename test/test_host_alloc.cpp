@@ -0,0 +1,131 @@
+#include <quickgui/rhi.hpp>
+#include <cstring>
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+using namespace quickgui::rhi;
+
+namespace {
+struct HostAllocScope
+{
+    VkAllocationCallbacks *cb;
+    HostAllocScope(size_t arena_size) : cb(host_alloc_init(arena_size)) {}
+    ~HostAllocScope() { host_alloc_terminate(); }
+    void* alloc(size_t size, size_t alignment, VkSystemAllocationScope scope) const
+    {
+        return cb->pfnAllocation(cb->pUserData, size, alignment, scope);
+    }
+    void* realloc(void *mem, size_t size, size_t alignment, VkSystemAllocationScope scope) const
+    {
+        return cb->pfnReallocation(cb->pUserData, mem, size, alignment, scope);
+    }
+    void free(void *mem) const { cb->pfnFree(cb->pUserData, mem); }
+};
+bool is_aligned(void const* mem, size_t alignment)
+{
+    return ((uintptr_t)mem % alignment) == 0;
+}
+} // namespace
+
+TEST_CASE("host_alloc.counts")
+{
+    HostAllocScope h(0);
+    CHECK(host_alloc_enabled());
+    void *a = h.alloc(100, 8, VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
+    void *b = h.alloc(50, 8, VK_SYSTEM_ALLOCATION_SCOPE_DEVICE);
+    REQUIRE(a != nullptr);
+    REQUIRE(b != nullptr);
+    HostAllocStats obj = host_alloc_stats(VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
+    CHECK(obj.num_allocs == 1);
+    CHECK(obj.num_frees == 0);
+    CHECK(obj.bytes == 100);
+    CHECK(obj.peak_bytes == 100);
+    HostAllocStats all = host_alloc_stats(VK_SYSTEM_ALLOCATION_SCOPE_MAX_ENUM);
+    CHECK(all.num_allocs == 2);
+    CHECK(all.bytes == 150);
+    h.free(a);
+    h.free(b);
+    h.free(nullptr);
+    obj = host_alloc_stats(VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
+    CHECK(obj.num_frees == 1);
+    CHECK(obj.bytes == 0);
+    CHECK(obj.peak_bytes == 100);
+    all = host_alloc_stats(VK_SYSTEM_ALLOCATION_SCOPE_MAX_ENUM);
+    CHECK(all.num_frees == 2);
+    CHECK(all.bytes == 0);
+    // the driver's own allocations are only notified
+    h.cb->pfnInternalAllocation(h.cb->pUserData, 32, VK_INTERNAL_ALLOCATION_TYPE_EXECUTABLE, VK_SYSTEM_ALLOCATION_SCOPE_CACHE);
+    CHECK(host_alloc_stats(VK_SYSTEM_ALLOCATION_SCOPE_CACHE).bytes == 32);
+    h.cb->pfnInternalFree(h.cb->pUserData, 32, VK_INTERNAL_ALLOCATION_TYPE_EXECUTABLE, VK_SYSTEM_ALLOCATION_SCOPE_CACHE);
+    CHECK(host_alloc_stats(VK_SYSTEM_ALLOCATION_SCOPE_CACHE).bytes == 0);
+}
+
+TEST_CASE("host_alloc.realloc")
+{
+    HostAllocScope h(0);
+    char *a = (char*)h.alloc(16, 16, VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
+    REQUIRE(a != nullptr);
+    memcpy(a, "0123456789abcde", 16);
+    char *b = (char*)h.realloc(a, 1000, 128, VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
+    REQUIRE(b != nullptr);
+    CHECK(is_aligned(b, 128));
+    CHECK(memcmp(b, "0123456789abcde", 16) == 0);
+    CHECK(host_alloc_stats(VK_SYSTEM_ALLOCATION_SCOPE_OBJECT).bytes == 1000);
+    CHECK(h.realloc(b, 0, 16, VK_SYSTEM_ALLOCATION_SCOPE_OBJECT) == nullptr);
+    CHECK(host_alloc_stats(VK_SYSTEM_ALLOCATION_SCOPE_OBJECT).bytes == 0);
+}
+
+TEST_CASE("host_alloc.alignment")
+{
+    for(size_t arena_size : {size_t(0), size_t(1) << 16})
+    {
+        HostAllocScope h(arena_size);
+        for(VkSystemAllocationScope scope : {VK_SYSTEM_ALLOCATION_SCOPE_COMMAND, VK_SYSTEM_ALLOCATION_SCOPE_OBJECT})
+        {
+            void *mem[10];
+            size_t alignment = 1;
+            for(void *&m : mem)
+            {
+                m = h.alloc(24, alignment, scope);
+                REQUIRE(m != nullptr);
+                CHECK_MESSAGE(is_aligned(m, alignment), "alignment=" << alignment << " arena=" << arena_size);
+                alignment *= 2;
+            }
+            for(void *m : mem)
+                h.free(m);
+        }
+        CHECK(host_alloc_stats(VK_SYSTEM_ALLOCATION_SCOPE_MAX_ENUM).bytes == 0);
+    }
+}
+
+TEST_CASE("host_alloc.arena")
+{
+    HostAllocScope h(1024);
+    const uint64_t hits = host_alloc_arena_hits();
+    void *a = h.alloc(100, 8, VK_SYSTEM_ALLOCATION_SCOPE_COMMAND);
+    CHECK(host_alloc_arena_hits() == hits + 1);
+    // only the transient allocations use the arena
+    void *b = h.alloc(100, 8, VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
+    CHECK(host_alloc_arena_hits() == hits + 1);
+    // the alignments over the arena's go to the heap
+    void *c = h.alloc(100, 256, VK_SYSTEM_ALLOCATION_SCOPE_COMMAND);
+    CHECK(is_aligned(c, 256));
+    CHECK(host_alloc_arena_hits() == hits + 1);
+    // as do those not fitting
+    void *d = h.alloc(2000, 8, VK_SYSTEM_ALLOCATION_SCOPE_COMMAND);
+    CHECK(host_alloc_arena_hits() == hits + 1);
+    void *e = h.alloc(100, 64, VK_SYSTEM_ALLOCATION_SCOPE_COMMAND);
+    CHECK(is_aligned(e, 64));
+    CHECK(host_alloc_arena_hits() == hits + 2);
+    CHECK(host_alloc_stats(VK_SYSTEM_ALLOCATION_SCOPE_COMMAND).bytes == 2300);
+    for(void *m : {a, b, c, d, e})
+        h.free(m);
+    CHECK(host_alloc_stats(VK_SYSTEM_ALLOCATION_SCOPE_MAX_ENUM).bytes == 0);
+    // the arena is rewound once all its allocations are freed
+    for(int i = 0; i < 20; ++i)
+    {
+        void *f = h.alloc(500, 16, VK_SYSTEM_ALLOCATION_SCOPE_COMMAND);
+        h.free(f);
+    }
+    CHECK(host_alloc_arena_hits() == hits + 22);
+}
@@ -0,0 +1,75 @@
+#include <quickgui/mpsc_queue.hpp>
+#include <thread>
+#include <vector>
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+using namespace quickgui;
+
+TEST_CASE("mpsc_queue.single_thread")
+{
+    mpsc_queue<int> q;
+    int val = -1;
+    CHECK(q.empty());
+    CHECK_FALSE(q.pop(&val));
+    CHECK(val == -1);
+    q.push(1);
+    q.push(2);
+    q.push(3);
+    CHECK_FALSE(q.empty());
+    REQUIRE(q.pop(&val));
+    CHECK(val == 1);
+    REQUIRE(q.pop(&val));
+    CHECK(val == 2);
+    q.push(4);
+    REQUIRE(q.pop(&val));
+    CHECK(val == 3);
+    REQUIRE(q.pop(&val));
+    CHECK(val == 4);
+    CHECK_FALSE(q.pop(&val));
+    CHECK(q.empty());
+}
+
+TEST_CASE("mpsc_queue.destroy_nonempty")
+{
+    mpsc_queue<std::vector<int>> q;
+    q.push({1, 2, 3});
+    q.push({4, 5});
+}
+
+TEST_CASE("mpsc_queue.multiple_producers")
+{
+    const int num_producers = 4;
+    const int num_values = 10000;
+    mpsc_queue<int> q;
+    std::vector<std::thread> producers;
+    for(int p = 0; p < num_producers; ++p)
+    {
+        producers.emplace_back([&q, p]{
+            for(int i = 0; i < num_values; ++i)
+                q.push(p * num_values + i);
+        });
+    }
+    // the values of each producer arrive in order
+    std::vector<int> next(num_producers, 0);
+    int count = 0;
+    while(count < num_producers * num_values)
+    {
+        int val;
+        if(!q.pop(&val))
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        const int p = val / num_values;
+        REQUIRE(p < num_producers);
+        CHECK(val % num_values == next[(size_t)p]);
+        ++next[(size_t)p];
+        ++count;
+    }
+    for(std::thread &t : producers)
+        t.join();
+    CHECK(q.empty());
+    for(int n : next)
+        CHECK(n == num_values);
+}
@@ -0,0 +1,198 @@
+#include <quickgui/overlay_canvas.hpp>
+#include <quickgui/primitive_draw_list.hpp>
+#include <quickgui/imgui.hpp>
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+using namespace quickgui;
+
+namespace {
+/** a frame of a headless imgui context, to get a draw list */
+struct ImGuiFrame
+{
+    ImGuiFrame()
+    {
+        ImGui::CreateContext();
+        ImGuiIO &io = ImGui::GetIO();
+        io.DisplaySize = ImVec2(640.f, 480.f);
+        io.DeltaTime = 1.f / 60.f;
+        io.Fonts->Build();
+        ImGui::NewFrame();
+    }
+    ~ImGuiFrame()
+    {
+        ImGui::EndFrame();
+        ImGui::DestroyContext();
+    }
+};
+
+struct Counts
+{
+    int num_vtx, num_idx;
+    ImDrawVert const* vtx; ///< the first vertex written
+};
+Counts draw(PrimitiveDrawList const& prims, ImVec2 subject_size, ImVec2 canvas_pos, ImVec2 canvas_size)
+{
+    ImDrawList *dl = ImGui::GetForegroundDrawList();
+    const int vtx0 = dl->VtxBuffer.Size;
+    const int idx0 = dl->IdxBuffer.Size;
+    const unsigned int curr0 = dl->_VtxCurrentIdx;
+    OverlayCanvas canvas;
+    canvas.draw(prims, subject_size, canvas_pos, canvas_size, dl);
+    const Counts c = {dl->VtxBuffer.Size - vtx0, dl->IdxBuffer.Size - idx0, dl->VtxBuffer.Data + vtx0};
+    // the indices refer to the vertices just written
+    for(int i = idx0; i < dl->IdxBuffer.Size; ++i)
+    {
+        CHECK(dl->IdxBuffer[i] >= curr0);
+        CHECK(dl->IdxBuffer[i] < curr0 + (unsigned)c.num_vtx);
+    }
+    return c;
+}
+Counts draw(PrimitiveDrawList const& prims)
+{
+    return draw(prims, ImVec2(100.f, 100.f), ImVec2(0.f, 0.f), ImVec2(100.f, 100.f));
+}
+void check_pos(ImVec2 pos, float x, float y)
+{
+    CHECK(pos.x == doctest::Approx(x));
+    CHECK(pos.y == doctest::Approx(y));
+}
+void check_pos(ImDrawVert const& v, float x, float y)
+{
+    check_pos(v.pos, x, y);
+}
+} // namespace
+
+TEST_CASE("overlay_canvas.num_vertices")
+{
+    ImGuiFrame frame;
+    const ucolor col(255, 0, 0);
+    SUBCASE("point")
+    {
+        PrimitiveDrawList prims;
+        prims.draw_point({50.f, 50.f}, col, 1.f);
+        const Counts c = draw(prims);
+        CHECK(c.num_vtx == 16);
+        CHECK(c.num_idx == 36);
+    }
+    SUBCASE("line")
+    {
+        PrimitiveDrawList prims;
+        prims.draw_line({10.f, 10.f}, {90.f, 20.f}, col, 1.f);
+        const Counts c = draw(prims);
+        CHECK(c.num_vtx == 4);
+        CHECK(c.num_idx == 6);
+    }
+    SUBCASE("rect")
+    {
+        PrimitiveDrawList prims;
+        prims.draw_rect({10.f, 10.f, 90.f, 20.f}, col, 1.f);
+        const Counts c = draw(prims);
+        CHECK(c.num_vtx == 8);
+        CHECK(c.num_idx == 24);
+    }
+    SUBCASE("rect_filled")
+    {
+        PrimitiveDrawList prims;
+        prims.draw_rect_filled({10.f, 10.f, 90.f, 20.f}, col, 1.f);
+        const Counts c = draw(prims);
+        CHECK(c.num_vtx == 4);
+        CHECK(c.num_idx == 6);
+    }
+    SUBCASE("run")
+    {
+        // one reservation for the consecutive quads primitives
+        PrimitiveDrawList prims;
+        prims.draw_point({50.f, 50.f}, col, 1.f);
+        prims.draw_line({10.f, 10.f}, {90.f, 20.f}, col, 1.f);
+        prims.draw_rect({10.f, 10.f, 90.f, 20.f}, col, 1.f);
+        prims.draw_rect_filled({10.f, 10.f, 90.f, 20.f}, col, 1.f);
+        const Counts c = draw(prims);
+        CHECK(c.num_vtx == 16 + 4 + 8 + 4);
+        CHECK(c.num_idx == 36 + 6 + 24 + 6);
+    }
+}
+
+TEST_CASE("overlay_canvas.transform")
+{
+    ImGuiFrame frame;
+    const ucolor col(255, 0, 0);
+    // subject to canvas: scale 2, offset (10,20)
+    const ImVec2 subject_size = {100.f, 50.f};
+    const ImVec2 canvas_pos = {10.f, 20.f};
+    const ImVec2 canvas_size = {200.f, 100.f};
+    SUBCASE("rect_filled")
+    {
+        PrimitiveDrawList prims;
+        prims.draw_rect_filled({5.f, 5.f, 15.f, 10.f}, col, 1.f);
+        const Counts c = draw(prims, subject_size, canvas_pos, canvas_size);
+        REQUIRE(c.num_vtx == 4);
+        check_pos(c.vtx[0], 20.f, 30.f);
+        check_pos(c.vtx[1], 40.f, 30.f);
+        check_pos(c.vtx[2], 40.f, 40.f);
+        check_pos(c.vtx[3], 20.f, 40.f);
+    }
+    SUBCASE("line")
+    {
+        // horizontal, 2 pixels thick: the quad spans 1 pixel on each
+        // side, centered on the pixels
+        PrimitiveDrawList prims;
+        prims.draw_line({0.f, 0.f}, {10.f, 0.f}, col, 2.f);
+        const Counts c = draw(prims, subject_size, canvas_pos, canvas_size);
+        REQUIRE(c.num_vtx == 4);
+        check_pos(c.vtx[0], 10.5f, 21.5f);
+        check_pos(c.vtx[1], 30.5f, 21.5f);
+        check_pos(c.vtx[2], 30.5f, 19.5f);
+        check_pos(c.vtx[3], 10.5f, 19.5f);
+    }
+    SUBCASE("rect")
+    {
+        // the ring, as AddRect() with a thickness of 1
+        PrimitiveDrawList prims;
+        prims.draw_rect({0.f, 0.f, 5.f, 5.f}, col, 1.f);
+        const Counts c = draw(prims, subject_size, canvas_pos, canvas_size);
+        REQUIRE(c.num_vtx == 8);
+        check_pos(c.vtx[0], 10.f, 20.f); // outer
+        check_pos(c.vtx[2], 20.f, 30.f);
+        check_pos(c.vtx[4], 11.f, 21.f); // inner
+        check_pos(c.vtx[6], 19.f, 29.f);
+    }
+    SUBCASE("odd_number_of_points")
+    {
+        // the points are transformed two at a time, and the last alone
+        PrimitiveDrawList prims;
+        prims.draw_line({0.f, 0.f}, {10.f, 0.f}, col, 2.f);
+        prims.draw_rect_filled({5.f, 5.f, 15.f, 10.f}, col, 1.f);
+        prims.draw_rect_filled({1.f, 2.f, 1.f, 2.f}, col, 1.f);
+        prims.draw_point({5.f, 5.f}, col, 1.f);
+        const Counts c = draw(prims, subject_size, canvas_pos, canvas_size);
+        REQUIRE(c.num_vtx == 4 + 4 + 4 + 16);
+        check_pos(c.vtx[4], 20.f, 30.f);
+        check_pos(c.vtx[6], 40.f, 40.f);
+        check_pos(c.vtx[8], 12.f, 24.f);
+        // the center of the marker, from its diagonals
+        ImDrawVert const* diag = c.vtx + 12 + 8;
+        check_pos(ImVec2(0.5f * (diag[0].pos.x + diag[2].pos.x), 0.5f * (diag[0].pos.y + diag[2].pos.y)), 20.5f, 30.5f);
+    }
+}
+
+TEST_CASE("overlay_canvas.poly")
+{
+    ImGuiFrame frame;
+    const ucolor col(255, 0, 0);
+    PrimitiveDrawList prims;
+    prims.draw_point({50.f, 50.f}, col, 1.f);
+    ImVec2 *pts = prims.draw_poly(3, col, 1.f);
+    pts[0] = {10.f, 10.f};
+    pts[1] = {90.f, 10.f};
+    pts[2] = {50.f, 90.f};
+    prims.draw_point({50.f, 50.f}, col, 1.f);
+    REQUIRE(prims.m_primitives.size() == 3);
+    CHECK(prims.m_primitives[1].type == PrimitiveDrawList::poly);
+    CHECK(prims.m_primitives[1].poly.first_point == 0);
+    CHECK(prims.m_primitives[1].poly.num_points == 3);
+    // the polyline goes through the draw list, between the markers
+    const Counts c = draw(prims);
+    CHECK(c.num_vtx > 2 * 16);
+    CHECK(c.num_idx > 2 * 36);
+}
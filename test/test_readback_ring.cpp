@@ -0,0 +1,66 @@
+#include <quickgui/rhi.hpp>
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+using Ring = quickgui::rhi::ReadbackRing<3>;
+
+TEST_CASE("readback_ring.start")
+{
+    Ring ring;
+    CHECK(ring.oldest_pending() == 3);
+    CHECK(ring.start() == 0);
+    CHECK(ring.start() == 1);
+    CHECK(ring.start() == 2);
+    CHECK(ring.requests[0] == 0);
+    CHECK(ring.requests[1] == 1);
+    CHECK(ring.requests[2] == 2);
+    CHECK(ring.pending(0));
+    CHECK(ring.pending(2));
+    // all in flight: the request is dropped, and does not take a number
+    CHECK(ring.start() == 3);
+    CHECK(ring.num_requests == 3);
+    CHECK(ring.oldest_pending() == 0);
+}
+
+TEST_CASE("readback_ring.complete_in_order")
+{
+    Ring ring;
+    (void)ring.start();
+    (void)ring.start();
+    CHECK(ring.oldest_pending() == 0);
+    ring.complete(0);
+    CHECK(!ring.pending(0));
+    CHECK(ring.oldest_pending() == 1);
+    // a held entry is not reused
+    CHECK(ring.start() == 2);
+    ring.complete(1);
+    CHECK(ring.oldest_pending() == 2);
+    CHECK(ring.start() == 3);
+    ring.release(0, 0);
+    // the freed entry is reused with a newer request
+    CHECK(ring.start() == 0);
+    CHECK(ring.requests[0] == 3);
+    // which is not the oldest
+    CHECK(ring.oldest_pending() == 2);
+    ring.complete(2);
+    CHECK(ring.oldest_pending() == 0);
+    ring.release(1, 1);
+    ring.release(2, 2);
+    ring.complete(0);
+    ring.release(0, 3);
+    CHECK(ring.oldest_pending() == 3);
+    for(uint32_t e = 0; e < 3; ++e)
+        CHECK(ring.states[e] == Ring::entry_free);
+}
+
+TEST_CASE("readback_ring.clear")
+{
+    Ring ring;
+    (void)ring.start();
+    (void)ring.start();
+    ring.complete(0);
+    ring.clear();
+    CHECK(ring.num_requests == 0);
+    CHECK(ring.oldest_pending() == 3);
+    CHECK(ring.start() == 0);
+}
@@ -0,0 +1,198 @@
+#include <quickgui/tiff.hpp>
+#include <algorithm>
+#include <cstring>
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+using namespace quickgui;
+
+namespace {
+
+/** writes classic TIFF files, with one strip or tile per block */
+struct TiffWriter
+{
+    bool big_endian;
+    std::vector<char> out;
+    struct Entry { uint16_t tag, type; std::vector<uint32_t> values; };
+
+    void put(uint64_t val, size_t size, size_t pos)
+    {
+        for(size_t i = 0; i < size; ++i)
+        {
+            const size_t shift = 8u * (big_endian ? size - 1u - i : i);
+            out[pos + i] = (char)((val >> shift) & 0xffu);
+        }
+    }
+    size_t append(uint64_t val, size_t size)
+    {
+        const size_t pos = out.size();
+        out.resize(pos + size);
+        put(val, size, pos);
+        return pos;
+    }
+    void header()
+    {
+        out.clear();
+        out.push_back(big_endian ? 'M' : 'I');
+        out.push_back(big_endian ? 'M' : 'I');
+        append(42, 2);
+        append(0, 4); // first directory, patched by page()
+    }
+    /** the blocks are already encoded */
+    void page(std::vector<Entry> entries, std::vector<std::vector<char>> const& blocks, uint16_t offsets_tag, uint16_t counts_tag, size_t prev_next_pos)
+    {
+        Entry offsets{offsets_tag, 4, {}};
+        Entry counts{counts_tag, 4, {}};
+        for(auto const& b : blocks)
+        {
+            offsets.values.push_back((uint32_t)out.size());
+            counts.values.push_back((uint32_t)b.size());
+            out.insert(out.end(), b.begin(), b.end());
+        }
+        entries.push_back(offsets);
+        entries.push_back(counts);
+        std::sort(entries.begin(), entries.end(), [](Entry const& a, Entry const& b){ return a.tag < b.tag; });
+        // out-of-line values
+        std::vector<size_t> value_pos;
+        for(Entry const& e : entries)
+        {
+            const size_t tsize = e.type == 3 ? 2u : 4u;
+            if(e.values.size() * tsize <= 4)
+            {
+                value_pos.push_back(0);
+                continue;
+            }
+            value_pos.push_back(out.size());
+            for(uint32_t v : e.values)
+                append(v, tsize);
+        }
+        if(out.size() & 1u)
+            out.push_back(0);
+        put(out.size(), 4, prev_next_pos);
+        append(entries.size(), 2);
+        for(size_t i = 0; i < entries.size(); ++i)
+        {
+            Entry const& e = entries[i];
+            const size_t tsize = e.type == 3 ? 2u : 4u;
+            append(e.tag, 2);
+            append(e.type, 2);
+            append(e.values.size(), 4);
+            if(value_pos[i])
+            {
+                append(value_pos[i], 4);
+                continue;
+            }
+            const size_t pos = append(0, 4);
+            for(size_t j = 0; j < e.values.size(); ++j)
+                put(e.values[j], tsize, pos + j * tsize);
+        }
+        next_pos = append(0, 4);
+    }
+    size_t next_pos = 4;
+};
+
+std::vector<char> encode_u16(std::vector<uint16_t> const& vals, bool big_endian)
+{
+    std::vector<char> ret;
+    for(uint16_t v : vals)
+    {
+        const char lo = (char)(v & 0xffu), hi = (char)(v >> 8u);
+        ret.push_back(big_endian ? hi : lo);
+        ret.push_back(big_endian ? lo : hi);
+    }
+    return ret;
+}
+
+} // namespace
+
+
+TEST_CASE("tiff.strips_u16")
+{
+    // a 3x3 16-bit stack of two pages, in strips of 2 rows
+    for(bool big_endian : {false, true})
+    {
+        TiffWriter w{big_endian, {}};
+        w.header();
+        for(uint16_t p = 0; p < 2; ++p)
+        {
+            std::vector<uint16_t> px(9);
+            for(uint16_t i = 0; i < 9; ++i)
+                px[i] = (uint16_t)(1000 * p + 257 * i);
+            std::vector<std::vector<char>> strips = {
+                encode_u16({px.begin(), px.begin() + 6}, big_endian),
+                encode_u16({px.begin() + 6, px.end()}, big_endian),
+            };
+            w.page({{256, 3, {3}}, {257, 3, {3}}, {258, 3, {16}}, {259, 3, {1}}, {277, 3, {1}}, {278, 3, {2}}},
+                   strips, 273, 279, w.next_pos);
+        }
+        TiffFile tif;
+        REQUIRE_MESSAGE(tif.open(ccharspan{w.out.data(), w.out.size()}), tif.error());
+        REQUIRE(tif.pages.size() == 2);
+        TiffPage const& p = tif.pages[1];
+        CHECK(p.width == 3);
+        CHECK(p.height == 3);
+        CHECK(p.data_type() == imgviewtype::u16);
+        CHECK(p.num_bytes() == 18);
+        std::vector<uint16_t> px(9);
+        REQUIRE(tif.read_page(1, (char*)px.data()));
+        for(uint16_t i = 0; i < 9; ++i)
+            CHECK(px[i] == 1000 + 257 * i);
+    }
+}
+
+TEST_CASE("tiff.tiles_rgb8")
+{
+    // a 5x3 RGB image in 4x4 tiles, padded at the border
+    TiffWriter w{false, {}};
+    w.header();
+    auto value = [](uint32_t x, uint32_t y, uint32_t c){ return (char)(x * 30 + y * 7 + c); };
+    std::vector<std::vector<char>> tiles;
+    for(uint32_t tx = 0; tx < 2; ++tx)
+    {
+        std::vector<char> tile(4 * 4 * 3, (char)0x55);
+        for(uint32_t y = 0; y < 3; ++y)
+            for(uint32_t x = 0; x < 4 && tx * 4 + x < 5; ++x)
+                for(uint32_t c = 0; c < 3; ++c)
+                    tile[(y * 4 + x) * 3 + c] = value(tx * 4 + x, y, c);
+        tiles.push_back(tile);
+    }
+    w.page({{256, 3, {5}}, {257, 3, {3}}, {258, 3, {8, 8, 8}}, {259, 3, {1}}, {277, 3, {3}}, {322, 3, {4}}, {323, 3, {4}}},
+           tiles, 324, 325, w.next_pos);
+    TiffFile tif;
+    REQUIRE_MESSAGE(tif.open(ccharspan{w.out.data(), w.out.size()}), tif.error());
+    REQUIRE(tif.pages.size() == 1);
+    CHECK(tif.pages[0].samples_per_pixel == 3);
+    std::vector<char> px(5 * 3 * 3);
+    REQUIRE(tif.read_page(0, px.data()));
+    for(uint32_t y = 0; y < 3; ++y)
+        for(uint32_t x = 0; x < 5; ++x)
+            for(uint32_t c = 0; c < 3; ++c)
+                CHECK(px[(y * 5 + x) * 3 + c] == value(x, y, c));
+}
+
+TEST_CASE("tiff.packbits")
+{
+    // 8 bytes: a literal run of 3, and a repeat of 5
+    TiffWriter w{false, {}};
+    w.header();
+    const std::vector<char> strip = {2, 1, 2, 3, -4, 9};
+    w.page({{256, 3, {4}}, {257, 3, {2}}, {258, 3, {8}}, {259, 3, {32773}}}, {strip}, 273, 279, w.next_pos);
+    TiffFile tif;
+    REQUIRE_MESSAGE(tif.open(ccharspan{w.out.data(), w.out.size()}), tif.error());
+    char px[8] = {};
+    REQUIRE(tif.read_page(0, px));
+    const char expected[8] = {1, 2, 3, 9, 9, 9, 9, 9};
+    CHECK(memcmp(px, expected, 8) == 0);
+}
+
+TEST_CASE("tiff.unsupported")
+{
+    TiffWriter w{false, {}};
+    w.header();
+    w.page({{256, 3, {4}}, {257, 3, {2}}, {258, 3, {8}}, {259, 3, {5}}}, {{0}}, 273, 279, w.next_pos); // LZW
+    TiffFile tif;
+    CHECK(!tif.open(ccharspan{w.out.data(), w.out.size()}));
+    CHECK(tif.pages.empty());
+    const char garbage[] = "not a tiff";
+    CHECK(!tif.open(ccharspan{garbage, sizeof(garbage)}));
+}
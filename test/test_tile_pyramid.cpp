@@ -0,0 +1,86 @@
+#include <quickgui/tile_pyramid.hpp>
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+using namespace quickgui;
+
+TEST_CASE("tile_pyramid.levels")
+{
+    TilePyramid p;
+    p.reset(1000, 300, 256);
+    CHECK(p.num_levels == 3);
+    CHECK(p.level_width(0) == 1000);
+    CHECK(p.level_width(1) == 500);
+    CHECK(p.level_width(2) == 250);
+    CHECK(p.level_height(2) == 75);
+    CHECK(p.num_tiles_x(0) == 4);
+    CHECK(p.num_tiles_y(0) == 2);
+    CHECK(p.num_tiles_x(2) == 1);
+    CHECK(p.num_tiles_y(2) == 1);
+    uint64_t x, y;
+    uint32_t w, h;
+    p.tile_rect({0, 3, 1}, &x, &y, &w, &h);
+    CHECK(x == 768);
+    CHECK(y == 256);
+    CHECK(w == 232);
+    CHECK(h == 44);
+    p.reset(100, 100, 256);
+    CHECK(p.num_levels == 1);
+    p.reset(uint64_t(1) << 20, uint64_t(1) << 19, 256);
+    CHECK(p.num_levels == 13);
+}
+
+TEST_CASE("tile_pyramid.key")
+{
+    const TileKey k = {5, 123456, 654321};
+    CHECK(TileKey::unpack(k.packed()) == k);
+    CHECK((TilePyramid::parent(k) == TileKey{6, 61728, 327160}));
+}
+
+TEST_CASE("tile_pyramid.level_for_scale")
+{
+    TilePyramid p;
+    p.reset(1 << 16, 1 << 16, 256);
+    CHECK(p.num_levels == 9);
+    CHECK(p.level_for_scale(4.0) == 0);
+    CHECK(p.level_for_scale(1.0) == 0);
+    CHECK(p.level_for_scale(0.6) == 0);
+    CHECK(p.level_for_scale(0.5) == 1);
+    CHECK(p.level_for_scale(0.3) == 1);
+    CHECK(p.level_for_scale(0.25) == 2);
+    CHECK(p.level_for_scale(1.0 / 1024.0) == 8); // clamped to the coarsest
+}
+
+TEST_CASE("tile_pyramid.visible_tiles")
+{
+    TilePyramid p;
+    p.reset(2048, 1024, 256);
+    std::vector<TileKey> tiles;
+    p.visible_tiles(0, 300, 10, 700, 260, &tiles);
+    REQUIRE(tiles.size() == 4);
+    CHECK((tiles.front() == TileKey{0, 1, 0}));
+    CHECK((tiles.back() == TileKey{0, 2, 1}));
+    tiles.clear();
+    p.visible_tiles(1, -500, -500, 5000, 5000, &tiles); // clamped
+    CHECK(tiles.size() == 4 * 2);
+    tiles.clear();
+    p.visible_tiles(0, 3000, 0, 4000, 100, &tiles); // outside
+    CHECK(tiles.empty());
+}
+
+TEST_CASE("tile_pyramid.downsample")
+{
+    const uint8_t src[3 * 3 * 4] = {
+        0, 0, 0, 0,     4, 4, 4, 4,     8, 8, 8, 8,
+        4, 4, 4, 4,     8, 8, 8, 8,     16, 16, 16, 16,
+        100, 0, 0, 255, 100, 0, 0, 255, 1, 2, 3, 4,
+    };
+    uint8_t dst[2 * 2 * 4] = {};
+    tile_pyramid_downsample_rgba8(src, 3, 3, dst);
+    CHECK(dst[0] == 4);  // (0+4+4+8)/4
+    CHECK(dst[4] == 12); // (8+8+16+16)/4
+    CHECK(dst[8] == 100);
+    CHECK(dst[11] == 255);
+    CHECK(dst[12] == 1);
+    CHECK(dst[15] == 4);
+}
@@ -0,0 +1,24 @@
+#include <quickgui/time.hpp>
+#include <cstdlib>
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+using namespace quickgui;
+
+TEST_CASE("from_hz")
+{
+    CHECK(from_hz(1.0) == secs(1));
+    CHECK(from_hz(2.0) == msecs(500));
+    CHECK(from_hz(1000.0) == msecs(1));
+    CHECK(std::abs((from_hz(60.0) - sixty_hz).count()) <= 1);
+    CHECK(std::abs((from_hz(30.f) - thirty_hz).count()) <= 8); // float precision
+    // less than one hertz
+    CHECK(from_hz(0.5) == secs(2));
+}
+
+TEST_CASE("to_hz")
+{
+    CHECK(to_hz<double>(secs(1)) == doctest::Approx(1.0));
+    CHECK(to_hz<double>(msecs(1)) == doctest::Approx(1000.0));
+    CHECK(to_hz<double>(from_hz(144.0)) == doctest::Approx(144.0).epsilon(1e-6));
+}
@@ -0,0 +1,56 @@
+#include <quickgui/window_level.hpp>
+#include <quickgui/palettes.hpp>
+#include <vector>
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+using namespace quickgui;
+
+TEST_CASE("window_level.map")
+{
+    const WindowLevel wl = WindowLevel::from_range(1000.f, 3000.f);
+    CHECK(wl.level == 2000.f);
+    CHECK(wl.width == 2000.f);
+    CHECK(wl.map(0.f) == 0.f);
+    CHECK(wl.map(1000.f) == doctest::Approx(0.f));
+    CHECK(wl.map(1500.f) == doctest::Approx(0.25f));
+    CHECK(wl.map(3000.f) == doctest::Approx(1.f));
+    CHECK(wl.map(60000.f) == 1.f);
+    WindowLevel g = wl;
+    g.gamma = 2.f;
+    CHECK(g.map(1500.f) == doctest::Approx(0.5f));
+}
+
+TEST_CASE("window_level.linear")
+{
+    // the shader samples R16_UNORM values normalized to [0,1]
+    const WindowLevel wl = WindowLevel::from_range(1000.f, 3000.f);
+    float mul, add;
+    wl.linear(65535.f, &mul, &add);
+    for(float v : {1000.f, 1500.f, 2999.f})
+        CHECK(v / 65535.f * mul + add == doctest::Approx(wl.map(v)).epsilon(1e-4));
+    // a window of width 0 is a step at the level
+    const WindowLevel step = {100.f, 0.f, 1.f};
+    CHECK(step.map(99.f) == 0.f);
+    CHECK(step.map(101.f) == 1.f);
+}
+
+TEST_CASE("window_level.colormap_lut")
+{
+    std::vector<ucolor> lut(256);
+    colormap_lut({palettes::grays::values, 2}, true, {lut.data(), lut.size()});
+    for(size_t i = 0; i < lut.size(); ++i)
+    {
+        CHECK(lut[i].r == i);
+        CHECK(lut[i].a == 255);
+    }
+    // the ends are the first and last colors
+    colormap_lut({palettes::viridis::values, C4_COUNTOF(palettes::viridis::values)}, true, {lut.data(), lut.size()});
+    CHECK(lut.front().r == 0x44);
+    CHECK(lut.back().g == 0xe7);
+    // categorical: equal steps
+    std::vector<ucolor> steps(20);
+    colormap_lut({palettes::d3_10::values, 10}, false, {steps.data(), steps.size()});
+    for(size_t i = 0; i < steps.size(); ++i)
+        CHECK(steps[i].g == palettes::d3_10::values[i / 2].g);
+}